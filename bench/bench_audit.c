@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "password_gen.h"
+#include "vault_audit.h"
+#include "vault_controller.h"
+
+#define BENCH_DEFAULT_COUNT 100000
+#define BENCH_VAULT_PATH "/tmp/bench_audit.vault"
+#define BENCH_MASTER "bench_audit_master"
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+    if (count <= 0) {
+        fprintf(stderr, "Usage: %s [entries]\n", argv[0]);
+        return 1;
+    }
+
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    if (vault_init(BENCH_MASTER, BENCH_VAULT_PATH) != 0) {
+        return 1;
+    }
+
+    password_policy_t policy;
+    password_policy_default(&policy, 12);
+    policy.max_length = 20;
+    password_generator_t generator;
+    if (password_generator_init(&generator, &policy) != 0) {
+        vault_cleanup();
+        return 1;
+    }
+
+    const char* weak[] = {"password", "123456", "qwerty123", "letmein", "Summer2024!"};
+    VaultEntry entry;
+    memset(&entry, 0, sizeof(entry));
+
+    vault_begin_batch();
+    for (int i = 0; i < count; i++) {
+        snprintf(entry.service, sizeof(entry.service), "service-%d", i);
+        snprintf(entry.username, sizeof(entry.username), "user%d@example.com", i % 1000);
+        if (i % 10 == 0) {
+            strcpy(entry.password, weak[(i / 10) % 5]);
+        } else {
+            password_generator_next(&generator, entry.password, sizeof(entry.password));
+        }
+        vault_put_entry(&entry);
+    }
+    vault_commit_batch();
+    password_generator_cleanup(&generator);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int thread_counts[] = {1, cpus > 1 ? (int)cpus : 2};
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        audit_options_t options;
+        audit_report_t report;
+        audit_options_default(&options);
+        options.threads = thread_counts[t];
+
+        if (vault_audit(&options, &report) != 0) {
+            fprintf(stderr, "Audit failed\n");
+            break;
+        }
+        printf("Audit of %zu entries with %d threads: %.3f s (%zu weak, %zu reused in %zu groups)\n",
+               report.total, report.threads_used, report.elapsed_seconds,
+               report.weak, report.reused, report.reuse_groups);
+        audit_report_free(&report);
+    }
+
+    vault_cleanup();
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <openssl/rand.h>
+#include "breach_check.h"
+
+#define BENCH_DEFAULT_COUNT 2000000
+#define BENCH_LOOKUPS 1000000
+#define BENCH_DB_PATH "/tmp/bench_breach.db"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_hashes(const void* a, const void* b) {
+    return memcmp(a, b, BREACH_HASH_SIZE);
+}
+
+static void run_lookups(const breach_db_t* db, const unsigned char* hashes, size_t count, const char* label) {
+    unsigned char probe[BREACH_HASH_SIZE];
+    size_t hits = 0, misses = 0;
+
+    double start = now_seconds();
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        if (i % 2 == 0) {
+            memcpy(probe, hashes + (i * 7919 % count) * BREACH_HASH_SIZE, BREACH_HASH_SIZE);
+        } else {
+            RAND_bytes(probe, sizeof(probe));
+        }
+        if (breach_db_lookup(db, probe, NULL) == 1) hits++;
+        else misses++;
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("%-12s %d lookups in %.3f s (%.0f/s, %zu hits, %zu misses)\n",
+           label, BENCH_LOOKUPS, elapsed, BENCH_LOOKUPS / elapsed, hits, misses);
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_COUNT;
+    if (count == 0) {
+        fprintf(stderr, "Usage: %s [hash_count]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned char* hashes = malloc(count * BREACH_HASH_SIZE);
+    FILE* dump = tmpfile();
+    if (!hashes || !dump || RAND_bytes(hashes, (int)(count * BREACH_HASH_SIZE)) != 1) {
+        free(hashes);
+        return 1;
+    }
+    qsort(hashes, count, BREACH_HASH_SIZE, compare_hashes);
+
+    for (size_t i = 0; i < count; i++) {
+        for (int b = 0; b < BREACH_HASH_SIZE; b++) {
+            fprintf(dump, "%02X", hashes[i * BREACH_HASH_SIZE + b]);
+        }
+        fprintf(dump, ":%zu\n", i % 100 + 1);
+    }
+
+    const int bloom_settings[] = {0, 10};
+    for (size_t s = 0; s < sizeof(bloom_settings) / sizeof(bloom_settings[0]); s++) {
+        breach_build_options_t options = {0, bloom_settings[s]};
+        breach_build_stats_t stats;
+        breach_db_t db;
+
+        rewind(dump);
+        double start = now_seconds();
+        if (breach_db_build(dump, BENCH_DB_PATH, &options, &stats) != 0 ||
+            breach_db_open(&db, BENCH_DB_PATH) != 0) {
+            fprintf(stderr, "Failed to build benchmark database\n");
+            break;
+        }
+        printf("Built %llu hashes (prefix %u bits, bloom %d bits/key) in %.3f s, %.1f MB\n",
+               (unsigned long long)stats.records, db.header->prefix_bits, bloom_settings[s],
+               now_seconds() - start, db.map_size / 1e6);
+
+        run_lookups(&db, hashes, count, bloom_settings[s] ? "With bloom:" : "Fan-out only:");
+        breach_db_close(&db);
+    }
+
+    remove(BENCH_DB_PATH);
+    fclose(dump);
+    free(hashes);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "vault_controller.h"
+#include "vault_codec.h"
+#include "crypto_engine.h"
+
+#define BENCH_DEFAULT_ENTRIES 20000
+#define BENCH_PUTS 10
+#define BENCH_OPENS 3
+#define BENCH_VAULT_PATH "/tmp/bench_codec.vault"
+#define BENCH_MASTER "bench_codec_master"
+
+static const char* domains[] = {"gmail.com", "outlook.com", "example.com", "proton.me"};
+static const char* services[] = {"github.com", "google.com", "amazon.com", "netflix.com",
+                                 "bank", "work-vpn", "reddit.com", "slack.com"};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void remove_vault(void) {
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_VAULT_PATH VAULT_LOCK_SUFFIX);
+}
+
+static void make_entry(VaultEntry* entry, size_t i, unsigned* seed) {
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->service, sizeof(entry->service), "%s-%zu", services[i % 8], i);
+    snprintf(entry->username, sizeof(entry->username), "user%zu@%s", i, domains[i % 4]);
+    for (int c = 0; c < 20; c++) {
+        entry->password[c] = (char)('!' + rand_r(seed) % 94);
+    }
+    if (i % 10 == 0) {
+        for (int c = 0; c < 32; c++) {
+            entry->totp_secret[c] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567"[rand_r(seed) % 32];
+        }
+        entry->totp_period = 30;
+        entry->totp_digits = 6;
+    }
+}
+
+static int run_codec(vault_codec_t codec, size_t entries, double kdf_ms) {
+    remove_vault();
+    vault_set_compression(codec);
+    vault_set_durability(VAULT_DURABILITY_NONE);
+
+    unsigned seed = 42;
+    vault_handle_t* vault = vault_handle_open(BENCH_MASTER, BENCH_VAULT_PATH, 0);
+    if (!vault) return -1;
+    vault_handle_begin_batch(vault);
+    for (size_t i = 0; i < entries; i++) {
+        VaultEntry entry;
+        make_entry(&entry, i, &seed);
+        vault_handle_put_entry(vault, &entry);
+    }
+    if (vault_handle_commit_batch(vault) != 0) {
+        vault_handle_close(vault);
+        return -1;
+    }
+
+    vault_set_durability(VAULT_DURABILITY_FSYNC);
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_PUTS; i++) {
+        VaultEntry entry;
+        make_entry(&entry, (size_t)i * 997 % entries, &seed);
+        if (vault_handle_put_entry(vault, &entry) != 0) {
+            vault_handle_close(vault);
+            return -1;
+        }
+    }
+    double save_ms = (now_seconds() - start) * 1000.0 / BENCH_PUTS;
+    vault_handle_close(vault);
+
+    struct stat st;
+    if (stat(BENCH_VAULT_PATH, &st) != 0) return -1;
+
+    double open_ms = 0;
+    for (int i = 0; i < BENCH_OPENS; i++) {
+        start = now_seconds();
+        vault = vault_handle_open(BENCH_MASTER, BENCH_VAULT_PATH, VAULT_OPEN_READ_ONLY);
+        open_ms += (now_seconds() - start) * 1000.0;
+        if (!vault) return -1;
+        vault_handle_close(vault);
+    }
+    open_ms /= BENCH_OPENS;
+
+    printf("%-10s %10.2f MB %12.2f ms %12.1f ms %12.1f ms\n", vault_codec_name(codec),
+           st.st_size / (1024.0 * 1024.0), save_ms, open_ms, open_ms - kdf_ms);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : BENCH_DEFAULT_ENTRIES;
+    if (entries == 0) {
+        fprintf(stderr, "Usage: %s [entries]\n", argv[0]);
+        return 1;
+    }
+    if (crypto_init() != 0) return 1;
+
+    unsigned char salt[SALT_SIZE] = {0}, key[KEY_LEN];
+    double start = now_seconds();
+    derive_key_with_salt(BENCH_MASTER, salt, SALT_SIZE, key);
+    double kdf_ms = (now_seconds() - start) * 1000.0;
+
+    printf("Vault file size, durable single-entry save and read-only unlock, %zu entries\n", entries);
+    printf("Each save rewrites the whole file and copies its backup first\n");
+    printf("load = unlock minus one key derivation (%.1f ms): read, decrypt and decompress\n\n",
+           kdf_ms);
+    printf("%-10s %13s %15s %15s %15s\n", "codec", "file", "save", "unlock", "load");
+
+    const vault_codec_t codecs[] = {VAULT_CODEC_NONE, VAULT_CODEC_ZLIB, VAULT_CODEC_ZLIB_DICT,
+                                    VAULT_CODEC_ZSTD, VAULT_CODEC_ZSTD_DICT};
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++) {
+        if (!vault_codec_available(codecs[i])) {
+            printf("%-10s not built (make WITH_ZSTD=1)\n", vault_codec_name(codecs[i]));
+            continue;
+        }
+        if (run_codec(codecs[i], entries, kdf_ms) != 0) {
+            printf("%-10s failed\n", vault_codec_name(codecs[i]));
+            failed = 1;
+        }
+    }
+
+    remove_vault();
+    return failed;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "vault_controller.h"
+
+#define BENCH_DEFAULT_ENTRIES 1000
+#define BENCH_DEFAULT_MUTATIONS 500
+#define BENCH_VAULT_PATH "/tmp/bench_durability.vault"
+#define BENCH_MASTER "bench_durability_master"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void make_entry(VaultEntry* entry, const char* prefix, size_t i) {
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->service, sizeof(entry->service), "%s%zu", prefix, i);
+    snprintf(entry->username, sizeof(entry->username), "user%zu@example.com", i);
+    snprintf(entry->password, sizeof(entry->password), "Pw-%zu-bench", i);
+}
+
+static int seed_vault(size_t entries) {
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_VAULT_PATH ".lock");
+    if (vault_init(BENCH_MASTER, BENCH_VAULT_PATH) != 0) return -1;
+
+    vault_begin_batch();
+    for (size_t i = 0; i < entries; i++) {
+        VaultEntry entry;
+        make_entry(&entry, "seed", i);
+        if (vault_put_entry(&entry) != 0) return -1;
+    }
+    int ret = vault_commit_batch();
+    vault_cleanup();
+    return ret;
+}
+
+static int run_mode(const char* label, vault_durability_t mode, int batched, int saver,
+                    size_t mutations) {
+    if (vault_set_durability(mode) != 0) return -1;
+    if (vault_open(BENCH_MASTER, BENCH_VAULT_PATH, 0) != 0) return -1;
+    if (saver && vault_start_saver(VAULT_SAVER_DELAY_MS, NULL, NULL) != 0) {
+        vault_cleanup();
+        return -1;
+    }
+
+    double start = now_seconds();
+    if (batched) vault_begin_batch();
+    for (size_t i = 0; i < mutations; i++) {
+        VaultEntry entry;
+        make_entry(&entry, label, i);
+        if (vault_put_entry(&entry) != 0) {
+            vault_cleanup();
+            return -1;
+        }
+    }
+    int ret = batched ? vault_commit_batch() : saver ? vault_flush() : vault_sync();
+    vault_cleanup();
+    double elapsed = now_seconds() - start;
+
+    printf("%-20s %10zu puts %8.3f s %10.0f puts/s %9.3f ms/put\n",
+           label, mutations, elapsed, mutations / elapsed, elapsed * 1000.0 / mutations);
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : BENCH_DEFAULT_ENTRIES;
+    size_t mutations = argc > 2 ? (size_t)atol(argv[2]) : BENCH_DEFAULT_MUTATIONS;
+    if (mutations == 0) {
+        fprintf(stderr, "Usage: %s [entries] [mutations]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Unbatched vault_put_entry throughput on a %zu-entry vault\n\n", entries);
+
+    const struct {
+        const char* label;
+        vault_durability_t mode;
+        int batched;
+        int saver;
+    } modes[] = {
+        {"none", VAULT_DURABILITY_NONE, 0, 0},
+        {"fsync", VAULT_DURABILITY_FSYNC, 0, 0},
+        {"group", VAULT_DURABILITY_GROUP, 0, 0},
+        {"fsync (async saver)", VAULT_DURABILITY_FSYNC, 0, 1},
+        {"fsync (one batch)", VAULT_DURABILITY_FSYNC, 1, 0}
+    };
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (seed_vault(entries) != 0 ||
+            run_mode(modes[i].label, modes[i].mode, modes[i].batched, modes[i].saver,
+                     mutations) != 0) {
+            printf("%-20s failed\n", modes[i].label);
+            failed = 1;
+        }
+    }
+
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_VAULT_PATH ".lock");
+    return failed;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "password_gen.h"
+#include "passphrase.h"
+
+#define BENCH_DEFAULT_COUNT 200000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int legacy_generate(char* output, int length) {
+    const char charset[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*()-_=+";
+
+    FILE* urandom = fopen("/dev/urandom", "r");
+    if (!urandom) {
+        return -1;
+    }
+
+    for (int i = 0; i < length; i++) {
+        unsigned char byte;
+        if (fread(&byte, 1, 1, urandom) != 1) {
+            fclose(urandom);
+            return -1;
+        }
+        output[i] = charset[byte % (sizeof(charset) - 1)];
+    }
+    output[length] = '\0';
+
+    fclose(urandom);
+    return 0;
+}
+
+static double max_bias(const unsigned long* counts, const char* charset, unsigned long total) {
+    size_t n = strlen(charset);
+    double expected = (double)total / n;
+    double worst = 0.0;
+
+    for (size_t i = 0; i < n; i++) {
+        double deviation = (counts[(unsigned char)charset[i]] - expected) / expected;
+        if (deviation < 0) deviation = -deviation;
+        if (deviation > worst) worst = deviation;
+    }
+    return worst * 100.0;
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+    const int length = 16;
+    const char* charset = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*()-_=+";
+    char password[PWGEN_MAX_LENGTH + 1];
+    unsigned long counts[256];
+
+    if (count <= 0) {
+        fprintf(stderr, "Usage: %s [count]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Password generation benchmark: %d passwords of %d characters\n\n", count, length);
+    printf("%-28s %14s %12s %12s\n", "generator", "passwords/s", "MB/s", "max bias %");
+
+    int legacy_count = count / 10 > 0 ? count / 10 : 1;
+    memset(counts, 0, sizeof(counts));
+    double start = now_seconds();
+    for (int i = 0; i < legacy_count; i++) {
+        if (legacy_generate(password, length) != 0) return 1;
+        for (int j = 0; j < length; j++) counts[(unsigned char)password[j]]++;
+    }
+    double elapsed = now_seconds() - start;
+    printf("%-28s %14.0f %12.2f %12.2f\n", "legacy (fread + modulo)",
+           legacy_count / elapsed, legacy_count * (length + 1) / elapsed / 1e6,
+           max_bias(counts, charset, (unsigned long)legacy_count * length));
+
+    password_policy_t policy;
+    password_policy_default(&policy, length);
+    password_generator_t generator;
+    if (password_generator_init(&generator, &policy) != 0) return 1;
+
+    memset(counts, 0, sizeof(counts));
+    start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        if (password_generator_next(&generator, password, sizeof(password)) < 0) return 1;
+        for (int j = 0; j < length; j++) counts[(unsigned char)password[j]]++;
+    }
+    elapsed = now_seconds() - start;
+    printf("%-28s %14.0f %12.2f %12.2f\n", "pooled rejection sampling",
+           count / elapsed, count * (length + 1) / elapsed / 1e6,
+           max_bias(counts, charset, (unsigned long)count * length));
+
+    policy.required_classes = PWGEN_CLASS_ALL;
+    password_generator_cleanup(&generator);
+    if (password_generator_init(&generator, &policy) != 0) return 1;
+
+    start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        if (password_generator_next(&generator, password, sizeof(password)) < 0) return 1;
+    }
+    elapsed = now_seconds() - start;
+    printf("%-28s %14.0f %12.2f %12s\n", "  + all classes required",
+           count / elapsed, count * (length + 1) / elapsed / 1e6, "-");
+
+    password_generator_cleanup(&generator);
+
+    passphrase_policy_t phrase_policy;
+    passphrase_policy_default(&phrase_policy);
+    passphrase_generator_t phrase_generator;
+    if (passphrase_generator_init(&phrase_generator, &phrase_policy) != 0) return 1;
+
+    char phrase[PASSPHRASE_MAX_LENGTH + 1];
+    size_t phrase_bytes = 0;
+    start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        int phrase_len = passphrase_generator_next(&phrase_generator, phrase, sizeof(phrase));
+        if (phrase_len < 0) return 1;
+        phrase_bytes += (size_t)phrase_len + 1;
+    }
+    elapsed = now_seconds() - start;
+    printf("%-28s %14.0f %12.2f %12s\n", "diceware passphrase (6 words)",
+           count / elapsed, phrase_bytes / elapsed / 1e6, "-");
+
+    passphrase_generator_cleanup(&phrase_generator);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "vault_controller.h"
+
+#define BENCH_DEFAULT_ENTRIES 20000
+#define BENCH_RUNS 5
+#define BENCH_SHARDS 16
+#define BENCH_SINGLE_PATH "/tmp/bench_open.vault"
+#define BENCH_SHARDED_PATH "/tmp/bench_open.d"
+#define BENCH_MASTER "bench_open_master"
+
+static void remove_vault(const char* path) {
+    char file[600];
+    for (int s = 0; s < VAULT_MAX_SHARDS; s++) {
+        snprintf(file, sizeof(file), "%s/%s%03d", path, VAULT_SHARD_PREFIX, s);
+        unlink(file);
+    }
+    snprintf(file, sizeof(file), "%s/%s", path, VAULT_MANIFEST_NAME);
+    unlink(file);
+    rmdir(path);
+    unlink(path);
+    snprintf(file, sizeof(file), "%s%s", path, VAULT_LOCK_SUFFIX);
+    unlink(file);
+    snprintf(file, sizeof(file), "%s.backup", path);
+    unlink(file);
+}
+
+/* Drops the vault's clean pages from the page cache so the next open reads the disk. */
+static void evict_file(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static void evict_vault(const char* path, uint32_t shards) {
+    if (shards == 1) {
+        evict_file(path);
+        return;
+    }
+    char file[600];
+    for (uint32_t s = 0; s < shards; s++) {
+        snprintf(file, sizeof(file), "%s/%s%03u", path, VAULT_SHARD_PREFIX, s);
+        evict_file(file);
+    }
+}
+
+static int run_case(const char* label, const char* path, uint32_t shards, int cold) {
+    vault_open_timings_t sum;
+    memset(&sum, 0, sizeof(sum));
+
+    for (int i = 0; i < BENCH_RUNS; i++) {
+        if (cold) evict_vault(path, shards);
+        vault_handle_t* vault = vault_handle_open(BENCH_MASTER, path, VAULT_OPEN_READ_ONLY);
+        if (!vault) return -1;
+        vault_open_timings_t timings;
+        vault_handle_open_timings(vault, &timings);
+        vault_handle_close(vault);
+
+        sum.read_ms += timings.read_ms;
+        sum.kdf_ms += timings.kdf_ms;
+        sum.decrypt_ms += timings.decrypt_ms;
+        sum.total_ms += timings.total_ms;
+    }
+
+    double sequential = (sum.read_ms + sum.kdf_ms + sum.decrypt_ms) / BENCH_RUNS;
+    double total = sum.total_ms / BENCH_RUNS;
+    printf("%-22s %8.1f %8.1f %8.1f %10.1f %8.1f ms %7.1f ms\n", label, sum.read_ms / BENCH_RUNS,
+           sum.kdf_ms / BENCH_RUNS, sum.decrypt_ms / BENCH_RUNS, sequential, total,
+           sequential - total);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : BENCH_DEFAULT_ENTRIES;
+    if (entries == 0) {
+        fprintf(stderr, "Usage: %s [entries]\n", argv[0]);
+        return 1;
+    }
+
+    remove_vault(BENCH_SINGLE_PATH);
+    remove_vault(BENCH_SHARDED_PATH);
+    vault_handle_t* vault = vault_handle_open(BENCH_MASTER, BENCH_SINGLE_PATH, 0);
+    if (!vault) return 1;
+    vault_handle_begin_batch(vault);
+    for (size_t i = 0; i < entries; i++) {
+        VaultEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        snprintf(entry.service, sizeof(entry.service), "service%zu", i);
+        snprintf(entry.username, sizeof(entry.username), "user%zu@example.com", i);
+        snprintf(entry.password, sizeof(entry.password), "Pw-%zu-bench", i);
+        vault_handle_put_entry(vault, &entry);
+    }
+    if (vault_handle_commit_batch(vault) != 0) return 1;
+    vault_handle_close(vault);
+    if (vault_reshard(BENCH_MASTER, BENCH_SINGLE_PATH, BENCH_SHARDED_PATH, BENCH_SHARDS) != 0) {
+        return 1;
+    }
+
+    printf("Read-only open of a %zu-entry vault, mean of %d runs\n", entries, BENCH_RUNS);
+    printf("The file is read on its own thread while the key is derived; \"saved\" is the\n");
+    printf("difference between the phases run back to back and the measured open\n");
+    printf("open also includes merging shards and building the index\n");
+    printf("Cold runs drop the vault from the page cache first\n\n");
+    printf("%-22s %8s %8s %8s %10s %11s %10s\n", "case", "read", "kdf", "decrypt", "sequential",
+           "open", "saved");
+
+    int failed = run_case("single file, warm", BENCH_SINGLE_PATH, 1, 0) != 0 ||
+                 run_case("single file, cold", BENCH_SINGLE_PATH, 1, 1) != 0 ||
+                 run_case("16 shards, warm", BENCH_SHARDED_PATH, BENCH_SHARDS, 0) != 0 ||
+                 run_case("16 shards, cold", BENCH_SHARDED_PATH, BENCH_SHARDS, 1) != 0;
+
+    remove_vault(BENCH_SINGLE_PATH);
+    remove_vault(BENCH_SHARDED_PATH);
+    return failed;
+}
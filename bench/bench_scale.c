@@ -0,0 +1,259 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "vault_controller.h"
+#include "vault_codec.h"
+#include "vault_gen.h"
+
+#define BENCH_MAX_SCALES 16
+#define BENCH_OPENS 3
+#define BENCH_GETS 1000
+#define BENCH_WRITES 5
+#define BENCH_LISTS 3
+#define BENCH_BACKUPS 3
+#define BENCH_VAULT_PATH "/tmp/bench_scale.vault"
+#define BENCH_MASTER "bench_scale_master"
+#define BENCH_NEW_MASTER "bench_scale_master2"
+
+static const size_t default_scales[] = {1000, 10000, 100000};
+
+typedef struct {
+    size_t entries;
+    long long file_bytes;
+    double generate_ms;
+    double init_ms;
+    double get_us;
+    double store_ms;
+    double remove_ms;
+    double list_ms;
+    double change_password_ms;
+    double backup_ms;
+    long peak_rss_kb;
+} scale_result_t;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void remove_vault(void) {
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_VAULT_PATH VAULT_LOCK_SUFFIX);
+}
+
+/* Runs in a child process so its peak RSS covers one scale only. */
+static int measure(size_t entries, scale_result_t* result) {
+    vault_gen_config_t config;
+    vault_gen_defaults(&config);
+    memset(result, 0, sizeof(*result));
+    result->entries = entries;
+
+    remove_vault();
+    double start = now_ms();
+    vault_handle_t* vault = vault_handle_open(BENCH_MASTER, BENCH_VAULT_PATH, 0);
+    if (!vault || vault_gen_fill(vault, &config, 0, entries) != 0) return -1;
+    result->generate_ms = now_ms() - start;
+    vault_handle_close(vault);
+
+    struct stat st;
+    if (stat(BENCH_VAULT_PATH, &st) != 0) return -1;
+    result->file_bytes = (long long)st.st_size;
+
+    for (int i = 0; i < BENCH_OPENS; i++) {
+        start = now_ms();
+        vault = vault_handle_open(BENCH_MASTER, BENCH_VAULT_PATH, 0);
+        result->init_ms += now_ms() - start;
+        if (!vault) return -1;
+        if (i + 1 < BENCH_OPENS) vault_handle_close(vault);
+    }
+    result->init_ms /= BENCH_OPENS;
+
+    unsigned seed = 7;
+    start = now_ms();
+    for (int i = 0; i < BENCH_GETS; i++) {
+        VaultEntry wanted, found;
+        vault_gen_entry(&config, (size_t)rand_r(&seed) % entries, &wanted);
+        if (vault_handle_get(vault, wanted.service, wanted.username, &found) != 0) return -1;
+    }
+    result->get_us = (now_ms() - start) * 1000.0 / BENCH_GETS;
+
+    start = now_ms();
+    for (int i = 0; i < BENCH_WRITES; i++) {
+        VaultEntry entry;
+        vault_gen_entry(&config, entries + (size_t)i, &entry);
+        if (vault_handle_put_entry(vault, &entry) != 0) return -1;
+    }
+    result->store_ms = (now_ms() - start) / BENCH_WRITES;
+
+    start = now_ms();
+    for (int i = 0; i < BENCH_WRITES; i++) {
+        VaultEntry entry;
+        vault_gen_entry(&config, (size_t)i * (entries / BENCH_WRITES), &entry);
+        if (vault_handle_remove(vault, entry.service, entry.username) != 0) return -1;
+    }
+    result->remove_ms = (now_ms() - start) / BENCH_WRITES;
+
+    start = now_ms();
+    for (int i = 0; i < BENCH_LISTS; i++) {
+        if (vault_handle_list(vault) != 0) return -1;
+    }
+    result->list_ms = (now_ms() - start) / BENCH_LISTS;
+
+    start = now_ms();
+    if (vault_handle_change_master_password(vault, BENCH_MASTER, BENCH_NEW_MASTER) != 0) return -1;
+    result->change_password_ms = now_ms() - start;
+    vault_handle_close(vault);
+
+    start = now_ms();
+    for (int i = 0; i < BENCH_BACKUPS; i++) {
+        if (vault_backup(BENCH_VAULT_PATH) != 0) return -1;
+    }
+    result->backup_ms = (now_ms() - start) / BENCH_BACKUPS;
+
+    remove_vault();
+    return 0;
+}
+
+static int run_scale(size_t entries, scale_result_t* result) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        close(fds[0]);
+        /* vault_handle_list() prints every entry. */
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) dup2(null_fd, STDOUT_FILENO);
+        scale_result_t child;
+        int ok = measure(entries, &child) == 0 &&
+                 write(fds[1], &child, sizeof(child)) == (ssize_t)sizeof(child);
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0 || got != (ssize_t)sizeof(*result)) {
+        remove_vault();
+        return -1;
+    }
+    result->peak_rss_kb = usage.ru_maxrss;
+    return 0;
+}
+
+static int write_csv(const char* path, const scale_result_t* results, size_t count) {
+    FILE* out = fopen(path, "w");
+    if (!out) return -1;
+
+    fprintf(out, "entries,file_bytes,generate_ms,init_ms,get_us,store_ms,remove_ms,list_ms,"
+                 "change_password_ms,backup_ms,peak_rss_kb\n");
+    for (size_t i = 0; i < count; i++) {
+        const scale_result_t* r = &results[i];
+        fprintf(out, "%zu,%lld,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%ld\n", r->entries,
+                r->file_bytes, r->generate_ms, r->init_ms, r->get_us, r->store_ms, r->remove_ms,
+                r->list_ms, r->change_password_ms, r->backup_ms, r->peak_rss_kb);
+    }
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+static int write_json(const char* path, const scale_result_t* results, size_t count) {
+    FILE* out = fopen(path, "w");
+    if (!out) return -1;
+
+    fprintf(out, "[\n");
+    for (size_t i = 0; i < count; i++) {
+        const scale_result_t* r = &results[i];
+        fprintf(out,
+                "  {\"entries\":%zu,\"file_bytes\":%lld,\"generate_ms\":%.3f,\"init_ms\":%.3f,"
+                "\"get_us\":%.3f,\"store_ms\":%.3f,\"remove_ms\":%.3f,\"list_ms\":%.3f,"
+                "\"change_password_ms\":%.3f,\"backup_ms\":%.3f,\"peak_rss_kb\":%ld}%s\n",
+                r->entries, r->file_bytes, r->generate_ms, r->init_ms, r->get_us, r->store_ms,
+                r->remove_ms, r->list_ms, r->change_password_ms, r->backup_ms, r->peak_rss_kb,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(out, "]\n");
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--csv file] [--json file] [--compression c] [entries...]\n",
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    const char* csv_path = NULL;
+    const char* json_path = NULL;
+    size_t scales[BENCH_MAX_SCALES];
+    size_t scale_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--compression") == 0 && i + 1 < argc) {
+            vault_codec_t codec;
+            if (vault_codec_parse(argv[++i], &codec) != 0 || vault_set_compression(codec) != 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (argv[i][0] != '-' && atol(argv[i]) >= BENCH_WRITES &&
+                   scale_count < BENCH_MAX_SCALES) {
+            scales[scale_count++] = (size_t)atol(argv[i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (scale_count == 0) {
+        scale_count = sizeof(default_scales) / sizeof(default_scales[0]);
+        memcpy(scales, default_scales, sizeof(default_scales));
+    }
+
+    printf("Vault operations by size, single-file vault with fsync durability\n");
+    printf("init: unlock, get: lookup of a random entry, store/remove: one durable save\n");
+    printf("Entries come from vault_gen with its default seed and lengths\n\n");
+    printf("%9s %9s %10s %9s %8s %9s %9s %9s %9s %9s %9s\n", "entries", "file MB", "generate",
+           "init", "get", "store", "remove", "list", "passwd", "backup", "peak RSS");
+
+    scale_result_t results[BENCH_MAX_SCALES];
+    int failed = 0;
+    for (size_t i = 0; i < scale_count; i++) {
+        if (run_scale(scales[i], &results[i]) != 0) {
+            printf("%9zu failed\n", scales[i]);
+            failed = 1;
+            break;
+        }
+        const scale_result_t* r = &results[i];
+        printf("%9zu %9.1f %7.0f ms %6.1f ms %5.1f us %6.1f ms %6.1f ms %6.1f ms %6.1f ms %6.1f ms "
+               "%6ld MB\n",
+               r->entries, r->file_bytes / (1024.0 * 1024.0), r->generate_ms, r->init_ms, r->get_us,
+               r->store_ms, r->remove_ms, r->list_ms, r->change_password_ms, r->backup_ms,
+               r->peak_rss_kb / 1024);
+    }
+    if (failed) return 1;
+
+    if (csv_path && write_csv(csv_path, results, scale_count) != 0) {
+        fprintf(stderr, "Failed to write %s\n", csv_path);
+        return 1;
+    }
+    if (json_path && write_json(json_path, results, scale_count) != 0) {
+        fprintf(stderr, "Failed to write %s\n", json_path);
+        return 1;
+    }
+    return 0;
+}
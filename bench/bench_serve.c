@@ -0,0 +1,102 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "serve.h"
+#include "vault_controller.h"
+
+#define BENCH_DEFAULT_ENTRIES 10000
+#define BENCH_DEFAULT_REQUESTS 200000
+#define BENCH_VAULT_PATH "/tmp/bench_serve.vault"
+#define BENCH_REQUESTS_PATH "/tmp/bench_serve.requests"
+#define BENCH_MASTER "bench_serve_master"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run_requests(const char* label, size_t requests) {
+    int fd = open(BENCH_REQUESTS_PATH, O_RDONLY);
+    FILE* out = fopen("/dev/null", "w");
+    if (fd < 0 || !out) return -1;
+
+    serve_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    double start = now_seconds();
+    int ret = serve_stdio(fd, out, &stats);
+    double elapsed = now_seconds() - start;
+
+    close(fd);
+    fclose(out);
+    if (ret != 0 || stats.requests != requests) return -1;
+
+    printf("%-34s %10zu requests %8.3f s %12.0f req/s (%zu errors, %zu commits)\n",
+           label, stats.requests, elapsed, stats.requests / elapsed, stats.errors, stats.commits);
+    return elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    int entries = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ENTRIES;
+    int requests = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_REQUESTS;
+    if (entries <= 0 || requests <= 0) {
+        fprintf(stderr, "Usage: %s [entries] [requests]\n", argv[0]);
+        return 1;
+    }
+
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+
+    double start = now_seconds();
+    if (vault_init(BENCH_MASTER, BENCH_VAULT_PATH) != 0) return 1;
+    double kdf = now_seconds() - start;
+
+    VaultEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    vault_begin_batch();
+    for (int i = 0; i < entries; i++) {
+        snprintf(entry.service, sizeof(entry.service), "service-%d", i);
+        snprintf(entry.username, sizeof(entry.username), "user%d@example.com", i % 100);
+        snprintf(entry.password, sizeof(entry.password), "password-%d", i);
+        vault_put_entry(&entry);
+    }
+    vault_commit_batch();
+
+    FILE* fp = fopen(BENCH_REQUESTS_PATH, "w");
+    if (!fp) return 1;
+    srand(1);
+    for (int i = 0; i < requests; i++) {
+        int n = rand() % entries;
+        fprintf(fp, "{\"id\":%d,\"op\":\"get\",\"service\":\"service-%d\",\"username\":\"user%d@example.com\"}\n",
+                i, n, n % 100);
+    }
+    fclose(fp);
+
+    printf("Vault with %d entries, unlock (KDF + decrypt) %.1f ms per process\n\n", entries, kdf * 1000);
+    double elapsed = run_requests("pipelined get", (size_t)requests);
+
+    int writes = requests / 10 > 0 ? requests / 10 : 1;
+    fp = fopen(BENCH_REQUESTS_PATH, "w");
+    if (!fp) return 1;
+    for (int i = 0; i < writes; i++) {
+        fprintf(fp, "{\"id\":%d,\"op\":\"store\",\"service\":\"service-%d\",\"username\":\"user%d@example.com\","
+                    "\"password\":\"rotated-%d\"}\n", i, i % entries, (i % entries) % 100, i);
+    }
+    fclose(fp);
+    run_requests("pipelined store (group commit)", (size_t)writes);
+
+    if (elapsed > 0) {
+        printf("\nOne process per query would spend %.1f s on unlocks alone for %d gets\n",
+               kdf * requests, requests);
+    }
+
+    vault_cleanup();
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_REQUESTS_PATH);
+    return 0;
+}
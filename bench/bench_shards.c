@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "vault_controller.h"
+
+#define BENCH_DEFAULT_ENTRIES 20000
+#define BENCH_PUTS 20
+#define BENCH_SINGLE_PATH "/tmp/bench_shards.vault"
+#define BENCH_SHARDED_PATH "/tmp/bench_shards.d"
+#define BENCH_MASTER "bench_shards_master"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void remove_vault(const char* path) {
+    char file[600];
+    for (int s = 0; s < VAULT_MAX_SHARDS; s++) {
+        snprintf(file, sizeof(file), "%s/%s%03d", path, VAULT_SHARD_PREFIX, s);
+        unlink(file);
+    }
+    snprintf(file, sizeof(file), "%s/%s", path, VAULT_MANIFEST_NAME);
+    unlink(file);
+    rmdir(path);
+    unlink(path);
+    snprintf(file, sizeof(file), "%s%s", path, VAULT_LOCK_SUFFIX);
+    unlink(file);
+    snprintf(file, sizeof(file), "%s.backup", path);
+    unlink(file);
+}
+
+static int run_layout(uint32_t shards, size_t entries) {
+    const char* path = shards > 1 ? BENCH_SHARDED_PATH : BENCH_SINGLE_PATH;
+    remove_vault(BENCH_SHARDED_PATH);
+    if (shards > 1 && vault_reshard(BENCH_MASTER, BENCH_SINGLE_PATH, path, shards) != 0) {
+        return -1;
+    }
+
+    double start = now_seconds();
+    vault_handle_t* vault = vault_handle_open(BENCH_MASTER, path, 0);
+    double open_ms = (now_seconds() - start) * 1000.0;
+    if (!vault) return -1;
+
+    start = now_seconds();
+    for (int i = 0; i < BENCH_PUTS; i++) {
+        VaultEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        snprintf(entry.service, sizeof(entry.service), "service%zu", (size_t)i * 997 % entries);
+        snprintf(entry.username, sizeof(entry.username), "user%zu@example.com", (size_t)i * 997 % entries);
+        snprintf(entry.password, sizeof(entry.password), "Changed-%d", i);
+        if (vault_handle_put_entry(vault, &entry) != 0) {
+            vault_handle_close(vault);
+            return -1;
+        }
+    }
+    double put_ms = (now_seconds() - start) * 1000.0 / BENCH_PUTS;
+    vault_handle_close(vault);
+
+    printf("%6u %12.1f ms %12.2f ms\n", shards, open_ms, put_ms);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : BENCH_DEFAULT_ENTRIES;
+    if (entries == 0) {
+        fprintf(stderr, "Usage: %s [entries]\n", argv[0]);
+        return 1;
+    }
+
+    remove_vault(BENCH_SINGLE_PATH);
+    vault_handle_t* vault = vault_handle_open(BENCH_MASTER, BENCH_SINGLE_PATH, 0);
+    if (!vault) return 1;
+    vault_handle_begin_batch(vault);
+    for (size_t i = 0; i < entries; i++) {
+        VaultEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        snprintf(entry.service, sizeof(entry.service), "service%zu", i);
+        snprintf(entry.username, sizeof(entry.username), "user%zu@example.com", i);
+        snprintf(entry.password, sizeof(entry.password), "Pw-%zu-bench", i);
+        vault_handle_put_entry(vault, &entry);
+    }
+    if (vault_handle_commit_batch(vault) != 0) return 1;
+    vault_handle_close(vault);
+
+    printf("Unlock and durable single-entry save on a %zu-entry vault\n", entries);
+    printf("Unlock includes one key derivation; each save rewrites only the affected shard\n");
+    printf("The single-file layout also copies its backup before every save\n\n");
+    printf("%6s %15s %15s\n", "shards", "unlock", "save");
+
+    const uint32_t layouts[] = {1, 4, 16, 64};
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        if (run_layout(layouts[i], entries) != 0) {
+            printf("%6u failed\n", layouts[i]);
+            failed = 1;
+        }
+    }
+
+    remove_vault(BENCH_SINGLE_PATH);
+    remove_vault(BENCH_SHARDED_PATH);
+    return failed;
+}
@@ -0,0 +1,173 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "vault_controller.h"
+
+#define BENCH_DEFAULT_ENTRIES 10000
+#define BENCH_DEFAULT_READERS 2
+#define BENCH_PHASE_SECONDS 1.0
+#define BENCH_MAX_SAMPLES 4000000
+#define BENCH_VAULT_PATH "/tmp/bench_snapshot.vault"
+#define BENCH_MASTER "bench_snapshot_master"
+
+typedef struct {
+    vault_handle_t* vault;
+    size_t entries;
+    unsigned seed;
+    double* samples;
+    size_t sample_count;
+    atomic_bool* stop;
+} reader_args_t;
+
+typedef struct {
+    vault_handle_t* vault;
+    size_t entries;
+    size_t writes;
+    atomic_bool* stop;
+} writer_args_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void make_entry(VaultEntry* entry, size_t i, size_t version) {
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->service, sizeof(entry->service), "service%zu", i);
+    snprintf(entry->username, sizeof(entry->username), "user%zu@example.com", i);
+    snprintf(entry->password, sizeof(entry->password), "Pw-%zu-%zu", i, version);
+}
+
+static void* reader_thread(void* arg) {
+    reader_args_t* args = arg;
+    char service[32], username[64];
+    VaultEntry entry;
+
+    while (!atomic_load(args->stop) && args->sample_count < BENCH_MAX_SAMPLES) {
+        size_t i = (size_t)rand_r(&args->seed) % args->entries;
+        snprintf(service, sizeof(service), "service%zu", i);
+        snprintf(username, sizeof(username), "user%zu@example.com", i);
+
+        double start = now_seconds();
+        vault_handle_get(args->vault, service, username, &entry);
+        args->samples[args->sample_count++] = (now_seconds() - start) * 1e6;
+    }
+    return NULL;
+}
+
+static void* writer_thread(void* arg) {
+    writer_args_t* args = arg;
+    VaultEntry entry;
+
+    while (!atomic_load(args->stop)) {
+        make_entry(&entry, args->writes % args->entries, args->writes + 1);
+        if (vault_handle_put_entry(args->vault, &entry) != 0) break;
+        args->writes++;
+    }
+    return NULL;
+}
+
+static int run_phase(const char* label, vault_handle_t* vault, size_t entries,
+                     int readers, int with_writer) {
+    atomic_bool stop;
+    atomic_init(&stop, false);
+
+    reader_args_t* reader_args = calloc((size_t)readers, sizeof(reader_args_t));
+    pthread_t* threads = calloc((size_t)readers, sizeof(pthread_t));
+    if (!reader_args || !threads) return -1;
+
+    for (int r = 0; r < readers; r++) {
+        reader_args[r].vault = vault;
+        reader_args[r].entries = entries;
+        reader_args[r].seed = (unsigned)(r + 1);
+        reader_args[r].stop = &stop;
+        reader_args[r].samples = malloc(BENCH_MAX_SAMPLES * sizeof(double));
+        if (!reader_args[r].samples) return -1;
+    }
+
+    writer_args_t writer = {vault, entries, 0, &stop};
+    pthread_t writer_tid;
+    if (with_writer) pthread_create(&writer_tid, NULL, writer_thread, &writer);
+    for (int r = 0; r < readers; r++) {
+        pthread_create(&threads[r], NULL, reader_thread, &reader_args[r]);
+    }
+
+    double start = now_seconds();
+    while (now_seconds() - start < BENCH_PHASE_SECONDS) {
+        usleep(10000);
+    }
+    atomic_store(&stop, true);
+    for (int r = 0; r < readers; r++) pthread_join(threads[r], NULL);
+    if (with_writer) pthread_join(writer_tid, NULL);
+
+    size_t total = 0;
+    for (int r = 0; r < readers; r++) total += reader_args[r].sample_count;
+    double* all = malloc((total ? total : 1) * sizeof(double));
+    if (!all) return -1;
+    size_t n = 0;
+    for (int r = 0; r < readers; r++) {
+        memcpy(all + n, reader_args[r].samples, reader_args[r].sample_count * sizeof(double));
+        n += reader_args[r].sample_count;
+        free(reader_args[r].samples);
+    }
+    qsort(all, total, sizeof(double), compare_double);
+
+    if (total > 0) {
+        printf("%-22s %10zu reads %8.2f %8.2f %9.2f %10.2f us %8zu writes\n", label, total,
+               all[total / 2], all[(total * 99) / 100], all[(total * 999) / 1000],
+               all[total - 1], writer.writes);
+    }
+
+    free(all);
+    free(reader_args);
+    free(threads);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : BENCH_DEFAULT_ENTRIES;
+    int readers = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_READERS;
+    if (entries == 0 || readers <= 0) {
+        fprintf(stderr, "Usage: %s [entries] [reader threads]\n", argv[0]);
+        return 1;
+    }
+
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_VAULT_PATH ".lock");
+
+    vault_handle_t* vault = vault_handle_open(BENCH_MASTER, BENCH_VAULT_PATH, 0);
+    if (!vault) return 1;
+
+    vault_handle_begin_batch(vault);
+    for (size_t i = 0; i < entries; i++) {
+        VaultEntry entry;
+        make_entry(&entry, i, 0);
+        vault_handle_put_entry(vault, &entry);
+    }
+    if (vault_handle_commit_batch(vault) != 0) return 1;
+
+    printf("vault_handle_get latency, %zu entries, %d reader thread(s), %.1f s per phase\n",
+           entries, readers, BENCH_PHASE_SECONDS);
+    printf("Each write in the storm is a full durable save (backup, encrypt, fsync, rename)\n\n");
+    printf("%-22s %16s %8s %8s %9s %10s\n", "phase", "", "p50", "p99", "p99.9", "max");
+
+    int failed = run_phase("reads only", vault, entries, readers, 0) != 0 ||
+                 run_phase("reads + write storm", vault, entries, readers, 1) != 0;
+
+    vault_handle_close(vault);
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_VAULT_PATH ".lock");
+    return failed;
+}
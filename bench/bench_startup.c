@@ -0,0 +1,127 @@
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "vault_controller.h"
+
+#define BENCH_DEFAULT_RUNS 50
+#define BENCH_BINARY "./securekey"
+#define BENCH_VAULT_PATH "/tmp/bench_startup.vault"
+#define BENCH_MASTER_PATH "/tmp/bench_startup.master"
+#define BENCH_MASTER "bench_startup_master"
+#define STARTUP_OVERHEAD_TARGET_MS 3.5
+
+extern char** environ;
+
+typedef struct {
+    const char* label;
+    int stateless;
+    const char* argv[12];
+} startup_case_t;
+
+static const startup_case_t cases[] = {
+    {"--version (process floor)", 0, {BENCH_BINARY, "--version", NULL}},
+    {"totp --secret", 1, {BENCH_BINARY, "totp", "--secret", "JBSWY3DPEHPK3PXP", NULL}},
+    {"check -p", 1, {BENCH_BINARY, "check", "-p", "Tr0ub4dor&3", NULL}},
+    {"generate -l 20", 1, {BENCH_BINARY, "generate", "-l", "20", NULL}},
+    {"list (unlock)", 0, {BENCH_BINARY, "list", "-v", BENCH_VAULT_PATH, "--master-fd", "3", NULL}}
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double run_once(const startup_case_t* c) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, 3, BENCH_MASTER_PATH, O_RDONLY, 0);
+
+    pid_t pid;
+    int status = 0;
+    double start = now_seconds();
+    int ret = posix_spawn(&pid, c->argv[0], &actions, NULL, (char* const*)c->argv, environ);
+    if (ret == 0) waitpid(pid, &status, 0);
+    double elapsed = now_seconds() - start;
+
+    posix_spawn_file_actions_destroy(&actions);
+    if (ret != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1;
+    return elapsed * 1000.0;
+}
+
+int main(int argc, char* argv[]) {
+    int runs = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_RUNS;
+    if (runs <= 0) {
+        fprintf(stderr, "Usage: %s [runs]\n", argv[0]);
+        return 1;
+    }
+    if (access(BENCH_BINARY, X_OK) != 0) {
+        fprintf(stderr, "%s not found; run make first\n", BENCH_BINARY);
+        return 1;
+    }
+
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    if (vault_init(BENCH_MASTER, BENCH_VAULT_PATH) != 0) return 1;
+    vault_cleanup();
+
+    FILE* fp = fopen(BENCH_MASTER_PATH, "w");
+    if (!fp) return 1;
+    fprintf(fp, "%s\n", BENCH_MASTER);
+    fclose(fp);
+
+    double* samples = malloc((size_t)runs * sizeof(double));
+    if (!samples) return 1;
+
+    printf("Exec-to-exit time over %d runs\n", runs);
+    printf("Target: stateless commands finish within %.1f ms (p50) of the --version floor\n\n",
+           STARTUP_OVERHEAD_TARGET_MS);
+    printf("%-28s %9s %9s %9s\n", "command", "p50 ms", "p95 ms", "target");
+
+    int missed = 0;
+    double floor_ms = 0.0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int ok = 1;
+        for (int r = 0; r < runs && ok; r++) {
+            samples[r] = run_once(&cases[i]);
+            ok = samples[r] >= 0;
+        }
+        if (!ok) {
+            printf("%-28s failed\n", cases[i].label);
+            missed++;
+            continue;
+        }
+
+        qsort(samples, (size_t)runs, sizeof(double), compare_double);
+        double p50 = samples[runs / 2];
+        double p95 = samples[(runs * 95) / 100 < runs ? (runs * 95) / 100 : runs - 1];
+        const char* verdict = "-";
+        if (i == 0) floor_ms = p50;
+        if (cases[i].stateless) {
+            int met = p50 - floor_ms <= STARTUP_OVERHEAD_TARGET_MS;
+            verdict = met ? "met" : "MISSED";
+            if (!met) missed++;
+        }
+        printf("%-28s %9.2f %9.2f %9s\n", cases[i].label, p50, p95, verdict);
+    }
+
+    free(samples);
+    unlink(BENCH_VAULT_PATH);
+    unlink(BENCH_VAULT_PATH ".backup");
+    unlink(BENCH_MASTER_PATH);
+
+    if (missed > 0) printf("\n%d command(s) missed the startup target\n", missed);
+    return 0;
+}
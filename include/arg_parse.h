@@ -17,7 +17,15 @@ typedef enum {
     CMD_CHECK,
     CMD_GENERATE,
     CMD_INIT,
-    CMD_CHANGE_PASSWORD
+    CMD_CHANGE_PASSWORD,
+    CMD_IMPORT,
+    CMD_AUDIT,
+    CMD_SEARCH,
+    CMD_SHELL,
+    CMD_SERVE,
+    CMD_EXEC,
+    CMD_RENDER,
+    CMD_STATS
 } command_t;
 
 typedef struct {
@@ -25,11 +33,42 @@ typedef struct {
     char service[64];
     char username[64];
     char vault_file[128];
-    char totp_secret[128];
+    char totp_secret[512];
+    char input_file[256];
     char password[64];
     int password_length;
+    int password_max_length;
+    int count;
+    int exclude_ambiguous;
+    char charset[129];
+    char require_classes[64];
+    int passphrase;
+    int words;
+    char separator[9];
+    char capitalize[16];
+    char breach_db[256];
+    int breached;
+    int check_all;
+    char output_file[256];
+    int threads;
+    int stale_days;
+    char query[256];
+    int idle_timeout;
+    int master_fd;
+    int lock_timeout;
+    int durability;
+    int compression;
+    int serve_stdio;
+    char serve_listen[108];
+    char manifest[256];
+    int rest_argc;
+    char** rest_argv;
     int show_password;
     int verbose;
+    int timings;
+    char metrics_file[256];
+    char metrics_socket[108];
+    int metrics_interval;
 } arguments_t;
 
 int parse_arguments(int argc, char *argv[], arguments_t *args);
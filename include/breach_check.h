@@ -0,0 +1,71 @@
+#ifndef BREACH_CHECK_H
+#define BREACH_CHECK_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BREACH_DB_MAGIC "SKBR"
+#define BREACH_DB_VERSION 1
+#define BREACH_DB_ENV "SECUREKEY_BREACH_DB"
+#define BREACH_DB_DEFAULT_PATH "~/.securekey/breached.db"
+
+#define BREACH_HASH_SIZE 20
+#define BREACH_MIN_PREFIX_BITS 8
+#define BREACH_MAX_PREFIX_BITS 24
+#define BREACH_TARGET_BUCKET 32
+#define BREACH_BLOOM_BLOCK_BITS 512
+#define BREACH_MAX_BLOOM_HASHES 10
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t record_count;
+    uint32_t prefix_bits;
+    uint32_t bloom_hashes;
+    uint64_t bloom_blocks;
+    uint64_t records_offset;
+    uint64_t fanout_offset;
+    uint64_t bloom_offset;
+    uint64_t reserved;
+} breach_db_header_t;
+
+typedef struct {
+    unsigned char hash[BREACH_HASH_SIZE];
+    uint32_t count;
+} breach_record_t;
+
+typedef struct {
+    void* map;
+    size_t map_size;
+    const breach_db_header_t* header;
+    const breach_record_t* records;
+    const uint32_t* fanout;
+    const uint64_t* bloom;
+} breach_db_t;
+
+typedef struct {
+    int prefix_bits;
+    int bloom_bits_per_key;
+} breach_build_options_t;
+
+typedef struct {
+    uint64_t records;
+    uint64_t duplicates;
+    uint64_t skipped;
+} breach_build_stats_t;
+
+int breach_db_open(breach_db_t* db, const char* path);
+
+void breach_db_close(breach_db_t* db);
+
+int breach_db_lookup(const breach_db_t* db, const unsigned char hash[BREACH_HASH_SIZE], uint32_t* count);
+
+int breach_db_check_password(const breach_db_t* db, const char* password, uint32_t* count);
+
+const char* breach_db_default_path(void);
+
+int breach_db_build(FILE* input, const char* out_path, const breach_build_options_t* options,
+                    breach_build_stats_t* stats);
+
+#endif
@@ -4,6 +4,8 @@
 #include <stddef.h>
 
 #define KEY_LEN 32
+#define KDF_NAME "PBKDF2-HMAC-SHA256"
+#define KDF_ITERATIONS 100000
 
 int crypto_init(void);
 
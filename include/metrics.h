@@ -0,0 +1,89 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "timings.h"
+
+#define METRICS_DEFAULT_INTERVAL_SEC 15
+
+/* Latency histograms. Every timings phase also gets one, starting at METRIC_PHASE_FIRST. */
+typedef enum {
+    METRIC_REQUEST_GET,
+    METRIC_REQUEST_LIST,
+    METRIC_REQUEST_SEARCH,
+    METRIC_REQUEST_STORE,
+    METRIC_REQUEST_REMOVE,
+    METRIC_REQUEST_TOTP,
+    METRIC_REQUEST_OTHER,
+    METRIC_SAVE,
+    METRIC_PHASE_FIRST,
+    METRIC_HISTOGRAM_COUNT = METRIC_PHASE_FIRST + TIMING_PHASE_COUNT
+} metric_histogram_t;
+
+/* Counters. The timings counters are mirrored starting at METRIC_TIMING_COUNTER_FIRST. */
+typedef enum {
+    METRIC_REQUEST_ERRORS,
+    METRIC_LOOKUP_HITS,
+    METRIC_LOOKUP_MISSES,
+    METRIC_SAVE_ERRORS,
+    METRIC_RELOADS,
+    METRIC_TIMING_COUNTER_FIRST,
+    METRIC_COUNTER_COUNT = METRIC_TIMING_COUNTER_FIRST + TIMING_COUNTER_COUNT
+} metric_counter_t;
+
+typedef enum {
+    METRIC_RESIDENT_SECRET_BYTES,
+    METRIC_GAUGE_COUNT
+} metric_gauge_t;
+
+/*
+ * Counters and histograms live in a block owned by the recording thread, so
+ * recording never contends; an export sums the blocks. While metrics are off
+ * each macro costs one relaxed load, and building with -DSECUREKEY_NO_METRICS
+ * (make NO_METRICS=1) removes them. Gauges are always kept.
+ */
+#ifdef SECUREKEY_NO_METRICS
+#define METRIC_START(name) do { } while (0)
+#define METRIC_OBSERVE(name, histogram) do { } while (0)
+#define METRIC_COUNT(counter, n) do { } while (0)
+#else
+#define METRIC_START(name) uint64_t name = metrics_now()
+#define METRIC_OBSERVE(name, histogram) metrics_observe((histogram), (name))
+#define METRIC_COUNT(counter, n) metrics_count((counter), (uint64_t)(n))
+#endif
+
+void metrics_enable(bool enabled);
+
+bool metrics_enabled(void);
+
+uint64_t metrics_now(void);
+
+void metrics_observe(metric_histogram_t histogram, uint64_t start);
+
+void metrics_observe_ns(metric_histogram_t histogram, uint64_t ns);
+
+void metrics_count(metric_counter_t counter, uint64_t amount);
+
+void metrics_gauge_add(metric_gauge_t gauge, int64_t amount);
+
+uint64_t metrics_counter(metric_counter_t counter);
+
+int64_t metrics_gauge(metric_gauge_t gauge);
+
+uint64_t metrics_histogram_count(metric_histogram_t histogram);
+
+uint64_t metrics_histogram_quantile_ns(metric_histogram_t histogram, double quantile);
+
+void metrics_reset(void);
+
+int metrics_write(FILE* out);
+
+int metrics_write_textfile(const char* path);
+
+int metrics_start_exporter(const char* textfile, const char* socket_path, int interval_sec);
+
+void metrics_stop_exporter(void);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef OTPAUTH_H
+#define OTPAUTH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "totp_engine.h"
+#include "vault_controller.h"
+
+#define OTPAUTH_SCHEME "otpauth://"
+
+typedef struct {
+    otp_type_t type;
+    char issuer[VAULT_SERVICE_LEN];
+    char account[VAULT_USERNAME_LEN];
+    char secret[VAULT_TOTP_LEN];
+    totp_algorithm_t algorithm;
+    int digits;
+    uint32_t period;
+    uint64_t counter;
+} otpauth_uri_t;
+
+typedef struct {
+    size_t imported;
+    size_t updated;
+    size_t failed;
+} otpauth_import_stats_t;
+
+int otpauth_parse(const char* uri, otpauth_uri_t* out);
+
+int otpauth_to_entry(const otpauth_uri_t* uri, VaultEntry* entry);
+
+int otpauth_import_stream(FILE* input, otpauth_import_stats_t* stats);
+
+int otpauth_import_file(const char* path, otpauth_import_stats_t* stats);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef PASSPHRASE_H
+#define PASSPHRASE_H
+
+#include <stddef.h>
+#include "password_gen.h"
+
+#define PASSPHRASE_MIN_WORDS 3
+#define PASSPHRASE_MAX_WORDS 20
+#define PASSPHRASE_DEFAULT_WORDS 6
+#define PASSPHRASE_MAX_WORD_LEN 9
+#define PASSPHRASE_MAX_SEPARATOR 8
+#define PASSPHRASE_DEFAULT_SEPARATOR "-"
+#define PASSPHRASE_MAX_LENGTH (PASSPHRASE_MAX_WORDS * (PASSPHRASE_MAX_WORD_LEN + PASSPHRASE_MAX_SEPARATOR))
+
+typedef enum {
+    PASSPHRASE_CAPS_NONE,
+    PASSPHRASE_CAPS_FIRST,
+    PASSPHRASE_CAPS_ALL,
+    PASSPHRASE_CAPS_RANDOM
+} passphrase_caps_t;
+
+typedef struct {
+    int words;
+    char separator[PASSPHRASE_MAX_SEPARATOR + 1];
+    passphrase_caps_t capitalize;
+} passphrase_policy_t;
+
+typedef struct {
+    passphrase_policy_t policy;
+    size_t separator_len;
+    random_pool_t pool;
+} passphrase_generator_t;
+
+void passphrase_policy_default(passphrase_policy_t* policy);
+
+int passphrase_parse_capitalize(const char* spec, passphrase_caps_t* caps);
+
+size_t passphrase_wordlist_size(void);
+
+const char* passphrase_word(size_t index);
+
+double passphrase_entropy_bits(const passphrase_policy_t* policy);
+
+int passphrase_generator_init(passphrase_generator_t* gen, const passphrase_policy_t* policy);
+
+int passphrase_generator_next(passphrase_generator_t* gen, char* output, size_t output_len);
+
+void passphrase_generator_cleanup(passphrase_generator_t* gen);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef PASSWORD_GEN_H
+#define PASSWORD_GEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PWGEN_CLASS_LOWER  0x01u
+#define PWGEN_CLASS_UPPER  0x02u
+#define PWGEN_CLASS_DIGIT  0x04u
+#define PWGEN_CLASS_SYMBOL 0x08u
+#define PWGEN_CLASS_ALL    0x0Fu
+
+#define PWGEN_MIN_LENGTH 4
+#define PWGEN_MAX_LENGTH 255
+#define PWGEN_MAX_ALPHABET 128
+#define PWGEN_POOL_SIZE 4096
+
+#define PWGEN_AMBIGUOUS_CHARS "Il1O0o|"
+
+typedef struct {
+    int min_length;
+    int max_length;
+    unsigned int required_classes;
+    int exclude_ambiguous;
+    char alphabet[PWGEN_MAX_ALPHABET + 1];
+} password_policy_t;
+
+typedef struct {
+    unsigned char bytes[PWGEN_POOL_SIZE];
+    size_t pos;
+} random_pool_t;
+
+typedef struct {
+    password_policy_t policy;
+    char charset[PWGEN_MAX_ALPHABET + 1];
+    size_t charset_len;
+    unsigned int available_classes;
+    random_pool_t pool;
+} password_generator_t;
+
+void password_policy_default(password_policy_t* policy, int length);
+
+int password_policy_parse_classes(const char* spec, unsigned int* classes);
+
+void random_pool_init(random_pool_t* pool);
+
+int random_pool_uniform(random_pool_t* pool, uint32_t bound, uint32_t* value);
+
+void random_pool_cleanup(random_pool_t* pool);
+
+int password_generator_init(password_generator_t* gen, const password_policy_t* policy);
+
+int password_generator_next(password_generator_t* gen, char* output, size_t output_len);
+
+void password_generator_cleanup(password_generator_t* gen);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "vault_controller.h"
+#include "vault_refs.h"
+
+#define RENDER_TAG_MAX 1024
+#define RENDER_MAX_REFS 65536
+#define RENDER_MAX_THREADS 64
+#define RENDER_SUFFIX ".tmpl"
+
+#define RENDER_OK 0
+#define RENDER_ERR_IO -1
+#define RENDER_ERR_SYNTAX -2
+#define RENDER_ERR_MISSING -3
+#define RENDER_ERR_LIMIT -4
+
+typedef struct {
+    char service[VAULT_SERVICE_LEN];
+    char username[VAULT_USERNAME_LEN];
+    vault_ref_t ref;
+    char value[VAULT_PASSWORD_LEN];
+    int value_len;
+    size_t source;
+    size_t line;
+} render_ref_t;
+
+typedef struct {
+    render_ref_t* refs;
+    size_t count;
+    size_t capacity;
+} render_refs_t;
+
+typedef struct {
+    const char* input;
+    char output[512];
+    size_t substitutions;
+    size_t error_line;
+    int status;
+} render_job_t;
+
+int render_scan(FILE* in, size_t source, render_refs_t* refs, size_t* error_line);
+
+int render_refs_resolve(render_refs_t* refs, size_t* missing);
+
+int render_stream(FILE* in, FILE* out, const render_refs_t* refs,
+                  size_t* substitutions, size_t* error_line);
+
+void render_refs_free(render_refs_t* refs);
+
+int render_output_path(const char* input, char* output, size_t output_len);
+
+int render_files(render_job_t* jobs, size_t count, int threads);
+
+const char* render_strerror(int status);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SECRET_EXEC_H
+#define SECRET_EXEC_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "vault_controller.h"
+#include "vault_refs.h"
+
+#define EXEC_NAME_MAX 128
+#define EXEC_MAX_BINDINGS 4096
+
+typedef struct {
+    char name[EXEC_NAME_MAX];
+    char service[VAULT_SERVICE_LEN];
+    char username[VAULT_USERNAME_LEN];
+    vault_ref_t ref;
+    size_t line;
+} exec_binding_t;
+
+typedef struct {
+    exec_binding_t* bindings;
+    size_t count;
+    size_t capacity;
+} exec_manifest_t;
+
+int exec_manifest_parse(FILE* fp, exec_manifest_t* manifest, size_t* error_line);
+
+int exec_manifest_load(const char* path, exec_manifest_t* manifest, size_t* error_line);
+
+void exec_manifest_free(exec_manifest_t* manifest);
+
+int exec_manifest_resolve(exec_manifest_t* manifest, size_t* missing_line);
+
+char** exec_build_environment(const exec_manifest_t* manifest, char* const* base_env);
+
+void exec_free_environment(char** env);
+
+int exec_command(const exec_manifest_t* manifest, char* const argv[]);
+
+#endif
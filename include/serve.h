@@ -0,0 +1,32 @@
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define SERVE_PROTOCOL_VERSION 1
+#define SERVE_MAX_LINE 65536
+#define SERVE_MAX_FIELDS 16
+#define SERVE_MAX_CONNECTIONS 256
+
+#define SERVE_CONTINUE 0
+#define SERVE_QUIT 1
+
+typedef struct {
+    size_t requests;
+    size_t errors;
+    size_t commits;
+    size_t connections;
+} serve_stats_t;
+
+void serve_write_greeting(FILE* out);
+
+int serve_handle_request(char* line, size_t len, FILE* out, serve_stats_t* stats);
+
+int serve_stdio(int in_fd, FILE* out, serve_stats_t* stats);
+
+int serve_socket(const char* path, serve_stats_t* stats);
+
+void serve_stop(void);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SERVE_LOAD_H
+#define SERVE_LOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOAD_DEFAULT_MIX "get=80,list=2,store=10,totp=8"
+
+/*
+ * Latency buckets: 64 linear sub-buckets per power of two, so a percentile
+ * is off by at most 1.6%. Values are capped at 2^36 ns (about 68 s).
+ */
+#define LATENCY_SUB_BITS 6
+#define LATENCY_SUB_BUCKETS (1u << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS 36
+#define LATENCY_BUCKETS ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+typedef enum {
+    LOAD_OP_GET,
+    LOAD_OP_LIST,
+    LOAD_OP_STORE,
+    LOAD_OP_TOTP,
+    LOAD_OP_COUNT
+} load_op_t;
+
+typedef struct {
+    uint32_t weights[LOAD_OP_COUNT];
+    uint32_t total;
+} load_mix_t;
+
+typedef struct {
+    uint64_t counts[LATENCY_BUCKETS];
+    uint64_t total;
+    uint64_t max_ns;
+} latency_histogram_t;
+
+const char* load_op_name(load_op_t op);
+
+int load_mix_parse(const char* text, load_mix_t* mix);
+
+load_op_t load_mix_pick(const load_mix_t* mix, uint64_t random);
+
+void latency_record(latency_histogram_t* histogram, uint64_t ns);
+
+void latency_merge(latency_histogram_t* into, const latency_histogram_t* from);
+
+uint64_t latency_percentile(const latency_histogram_t* histogram, double percentile);
+
+const char* load_json_string(const char* from, const char* end, const char* key,
+                             const char** value_end);
+
+#endif
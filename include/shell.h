@@ -0,0 +1,41 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define SHELL_LINE_MAX 1024
+#define SHELL_MAX_ARGS 16
+#define SHELL_HISTORY_SIZE 64
+#define SHELL_DEFAULT_IDLE_TIMEOUT 300
+#define SHELL_REDACTED "********"
+
+#define SHELL_OK 0
+#define SHELL_ERROR 1
+#define SHELL_EXIT 2
+
+typedef struct {
+    char vault_path[512];
+    int interactive;
+    int idle_timeout;
+    int locked;
+    size_t line_number;
+    char history[SHELL_HISTORY_SIZE][SHELL_LINE_MAX];
+    size_t history_count;
+} shell_session_t;
+
+void shell_session_init(shell_session_t* session, const char* vault_path, int interactive, int idle_timeout);
+
+void shell_session_cleanup(shell_session_t* session);
+
+int shell_tokenize(char* line, char** argv, int max_args);
+
+void shell_history_add(shell_session_t* session, int argc, char** argv);
+
+const char* shell_history_get(const shell_session_t* session, size_t index);
+
+int shell_execute(shell_session_t* session, char* line);
+
+int shell_run(shell_session_t* session, FILE* in);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef STRENGTH_H
+#define STRENGTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STRENGTH_DICT_MAGIC "SKDT"
+#define STRENGTH_DICT_VERSION 1
+#define STRENGTH_DICT_FILENAME "securekey.dict"
+#define STRENGTH_DICT_ENV "SECUREKEY_DICT"
+#define STRENGTH_MAX_DICTS 8
+#define STRENGTH_DICT_NAME_LEN 16
+#define STRENGTH_MAX_LENGTH 256
+#define STRENGTH_MAX_SEQUENCE 32
+
+typedef enum {
+    MATCH_BRUTEFORCE = 0,
+    MATCH_DICTIONARY,
+    MATCH_REPEAT,
+    MATCH_SEQUENCE,
+    MATCH_YEAR
+} match_pattern_t;
+
+typedef struct {
+    match_pattern_t pattern;
+    size_t i;
+    size_t j;
+    double guesses_log10;
+    uint32_t rank;
+    int dict;
+    int l33t;
+    int reversed;
+} strength_match_t;
+
+typedef struct {
+    double guesses_log10;
+    double entropy_bits;
+    int score;
+    size_t match_count;
+    strength_match_t sequence[STRENGTH_MAX_SEQUENCE];
+} strength_result_t;
+
+int strength_estimate(const char* password, strength_result_t* result);
+
+const char* strength_score_label(int score);
+
+const char* strength_pattern_name(match_pattern_t pattern);
+
+const char* strength_dict_name(int dict);
+
+int strength_load_dictionary(const char* path);
+
+void strength_unload_dictionary(void);
+
+int strength_dictionary_loaded(void);
+
+int strength_dict_build(const char* const* list_paths, const char* const* names,
+                        size_t list_count, const char* out_path);
+
+#endif
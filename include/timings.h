@@ -0,0 +1,78 @@
+#ifndef TIMINGS_H
+#define TIMINGS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    TIMINGS_OFF,
+    TIMINGS_TEXT,
+    TIMINGS_JSON
+} timings_format_t;
+
+typedef enum {
+    TIMING_LOCK_WAIT,
+    TIMING_FILE_READ,
+    TIMING_KDF,
+    TIMING_DECRYPT,
+    TIMING_DECOMPRESS,
+    TIMING_INDEX_BUILD,
+    TIMING_BACKUP,
+    TIMING_COMPRESS,
+    TIMING_ENCRYPT,
+    TIMING_FILE_WRITE,
+    TIMING_FSYNC,
+    TIMING_RENAME,
+    TIMING_PHASE_COUNT
+} timing_phase_t;
+
+typedef enum {
+    TIMING_BYTES_READ,
+    TIMING_BYTES_WRITTEN,
+    TIMING_ENTRIES_LOADED,
+    TIMING_ENTRIES_SCANNED,
+    TIMING_COUNTER_COUNT
+} timing_counter_t;
+
+/*
+ * TIMING_START(t) ... TIMING_STOP(t, phase) adds the time in between to a
+ * phase, and to its metrics histogram when metrics are on. While both are
+ * off each macro costs two relaxed loads, and building with
+ * -DSECUREKEY_NO_TIMINGS (make NO_TIMINGS=1) removes them.
+ */
+#ifdef SECUREKEY_NO_TIMINGS
+#define TIMING_START(name) do { } while (0)
+#define TIMING_STOP(name, phase) do { } while (0)
+#define TIMING_COUNT(counter, n) do { } while (0)
+#else
+#define TIMING_START(name) uint64_t name = timings_now()
+#define TIMING_STOP(name, phase) timings_add((phase), (name))
+#define TIMING_COUNT(counter, n) timings_count((counter), (uint64_t)(n))
+#endif
+
+void timings_enable(timings_format_t format);
+
+timings_format_t timings_format(void);
+
+const char* timings_phase_name(timing_phase_t phase);
+
+const char* timings_counter_name(timing_counter_t counter);
+
+uint64_t timings_now(void);
+
+void timings_add(timing_phase_t phase, uint64_t start);
+
+void timings_count(timing_counter_t counter, uint64_t amount);
+
+void timings_reset(void);
+
+double timings_phase_ms(timing_phase_t phase);
+
+uint64_t timings_phase_calls(timing_phase_t phase);
+
+uint64_t timings_counter(timing_counter_t counter);
+
+void timings_report(FILE* out);
+
+#endif
@@ -3,12 +3,38 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <time.h>
+
+#define TOTP_DEFAULT_PERIOD 30
+#define TOTP_DEFAULT_DIGITS 6
+#define TOTP_MIN_DIGITS 6
+#define TOTP_MAX_DIGITS 8
+#define TOTP_MAX_SECRET_BYTES 128
+
+typedef enum {
+    OTP_TYPE_TOTP = 0,
+    OTP_TYPE_HOTP = 1
+} otp_type_t;
+
+typedef enum {
+    TOTP_ALG_SHA1 = 0,
+    TOTP_ALG_SHA256 = 1,
+    TOTP_ALG_SHA512 = 2
+} totp_algorithm_t;
 
 uint32_t generate_totp(const char* base32_secret);
 int generate_totp_secret(char* output, size_t output_len);
 int validate_totp(const char* base32_secret, uint32_t code);
 
+uint32_t generate_otp(const char* base32_secret, totp_algorithm_t algorithm,
+                      int digits, uint64_t counter);
+uint32_t generate_totp_at(const char* base32_secret, totp_algorithm_t algorithm,
+                          int digits, uint32_t period, time_t now);
+
+const char* totp_algorithm_name(totp_algorithm_t algorithm);
+int totp_algorithm_from_name(const char* name, totp_algorithm_t* algorithm);
+
 int base32_decode(const char* encoded, unsigned char* result, size_t buf_len);
 int base32_encode(const unsigned char* data, size_t len, char* result, size_t buf_len);
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,7 @@
 #define UTILITIES_H
 
 #include <stddef.h>
+#include <stdio.h>
 
 int check_password_strength(const char* password);
 
@@ -9,4 +10,8 @@ int generate_random_password(char* output, size_t output_len, int length);
 
 int read_password_secure(const char* prompt, char* password, size_t max_len);
 
+int read_password_fd(int fd, char* password, size_t max_len);
+
+void json_write_string(FILE* out, const char* value);
+
 #endif
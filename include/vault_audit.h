@@ -0,0 +1,66 @@
+#ifndef VAULT_AUDIT_H
+#define VAULT_AUDIT_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "breach_check.h"
+
+#define AUDIT_DEFAULT_STALE_DAYS 365
+#define AUDIT_DEFAULT_WEAK_SCORE 3
+#define AUDIT_MAX_THREADS 64
+#define AUDIT_MIN_ENTRIES_PER_THREAD 256
+
+#define AUDIT_FLAG_REUSED   0x01u
+#define AUDIT_FLAG_WEAK     0x02u
+#define AUDIT_FLAG_BREACHED 0x04u
+#define AUDIT_FLAG_NO_TOTP  0x08u
+#define AUDIT_FLAG_STALE    0x10u
+#define AUDIT_FLAG_OTP_ONLY 0x20u
+
+typedef struct {
+    int threads;
+    int stale_days;
+    int weak_score;
+    const breach_db_t* breach_db;
+    time_t now;
+} audit_options_t;
+
+typedef struct {
+    unsigned int flags;
+    int score;
+    double guesses_log10;
+    uint32_t breach_count;
+    size_t reuse_group;
+    size_t reuse_count;
+    int64_t age_days;
+} audit_entry_result_t;
+
+typedef struct {
+    size_t total;
+    size_t reused;
+    size_t reuse_groups;
+    size_t weak;
+    size_t breached;
+    size_t no_totp;
+    size_t stale;
+    size_t undated;
+    size_t otp_only;
+    int threads_used;
+    int breach_checked;
+    double elapsed_seconds;
+    audit_entry_result_t* entries;
+} audit_report_t;
+
+void audit_options_default(audit_options_t* options);
+
+int vault_audit(const audit_options_t* options, audit_report_t* report);
+
+int audit_report_write_json(const audit_report_t* report, FILE* out);
+
+void audit_report_free(audit_report_t* report);
+
+const char* audit_flag_name(unsigned int flag);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef VAULT_CODEC_H
+#define VAULT_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vault_controller.h"
+
+int vault_codec_parse(const char* name, vault_codec_t* codec);
+
+const char* vault_codec_name(vault_codec_t codec);
+
+bool vault_codec_available(vault_codec_t codec);
+
+size_t vault_codec_bound(vault_codec_t codec, size_t size);
+
+int vault_codec_compress(vault_codec_t codec, const void* src, size_t size,
+                         unsigned char* dst, size_t* dst_size);
+
+int vault_codec_decompress(vault_codec_t codec, const unsigned char* src, size_t size,
+                           void* dst, size_t dst_size);
+
+#endif
@@ -6,13 +6,50 @@
 #include <stddef.h>
 
 #define VAULT_MAGIC "SKEY"
-#define VAULT_VERSION 1
+#define VAULT_VERSION 4
+#define VAULT_MIN_VERSION 1
 #define VAULT_DEFAULT_PATH "~/.securekey/vault.dat"
 
 #define VAULT_SERVICE_LEN 256
 #define VAULT_USERNAME_LEN 256
 #define VAULT_PASSWORD_LEN 256
-#define VAULT_TOTP_LEN 64
+#define VAULT_TOTP_LEN 128
+
+#define VAULT_INDEX_MIN_SLOTS 64
+
+#define VAULT_OPEN_READ_ONLY 0x01u
+#define VAULT_LOCK_SUFFIX ".lock"
+#define VAULT_LOCK_TIMEOUT_MS 10000
+
+#define VAULT_GROUP_COMMIT_MAX 64
+#define VAULT_GROUP_COMMIT_WINDOW_MS 20
+#define VAULT_SAVER_DELAY_MS 50
+
+#define VAULT_MAX_SHARDS 256
+#define VAULT_MANIFEST_NAME "manifest"
+#define VAULT_SHARD_PREFIX "shard-"
+
+typedef enum {
+    VAULT_DURABILITY_NONE,
+    VAULT_DURABILITY_FSYNC,
+    VAULT_DURABILITY_GROUP
+} vault_durability_t;
+
+typedef enum {
+    VAULT_CODEC_NONE,
+    VAULT_CODEC_ZLIB,
+    VAULT_CODEC_ZLIB_DICT,
+    VAULT_CODEC_ZSTD,
+    VAULT_CODEC_ZSTD_DICT
+} vault_codec_t;
+
+typedef enum {
+    VAULT_SAVE_TEMP_CREATED,
+    VAULT_SAVE_HEADER_WRITTEN,
+    VAULT_SAVE_BODY_WRITTEN,
+    VAULT_SAVE_SYNCED,
+    VAULT_SAVE_RENAMED
+} vault_save_stage_t;
 
 #define SALT_SIZE 16
 #define IV_SIZE 16
@@ -23,6 +60,13 @@ typedef struct {
     char username[VAULT_USERNAME_LEN]; 
     char password[VAULT_PASSWORD_LEN]; 
     char totp_secret[VAULT_TOTP_LEN];   
+    uint64_t totp_counter;
+    uint32_t totp_period;
+    uint8_t totp_type;
+    uint8_t totp_algorithm;
+    uint8_t totp_digits;
+    uint8_t reserved;
+    uint64_t password_updated_at;
 } VaultEntry;
 
 typedef struct {
@@ -30,31 +74,82 @@ typedef struct {
     uint32_t version;           
     unsigned char salt[SALT_SIZE];  
     uint32_t entry_count;      
+    uint32_t codec;
+    uint32_t payload_size;
 } VaultHeader;
 
+/* Phases of vault_handle_open(). Reading overlaps the key derivation. */
+typedef struct {
+    double read_ms;
+    double kdf_ms;
+    double decrypt_ms;
+    double total_ms;
+} vault_open_timings_t;
+
+/* On-disk footprint of an open vault. */
 typedef struct {
-    char vault_path[512];          
-    unsigned char key[32];          
-    VaultHeader header;           
-    VaultEntry* entries;           
-    bool is_open;                  
-    bool auto_backup;               
-} VaultState;
+    uint32_t shards;
+    uint32_t version;
+    vault_codec_t codec;
+    uint64_t file_bytes;
+    uint64_t ciphertext_bytes;
+    uint64_t backup_bytes;
+} vault_layout_t;
+
+typedef struct VaultState vault_handle_t;
+typedef struct VaultSnapshot vault_snapshot_t;
+
+typedef void (*vault_save_error_fn)(vault_handle_t* vault, int error, void* context);
+typedef void (*vault_reload_fn)(vault_handle_t* vault, void* context);
 
 
 int vault_init(const char* master_password, const char* vault_path);
 
+int vault_open(const char* master_password, const char* vault_path, unsigned int flags);
+
+void vault_set_lock_timeout(int timeout_ms);
+
+bool vault_is_read_only(void);
+
+int vault_set_durability(vault_durability_t mode);
+
+int vault_parse_durability(const char* name, vault_durability_t* mode);
+
+int vault_set_compression(vault_codec_t codec);
+
+int vault_sync(void);
+
+int vault_start_saver(int delay_ms, vault_save_error_fn on_error, void* context);
+
+int vault_flush(void);
+
+int vault_reload(void);
+
+int vault_watch(vault_reload_fn on_reload, void* context);
+
+void vault_set_save_hook(void (*hook)(vault_save_stage_t stage));
+
 int vault_store(const char* service, const char* username,
                 const char* password, const char* totp_secret, bool force);
 
 
+int vault_put_entry(const VaultEntry* entry);
+
+int vault_begin_batch(void);
+
+int vault_commit_batch(void);
+
 int vault_get(const char* service, const char* username, VaultEntry* entry);
 
+int vault_get_entry_at(size_t index, VaultEntry* entry);
+
 
 int vault_list(void);
 
 int vault_remove(const char* service, const char* username);
 
+int vault_remove_entry_at(size_t index);
+
 void vault_cleanup(void);
 
 int vault_change_master_password(const char* old_password,
@@ -72,6 +167,93 @@ size_t vault_entry_count(void);
 
 int vault_find_entry(const char* service, const char* username);
 
+size_t vault_search(const char* query, size_t* matches, size_t max_matches);
+
+uint32_t vault_entry_otp(const VaultEntry* entry);
+
+int vault_issue_otp(const char* service, const char* username, uint32_t* code, uint64_t* counter);
+
+vault_handle_t* vault_handle_open(const char* master_password, const char* vault_path,
+                                  unsigned int flags);
+
+void vault_handle_close(vault_handle_t* vault);
+
+bool vault_handle_is_read_only(const vault_handle_t* vault);
+
+int vault_handle_sync(vault_handle_t* vault);
+
+int vault_handle_start_saver(vault_handle_t* vault, int delay_ms, vault_save_error_fn on_error,
+                             void* context);
+
+int vault_handle_flush(vault_handle_t* vault);
+
+int vault_handle_reload(vault_handle_t* vault);
+
+int vault_handle_watch(vault_handle_t* vault, vault_reload_fn on_reload, void* context);
+
+uint64_t vault_handle_generation(vault_handle_t* vault);
+
+uint32_t vault_handle_shard_count(const vault_handle_t* vault);
+
+vault_codec_t vault_handle_compression(const vault_handle_t* vault);
+
+void vault_handle_open_timings(const vault_handle_t* vault, vault_open_timings_t* timings);
+
+int vault_handle_layout(vault_handle_t* vault, vault_layout_t* layout);
+
+int vault_create_sharded(const char* vault_dir, uint32_t shards);
+
+int vault_reshard(const char* master_password, const char* source, const char* destination,
+                  uint32_t shards);
+
+int vault_handle_store(vault_handle_t* vault, const char* service, const char* username,
+                       const char* password, const char* totp_secret, bool force);
+
+int vault_handle_put_entry(vault_handle_t* vault, const VaultEntry* entry);
+
+int vault_handle_begin_batch(vault_handle_t* vault);
+
+int vault_handle_commit_batch(vault_handle_t* vault);
+
+int vault_handle_get(vault_handle_t* vault, const char* service, const char* username,
+                     VaultEntry* entry);
+
+int vault_handle_get_entry_at(vault_handle_t* vault, size_t index, VaultEntry* entry);
+
+int vault_handle_issue_otp(vault_handle_t* vault, const char* service, const char* username,
+                           uint32_t* code, uint64_t* counter);
+
+int vault_handle_list(vault_handle_t* vault);
+
+int vault_handle_remove(vault_handle_t* vault, const char* service, const char* username);
+
+int vault_handle_remove_entry_at(vault_handle_t* vault, size_t index);
+
+int vault_handle_change_master_password(vault_handle_t* vault, const char* old_password,
+                                        const char* new_password);
+
+size_t vault_handle_entry_count(vault_handle_t* vault);
+
+int vault_handle_find_entry(vault_handle_t* vault, const char* service, const char* username);
+
+size_t vault_handle_search(vault_handle_t* vault, const char* query, size_t* matches,
+                          size_t max_matches);
+
+const vault_snapshot_t* vault_snapshot_acquire(vault_handle_t* vault);
+
+void vault_snapshot_release(vault_handle_t* vault, const vault_snapshot_t* snapshot);
+
+size_t vault_snapshot_count(const vault_snapshot_t* snapshot);
+
+const VaultEntry* vault_snapshot_entry(const vault_snapshot_t* snapshot, size_t index);
+
+int vault_snapshot_find(const vault_snapshot_t* snapshot, const char* service,
+                        const char* username);
+
+size_t vault_handle_retired_snapshots(vault_handle_t* vault);
+
+vault_handle_t* vault_default_handle(void);
+
 const char* vault_get_default_path(void);
 int vault_ensure_directory(void);
 
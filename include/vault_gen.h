@@ -0,0 +1,33 @@
+#ifndef VAULT_GEN_H
+#define VAULT_GEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "vault_controller.h"
+
+#define VAULT_GEN_DEFAULT_SEED 1
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+} vault_gen_range_t;
+
+/* Field lengths are drawn uniformly from each range. */
+typedef struct {
+    uint64_t seed;
+    vault_gen_range_t service_len;
+    vault_gen_range_t username_len;
+    vault_gen_range_t password_len;
+    uint32_t totp_percent;
+} vault_gen_config_t;
+
+void vault_gen_defaults(vault_gen_config_t* config);
+
+int vault_gen_parse_range(const char* text, uint32_t limit, vault_gen_range_t* range);
+
+void vault_gen_entry(const vault_gen_config_t* config, size_t index, VaultEntry* entry);
+
+int vault_gen_fill(vault_handle_t* vault, const vault_gen_config_t* config, size_t first,
+                   size_t count);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef VAULT_REFS_H
+#define VAULT_REFS_H
+
+#include <stddef.h>
+
+typedef enum {
+    REF_FIELD_PASSWORD,
+    REF_FIELD_USERNAME,
+    REF_FIELD_SERVICE,
+    REF_FIELD_TOTP,
+    REF_FIELD_TOTP_SECRET
+} ref_field_t;
+
+typedef struct {
+    const char* service;
+    const char* username;
+    ref_field_t field;
+    int entry_index;
+} vault_ref_t;
+
+int vault_ref_parse_field(const char* name, ref_field_t* field);
+
+const char* vault_ref_field_name(ref_field_t field);
+
+int vault_ref_value(const vault_ref_t* ref, char* out, size_t out_len);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef VAULT_STATS_H
+#define VAULT_STATS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vault_controller.h"
+
+typedef enum {
+    STATS_FIELD_SERVICE,
+    STATS_FIELD_USERNAME,
+    STATS_FIELD_PASSWORD,
+    STATS_FIELD_TOTP,
+    STATS_FIELD_COUNT
+} stats_field_t;
+
+/* Length buckets: 0, 1-8, 9-16, 17-32, 33-64, 65-128, 129+. */
+#define STATS_LENGTH_BUCKETS 7
+
+typedef struct {
+    size_t counts[STATS_LENGTH_BUCKETS];
+    size_t max_length;
+    uint64_t total_length;
+} stats_histogram_t;
+
+typedef struct {
+    size_t entries;
+    size_t totp_entries;
+    stats_histogram_t fields[STATS_FIELD_COUNT];
+    uint64_t useful_bytes;
+    uint64_t allocated_bytes;
+    vault_layout_t layout;
+    vault_open_timings_t unlock;
+    const char* kdf_name;
+    uint32_t kdf_iterations;
+} vault_stats_t;
+
+int vault_stats_collect(vault_handle_t* vault, vault_stats_t* stats);
+
+void vault_stats_print(const vault_stats_t* stats, FILE* out);
+
+int vault_stats_write_json(const vault_stats_t* stats, FILE* out);
+
+const char* stats_field_name(stats_field_t field);
+
+const char* stats_bucket_label(int bucket);
+
+#endif
@@ -1,4 +1,8 @@
 #include "arg_parse.h"
+#include "vault_controller.h"
+#include "vault_codec.h"
+#include "timings.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -13,10 +17,41 @@ int parse_arguments(int argc, char *argv[], arguments_t *args) {
     args->username[0] = '\0';
     strcpy(args->vault_file, "securekey.vault");
     args->totp_secret[0] = '\0';
+    args->input_file[0] = '\0';
     args->password[0] = '\0';
     args->password_length = 16;
+    args->password_max_length = 16;
+    args->count = 0;
+    args->exclude_ambiguous = 0;
+    args->charset[0] = '\0';
+    args->require_classes[0] = '\0';
+    args->passphrase = 0;
+    args->words = 6;
+    strcpy(args->separator, "-");
+    strcpy(args->capitalize, "none");
+    args->breach_db[0] = '\0';
+    args->breached = 0;
+    args->check_all = 0;
+    args->output_file[0] = '\0';
+    args->threads = 0;
+    args->stale_days = 365;
+    args->query[0] = '\0';
+    args->idle_timeout = 300;
+    args->master_fd = -1;
+    args->lock_timeout = 10;
+    args->durability = VAULT_DURABILITY_FSYNC;
+    args->compression = -1;
+    args->serve_stdio = 0;
+    args->serve_listen[0] = '\0';
+    args->manifest[0] = '\0';
+    args->rest_argc = 0;
+    args->rest_argv = NULL;
     args->show_password = 0;
     args->verbose = 0;
+    args->timings = TIMINGS_OFF;
+    args->metrics_file[0] = '\0';
+    args->metrics_socket[0] = '\0';
+    args->metrics_interval = METRICS_DEFAULT_INTERVAL_SEC;
     
     if (strcmp(argv[1], "store") == 0 || strcmp(argv[1], "add") == 0) {
         args->command = CMD_STORE;
@@ -36,6 +71,22 @@ int parse_arguments(int argc, char *argv[], arguments_t *args) {
         args->command = CMD_INIT;
     } else if (strcmp(argv[1], "change-password") == 0 || strcmp(argv[1], "passwd") == 0) {
         args->command = CMD_CHANGE_PASSWORD;
+    } else if (strcmp(argv[1], "import") == 0) {
+        args->command = CMD_IMPORT;
+    } else if (strcmp(argv[1], "audit") == 0) {
+        args->command = CMD_AUDIT;
+    } else if (strcmp(argv[1], "search") == 0 || strcmp(argv[1], "find") == 0) {
+        args->command = CMD_SEARCH;
+    } else if (strcmp(argv[1], "shell") == 0) {
+        args->command = CMD_SHELL;
+    } else if (strcmp(argv[1], "serve") == 0) {
+        args->command = CMD_SERVE;
+    } else if (strcmp(argv[1], "exec") == 0) {
+        args->command = CMD_EXEC;
+    } else if (strcmp(argv[1], "render") == 0) {
+        args->command = CMD_RENDER;
+    } else if (strcmp(argv[1], "stats") == 0) {
+        args->command = CMD_STATS;
     } else if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
         print_usage(argv[0]);
         exit(0);
@@ -74,12 +125,26 @@ int parse_arguments(int argc, char *argv[], arguments_t *args) {
             }
         } else if (strcmp(argv[i], "--secret") == 0) {
             if (i + 1 < argc) {
-                strncpy(args->totp_secret, argv[++i], sizeof(args->totp_secret) - 1);
-                args->totp_secret[sizeof(args->totp_secret) - 1] = '\0';
+                if (strlen(argv[++i]) >= sizeof(args->totp_secret)) {
+                    fprintf(stderr, "Error: --secret value is too long\n");
+                    return -1;
+                }
+                strcpy(args->totp_secret, argv[i]);
             } else {
                 fprintf(stderr, "Error: --secret requires a value\n");
                 return -1;
             }
+        } else if (strcmp(argv[i], "--file") == 0 || strcmp(argv[i], "-f") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->input_file)) {
+                    fprintf(stderr, "Error: --file path is too long\n");
+                    return -1;
+                }
+                strcpy(args->input_file, argv[i]);
+            } else {
+                fprintf(stderr, "Error: --file requires a value\n");
+                return -1;
+            }
         } else if (strcmp(argv[i], "--password") == 0 || strcmp(argv[i], "-p") == 0) {
             if (i + 1 < argc) {
                 strncpy(args->password, argv[++i], sizeof(args->password) - 1);
@@ -90,8 +155,12 @@ int parse_arguments(int argc, char *argv[], arguments_t *args) {
             }
         } else if (strcmp(argv[i], "--length") == 0 || strcmp(argv[i], "-l") == 0) {
             if (i + 1 < argc) {
-                args->password_length = atoi(argv[++i]);
-                if (args->password_length < 8 || args->password_length > 64) {
+                const char* value = argv[++i];
+                const char* dash = strchr(value, '-');
+                args->password_length = atoi(value);
+                args->password_max_length = dash ? atoi(dash + 1) : args->password_length;
+                if (args->password_length < 8 || args->password_max_length > 64 ||
+                    args->password_length > args->password_max_length) {
                     fprintf(stderr, "Error: Password length must be between 8 and 64\n");
                     return -1;
                 }
@@ -99,10 +168,276 @@ int parse_arguments(int argc, char *argv[], arguments_t *args) {
                 fprintf(stderr, "Error: --length requires a value\n");
                 return -1;
             }
+        } else if (strcmp(argv[i], "--count") == 0 || strcmp(argv[i], "-n") == 0) {
+            if (i + 1 < argc) {
+                args->count = atoi(argv[++i]);
+                if (args->count < 1 || args->count > 10000000) {
+                    fprintf(stderr, "Error: Count must be between 1 and 10000000\n");
+                    return -1;
+                }
+            } else {
+                fprintf(stderr, "Error: --count requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--charset") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->charset)) {
+                    fprintf(stderr, "Error: --charset value is too long\n");
+                    return -1;
+                }
+                strcpy(args->charset, argv[i]);
+            } else {
+                fprintf(stderr, "Error: --charset requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--require") == 0) {
+            if (i + 1 < argc) {
+                strncpy(args->require_classes, argv[++i], sizeof(args->require_classes) - 1);
+                args->require_classes[sizeof(args->require_classes) - 1] = '\0';
+            } else {
+                fprintf(stderr, "Error: --require requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--passphrase") == 0) {
+            args->passphrase = 1;
+        } else if (strcmp(argv[i], "--words") == 0) {
+            if (i + 1 < argc) {
+                args->words = atoi(argv[++i]);
+                if (args->words < 3 || args->words > 20) {
+                    fprintf(stderr, "Error: Word count must be between 3 and 20\n");
+                    return -1;
+                }
+                args->passphrase = 1;
+            } else {
+                fprintf(stderr, "Error: --words requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--separator") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->separator)) {
+                    fprintf(stderr, "Error: --separator is too long (max 8 characters)\n");
+                    return -1;
+                }
+                strcpy(args->separator, argv[i]);
+                args->passphrase = 1;
+            } else {
+                fprintf(stderr, "Error: --separator requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--capitalize") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->capitalize)) {
+                    fprintf(stderr, "Error: Invalid --capitalize mode\n");
+                    return -1;
+                }
+                strcpy(args->capitalize, argv[i]);
+                args->passphrase = 1;
+            } else {
+                fprintf(stderr, "Error: --capitalize requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--breach-db") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->breach_db)) {
+                    fprintf(stderr, "Error: --breach-db path is too long\n");
+                    return -1;
+                }
+                strcpy(args->breach_db, argv[i]);
+                args->breached = 1;
+            } else {
+                fprintf(stderr, "Error: --breach-db requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--breached") == 0) {
+            args->breached = 1;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->output_file)) {
+                    fprintf(stderr, "Error: --json path is too long\n");
+                    return -1;
+                }
+                strcpy(args->output_file, argv[i]);
+            } else {
+                fprintf(stderr, "Error: --json requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--metrics-file") == 0 ||
+                   strcmp(argv[i], "--metrics-socket") == 0) {
+            int is_file = argv[i][10] == 'f';
+            char* target = is_file ? args->metrics_file : args->metrics_socket;
+            size_t size = is_file ? sizeof(args->metrics_file) : sizeof(args->metrics_socket);
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= size) {
+                    fprintf(stderr, "Error: %s path is too long\n", argv[i - 1]);
+                    return -1;
+                }
+                strcpy(target, argv[i]);
+            } else {
+                fprintf(stderr, "Error: %s requires a value\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--metrics-interval") == 0) {
+            if (i + 1 < argc) {
+                args->metrics_interval = atoi(argv[++i]);
+                if (args->metrics_interval <= 0) {
+                    fprintf(stderr, "Error: --metrics-interval must be positive\n");
+                    return -1;
+                }
+            } else {
+                fprintf(stderr, "Error: --metrics-interval requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            if (i + 1 < argc) {
+                args->threads = atoi(argv[++i]);
+                if (args->threads < 1 || args->threads > 64) {
+                    fprintf(stderr, "Error: Threads must be between 1 and 64\n");
+                    return -1;
+                }
+            } else {
+                fprintf(stderr, "Error: --threads requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--stale-days") == 0) {
+            if (i + 1 < argc) {
+                args->stale_days = atoi(argv[++i]);
+                if (args->stale_days < 1) {
+                    fprintf(stderr, "Error: --stale-days must be positive\n");
+                    return -1;
+                }
+            } else {
+                fprintf(stderr, "Error: --stale-days requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--query") == 0 || strcmp(argv[i], "-q") == 0) {
+            if (i + 1 < argc) {
+                strncpy(args->query, argv[++i], sizeof(args->query) - 1);
+                args->query[sizeof(args->query) - 1] = '\0';
+            } else {
+                fprintf(stderr, "Error: --query requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--idle-timeout") == 0) {
+            if (i + 1 < argc) {
+                args->idle_timeout = atoi(argv[++i]);
+                if (args->idle_timeout < 0) {
+                    fprintf(stderr, "Error: --idle-timeout cannot be negative\n");
+                    return -1;
+                }
+            } else {
+                fprintf(stderr, "Error: --idle-timeout requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--master-fd") == 0) {
+            if (i + 1 < argc) {
+                args->master_fd = atoi(argv[++i]);
+                if (args->master_fd < 0) {
+                    fprintf(stderr, "Error: Invalid --master-fd\n");
+                    return -1;
+                }
+            } else {
+                fprintf(stderr, "Error: --master-fd requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--lock-timeout") == 0) {
+            if (i + 1 < argc) {
+                args->lock_timeout = atoi(argv[++i]);
+                if (args->lock_timeout < 0) {
+                    fprintf(stderr, "Error: --lock-timeout cannot be negative\n");
+                    return -1;
+                }
+            } else {
+                fprintf(stderr, "Error: --lock-timeout requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--durability") == 0) {
+            if (i + 1 < argc) {
+                vault_durability_t mode;
+                if (vault_parse_durability(argv[++i], &mode) != 0) {
+                    fprintf(stderr, "Error: --durability must be none, fsync or group\n");
+                    return -1;
+                }
+                args->durability = (int)mode;
+            } else {
+                fprintf(stderr, "Error: --durability requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--compression") == 0) {
+            if (i + 1 < argc) {
+                vault_codec_t codec;
+                if (vault_codec_parse(argv[++i], &codec) != 0) {
+                    fprintf(stderr, "Error: --compression must be none, zlib, zlib-dict, zstd or zstd-dict\n");
+                    return -1;
+                }
+                if (!vault_codec_available(codec)) {
+                    fprintf(stderr, "Error: this build does not support %s compression\n", argv[i]);
+                    return -1;
+                }
+                args->compression = (int)codec;
+            } else {
+                fprintf(stderr, "Error: --compression requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--stdio") == 0) {
+            args->serve_stdio = 1;
+        } else if (strcmp(argv[i], "--listen") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->serve_listen)) {
+                    fprintf(stderr, "Error: --listen path is too long\n");
+                    return -1;
+                }
+                strcpy(args->serve_listen, argv[i]);
+            } else {
+                fprintf(stderr, "Error: --listen requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--manifest") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->manifest)) {
+                    fprintf(stderr, "Error: --manifest path is too long\n");
+                    return -1;
+                }
+                strcpy(args->manifest, argv[i]);
+            } else {
+                fprintf(stderr, "Error: --manifest requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--output") == 0 || strcmp(argv[i], "-o") == 0) {
+            if (i + 1 < argc) {
+                if (strlen(argv[++i]) >= sizeof(args->output_file)) {
+                    fprintf(stderr, "Error: --output path is too long\n");
+                    return -1;
+                }
+                strcpy(args->output_file, argv[i]);
+            } else {
+                fprintf(stderr, "Error: --output requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--") == 0 &&
+                   (args->command == CMD_EXEC || args->command == CMD_RENDER)) {
+            args->rest_argc = argc - i - 1;
+            args->rest_argv = &argv[i + 1];
+            break;
+        } else if (strcmp(argv[i], "--all") == 0) {
+            args->check_all = 1;
+        } else if (strcmp(argv[i], "--no-ambiguous") == 0) {
+            args->exclude_ambiguous = 1;
         } else if (strcmp(argv[i], "--show") == 0) {
             args->show_password = 1;
         } else if (strcmp(argv[i], "--verbose") == 0) {
             args->verbose = 1;
+            if (args->timings == TIMINGS_OFF) {
+                args->timings = TIMINGS_TEXT;
+            }
+        } else if (strncmp(argv[i], "--timings=", 10) == 0) {
+            if (strcmp(argv[i] + 10, "json") == 0) {
+                args->timings = TIMINGS_JSON;
+            } else if (strcmp(argv[i] + 10, "text") == 0) {
+                args->timings = TIMINGS_TEXT;
+            } else {
+                fprintf(stderr, "Error: --timings must be text or json\n");
+                return -1;
+            }
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             print_usage(argv[0]);
             exit(0);
@@ -127,20 +462,66 @@ int parse_arguments(int argc, char *argv[], arguments_t *args) {
             break;
             
         case CMD_TOTP:
-            if (args->totp_secret[0] == '\0') {
-                fprintf(stderr, "Error: Command 'totp' requires --secret\n");
+            if (args->totp_secret[0] == '\0' && (args->service[0] == '\0' || args->username[0] == '\0')) {
+                fprintf(stderr, "Error: Command 'totp' requires --secret, or --service and --username\n");
                 return -1;
             }
             break;
             
         case CMD_CHECK:
-            if (args->password[0] == '\0') {
-                fprintf(stderr, "Error: Command 'check' requires --password\n");
+            if (args->password[0] == '\0' && args->input_file[0] == '\0' && !args->check_all) {
+                fprintf(stderr, "Error: Command 'check' requires --password, --file or --all\n");
                 return -1;
             }
             break;
             
+        case CMD_IMPORT:
+            if (args->input_file[0] == '\0') {
+                fprintf(stderr, "Error: Command 'import' requires --file\n");
+                return -1;
+            }
+            break;
+
+        case CMD_SEARCH:
+            if (args->query[0] == '\0') {
+                fprintf(stderr, "Error: Command 'search' requires --query\n");
+                return -1;
+            }
+            break;
+
+        case CMD_SERVE:
+            if (args->serve_stdio == (args->serve_listen[0] != '\0')) {
+                fprintf(stderr, "Error: Command 'serve' requires either --stdio or --listen\n");
+                return -1;
+            }
+            break;
+
+        case CMD_EXEC:
+            if (args->manifest[0] == '\0') {
+                fprintf(stderr, "Error: Command 'exec' requires --manifest\n");
+                return -1;
+            }
+            if (args->rest_argc == 0) {
+                fprintf(stderr, "Error: Command 'exec' requires a command after --\n");
+                return -1;
+            }
+            break;
+
+        case CMD_RENDER:
+            if (args->rest_argc == 0) {
+                fprintf(stderr, "Error: Command 'render' requires templates after --\n");
+                return -1;
+            }
+            if (args->output_file[0] != '\0' && args->rest_argc > 1) {
+                fprintf(stderr, "Error: --output can only be used with a single template\n");
+                return -1;
+            }
+            break;
+
         case CMD_LIST:
+        case CMD_AUDIT:
+        case CMD_STATS:
+        case CMD_SHELL:
         case CMD_GENERATE:
         case CMD_INIT:
             break;
@@ -161,21 +542,59 @@ void print_usage(const char *program_name) {
     printf("  get, retrieve      Retrieve a password\n");
     printf("  list, ls           List all stored services\n");
     printf("  remove, rm         Remove a stored password\n");
-    printf("  totp, 2fa          Generate TOTP code\n");
+    printf("  totp, 2fa          Generate a TOTP code, or issue a stored entry's next code\n");
     printf("  check, validate    Check password strength\n");
     printf("  generate, gen      Generate a strong password\n");
     printf("  init               Initialize new vault\n");
-    printf("  change-password    Change vault master password\n\n");
+    printf("  change-password    Change vault master password\n");
+    printf("  import             Import otpauth:// URIs from a file\n");
+    printf("  audit              Report reused, weak, breached and stale passwords\n");
+    printf("  search, find       Find entries whose service or username contains text\n");
+    printf("  shell              Unlock once and run commands interactively or from stdin\n");
+    printf("  serve              Answer JSON-lines requests (--stdio or --listen)\n");
+    printf("  exec               Run a command with vault secrets in its environment\n");
+    printf("  render             Fill vault references into *.tmpl config templates\n");
+    printf("  stats              Report entry sizes, file layout and unlock cost\n\n");
     
     printf("Options:\n");
     printf("  -s, --service <name>    Service name (e.g., github, gmail)\n");
     printf("  -u, --username <name>   Username/email for the service\n");
-    printf("  -v, --vault <file>      Vault file (default: securekey.vault)\n");
-    printf("      --secret <key>      Base32 secret for TOTP\n");
+    printf("  -v, --vault <path>      Vault file or sharded vault directory (default: securekey.vault)\n");
+    printf("      --secret <key>      Base32 secret or otpauth:// URI for TOTP\n");
+    printf("  -f, --file <path>       Input file (otpauth:// URIs for import, passwords for check)\n");
     printf("  -p, --password <pass>   Password for strength checking\n");
-    printf("  -l, --length <num>      Password length for generation (8-64)\n");
+    printf("  -l, --length <num>      Password length for generation (8-64, or a range like 12-20)\n");
+    printf("  -n, --count <num>       Generate <num> passwords, one per line\n");
+    printf("      --charset <chars>   Custom alphabet for generation\n");
+    printf("      --require <list>    Required classes: lower,upper,digit,symbol\n");
+    printf("      --passphrase        Generate a diceware passphrase instead\n");
+    printf("      --words <num>       Passphrase word count, 3-20 (default: 6)\n");
+    printf("      --separator <str>   Passphrase word separator (default: -)\n");
+    printf("      --capitalize <mode> none, first, all or random (default: none)\n");
+    printf("      --no-ambiguous      Exclude look-alike characters (%s)\n", "Il1O0o|");
+    printf("      --breached          Look passwords up in the offline breach database\n");
+    printf("      --breach-db <file>  Breach database (default: %s)\n", "~/.securekey/breached.db");
+    printf("      --all               Check every password in the vault\n");
+    printf("      --json <file>       Write the audit or stats report as JSON ('-' for stdout)\n");
+    printf("      --threads <num>     Worker threads for audit and render (default: all CPUs)\n");
+    printf("      --stale-days <num>  Passwords older than this are stale (default: 365)\n");
+    printf("  -q, --query <text>      Text to search for (case-insensitive)\n");
+    printf("      --idle-timeout <s>  Lock the shell after <s> idle seconds, 0 disables (default: 300)\n");
+    printf("      --master-fd <fd>    Read the master password from file descriptor <fd>\n");
+    printf("      --lock-timeout <s>  Wait up to <s> seconds for another process's vault lock (default: 10)\n");
+    printf("      --durability <m>    Save durability: none, fsync or group (default: fsync)\n");
+    printf("      --compression <c>   Compress saves: none, zlib, zlib-dict, zstd or zstd-dict\n");
+    printf("      --stdio             Serve the JSON-lines protocol on stdin/stdout\n");
+    printf("      --listen <socket>   Serve the JSON-lines protocol to many clients on a Unix socket\n");
+    printf("      --manifest <file>   exec manifest: NAME service username [field] per line\n");
+    printf("  -o, --output <file>     render output for a single template ('-' for stdout)\n");
     printf("      --show              Show password in plain text\n");
-    printf("      --verbose           Show detailed information\n");
+    printf("      --verbose           Show detailed information and phase timings\n");
+    printf("      --timings=<f>       Print phase timings on stderr as text or json\n");
+    printf("      --metrics-file <f>  Write Prometheus metrics to <f> periodically\n");
+    printf("      --metrics-socket <p> Answer metrics scrapes on Unix socket <p>\n");
+    printf("      --metrics-interval <s> Seconds between metrics file writes (default: %d)\n",
+           METRICS_DEFAULT_INTERVAL_SEC);
     printf("  -h, --help              Show this help message\n");
     printf("      --version           Show version information\n\n");
     
@@ -184,10 +603,25 @@ void print_usage(const char *program_name) {
     printf("  %s get -s github -u user@example.com\n", program_name);
     printf("  %s list --verbose\n", program_name);
     printf("  %s totp --secret JBSWY3DPEHPK3PXP\n", program_name);
+    printf("  %s totp -s github -u user@example.com\n", program_name);
     printf("  %s check -p 'MyPassword123!'\n", program_name);
+    printf("  %s check -f passwords.txt\n", program_name);
+    printf("  %s check --breached --all\n", program_name);
+    printf("  %s audit --breached --json report.json\n", program_name);
+    printf("  %s stats --json stats.json\n", program_name);
     printf("  %s generate -l 20 --show\n", program_name);
+    printf("  %s generate -l 14-20 --require lower,upper,digit --count 1000\n", program_name);
+    printf("  %s generate --passphrase --words 7 --capitalize first --show\n", program_name);
     printf("  %s init -v my_vault.dat\n", program_name);
     printf("  %s change-password\n", program_name);
+    printf("  %s import -f authenticator_export.txt\n", program_name);
+    printf("  %s search -q github\n", program_name);
+    printf("  %s shell --idle-timeout 120\n", program_name);
+    printf("  %s shell --master-fd 3 < script.txt 3< master.txt\n", program_name);
+    printf("  %s serve --stdio --master-fd 3 3< master.txt\n", program_name);
+    printf("  %s serve --stdio --metrics-file /var/lib/node_exporter/securekey.prom\n", program_name);
+    printf("  %s exec --manifest app.env -- ./server --port 8080\n", program_name);
+    printf("  %s render -- app.conf.tmpl nginx.conf.tmpl\n", program_name);
 }
 
 void print_version(void) {
@@ -206,6 +640,14 @@ const char* command_to_string(command_t cmd) {
         case CMD_GENERATE: return "generate";
         case CMD_INIT: return "init";
         case CMD_CHANGE_PASSWORD: return "change-password";
+        case CMD_IMPORT: return "import";
+        case CMD_AUDIT: return "audit";
+        case CMD_SEARCH: return "search";
+        case CMD_SHELL: return "shell";
+        case CMD_SERVE: return "serve";
+        case CMD_EXEC: return "exec";
+        case CMD_RENDER: return "render";
+        case CMD_STATS: return "stats";
         default: return "unknown";
     }
 }
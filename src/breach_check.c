@@ -0,0 +1,391 @@
+#include "breach_check.h"
+#include <openssl/evp.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BLOOM_BLOCK_WORDS (BREACH_BLOOM_BLOCK_BITS / 64)
+#define BUILD_BUFFER_RECORDS 4096
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t hash_prefix(const unsigned char* hash, uint32_t bits) {
+    uint32_t value = ((uint32_t)hash[0] << 24) | ((uint32_t)hash[1] << 16) |
+                     ((uint32_t)hash[2] << 8) | hash[3];
+    return value >> (32 - bits);
+}
+
+static uint64_t bloom_block(const unsigned char* hash, uint64_t blocks) {
+    uint64_t value = 0;
+    for (int i = 12; i < 20; i++) {
+        value = (value << 8) | hash[i];
+    }
+    return value % blocks;
+}
+
+static uint32_t bloom_bit(const unsigned char* hash, uint32_t index) {
+    uint32_t bit = index * 9;
+    uint32_t word = ((uint32_t)hash[bit / 8] << 8) | hash[bit / 8 + 1];
+    return (word >> (7 - bit % 8)) & (BREACH_BLOOM_BLOCK_BITS - 1);
+}
+
+static void bloom_add(uint64_t* bloom, uint64_t blocks, uint32_t hashes, const unsigned char* hash) {
+    uint64_t* block = bloom + bloom_block(hash, blocks) * BLOOM_BLOCK_WORDS;
+    for (uint32_t k = 0; k < hashes; k++) {
+        uint32_t bit = bloom_bit(hash, k);
+        block[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+static int bloom_contains(const uint64_t* bloom, uint64_t blocks, uint32_t hashes, const unsigned char* hash) {
+    const uint64_t* block = bloom + bloom_block(hash, blocks) * BLOOM_BLOCK_WORDS;
+    for (uint32_t k = 0; k < hashes; k++) {
+        uint32_t bit = bloom_bit(hash, k);
+        if (!(block[bit / 64] & (1ULL << (bit % 64)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int breach_db_open(breach_db_t* db, const char* path) {
+    if (!db || !path) return -1;
+    memset(db, 0, sizeof(*db));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(breach_db_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const breach_db_header_t* header = (const breach_db_header_t*)map;
+    uint64_t size = (uint64_t)st.st_size;
+    uint64_t fanout_len = 0;
+
+    int valid = memcmp(header->magic, BREACH_DB_MAGIC, 4) == 0 &&
+                header->version == BREACH_DB_VERSION &&
+                header->prefix_bits >= BREACH_MIN_PREFIX_BITS &&
+                header->prefix_bits <= BREACH_MAX_PREFIX_BITS &&
+                header->record_count <= UINT32_MAX &&
+                header->bloom_hashes <= BREACH_MAX_BLOOM_HASHES;
+
+    if (valid) {
+        fanout_len = ((1ULL << header->prefix_bits) + 1) * sizeof(uint32_t);
+        valid = header->records_offset >= sizeof(breach_db_header_t) &&
+                header->records_offset + header->record_count * sizeof(breach_record_t) <= size &&
+                header->fanout_offset % sizeof(uint32_t) == 0 &&
+                header->fanout_offset + fanout_len <= size &&
+                (header->bloom_hashes == 0 ||
+                 (header->bloom_blocks > 0 && header->bloom_blocks <= size / (BREACH_BLOOM_BLOCK_BITS / 8) &&
+                  header->bloom_offset % sizeof(uint64_t) == 0 &&
+                  header->bloom_offset + header->bloom_blocks * (BREACH_BLOOM_BLOCK_BITS / 8) <= size));
+    }
+
+    if (valid) {
+        const uint32_t* fanout = (const uint32_t*)((const char*)map + header->fanout_offset);
+        valid = fanout[1ULL << header->prefix_bits] == header->record_count;
+    }
+
+    if (!valid) {
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    madvise(map, st.st_size, MADV_RANDOM);
+
+    db->map = map;
+    db->map_size = st.st_size;
+    db->header = header;
+    db->records = (const breach_record_t*)((const char*)map + header->records_offset);
+    db->fanout = (const uint32_t*)((const char*)map + header->fanout_offset);
+    db->bloom = header->bloom_hashes ? (const uint64_t*)((const char*)map + header->bloom_offset) : NULL;
+    return 0;
+}
+
+void breach_db_close(breach_db_t* db) {
+    if (!db) return;
+    if (db->map) {
+        munmap(db->map, db->map_size);
+    }
+    memset(db, 0, sizeof(*db));
+}
+
+int breach_db_lookup(const breach_db_t* db, const unsigned char hash[BREACH_HASH_SIZE], uint32_t* count) {
+    if (!db || !db->map || !hash) return -1;
+    if (count) *count = 0;
+
+    const breach_db_header_t* header = db->header;
+    if (db->bloom && !bloom_contains(db->bloom, header->bloom_blocks, header->bloom_hashes, hash)) {
+        return 0;
+    }
+
+    uint32_t prefix = hash_prefix(hash, header->prefix_bits);
+    uint32_t lo = db->fanout[prefix];
+    uint32_t hi = db->fanout[prefix + 1];
+    if (lo > hi || hi > header->record_count) return -1;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(db->records[mid].hash, hash, BREACH_HASH_SIZE);
+        if (cmp == 0) {
+            if (count) *count = db->records[mid].count;
+            return 1;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return 0;
+}
+
+int breach_db_check_password(const breach_db_t* db, const char* password, uint32_t* count) {
+    if (!password) return -1;
+
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len = 0;
+    if (EVP_Digest(password, strlen(password), hash, &hash_len, EVP_sha1(), NULL) != 1 ||
+        hash_len != BREACH_HASH_SIZE) {
+        return -1;
+    }
+
+    int ret = breach_db_lookup(db, hash, count);
+    memset(hash, 0, sizeof(hash));
+    return ret;
+}
+
+const char* breach_db_default_path(void) {
+    static char path[512];
+
+    const char* env = getenv(BREACH_DB_ENV);
+    if (env && env[0]) {
+        return env;
+    }
+
+    const char* home = getenv("HOME");
+    if (!home) {
+        return NULL;
+    }
+    snprintf(path, sizeof(path), "%s%s", home, BREACH_DB_DEFAULT_PATH + 1);
+    return path;
+}
+
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = tolower(c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static int parse_dump_line(const char* line, breach_record_t* record) {
+    for (int i = 0; i < BREACH_HASH_SIZE; i++) {
+        int hi = hex_value((unsigned char)line[i * 2]);
+        int lo = hi < 0 ? -1 : hex_value((unsigned char)line[i * 2 + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        record->hash[i] = (unsigned char)(hi << 4 | lo);
+    }
+
+    const char* rest = line + BREACH_HASH_SIZE * 2;
+    record->count = 1;
+    if (*rest == ':') {
+        char* end;
+        unsigned long long value = strtoull(rest + 1, &end, 10);
+        if (end == rest + 1) return -1;
+        record->count = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+        rest = end;
+    }
+
+    while (*rest == '\r' || *rest == '\n' || *rest == ' ' || *rest == '\t') rest++;
+    return *rest == '\0' ? 0 : -1;
+}
+
+static int write_zeros(FILE* out, uint64_t len) {
+    static const char zeros[64];
+    while (len > 0) {
+        size_t chunk = len > sizeof(zeros) ? sizeof(zeros) : (size_t)len;
+        if (fwrite(zeros, 1, chunk, out) != chunk) return -1;
+        len -= chunk;
+    }
+    return 0;
+}
+
+static int flush_records(FILE* out, breach_record_t* buffer, size_t* buffered) {
+    if (*buffered && fwrite(buffer, sizeof(breach_record_t), *buffered, out) != *buffered) {
+        return -1;
+    }
+    *buffered = 0;
+    return 0;
+}
+
+static uint32_t auto_prefix_bits(uint64_t records) {
+    uint32_t bits = BREACH_MIN_PREFIX_BITS;
+    while (bits < BREACH_MAX_PREFIX_BITS && (records >> bits) > BREACH_TARGET_BUCKET) {
+        bits++;
+    }
+    return bits;
+}
+
+int breach_db_build(FILE* input, const char* out_path, const breach_build_options_t* options,
+                    breach_build_stats_t* stats) {
+    if (!input || !out_path || !stats) return -1;
+    memset(stats, 0, sizeof(*stats));
+
+    int prefix_bits = options ? options->prefix_bits : 0;
+    int bloom_bits = options ? options->bloom_bits_per_key : 0;
+    if ((prefix_bits != 0 && (prefix_bits < BREACH_MIN_PREFIX_BITS || prefix_bits > BREACH_MAX_PREFIX_BITS)) ||
+        bloom_bits < 0 || bloom_bits > 64) {
+        return -1;
+    }
+
+    FILE* out = fopen(out_path, "w+b");
+    if (!out) {
+        fprintf(stderr, "Failed to create %s: %s\n", out_path, strerror(errno));
+        return -1;
+    }
+
+    breach_db_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BREACH_DB_MAGIC, 4);
+    header.version = BREACH_DB_VERSION;
+    header.records_offset = sizeof(header);
+
+    int ret = -1;
+    char* line = NULL;
+    size_t cap = 0;
+    breach_record_t* buffer = malloc(BUILD_BUFFER_RECORDS * sizeof(breach_record_t));
+    uint32_t* fanout = NULL;
+    uint64_t* bloom = NULL;
+    void* map = MAP_FAILED;
+    size_t map_len = 0;
+    size_t buffered = 0;
+    breach_record_t pending;
+    int has_pending = 0;
+
+    if (!buffer || fwrite(&header, sizeof(header), 1, out) != 1) goto done;
+
+    while (getline(&line, &cap, input) != -1) {
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '\0' || line[0] == '#') continue;
+
+        breach_record_t record;
+        if (parse_dump_line(line, &record) != 0) {
+            stats->skipped++;
+            continue;
+        }
+
+        if (has_pending) {
+            int cmp = memcmp(pending.hash, record.hash, BREACH_HASH_SIZE);
+            if (cmp == 0) {
+                uint64_t merged = (uint64_t)pending.count + record.count;
+                pending.count = merged > UINT32_MAX ? UINT32_MAX : (uint32_t)merged;
+                stats->duplicates++;
+                continue;
+            }
+            if (cmp > 0) {
+                fprintf(stderr, "Error: Input is not sorted by hash (line %llu)\n",
+                        (unsigned long long)(stats->records + stats->duplicates + stats->skipped + 1));
+                goto done;
+            }
+
+            buffer[buffered++] = pending;
+            stats->records++;
+            if (buffered == BUILD_BUFFER_RECORDS && flush_records(out, buffer, &buffered) != 0) goto done;
+        }
+
+        pending = record;
+        has_pending = 1;
+    }
+
+    if (has_pending) {
+        buffer[buffered++] = pending;
+        stats->records++;
+    }
+    if (flush_records(out, buffer, &buffered) != 0 || fflush(out) != 0) goto done;
+
+    if (stats->records > UINT32_MAX) {
+        fprintf(stderr, "Error: Too many records\n");
+        goto done;
+    }
+
+    header.record_count = stats->records;
+    header.prefix_bits = prefix_bits ? (uint32_t)prefix_bits : auto_prefix_bits(stats->records);
+
+    uint64_t buckets = 1ULL << header.prefix_bits;
+    uint64_t records_end = header.records_offset + header.record_count * sizeof(breach_record_t);
+    header.fanout_offset = align_up(records_end, sizeof(uint64_t));
+
+    if (bloom_bits > 0 && stats->records > 0) {
+        uint64_t total_bits = stats->records * (uint64_t)bloom_bits;
+        int hashes = (int)lround(bloom_bits * 0.6931);
+        header.bloom_hashes = hashes < 1 ? 1 : hashes > BREACH_MAX_BLOOM_HASHES ? BREACH_MAX_BLOOM_HASHES : hashes;
+        header.bloom_blocks = (total_bits + BREACH_BLOOM_BLOCK_BITS - 1) / BREACH_BLOOM_BLOCK_BITS;
+        header.bloom_offset = align_up(header.fanout_offset + (buckets + 1) * sizeof(uint32_t),
+                                       BREACH_BLOOM_BLOCK_BITS / 8);
+    }
+
+    fanout = calloc(buckets + 1, sizeof(uint32_t));
+    if (header.bloom_hashes) {
+        bloom = calloc(header.bloom_blocks, BREACH_BLOOM_BLOCK_BITS / 8);
+    }
+    if (!fanout || (header.bloom_hashes && !bloom)) goto done;
+
+    if (header.record_count > 0) {
+        map_len = records_end;
+        map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fileno(out), 0);
+        if (map == MAP_FAILED) goto done;
+        madvise(map, map_len, MADV_SEQUENTIAL);
+
+        const breach_record_t* records = (const breach_record_t*)((const char*)map + header.records_offset);
+        for (uint64_t i = 0; i < header.record_count; i++) {
+            fanout[hash_prefix(records[i].hash, header.prefix_bits) + 1]++;
+            if (bloom) {
+                bloom_add(bloom, header.bloom_blocks, header.bloom_hashes, records[i].hash);
+            }
+        }
+    }
+
+    for (uint64_t b = 1; b <= buckets; b++) {
+        fanout[b] += fanout[b - 1];
+    }
+
+    if (fseeko(out, (off_t)records_end, SEEK_SET) != 0 ||
+        write_zeros(out, header.fanout_offset - records_end) != 0 ||
+        fwrite(fanout, sizeof(uint32_t), buckets + 1, out) != buckets + 1) {
+        goto done;
+    }
+
+    if (bloom) {
+        uint64_t fanout_end = header.fanout_offset + (buckets + 1) * sizeof(uint32_t);
+        if (write_zeros(out, header.bloom_offset - fanout_end) != 0 ||
+            fwrite(bloom, BREACH_BLOOM_BLOCK_BITS / 8, header.bloom_blocks, out) != header.bloom_blocks) {
+            goto done;
+        }
+    }
+
+    if (fseeko(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1) goto done;
+
+    ret = 0;
+
+done:
+    if (map != MAP_FAILED) munmap(map, map_len);
+    if (fclose(out) != 0) ret = -1;
+    if (ret != 0) remove(out_path);
+    free(line);
+    free(buffer);
+    free(fanout);
+    free(bloom);
+    return ret;
+}
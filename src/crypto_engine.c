@@ -1,6 +1,8 @@
 #include "crypto_engine.h"
+#include "timings.h"
 #include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <openssl/crypto.h>
 #include <string.h>
 
 #define KEY_LEN 32
@@ -8,36 +10,53 @@
 #define IV_LEN 16
 
 static unsigned char global_salt[SALT_LEN];
+static int global_salt_ready = 0;
+static int crypto_ready = 0;
 
 int crypto_init(void) {
-    return RAND_bytes(global_salt, SALT_LEN) == 1 ? 0 : -1;
+    if (!crypto_ready) {
+        if (OPENSSL_init_crypto(0, NULL) != 1) return -1;
+        crypto_ready = 1;
+    }
+    return 0;
 }
 
 int crypto_cleanup(void) {
-    secure_cleanup(global_salt, SALT_LEN);
+    if (global_salt_ready) {
+        secure_cleanup(global_salt, SALT_LEN);
+        global_salt_ready = 0;
+    }
     return 0;
 }
 
 int derive_key(const char* password, unsigned char* key) {
+    if (!global_salt_ready) {
+        if (RAND_bytes(global_salt, SALT_LEN) != 1) return -1;
+        global_salt_ready = 1;
+    }
+
     return PKCS5_PBKDF2_HMAC(
         password, strlen(password),
         global_salt, SALT_LEN,
-        100000, EVP_sha256(),
+        KDF_ITERATIONS, EVP_sha256(),
         KEY_LEN, key
     ) == 1 ? 0 : -1;
 }
 
 int derive_key_with_salt(const char* password, const unsigned char* salt, size_t salt_len, unsigned char* key) {
-    return PKCS5_PBKDF2_HMAC(
+    TIMING_START(started);
+    int ret = PKCS5_PBKDF2_HMAC(
         password, strlen(password),
         salt, salt_len,
-        100000, EVP_sha256(),
+        KDF_ITERATIONS, EVP_sha256(),
         KEY_LEN, key
     ) == 1 ? 0 : -1;
+    TIMING_STOP(started, TIMING_KDF);
+    return ret;
 }
 
-int encrypt_data(const unsigned char* plaintext, size_t len,
-                 const unsigned char* key, unsigned char* ciphertext) {
+static int encrypt_cbc(const unsigned char* plaintext, size_t len,
+                       const unsigned char* key, unsigned char* ciphertext) {
     unsigned char iv[IV_LEN];
     if (RAND_bytes(iv, IV_LEN) != 1) return -1;
 
@@ -65,8 +84,8 @@ int encrypt_data(const unsigned char* plaintext, size_t len,
     return out_len + final_len + IV_LEN;
 }
 
-int decrypt_data(const unsigned char* ciphertext, size_t len,
-                 const unsigned char* key, unsigned char* plaintext) {
+static int decrypt_cbc(const unsigned char* ciphertext, size_t len,
+                       const unsigned char* key, unsigned char* plaintext) {
     if (len < IV_LEN) return -1;
 
     unsigned char iv[IV_LEN];
@@ -94,6 +113,22 @@ int decrypt_data(const unsigned char* ciphertext, size_t len,
     return out_len + final_len;
 }
 
+int encrypt_data(const unsigned char* plaintext, size_t len,
+                 const unsigned char* key, unsigned char* ciphertext) {
+    TIMING_START(started);
+    int ret = encrypt_cbc(plaintext, len, key, ciphertext);
+    TIMING_STOP(started, TIMING_ENCRYPT);
+    return ret;
+}
+
+int decrypt_data(const unsigned char* ciphertext, size_t len,
+                 const unsigned char* key, unsigned char* plaintext) {
+    TIMING_START(started);
+    int ret = decrypt_cbc(ciphertext, len, key, plaintext);
+    TIMING_STOP(started, TIMING_DECRYPT);
+    return ret;
+}
+
 void secure_cleanup(void* data, size_t len) {
     if (data && len > 0) {
         memset(data, 0, len);
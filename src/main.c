@@ -1,11 +1,29 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
 #include "arg_parse.h"
 #include "crypto_engine.h"
 #include "vault_controller.h"
 #include "totp_engine.h"
+#include "otpauth.h"
+#include "password_gen.h"
+#include "passphrase.h"
+#include "strength.h"
+#include "breach_check.h"
+#include "vault_audit.h"
+#include "vault_stats.h"
+#include "shell.h"
+#include "serve.h"
+#include "secret_exec.h"
+#include "render.h"
 #include "utilities.h"
+#include "timings.h"
+#include "metrics.h"
 
 #define MAX_PASSWORD_LEN 256
 
@@ -15,33 +33,511 @@ static void display_password_strength(const char* password) {
         return;
     }
 
-    int length = strlen(password);
-    int has_lower = 0, has_upper = 0, has_digit = 0, has_special = 0;
+    strength_result_t result;
+    if (strength_estimate(password, &result) != 0) {
+        fprintf(stderr, "Error: Password is too long to analyze\n");
+        return;
+    }
 
-    for (int i = 0; i < length; i++) {
-        if (password[i] >= 'a' && password[i] <= 'z') has_lower = 1;
-        else if (password[i] >= 'A' && password[i] <= 'Z') has_upper = 1;
-        else if (password[i] >= '0' && password[i] <= '9') has_digit = 1;
-        else has_special = 1;
+    if (!strength_dictionary_loaded()) {
+        fprintf(stderr, "Warning: Strength dictionary not found, dictionary matching disabled\n");
     }
 
     printf("Password strength analysis:\n");
-    printf("  Length: %d characters %s\n", length, length >= 12 ? "[GOOD]" : length >= 8 ? "[OK]" : "[WEAK]");
-    printf("  Lowercase letters: %s\n", has_lower ? "Yes" : "No");
-    printf("  Uppercase letters: %s\n", has_upper ? "Yes" : "No");
-    printf("  Digits: %s\n", has_digit ? "Yes" : "No");
-    printf("  Special characters: %s\n", has_special ? "Yes" : "No");
-
-    int score = check_password_strength(password);
-
-    printf("\nOverall strength: ");
-    if (score >= 6) {
-        printf("STRONG\n");
-    } else if (score >= 4) {
-        printf("MODERATE\n");
+    printf("  Length: %zu characters\n", strlen(password));
+    printf("  Estimated guesses: 10^%.1f\n", result.guesses_log10);
+    printf("  Entropy: %.1f bits\n", result.entropy_bits);
+    printf("  Patterns:\n");
+
+    for (size_t i = 0; i < result.match_count; i++) {
+        const strength_match_t* match = &result.sequence[i];
+        printf("    [%zu-%zu] %-10s", match->i, match->j, strength_pattern_name(match->pattern));
+        if (match->pattern == MATCH_DICTIONARY) {
+            printf(" %s rank %u%s%s", strength_dict_name(match->dict), match->rank,
+                   match->l33t ? ", l33t" : "", match->reversed ? ", reversed" : "");
+        }
+        printf(" (10^%.1f guesses)\n", match->guesses_log10);
+    }
+
+    printf("\nOverall strength: %s (%d/4)\n", strength_score_label(result.score), result.score);
+}
+
+static int read_master_password(const arguments_t* args, char* password) {
+    if (args->master_fd >= 0) {
+        return read_password_fd(args->master_fd, password, MAX_PASSWORD_LEN);
+    }
+    return read_password_secure("Enter master password: ", password, MAX_PASSWORD_LEN);
+}
+
+static int search_entries(const char* query) {
+    size_t total = vault_entry_count();
+    size_t* matches = total > 0 ? malloc(total * sizeof(size_t)) : NULL;
+    if (total > 0 && !matches) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+
+    size_t found = vault_search(query, matches, total);
+    VaultEntry entry;
+    for (size_t i = 0; i < found; i++) {
+        if (vault_get_entry_at(matches[i], &entry) != 0) continue;
+        printf("%3zu. %-30s %-30s%s\n", matches[i] + 1, entry.service, entry.username,
+               entry.totp_secret[0] ? " [TOTP]" : "");
+    }
+    secure_cleanup(&entry, sizeof(entry));
+    free(matches);
+
+    printf("%zu matching %s\n", found, found == 1 ? "entry" : "entries");
+    return found > 0 ? 0 : 1;
+}
+
+static int is_read_only_command(command_t command) {
+    switch (command) {
+        case CMD_RETRIEVE:
+        case CMD_LIST:
+        case CMD_CHECK:
+        case CMD_AUDIT:
+        case CMD_STATS:
+        case CMD_SEARCH:
+        case CMD_EXEC:
+        case CMD_RENDER:
+        case CMD_TOTP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* Issuing an HOTP code advances its counter, so only HOTP entries need a writable vault. */
+static int stored_entry_is_hotp(const arguments_t* args) {
+    VaultEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    int index = vault_find_entry(args->service, args->username);
+    int hotp = index >= 0 && vault_get_entry_at((size_t)index, &entry) == 0 &&
+               entry.totp_secret[0] && entry.totp_type == OTP_TYPE_HOTP;
+    secure_cleanup(&entry, sizeof(entry));
+    return hotp;
+}
+
+static void stop_serving(int sig) {
+    (void)sig;
+    serve_stop();
+}
+
+static int run_serve_socket(const char* path) {
+    struct sigaction action, old_int, old_term;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_serving;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &old_int);
+    sigaction(SIGTERM, &action, &old_term);
+
+    int ret = serve_socket(path, NULL);
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    return ret;
+}
+
+static int run_exec(const arguments_t* args) {
+    exec_manifest_t manifest;
+    size_t line = 0;
+
+    if (exec_manifest_load(args->manifest, &manifest, &line) != 0) {
+        if (line > 0) {
+            fprintf(stderr, "Error: %s:%zu: invalid manifest line\n", args->manifest, line);
+        } else {
+            fprintf(stderr, "Error: Cannot read manifest '%s'\n", args->manifest);
+        }
+        return 1;
+    }
+
+    if (exec_manifest_resolve(&manifest, &line) != 0) {
+        fprintf(stderr, "Error: %s:%zu: entry not found in vault\n", args->manifest, line);
+        exec_manifest_free(&manifest);
+        return 1;
+    }
+
+    exec_command(&manifest, args->rest_argv);
+
+    int err = errno;
+    fprintf(stderr, "Error: Cannot execute '%s': %s\n", args->rest_argv[0], strerror(err));
+    exec_manifest_free(&manifest);
+    return err == ENOENT ? 127 : 126;
+}
+
+static int run_render(const arguments_t* args) {
+    size_t count = (size_t)args->rest_argc;
+    render_job_t* jobs = calloc(count, sizeof(render_job_t));
+    if (!jobs) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        jobs[i].input = args->rest_argv[i];
+        if (args->output_file[0]) {
+            strcpy(jobs[i].output, args->output_file);
+        } else if (render_output_path(jobs[i].input, jobs[i].output, sizeof(jobs[i].output)) != 0) {
+            fprintf(stderr, "Error: Template '%s' must end in %s (or use --output)\n",
+                    jobs[i].input, RENDER_SUFFIX);
+            free(jobs);
+            return 1;
+        }
+    }
+
+    int ret = render_files(jobs, count, args->threads);
+    FILE* report = strcmp(jobs[0].output, "-") == 0 ? stderr : stdout;
+
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].status != RENDER_OK) {
+            if (jobs[i].error_line > 0) {
+                fprintf(stderr, "Error: %s:%zu: %s\n", jobs[i].input, jobs[i].error_line,
+                        render_strerror(jobs[i].status));
+            } else {
+                fprintf(stderr, "Error: %s: %s\n", jobs[i].input, render_strerror(jobs[i].status));
+            }
+        } else if (ret == RENDER_OK) {
+            fprintf(report, "Rendered %s -> %s (%zu %s)\n", jobs[i].input, jobs[i].output,
+                    jobs[i].substitutions, jobs[i].substitutions == 1 ? "secret" : "secrets");
+        }
+    }
+
+    free(jobs);
+    return ret == RENDER_OK ? 0 : 1;
+}
+
+static int open_breach_db(const arguments_t* args, breach_db_t* db) {
+    const char* path = args->breach_db[0] ? args->breach_db : breach_db_default_path();
+
+    if (!path || breach_db_open(db, path) != 0) {
+        fprintf(stderr, "Error: Cannot open breach database %s\n", path ? path : BREACH_DB_DEFAULT_PATH);
+        fprintf(stderr, "Build one from the HIBP SHA-1 dump with: breach_build <dump.txt> <output.db>\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int report_breach(const breach_db_t* db, const char* password) {
+    uint32_t count = 0;
+    int found = breach_db_check_password(db, password, &count);
+
+    if (found < 0) {
+        fprintf(stderr, "Error: Breach lookup failed\n");
+        return -1;
+    }
+    if (found) {
+        printf("Breached: YES, seen %u times in known breaches\n", count);
     } else {
-        printf("WEAK\n");
+        printf("Breached: not found in breach database\n");
+    }
+    return found;
+}
+
+static int score_password_file(const char* path, const breach_db_t* db) {
+    FILE* fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open %s\n", path);
+        return 1;
+    }
+
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &cap, fp)) != -1) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (len == 0) continue;
+
+        strength_result_t result;
+        if (strength_estimate(line, &result) != 0) {
+            printf("-\t-\t%s%s\n", db ? "-\t" : "", line);
+            continue;
+        }
+
+        if (db) {
+            uint32_t count = 0;
+            breach_db_check_password(db, line, &count);
+            printf("%d\t%.2f\t%u\t%s\n", result.score, result.guesses_log10, count, line);
+        } else {
+            printf("%d\t%.2f\t%s\n", result.score, result.guesses_log10, line);
+        }
+    }
+
+    if (line) {
+        secure_cleanup(line, cap);
+        free(line);
+    }
+    if (fp != stdin) fclose(fp);
+    return 0;
+}
+
+static int check_vault_entries(const breach_db_t* db) {
+    size_t total = vault_entry_count();
+    size_t weak = 0, breached = 0;
+    VaultEntry entry;
+
+    for (size_t i = 0; i < total; i++) {
+        if (vault_get_entry_at(i, &entry) != 0) {
+            continue;
+        }
+
+        int score = check_password_strength(entry.password);
+        uint32_t count = 0;
+        int found = db ? breach_db_check_password(db, entry.password, &count) : 0;
+
+        if (score >= 0 && score < 3) weak++;
+        if (found > 0) breached++;
+
+        printf("%s (%s): %s", entry.service, entry.username, strength_score_label(score));
+        if (found > 0) {
+            printf(", BREACHED (%u times)", count);
+        }
+        printf("\n");
+    }
+    secure_cleanup(&entry, sizeof(entry));
+
+    printf("\n%zu entries checked: %zu weak", total, weak);
+    if (db) {
+        printf(", %zu breached", breached);
+    }
+    printf("\n");
+
+    return (weak > 0 || breached > 0) ? 1 : 0;
+}
+
+static FILE* open_json_output(const char* path) {
+    if (strcmp(path, "-") == 0) {
+        return stdout;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE* out = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!out) {
+        if (fd >= 0) close(fd);
+        fprintf(stderr, "Error: Cannot write %s\n", path);
+    }
+    return out;
+}
+
+static int close_json_output(FILE* out, int ret) {
+    if (out == stdout) {
+        return fflush(out) != 0 ? -1 : ret;
+    }
+    return fclose(out) != 0 ? -1 : ret;
+}
+
+static int write_audit_json(const audit_report_t* report, const char* path) {
+    FILE* out = open_json_output(path);
+    if (!out) return -1;
+    return close_json_output(out, audit_report_write_json(report, out));
+}
+
+static int run_audit(const arguments_t* args) {
+    breach_db_t db;
+    if (args->breached && open_breach_db(args, &db) != 0) {
+        return 1;
+    }
+
+    audit_options_t options;
+    audit_options_default(&options);
+    options.threads = args->threads;
+    options.stale_days = args->stale_days;
+    options.breach_db = args->breached ? &db : NULL;
+
+    audit_report_t report;
+    int ret = vault_audit(&options, &report);
+    if (ret != 0) {
+        fprintf(stderr, "Error: Audit failed\n");
+        if (args->breached) breach_db_close(&db);
+        return 1;
+    }
+
+    FILE* summary = strcmp(args->output_file, "-") == 0 ? stderr : stdout;
+    fprintf(summary, "Audited %zu entries in %.2f s (%d threads)\n",
+            report.total, report.elapsed_seconds, report.threads_used);
+    fprintf(summary, "  Reused passwords:   %zu entries in %zu groups\n", report.reused, report.reuse_groups);
+    fprintf(summary, "  Weak passwords:     %zu\n", report.weak);
+    if (report.breach_checked) {
+        fprintf(summary, "  Breached passwords: %zu\n", report.breached);
+    } else {
+        fprintf(summary, "  Breached passwords: not checked (use --breached)\n");
+    }
+    fprintf(summary, "  Missing TOTP:       %zu\n", report.no_totp);
+    fprintf(summary, "  Stale (%d+ days):  %zu (%zu without a change date)\n",
+            args->stale_days, report.stale, report.undated);
+    if (report.otp_only) {
+        fprintf(summary, "  OTP only:           %zu (no password to check)\n", report.otp_only);
+    }
+
+    if (args->verbose) {
+        VaultEntry entry;
+        for (size_t i = 0; i < report.total; i++) {
+            unsigned int flags = report.entries[i].flags & ~AUDIT_FLAG_NO_TOTP;
+            if (flags == 0 || vault_get_entry_at(i, &entry) != 0) continue;
+
+            fprintf(summary, "  %s (%s):", entry.service, entry.username);
+            for (unsigned int flag = AUDIT_FLAG_REUSED; flag <= AUDIT_FLAG_OTP_ONLY; flag <<= 1) {
+                if (flags & flag) fprintf(summary, " %s", audit_flag_name(flag));
+            }
+            fprintf(summary, "\n");
+        }
+        secure_cleanup(&entry, sizeof(entry));
+    }
+
+    ret = (report.reused || report.weak || report.breached || report.stale) ? 1 : 0;
+
+    if (args->output_file[0] && write_audit_json(&report, args->output_file) != 0) {
+        ret = 1;
+    }
+
+    audit_report_free(&report);
+    if (args->breached) breach_db_close(&db);
+    return ret;
+}
+
+static int run_stats(const arguments_t* args) {
+    vault_stats_t stats;
+    if (vault_stats_collect(vault_default_handle(), &stats) != 0) {
+        fprintf(stderr, "Error: Cannot read vault statistics\n");
+        return 1;
+    }
+
+    vault_stats_print(&stats, strcmp(args->output_file, "-") == 0 ? stderr : stdout);
+    if (args->output_file[0]) {
+        FILE* out = open_json_output(args->output_file);
+        if (!out || close_json_output(out, vault_stats_write_json(&stats, out)) != 0) {
+            return 1;
+        }
     }
+    return 0;
+}
+
+#define GENERATE_MAX_ITEM (PWGEN_MAX_LENGTH > PASSPHRASE_MAX_LENGTH ? PWGEN_MAX_LENGTH : PASSPHRASE_MAX_LENGTH)
+
+typedef int (*generate_next_fn)(void* generator, char* output, size_t output_len);
+
+/*
+ * Prints one item, or streams --count items through a 64 KiB buffer.
+ * label names the item in messages ("password", "passphrase").
+ */
+static int generate_items(const arguments_t* args, generate_next_fn next, void* generator,
+                          const char* label) {
+    int count = args->count > 0 ? args->count : 1;
+    int streaming = args->count > 0;
+    static char output_buffer[1 << 16];
+    size_t buffered = 0;
+
+    char item[GENERATE_MAX_ITEM + 1];
+    int ret = 0;
+
+    for (int i = 0; i < count; i++) {
+        int length = next(generator, item, sizeof(item));
+        if (length < 0) {
+            fprintf(stderr, "Error: Failed to generate %s\n", label);
+            ret = 1;
+            break;
+        }
+
+        if (streaming) {
+            if (buffered + (size_t)length + 1 > sizeof(output_buffer)) {
+                fwrite(output_buffer, 1, buffered, stdout);
+                buffered = 0;
+            }
+            memcpy(output_buffer + buffered, item, length);
+            buffered += length;
+            output_buffer[buffered++] = '\n';
+        } else if (args->show_password) {
+            printf("Generated %s: %s\n", label, item);
+        } else {
+            printf("Generated %s (hidden)\n", label);
+            printf("Use --show to display the %s\n", label);
+        }
+    }
+
+    fwrite(output_buffer, 1, buffered, stdout);
+    fflush(stdout);
+
+    secure_cleanup(item, sizeof(item));
+    secure_cleanup(output_buffer, sizeof(output_buffer));
+    return ret;
+}
+
+static int next_password(void* generator, char* output, size_t output_len) {
+    return password_generator_next((password_generator_t*)generator, output, output_len);
+}
+
+static int next_passphrase(void* generator, char* output, size_t output_len) {
+    return passphrase_generator_next((passphrase_generator_t*)generator, output, output_len);
+}
+
+static int generate_passwords(const arguments_t* args) {
+    password_policy_t policy;
+    password_policy_default(&policy, args->password_length);
+    policy.max_length = args->password_max_length;
+    policy.exclude_ambiguous = args->exclude_ambiguous;
+    strncpy(policy.alphabet, args->charset, PWGEN_MAX_ALPHABET);
+
+    if (args->require_classes[0] &&
+        password_policy_parse_classes(args->require_classes, &policy.required_classes) != 0) {
+        fprintf(stderr, "Error: Invalid --require list (use lower,upper,digit,symbol)\n");
+        return 1;
+    }
+
+    password_generator_t generator;
+    if (password_generator_init(&generator, &policy) != 0) {
+        fprintf(stderr, "Error: Password policy cannot be satisfied\n");
+        return 1;
+    }
+
+    int ret = generate_items(args, next_password, &generator, "password");
+    password_generator_cleanup(&generator);
+    return ret;
+}
+
+static int generate_passphrases(const arguments_t* args) {
+    passphrase_policy_t policy;
+    passphrase_policy_default(&policy);
+    policy.words = args->words;
+    strncpy(policy.separator, args->separator, PASSPHRASE_MAX_SEPARATOR);
+
+    if (passphrase_parse_capitalize(args->capitalize, &policy.capitalize) != 0) {
+        fprintf(stderr, "Error: Invalid --capitalize mode (use none, first, all or random)\n");
+        return 1;
+    }
+
+    passphrase_generator_t generator;
+    if (passphrase_generator_init(&generator, &policy) != 0) {
+        fprintf(stderr, "Error: Invalid passphrase options\n");
+        return 1;
+    }
+
+    int ret = generate_items(args, next_passphrase, &generator, "passphrase");
+    if (ret == 0) {
+        fprintf(args->count > 0 ? stderr : stdout, "Entropy: %.1f bits (%d words from a %zu-word list)\n",
+                passphrase_entropy_bits(&policy), policy.words, passphrase_wordlist_size());
+    }
+
+    passphrase_generator_cleanup(&generator);
+    return ret;
+}
+
+static bool confirm_overwrite(const char* service, const char* username) {
+    char answer[16];
+
+    printf("Entry for '%s' (%s) already exists.\n", service, username);
+    printf("Overwrite? (y/n): ");
+    fflush(stdout);
+    if (!fgets(answer, sizeof(answer), stdin)) {
+        return false;
+    }
+    return answer[0] == 'y' || answer[0] == 'Y';
+}
+
+static void report_timings(void) {
+    timings_report(stderr);
 }
 
 int main(int argc, char* argv[]) {
@@ -52,31 +548,94 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    if (crypto_init() != 0) {
-        fprintf(stderr, "Error: Failed to initialize crypto engine\n");
-        return 1;
+    if (args.timings != TIMINGS_OFF) {
+        timings_enable((timings_format_t)args.timings);
+        atexit(report_timings);
+    }
+
+    if (args.metrics_file[0] || args.metrics_socket[0]) {
+        if (metrics_start_exporter(args.metrics_file[0] ? args.metrics_file : NULL,
+                                   args.metrics_socket[0] ? args.metrics_socket : NULL,
+                                   args.metrics_interval) != 0) {
+            fprintf(stderr, "Error: Failed to start the metrics exporter\n");
+            return 1;
+        }
+        /* Every return path below must write the last textfile and remove the socket. */
+        atexit(metrics_stop_exporter);
     }
 
     int ret = 0;
 
     switch (args.command) {
         case CMD_TOTP: {
-            uint32_t code = generate_totp(args.totp_secret);
-            printf("TOTP Code: %06u\n", code);
-            crypto_cleanup();
+            if (args.totp_secret[0] == '\0') {
+                break;  /* A stored entry's code; needs the vault. */
+            }
+            uint32_t code;
+            int digits = TOTP_DEFAULT_DIGITS;
+
+            if (strncasecmp(args.totp_secret, OTPAUTH_SCHEME, strlen(OTPAUTH_SCHEME)) == 0) {
+                otpauth_uri_t uri;
+                if (otpauth_parse(args.totp_secret, &uri) != 0) {
+                    fprintf(stderr, "Error: Invalid otpauth:// URI\n");
+                    return 1;
+                }
+
+                VaultEntry entry;
+                otpauth_to_entry(&uri, &entry);
+                code = vault_entry_otp(&entry);
+                digits = entry.totp_digits;
+                secure_cleanup(&uri, sizeof(uri));
+                secure_cleanup(&entry, sizeof(entry));
+            } else {
+                code = generate_totp(args.totp_secret);
+            }
+
+            printf("TOTP Code: %0*u\n", digits, code);
             return 0;
         }
 
-        case CMD_CHECK:
-            display_password_strength(args.password);
-            crypto_cleanup();
-            return 0;
+        case CMD_CHECK: {
+            if (args.check_all) {
+                break;
+            }
+
+            breach_db_t db;
+            if (args.breached && open_breach_db(&args, &db) != 0) {
+                return 1;
+            }
+
+            int ret_check = 0;
+            if (args.input_file[0]) {
+                ret_check = score_password_file(args.input_file, args.breached ? &db : NULL);
+            } else {
+                display_password_strength(args.password);
+                if (args.breached) {
+                    ret_check = report_breach(&db, args.password) != 0 ? 1 : 0;
+                }
+            }
+
+            if (args.breached) {
+                breach_db_close(&db);
+            }
+            return ret_check;
+        }
 
         case CMD_GENERATE: {
+            if (args.passphrase) {
+                int ret_gen = generate_passphrases(&args);
+                return ret_gen;
+            }
+
+            if (args.count > 0 || args.charset[0] || args.require_classes[0] ||
+                args.exclude_ambiguous || args.password_max_length != args.password_length) {
+                int ret_gen = generate_passwords(&args);
+                return ret_gen;
+            }
+
             char password[65];
             if (generate_random_password(password, sizeof(password), args.password_length) != 0) {
                 fprintf(stderr, "Error: Failed to generate password\n");
-                crypto_cleanup();
                 return 1;
             }
             if (args.show_password) {
@@ -85,7 +644,6 @@ int main(int argc, char* argv[]) {
                 printf("Generated password (hidden)\n");
                 printf("Use --show to display the password\n");
             }
-            crypto_cleanup();
             return 0;
         }
 
@@ -94,10 +652,18 @@ int main(int argc, char* argv[]) {
     }
 
     char master_password[MAX_PASSWORD_LEN];
-    const char* vault_path = vault_get_default_path();
-
-    if (args.vault_file[0] != '\0' && strcmp(args.vault_file, "securekey.vault") != 0) {
-        vault_path = args.vault_file;
+    const char* vault_path = args.vault_file;
+    if (vault_path[0] == '\0' || strcmp(vault_path, "securekey.vault") == 0) {
+        vault_path = vault_get_default_path();
+    }
+    vault_set_lock_timeout(args.lock_timeout * 1000);
+    vault_set_durability((vault_durability_t)args.durability);
+    if (args.compression >= 0) {
+        vault_set_compression((vault_codec_t)args.compression);
+        if (is_read_only_command(args.command) && args.command != CMD_TOTP) {
+            fprintf(stderr, "Warning: --compression only applies when the vault is saved; "
+                            "use vault_reshard --compression to convert it\n");
+        }
     }
 
     if (args.command == CMD_INIT) {
@@ -225,13 +791,21 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    if (read_password_secure("Enter master password: ", master_password, MAX_PASSWORD_LEN) != 0) {
+    if (read_master_password(&args, master_password) != 0) {
         fprintf(stderr, "Error: Failed to read password\n");
+        if (args.master_fd < 0 && !isatty(STDIN_FILENO)) {
+            fprintf(stderr, "Use --master-fd when stdin is not a terminal\n");
+        }
         crypto_cleanup();
         return 1;
     }
 
-    ret = vault_init(master_password, vault_path);
+    ret = vault_open(master_password, vault_path,
+                     is_read_only_command(args.command) ? VAULT_OPEN_READ_ONLY : 0);
+    if (ret == 0 && args.command == CMD_TOTP && stored_entry_is_hotp(&args)) {
+        vault_cleanup();
+        ret = vault_open(master_password, vault_path, 0);
+    }
     secure_cleanup(master_password, MAX_PASSWORD_LEN);
 
     if (ret != 0) {
@@ -243,6 +817,13 @@ int main(int argc, char* argv[]) {
 
     switch (args.command) {
         case CMD_STORE: {
+            if (vault_find_entry(args.service, args.username) >= 0 &&
+                !confirm_overwrite(args.service, args.username)) {
+                printf("Cancelled.\n");
+                ret = 1;
+                break;
+            }
+
             char password[MAX_PASSWORD_LEN];
             if (read_password_secure("Enter password to store: ", password, MAX_PASSWORD_LEN) != 0) {
                 fprintf(stderr, "Error: Failed to read password\n");
@@ -263,6 +844,24 @@ int main(int argc, char* argv[]) {
             break;
         }
 
+        case CMD_TOTP: {
+            VaultEntry entry;
+            uint32_t code;
+            uint64_t counter;
+            ret = vault_get(args.service, args.username, &entry);
+            if (ret == 0) {
+                ret = vault_issue_otp(args.service, args.username, &code, &counter);
+            }
+            if (ret == 0 && entry.totp_type == OTP_TYPE_HOTP) {
+                printf("HOTP Code: %0*u (counter %llu)\n", entry.totp_digits, code,
+                       (unsigned long long)counter);
+            } else if (ret == 0) {
+                printf("TOTP Code: %0*u\n", entry.totp_digits, code);
+            }
+            secure_cleanup(&entry, sizeof(entry));
+            break;
+        }
+
         case CMD_RETRIEVE: {
             VaultEntry entry;
             ret = vault_get(args.service, args.username, &entry);
@@ -278,9 +877,15 @@ int main(int argc, char* argv[]) {
                 }
 
                 if (entry.totp_secret[0] != '\0') {
-                    uint32_t totp_code = generate_totp(entry.totp_secret);
                     printf("TOTP Secret: %s\n", entry.totp_secret);
-                    printf("Current TOTP Code: %06u\n", totp_code);
+                    if (entry.totp_type == OTP_TYPE_HOTP) {
+                        /* HOTP codes are single-use; totp issues the next one and advances the counter. */
+                        printf("HOTP Counter: %llu\n", (unsigned long long)entry.totp_counter);
+                        printf("Use 'totp -s %s -u %s' to issue the next HOTP code\n",
+                               entry.service, entry.username);
+                    } else {
+                        printf("Current TOTP Code: %0*u\n", entry.totp_digits, vault_entry_otp(&entry));
+                    }
                 }
 
                 secure_cleanup(&entry, sizeof(entry));
@@ -306,6 +911,69 @@ int main(int argc, char* argv[]) {
             }
             break;
 
+        case CMD_CHECK: {
+            breach_db_t db;
+            if (args.breached && open_breach_db(&args, &db) != 0) {
+                ret = 1;
+                break;
+            }
+
+            ret = check_vault_entries(args.breached ? &db : NULL);
+
+            if (args.breached) {
+                breach_db_close(&db);
+            }
+            break;
+        }
+
+        case CMD_AUDIT:
+            ret = run_audit(&args);
+            break;
+
+        case CMD_STATS:
+            ret = run_stats(&args);
+            break;
+
+        case CMD_SEARCH:
+            ret = search_entries(args.query);
+            break;
+
+        case CMD_SERVE:
+            ret = args.serve_listen[0] ? run_serve_socket(args.serve_listen)
+                                       : serve_stdio(STDIN_FILENO, stdout, NULL);
+            break;
+
+        case CMD_EXEC:
+            ret = run_exec(&args);
+            break;
+
+        case CMD_RENDER:
+            ret = run_render(&args);
+            break;
+
+        case CMD_SHELL: {
+            static shell_session_t session;
+            shell_session_init(&session, vault_path, isatty(STDIN_FILENO), args.idle_timeout);
+            ret = shell_run(&session, stdin);
+            shell_session_cleanup(&session);
+            break;
+        }
+
+        case CMD_IMPORT: {
+            otpauth_import_stats_t stats;
+            ret = otpauth_import_file(args.input_file, &stats);
+            if (ret == 0) {
+                printf("Imported %zu new and %zu updated entries (%zu skipped)\n",
+                       stats.imported, stats.updated, stats.failed);
+                if (stats.failed > 0) {
+                    ret = 1;
+                }
+            } else {
+                fprintf(stderr, "Error: Failed to import entries\n");
+            }
+            break;
+        }
+
         default:
             fprintf(stderr, "Error: Unknown command\n");
             ret = 1;
@@ -0,0 +1,644 @@
+#include "metrics.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * HDR-style buckets: values below 8 ns get one bucket each, and every power
+ * of two above that is split into 8 linear sub-buckets, so a recorded value
+ * is off by at most 12.5%. Values are capped at 2^40 ns (about 18 minutes).
+ */
+#define METRIC_SUB_BITS 3
+#define METRIC_SUB_BUCKETS (1u << METRIC_SUB_BITS)
+#define METRIC_MAX_BITS 40
+#define METRIC_BUCKETS ((METRIC_MAX_BITS - METRIC_SUB_BITS + 1) * METRIC_SUB_BUCKETS)
+
+/* Exported "le" bounds are the powers of two from 2^10 ns (1 us) to 2^35 ns (34 s). */
+#define METRIC_LE_MIN_BITS 10
+#define METRIC_LE_MAX_BITS 35
+
+#define METRIC_SCRAPE_READ_MS 100
+
+typedef struct {
+    atomic_uint_fast64_t buckets[METRIC_BUCKETS];
+    atomic_uint_fast64_t sum_ns;
+} histogram_t;
+
+typedef struct metrics_block {
+    atomic_uint_fast64_t counters[METRIC_COUNTER_COUNT];
+    _Atomic(histogram_t*) histograms[METRIC_HISTOGRAM_COUNT];
+    struct metrics_block* next;
+} metrics_block_t;
+
+typedef struct {
+    const char* name;
+    const char* help;
+    const char* label;
+} metric_info_t;
+
+static const metric_info_t histogram_info[METRIC_PHASE_FIRST] = {
+    {"securekey_request_duration_seconds", "Time to answer a serve request.", "op=\"get\""},
+    {"securekey_request_duration_seconds", NULL, "op=\"list\""},
+    {"securekey_request_duration_seconds", NULL, "op=\"search\""},
+    {"securekey_request_duration_seconds", NULL, "op=\"store\""},
+    {"securekey_request_duration_seconds", NULL, "op=\"remove\""},
+    {"securekey_request_duration_seconds", NULL, "op=\"totp\""},
+    {"securekey_request_duration_seconds", NULL, "op=\"other\""},
+    {"securekey_save_duration_seconds", "Time to write changed vault files.", NULL}
+};
+
+static const metric_info_t counter_info[METRIC_TIMING_COUNTER_FIRST] = {
+    {"securekey_request_errors_total", "Serve requests answered with an error.", NULL},
+    {"securekey_lookups_total", "Entry lookups by service and username.", "result=\"hit\""},
+    {"securekey_lookups_total", NULL, "result=\"miss\""},
+    {"securekey_save_errors_total", "Vault saves that failed.", NULL},
+    {"securekey_reloads_total", "Reloads of a vault changed by another process.", NULL}
+};
+
+static const char* timing_counter_help[TIMING_COUNTER_COUNT] = {
+    "Bytes read from vault files.",
+    "Bytes written to vault files.",
+    "Entries decrypted while opening vaults.",
+    "Entries scanned by list and search."
+};
+
+static const metric_info_t gauge_info[METRIC_GAUGE_COUNT] = {
+    {"securekey_resident_secret_bytes", "Bytes of decrypted entries held in memory.", NULL}
+};
+
+static atomic_bool g_enabled = false;
+static atomic_int_fast64_t g_gauges[METRIC_GAUGE_COUNT];
+
+static pthread_mutex_t g_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static metrics_block_t* g_blocks = NULL;
+static metrics_block_t g_retired;
+static pthread_key_t g_block_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static __thread metrics_block_t* t_block = NULL;
+
+static struct {
+    bool running;
+    pthread_t thread;
+    int stop_pipe[2];
+    int listen_fd;
+    int interval_ms;
+    char textfile[512];
+    char socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+} g_exporter;
+
+/* Only the owning thread writes a block, so a plain load and store is enough. */
+static void bump(atomic_uint_fast64_t* value, uint64_t amount) {
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+static uint32_t bucket_index(uint64_t ns) {
+    if (ns >= (1ull << METRIC_MAX_BITS)) {
+        ns = (1ull << METRIC_MAX_BITS) - 1;
+    }
+    if (ns < METRIC_SUB_BUCKETS) {
+        return (uint32_t)ns;
+    }
+    uint32_t exponent = (uint32_t)(63 - __builtin_clzll(ns)) - METRIC_SUB_BITS + 1;
+    return exponent * METRIC_SUB_BUCKETS + (uint32_t)(ns >> (exponent - 1)) - METRIC_SUB_BUCKETS;
+}
+
+/* Exclusive upper bound of a bucket, in nanoseconds. */
+static uint64_t bucket_limit(uint32_t index) {
+    if (index < METRIC_SUB_BUCKETS) {
+        return index + 1;
+    }
+    uint32_t exponent = index / METRIC_SUB_BUCKETS;
+    uint64_t mantissa = index % METRIC_SUB_BUCKETS + METRIC_SUB_BUCKETS;
+    return (mantissa + 1) << (exponent - 1);
+}
+
+/* Folds an exiting thread's block into g_retired. */
+static void retire_block(void* arg) {
+    metrics_block_t* block = (metrics_block_t*)arg;
+
+    pthread_mutex_lock(&g_registry_lock);
+    for (metrics_block_t** p = &g_blocks; *p; p = &(*p)->next) {
+        if (*p == block) {
+            *p = block->next;
+            break;
+        }
+    }
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        bump(&g_retired.counters[c], atomic_load(&block->counters[c]));
+    }
+    for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        histogram_t* from = atomic_load(&block->histograms[h]);
+        histogram_t* into = atomic_load(&g_retired.histograms[h]);
+        if (from && !into && (into = (histogram_t*)calloc(1, sizeof(histogram_t)))) {
+            atomic_store(&g_retired.histograms[h], into);
+        }
+        if (from && into) {
+            for (uint32_t b = 0; b < METRIC_BUCKETS; b++) {
+                bump(&into->buckets[b], atomic_load(&from->buckets[b]));
+            }
+            bump(&into->sum_ns, atomic_load(&from->sum_ns));
+        }
+        free(from);
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+    free(block);
+}
+
+static void create_block_key(void) {
+    pthread_key_create(&g_block_key, retire_block);
+}
+
+static metrics_block_t* thread_block(void) {
+    if (t_block) {
+        return t_block;
+    }
+
+    pthread_once(&g_key_once, create_block_key);
+    metrics_block_t* block = (metrics_block_t*)calloc(1, sizeof(metrics_block_t));
+    if (!block) {
+        return NULL;
+    }
+    pthread_mutex_lock(&g_registry_lock);
+    block->next = g_blocks;
+    g_blocks = block;
+    pthread_mutex_unlock(&g_registry_lock);
+    pthread_setspecific(g_block_key, block);
+    t_block = block;
+    return block;
+}
+
+void metrics_enable(bool enabled) {
+    atomic_store(&g_enabled, enabled);
+}
+
+bool metrics_enabled(void) {
+    return atomic_load_explicit(&g_enabled, memory_order_relaxed);
+}
+
+/* Returns 0 while metrics are off, which makes the matching metrics_observe() a no-op. */
+uint64_t metrics_now(void) {
+    if (!metrics_enabled()) {
+        return 0;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_observe_ns(metric_histogram_t histogram, uint64_t ns) {
+    if (!metrics_enabled() || histogram >= METRIC_HISTOGRAM_COUNT) {
+        return;
+    }
+    metrics_block_t* block = thread_block();
+    if (!block) {
+        return;
+    }
+
+    histogram_t* h = atomic_load_explicit(&block->histograms[histogram], memory_order_relaxed);
+    if (!h) {
+        h = (histogram_t*)calloc(1, sizeof(histogram_t));
+        if (!h) {
+            return;
+        }
+        atomic_store_explicit(&block->histograms[histogram], h, memory_order_release);
+    }
+    bump(&h->buckets[bucket_index(ns)], 1);
+    bump(&h->sum_ns, ns);
+}
+
+void metrics_observe(metric_histogram_t histogram, uint64_t start) {
+    if (start == 0) {
+        return;
+    }
+    uint64_t now = metrics_now();
+    if (now >= start) {
+        metrics_observe_ns(histogram, now - start);
+    }
+}
+
+void metrics_count(metric_counter_t counter, uint64_t amount) {
+    if (!metrics_enabled() || counter >= METRIC_COUNTER_COUNT) {
+        return;
+    }
+    metrics_block_t* block = thread_block();
+    if (block) {
+        bump(&block->counters[counter], amount);
+    }
+}
+
+void metrics_gauge_add(metric_gauge_t gauge, int64_t amount) {
+    if (gauge < METRIC_GAUGE_COUNT) {
+        atomic_fetch_add_explicit(&g_gauges[gauge], amount, memory_order_relaxed);
+    }
+}
+
+int64_t metrics_gauge(metric_gauge_t gauge) {
+    return gauge < METRIC_GAUGE_COUNT ? (int64_t)atomic_load(&g_gauges[gauge]) : 0;
+}
+
+/* Caller holds g_registry_lock. */
+static uint64_t sum_counter(metric_counter_t counter) {
+    uint64_t total = atomic_load(&g_retired.counters[counter]);
+    for (metrics_block_t* b = g_blocks; b; b = b->next) {
+        total += atomic_load_explicit(&b->counters[counter], memory_order_relaxed);
+    }
+    return total;
+}
+
+/* Caller holds g_registry_lock. Returns the number of recorded values. */
+static uint64_t sum_histogram(metric_histogram_t histogram, uint64_t* buckets, uint64_t* sum_ns) {
+    memset(buckets, 0, METRIC_BUCKETS * sizeof(uint64_t));
+    *sum_ns = 0;
+
+    uint64_t count = 0;
+    for (metrics_block_t* b = &g_retired; b; b = b == &g_retired ? g_blocks : b->next) {
+        histogram_t* h = atomic_load_explicit(&b->histograms[histogram], memory_order_acquire);
+        if (!h) continue;
+        for (uint32_t i = 0; i < METRIC_BUCKETS; i++) {
+            uint64_t n = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+            buckets[i] += n;
+            count += n;
+        }
+        *sum_ns += atomic_load_explicit(&h->sum_ns, memory_order_relaxed);
+    }
+    return count;
+}
+
+uint64_t metrics_counter(metric_counter_t counter) {
+    if (counter >= METRIC_COUNTER_COUNT) {
+        return 0;
+    }
+    pthread_mutex_lock(&g_registry_lock);
+    uint64_t total = sum_counter(counter);
+    pthread_mutex_unlock(&g_registry_lock);
+    return total;
+}
+
+uint64_t metrics_histogram_count(metric_histogram_t histogram) {
+    if (histogram >= METRIC_HISTOGRAM_COUNT) {
+        return 0;
+    }
+    uint64_t buckets[METRIC_BUCKETS], sum_ns;
+    pthread_mutex_lock(&g_registry_lock);
+    uint64_t count = sum_histogram(histogram, buckets, &sum_ns);
+    pthread_mutex_unlock(&g_registry_lock);
+    return count;
+}
+
+/* Returns the largest value that falls in the bucket holding the quantile. */
+uint64_t metrics_histogram_quantile_ns(metric_histogram_t histogram, double quantile) {
+    if (histogram >= METRIC_HISTOGRAM_COUNT) {
+        return 0;
+    }
+    uint64_t buckets[METRIC_BUCKETS], sum_ns;
+    pthread_mutex_lock(&g_registry_lock);
+    uint64_t count = sum_histogram(histogram, buckets, &sum_ns);
+    pthread_mutex_unlock(&g_registry_lock);
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(quantile * (double)count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < METRIC_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucket_limit(i) - 1;
+        }
+    }
+    return bucket_limit(METRIC_BUCKETS - 1) - 1;
+}
+
+/* Clears counters and histograms; gauges track live state and are kept. */
+void metrics_reset(void) {
+    pthread_mutex_lock(&g_registry_lock);
+    for (metrics_block_t* b = &g_retired; b; b = b == &g_retired ? g_blocks : b->next) {
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+            atomic_store(&b->counters[c], 0);
+        }
+        for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+            histogram_t* hist = atomic_load(&b->histograms[h]);
+            if (!hist) continue;
+            for (uint32_t i = 0; i < METRIC_BUCKETS; i++) {
+                atomic_store(&hist->buckets[i], 0);
+            }
+            atomic_store(&hist->sum_ns, 0);
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+}
+
+#define METRIC_NAME_MAX 64
+
+/* Prints HELP and TYPE when a new metric family starts. */
+static void write_family(FILE* out, char* last, const char* name, const char* help,
+                         const char* type) {
+    if (strcmp(last, name) == 0) {
+        return;
+    }
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    snprintf(last, METRIC_NAME_MAX, "%s", name);
+}
+
+/* Rows that continue a family leave help NULL. */
+static const char* family_help(const metric_info_t* info, int index) {
+    while (!info[index].help) index--;
+    return info[index].help;
+}
+
+static void write_value(FILE* out, const char* name, const char* suffix, const char* label,
+                        unsigned long long value) {
+    if (label) {
+        fprintf(out, "%s%s{%s} %llu\n", name, suffix, label, value);
+    } else {
+        fprintf(out, "%s%s %llu\n", name, suffix, value);
+    }
+}
+
+static void write_histogram(FILE* out, const char* name, const char* label, const uint64_t* buckets,
+                            uint64_t count, uint64_t sum_ns) {
+    const char* sep = label ? "," : "";
+    uint64_t cumulative = 0;
+    uint32_t b = 0;
+    for (int bits = METRIC_LE_MIN_BITS; bits <= METRIC_LE_MAX_BITS; bits++) {
+        while (b < METRIC_BUCKETS && bucket_limit(b) <= (1ull << bits)) {
+            cumulative += buckets[b++];
+        }
+        fprintf(out, "%s_bucket{%s%sle=\"%.12g\"} %llu\n", name, label ? label : "", sep,
+                (double)(1ull << bits) / 1e9, (unsigned long long)cumulative);
+    }
+    fprintf(out, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, label ? label : "", sep,
+            (unsigned long long)count);
+    if (label) {
+        fprintf(out, "%s_sum{%s} %.9f\n", name, label, sum_ns / 1e9);
+    } else {
+        fprintf(out, "%s_sum %.9f\n", name, sum_ns / 1e9);
+    }
+    write_value(out, name, "_count", label, count);
+}
+
+/* Prometheus text exposition format. Histograms with no values are left out. */
+int metrics_write(FILE* out) {
+    if (!out) return -1;
+
+    char last[METRIC_NAME_MAX] = "";
+    uint64_t buckets[METRIC_BUCKETS];
+    uint64_t sum_ns;
+    pthread_mutex_lock(&g_registry_lock);
+
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        uint64_t value = sum_counter((metric_counter_t)c);
+        if (c < METRIC_TIMING_COUNTER_FIRST) {
+            write_family(out, last, counter_info[c].name, family_help(counter_info, c), "counter");
+            write_value(out, counter_info[c].name, "", counter_info[c].label, value);
+        } else {
+            int t = c - METRIC_TIMING_COUNTER_FIRST;
+            char name[METRIC_NAME_MAX];
+            snprintf(name, sizeof(name), "securekey_%s_total",
+                     timings_counter_name((timing_counter_t)t));
+            write_family(out, last, name, timing_counter_help[t], "counter");
+            write_value(out, name, "", NULL, value);
+        }
+    }
+
+    for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        uint64_t count = sum_histogram((metric_histogram_t)h, buckets, &sum_ns);
+        if (count == 0) continue;
+
+        if (h < METRIC_PHASE_FIRST) {
+            write_family(out, last, histogram_info[h].name, family_help(histogram_info, h),
+                         "histogram");
+            write_histogram(out, histogram_info[h].name, histogram_info[h].label, buckets, count,
+                            sum_ns);
+        } else {
+            char label[48];
+            snprintf(label, sizeof(label), "phase=\"%s\"",
+                     timings_phase_name((timing_phase_t)(h - METRIC_PHASE_FIRST)));
+            write_family(out, last, "securekey_phase_duration_seconds",
+                         "Time spent in each vault phase, summed over threads.", "histogram");
+            write_histogram(out, "securekey_phase_duration_seconds", label, buckets, count, sum_ns);
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+
+    for (int g = 0; g < METRIC_GAUGE_COUNT; g++) {
+        fprintf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %lld\n", gauge_info[g].name,
+                gauge_info[g].help, gauge_info[g].name, gauge_info[g].name,
+                (long long)metrics_gauge((metric_gauge_t)g));
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+/* Writes a temporary file and renames it, as the node_exporter textfile collector expects. */
+int metrics_write_textfile(const char* path) {
+    if (!path) return -1;
+
+    char tmp[600];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* out = fopen(tmp, "w");
+    if (!out) {
+        return -1;
+    }
+    int ret = metrics_write(out);
+    if (fclose(out) != 0) {
+        ret = -1;
+    }
+    if (ret != 0 || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static int send_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/*
+ * One scrape per connection. A client that sends an HTTP GET (for example
+ * curl --unix-socket) gets an HTTP/1.0 response; anything else gets the
+ * bare text.
+ */
+static void answer_scrape(int listen_fd) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+
+    char request[1024];
+    ssize_t got = 0;
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, METRIC_SCRAPE_READ_MS) > 0) {
+        got = recv(fd, request, sizeof(request) - 1, MSG_DONTWAIT);
+    }
+    bool http = got >= 4 && memcmp(request, "GET ", 4) == 0;
+
+    char* body = NULL;
+    size_t body_len = 0;
+    FILE* mem = open_memstream(&body, &body_len);
+    if (mem) {
+        metrics_write(mem);
+        fclose(mem);
+    }
+    if (body) {
+        char header[160];
+        int header_len = snprintf(header, sizeof(header),
+                                  "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: %zu\r\n\r\n", body_len);
+        if (!http || send_all(fd, header, (size_t)header_len) == 0) {
+            send_all(fd, body, body_len);
+        }
+        free(body);
+    }
+    close(fd);
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void* exporter_main(void* arg) {
+    (void)arg;
+    bool textfile = g_exporter.textfile[0] != '\0';
+    uint64_t next = monotonic_ms() + (uint64_t)g_exporter.interval_ms;
+    if (textfile) {
+        metrics_write_textfile(g_exporter.textfile);
+    }
+
+    for (;;) {
+        struct pollfd fds[2] = {{g_exporter.stop_pipe[0], POLLIN, 0},
+                                {g_exporter.listen_fd, POLLIN, 0}};
+        nfds_t nfds = g_exporter.listen_fd >= 0 ? 2 : 1;
+        uint64_t now = monotonic_ms();
+        int timeout = !textfile ? -1 : now >= next ? 0 : (int)(next - now);
+
+        int ready = poll(fds, nfds, timeout);
+        if (ready < 0 && errno != EINTR) break;
+        if (ready > 0 && fds[0].revents) break;
+        if (ready > 0 && nfds == 2 && (fds[1].revents & POLLIN)) {
+            answer_scrape(g_exporter.listen_fd);
+        }
+
+        now = monotonic_ms();
+        if (textfile && now >= next) {
+            metrics_write_textfile(g_exporter.textfile);
+            next = now + (uint64_t)g_exporter.interval_ms;
+        }
+    }
+    return NULL;
+}
+
+static int open_metrics_socket(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Metrics socket path is too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    /* A socket left behind by an earlier run is replaced; any other file is not. */
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create metrics socket: %s\n", strerror(errno));
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || chmod(path, 0600) != 0 ||
+        listen(fd, 8) != 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Enables metrics and starts a thread that rewrites textfile every
+ * interval_sec seconds and/or answers scrapes on socket_path.
+ */
+int metrics_start_exporter(const char* textfile, const char* socket_path, int interval_sec) {
+    if (g_exporter.running || (!textfile && !socket_path) || interval_sec <= 0) {
+        return -1;
+    }
+
+    memset(&g_exporter, 0, sizeof(g_exporter));
+    g_exporter.listen_fd = -1;
+    g_exporter.interval_ms = interval_sec * 1000;
+    if (textfile) {
+        snprintf(g_exporter.textfile, sizeof(g_exporter.textfile), "%s", textfile);
+    }
+    if (socket_path) {
+        g_exporter.listen_fd = open_metrics_socket(socket_path);
+        if (g_exporter.listen_fd < 0) {
+            return -1;
+        }
+        snprintf(g_exporter.socket_path, sizeof(g_exporter.socket_path), "%s", socket_path);
+    }
+    if (pipe(g_exporter.stop_pipe) != 0) {
+        if (g_exporter.listen_fd >= 0) {
+            close(g_exporter.listen_fd);
+            unlink(g_exporter.socket_path);
+        }
+        return -1;
+    }
+
+    metrics_enable(true);
+    if (pthread_create(&g_exporter.thread, NULL, exporter_main, NULL) != 0) {
+        close(g_exporter.stop_pipe[0]);
+        close(g_exporter.stop_pipe[1]);
+        if (g_exporter.listen_fd >= 0) {
+            close(g_exporter.listen_fd);
+            unlink(g_exporter.socket_path);
+        }
+        return -1;
+    }
+    g_exporter.running = true;
+    return 0;
+}
+
+/* Stops the exporter thread and writes the textfile one last time. */
+void metrics_stop_exporter(void) {
+    if (!g_exporter.running) {
+        return;
+    }
+
+    ssize_t ignored = write(g_exporter.stop_pipe[1], "x", 1);
+    (void)ignored;
+    pthread_join(g_exporter.thread, NULL);
+    close(g_exporter.stop_pipe[0]);
+    close(g_exporter.stop_pipe[1]);
+    if (g_exporter.listen_fd >= 0) {
+        close(g_exporter.listen_fd);
+        unlink(g_exporter.socket_path);
+    }
+    if (g_exporter.textfile[0]) {
+        metrics_write_textfile(g_exporter.textfile);
+    }
+    g_exporter.running = false;
+}
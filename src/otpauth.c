@@ -0,0 +1,301 @@
+#include "otpauth.h"
+#include "crypto_engine.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int percent_decode(const char* src, size_t len, char* dst, size_t dst_size, int plus_is_space) {
+    size_t out = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = src[i];
+
+        if (c == '%') {
+            if (i + 2 >= len) return -1;
+            int hi = hex_value(src[i + 1]);
+            int lo = hex_value(src[i + 2]);
+            if (hi < 0 || lo < 0) return -1;
+            c = (char)((hi << 4) | lo);
+            i += 2;
+        } else if (c == '+' && plus_is_space) {
+            c = ' ';
+        }
+
+        if (c == '\0' || out + 1 >= dst_size) return -1;
+        dst[out++] = c;
+    }
+
+    dst[out] = '\0';
+    return 0;
+}
+
+static void trim_spaces(char* str) {
+    size_t start = 0;
+    while (str[start] == ' ') start++;
+
+    size_t len = strlen(str + start);
+    memmove(str, str + start, len + 1);
+
+    while (len > 0 && str[len - 1] == ' ') {
+        str[--len] = '\0';
+    }
+}
+
+static int normalize_secret(const char* raw, char* secret, size_t secret_size) {
+    size_t out = 0;
+
+    for (const char* p = raw; *p; p++) {
+        char c = (char)toupper((unsigned char)*p);
+        if (c == ' ' || c == '-' || c == '=') continue;
+        if (!((c >= 'A' && c <= 'Z') || (c >= '2' && c <= '7'))) return -1;
+        if (out + 1 >= secret_size) return -1;
+        secret[out++] = c;
+    }
+
+    secret[out] = '\0';
+    return out > 0 ? 0 : -1;
+}
+
+static int parse_number(const char* value, unsigned long long max, unsigned long long* result) {
+    if (!isdigit((unsigned char)value[0])) return -1;
+
+    char* end;
+    errno = 0;
+    unsigned long long number = strtoull(value, &end, 10);
+    if (errno != 0 || *end != '\0' || number > max) return -1;
+
+    *result = number;
+    return 0;
+}
+
+static int parse_parameter(otpauth_uri_t* out, const char* key, const char* value,
+                           int* has_secret, int* has_counter) {
+    unsigned long long number;
+
+    if (strcasecmp(key, "secret") == 0) {
+        if (normalize_secret(value, out->secret, sizeof(out->secret)) != 0) return -1;
+        *has_secret = 1;
+    } else if (strcasecmp(key, "issuer") == 0) {
+        if (strlen(value) >= sizeof(out->issuer)) return -1;
+        strcpy(out->issuer, value);
+        trim_spaces(out->issuer);
+    } else if (strcasecmp(key, "algorithm") == 0) {
+        if (totp_algorithm_from_name(value, &out->algorithm) != 0) return -1;
+    } else if (strcasecmp(key, "digits") == 0) {
+        if (parse_number(value, TOTP_MAX_DIGITS, &number) != 0 || number < TOTP_MIN_DIGITS) return -1;
+        out->digits = (int)number;
+    } else if (strcasecmp(key, "period") == 0) {
+        if (parse_number(value, 86400, &number) != 0 || number == 0) return -1;
+        out->period = (uint32_t)number;
+    } else if (strcasecmp(key, "counter") == 0) {
+        if (parse_number(value, UINT64_MAX, &number) != 0) return -1;
+        out->counter = number;
+        *has_counter = 1;
+    }
+
+    return 0;
+}
+
+int otpauth_parse(const char* uri, otpauth_uri_t* out) {
+    if (!uri || !out) return -1;
+
+    memset(out, 0, sizeof(*out));
+    out->algorithm = TOTP_ALG_SHA1;
+    out->digits = TOTP_DEFAULT_DIGITS;
+    out->period = TOTP_DEFAULT_PERIOD;
+
+    size_t scheme_len = strlen(OTPAUTH_SCHEME);
+    if (strncasecmp(uri, OTPAUTH_SCHEME, scheme_len) != 0) return -1;
+
+    const char* type = uri + scheme_len;
+    const char* slash = strchr(type, '/');
+    if (!slash) return -1;
+
+    size_t type_len = slash - type;
+    if (type_len == 4 && strncasecmp(type, "totp", 4) == 0) {
+        out->type = OTP_TYPE_TOTP;
+    } else if (type_len == 4 && strncasecmp(type, "hotp", 4) == 0) {
+        out->type = OTP_TYPE_HOTP;
+    } else {
+        return -1;
+    }
+
+    const char* label = slash + 1;
+    const char* query = strchr(label, '?');
+    size_t label_len = query ? (size_t)(query - label) : strlen(label);
+
+    char decoded_label[VAULT_SERVICE_LEN + VAULT_USERNAME_LEN];
+    if (percent_decode(label, label_len, decoded_label, sizeof(decoded_label), 0) != 0) return -1;
+
+    char* colon = strchr(decoded_label, ':');
+    const char* account = decoded_label;
+    if (colon) {
+        *colon = '\0';
+        if (strlen(decoded_label) >= sizeof(out->issuer)) return -1;
+        strcpy(out->issuer, decoded_label);
+        trim_spaces(out->issuer);
+        account = colon + 1;
+    }
+
+    if (strlen(account) >= sizeof(out->account)) return -1;
+    strcpy(out->account, account);
+    trim_spaces(out->account);
+
+    int has_secret = 0, has_counter = 0;
+    const char* param = query ? query + 1 : NULL;
+
+    while (param && *param) {
+        const char* amp = strchr(param, '&');
+        size_t param_len = amp ? (size_t)(amp - param) : strlen(param);
+        const char* eq = memchr(param, '=', param_len);
+
+        if (eq) {
+            char key[32];
+            char value[VAULT_SERVICE_LEN];
+            size_t key_len = eq - param;
+
+            if (percent_decode(param, key_len, key, sizeof(key), 1) != 0 ||
+                percent_decode(eq + 1, param_len - key_len - 1, value, sizeof(value), 1) != 0 ||
+                parse_parameter(out, key, value, &has_secret, &has_counter) != 0) {
+                secure_cleanup(value, sizeof(value));
+                secure_cleanup(out, sizeof(*out));
+                return -1;
+            }
+            secure_cleanup(value, sizeof(value));
+        }
+
+        param = amp ? amp + 1 : NULL;
+    }
+
+    if (!has_secret || out->account[0] == '\0' ||
+        (out->type == OTP_TYPE_HOTP && !has_counter)) {
+        secure_cleanup(out, sizeof(*out));
+        return -1;
+    }
+
+    return 0;
+}
+
+int otpauth_to_entry(const otpauth_uri_t* uri, VaultEntry* entry) {
+    if (!uri || !entry) return -1;
+
+    memset(entry, 0, sizeof(*entry));
+
+    const char* service = uri->issuer[0] != '\0' ? uri->issuer : uri->account;
+    strncpy(entry->service, service, VAULT_SERVICE_LEN - 1);
+    strncpy(entry->username, uri->account, VAULT_USERNAME_LEN - 1);
+    strncpy(entry->totp_secret, uri->secret, VAULT_TOTP_LEN - 1);
+
+    entry->totp_type = (uint8_t)uri->type;
+    entry->totp_algorithm = (uint8_t)uri->algorithm;
+    entry->totp_digits = (uint8_t)uri->digits;
+    entry->totp_period = uri->period;
+    entry->totp_counter = uri->counter;
+
+    return 0;
+}
+
+static char* trim_line(char* line) {
+    while (isspace((unsigned char)*line)) line++;
+
+    size_t len = strlen(line);
+    while (len > 0 && isspace((unsigned char)line[len - 1])) {
+        line[--len] = '\0';
+    }
+
+    return line;
+}
+
+int otpauth_import_stream(FILE* input, otpauth_import_stats_t* stats) {
+    if (!input || !stats) return -1;
+
+    memset(stats, 0, sizeof(*stats));
+
+    if (vault_begin_batch() != 0) {
+        return -1;
+    }
+
+    char* line = NULL;
+    size_t capacity = 0;
+    size_t line_number = 0;
+    int ret = 0;
+
+    while (getline(&line, &capacity, input) != -1) {
+        line_number++;
+
+        char* uri = trim_line(line);
+        if (uri[0] == '\0' || uri[0] == '#') {
+            continue;
+        }
+
+        otpauth_uri_t parsed;
+        if (otpauth_parse(uri, &parsed) != 0) {
+            fprintf(stderr, "Line %zu: invalid otpauth URI, skipped\n", line_number);
+            stats->failed++;
+            continue;
+        }
+
+        VaultEntry entry;
+        otpauth_to_entry(&parsed, &entry);
+        secure_cleanup(&parsed, sizeof(parsed));
+
+        int existing = vault_find_entry(entry.service, entry.username);
+        if (existing >= 0) {
+            VaultEntry current;
+            if (vault_get(entry.service, entry.username, &current) == 0) {
+                memcpy(entry.password, current.password, sizeof(entry.password));
+            }
+            secure_cleanup(&current, sizeof(current));
+        }
+
+        if (vault_put_entry(&entry) != 0) {
+            fprintf(stderr, "Line %zu: failed to store entry\n", line_number);
+            stats->failed++;
+        } else if (existing >= 0) {
+            stats->updated++;
+        } else {
+            stats->imported++;
+        }
+
+        secure_cleanup(&entry, sizeof(entry));
+    }
+
+    if (line) {
+        secure_cleanup(line, capacity);
+        free(line);
+    }
+
+    if (ferror(input)) {
+        fprintf(stderr, "Failed to read import file\n");
+        ret = -1;
+    }
+
+    if (vault_commit_batch() != 0) {
+        ret = -1;
+    }
+
+    return ret;
+}
+
+int otpauth_import_file(const char* path, otpauth_import_stats_t* stats) {
+    if (!path) return -1;
+
+    FILE* input = fopen(path, "r");
+    if (!input) {
+        fprintf(stderr, "Failed to open import file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int ret = otpauth_import_stream(input, stats);
+    fclose(input);
+    return ret;
+}
@@ -0,0 +1,126 @@
+#include "passphrase.h"
+#include "crypto_engine.h"
+#include <math.h>
+#include <string.h>
+
+static const char passphrase_words[][PASSPHRASE_MAX_WORD_LEN + 1] = {
+#include "wordlist.inc"
+};
+
+#define PASSPHRASE_WORD_COUNT (sizeof(passphrase_words) / sizeof(passphrase_words[0]))
+
+_Static_assert(PASSPHRASE_WORD_COUNT >= 1024, "passphrase wordlist is too small");
+
+void passphrase_policy_default(passphrase_policy_t* policy) {
+    if (!policy) return;
+
+    memset(policy, 0, sizeof(*policy));
+    policy->words = PASSPHRASE_DEFAULT_WORDS;
+    strcpy(policy->separator, PASSPHRASE_DEFAULT_SEPARATOR);
+    policy->capitalize = PASSPHRASE_CAPS_NONE;
+}
+
+int passphrase_parse_capitalize(const char* spec, passphrase_caps_t* caps) {
+    if (!spec || !caps) return -1;
+
+    if (strcmp(spec, "none") == 0) {
+        *caps = PASSPHRASE_CAPS_NONE;
+    } else if (strcmp(spec, "first") == 0) {
+        *caps = PASSPHRASE_CAPS_FIRST;
+    } else if (strcmp(spec, "all") == 0) {
+        *caps = PASSPHRASE_CAPS_ALL;
+    } else if (strcmp(spec, "random") == 0) {
+        *caps = PASSPHRASE_CAPS_RANDOM;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+size_t passphrase_wordlist_size(void) {
+    return PASSPHRASE_WORD_COUNT;
+}
+
+const char* passphrase_word(size_t index) {
+    return index < PASSPHRASE_WORD_COUNT ? passphrase_words[index] : NULL;
+}
+
+double passphrase_entropy_bits(const passphrase_policy_t* policy) {
+    if (!policy) return 0.0;
+
+    double bits = policy->words * log2((double)PASSPHRASE_WORD_COUNT);
+    if (policy->capitalize == PASSPHRASE_CAPS_RANDOM) {
+        bits += policy->words;
+    }
+    return bits;
+}
+
+int passphrase_generator_init(passphrase_generator_t* gen, const passphrase_policy_t* policy) {
+    if (!gen || !policy) return -1;
+
+    memset(gen, 0, sizeof(*gen));
+    gen->policy = *policy;
+    gen->policy.separator[PASSPHRASE_MAX_SEPARATOR] = '\0';
+    gen->separator_len = strlen(gen->policy.separator);
+    random_pool_init(&gen->pool);
+
+    if (policy->words < PASSPHRASE_MIN_WORDS || policy->words > PASSPHRASE_MAX_WORDS) {
+        return -1;
+    }
+    if (policy->capitalize < PASSPHRASE_CAPS_NONE || policy->capitalize > PASSPHRASE_CAPS_RANDOM) {
+        return -1;
+    }
+    return 0;
+}
+
+int passphrase_generator_next(passphrase_generator_t* gen, char* output, size_t output_len) {
+    if (!gen || !output || output_len == 0) return -1;
+
+    size_t length = 0;
+
+    for (int i = 0; i < gen->policy.words; i++) {
+        uint32_t index;
+        if (random_pool_uniform(&gen->pool, (uint32_t)PASSPHRASE_WORD_COUNT, &index) != 0) {
+            secure_cleanup(output, length);
+            return -1;
+        }
+
+        const char* word = passphrase_words[index];
+        size_t word_len = strlen(word);
+        size_t sep_len = i > 0 ? gen->separator_len : 0;
+
+        if (length + sep_len + word_len + 1 > output_len) {
+            secure_cleanup(output, length);
+            return -1;
+        }
+
+        memcpy(output + length, gen->policy.separator, sep_len);
+        length += sep_len;
+
+        int upper = 0;
+        if (gen->policy.capitalize == PASSPHRASE_CAPS_RANDOM) {
+            uint32_t bit;
+            if (random_pool_uniform(&gen->pool, 2, &bit) != 0) {
+                secure_cleanup(output, length);
+                return -1;
+            }
+            upper = (int)bit;
+        } else {
+            upper = gen->policy.capitalize != PASSPHRASE_CAPS_NONE;
+        }
+
+        for (size_t j = 0; j < word_len; j++) {
+            char c = word[j];
+            int raise = gen->policy.capitalize == PASSPHRASE_CAPS_ALL || (upper && j == 0);
+            output[length++] = (raise && c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+        }
+    }
+
+    output[length] = '\0';
+    return (int)length;
+}
+
+void passphrase_generator_cleanup(passphrase_generator_t* gen) {
+    if (!gen) return;
+    random_pool_cleanup(&gen->pool);
+}
@@ -0,0 +1,221 @@
+#include "password_gen.h"
+#include "crypto_engine.h"
+#include <openssl/rand.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/random.h>
+
+#define PWGEN_MAX_ATTEMPTS 1000
+
+static const char lower_chars[] = "abcdefghijklmnopqrstuvwxyz";
+static const char upper_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const char digit_chars[] = "0123456789";
+static const char symbol_chars[] = "!@#$%^&*()-_=+";
+
+static unsigned int char_class(char c) {
+    if (c >= 'a' && c <= 'z') return PWGEN_CLASS_LOWER;
+    if (c >= 'A' && c <= 'Z') return PWGEN_CLASS_UPPER;
+    if (c >= '0' && c <= '9') return PWGEN_CLASS_DIGIT;
+    return PWGEN_CLASS_SYMBOL;
+}
+
+static int popcount(unsigned int value) {
+    int count = 0;
+    while (value) {
+        count += value & 1u;
+        value >>= 1;
+    }
+    return count;
+}
+
+void password_policy_default(password_policy_t* policy, int length) {
+    if (!policy) return;
+
+    memset(policy, 0, sizeof(*policy));
+    policy->min_length = length;
+    policy->max_length = length;
+    policy->required_classes = 0;
+    policy->exclude_ambiguous = 0;
+}
+
+int password_policy_parse_classes(const char* spec, unsigned int* classes) {
+    if (!spec || !classes) return -1;
+
+    unsigned int mask = 0;
+    const char* p = spec;
+
+    while (*p) {
+        const char* comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+
+        if (len == 5 && strncmp(p, "lower", 5) == 0) {
+            mask |= PWGEN_CLASS_LOWER;
+        } else if (len == 5 && strncmp(p, "upper", 5) == 0) {
+            mask |= PWGEN_CLASS_UPPER;
+        } else if (len == 5 && strncmp(p, "digit", 5) == 0) {
+            mask |= PWGEN_CLASS_DIGIT;
+        } else if (len == 6 && strncmp(p, "symbol", 6) == 0) {
+            mask |= PWGEN_CLASS_SYMBOL;
+        } else if (len == 3 && strncmp(p, "all", 3) == 0) {
+            mask |= PWGEN_CLASS_ALL;
+        } else {
+            return -1;
+        }
+
+        p = comma ? comma + 1 : p + len;
+    }
+
+    *classes = mask;
+    return 0;
+}
+
+void random_pool_init(random_pool_t* pool) {
+    if (!pool) return;
+    pool->pos = PWGEN_POOL_SIZE;
+}
+
+static int random_pool_fill(unsigned char* bytes, size_t len) {
+    size_t filled = 0;
+    while (filled < len) {
+        ssize_t n = getrandom(bytes + filled, len - filled, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return RAND_bytes(bytes, (int)len) == 1 ? 0 : -1;
+        }
+        filled += (size_t)n;
+    }
+    return 0;
+}
+
+static int random_pool_read(random_pool_t* pool, unsigned char* out, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (pool->pos >= PWGEN_POOL_SIZE) {
+            if (random_pool_fill(pool->bytes, PWGEN_POOL_SIZE) != 0) {
+                return -1;
+            }
+            pool->pos = 0;
+        }
+        out[i] = pool->bytes[pool->pos];
+        pool->bytes[pool->pos++] = 0;
+    }
+    return 0;
+}
+
+int random_pool_uniform(random_pool_t* pool, uint32_t bound, uint32_t* value) {
+    if (!pool || !value || bound == 0) return -1;
+
+    if (bound == 1) {
+        *value = 0;
+        return 0;
+    }
+
+    if (bound <= 256) {
+        uint32_t limit = 256 - (256 % bound);
+        unsigned char byte;
+        do {
+            if (random_pool_read(pool, &byte, 1) != 0) return -1;
+        } while (byte >= limit);
+        *value = byte % bound;
+        return 0;
+    }
+
+    uint64_t limit = 0x100000000ULL - (0x100000000ULL % bound);
+    uint32_t word;
+    do {
+        unsigned char bytes[4];
+        if (random_pool_read(pool, bytes, sizeof(bytes)) != 0) return -1;
+        word = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+               ((uint32_t)bytes[2] << 8) | bytes[3];
+    } while (word >= limit);
+
+    *value = word % bound;
+    return 0;
+}
+
+void random_pool_cleanup(random_pool_t* pool) {
+    if (!pool) return;
+    secure_cleanup(pool->bytes, sizeof(pool->bytes));
+    pool->pos = PWGEN_POOL_SIZE;
+}
+
+static void append_chars(password_generator_t* gen, const char* chars, int exclude_ambiguous) {
+    for (const char* p = chars; *p; p++) {
+        if (*p < 0x21 || *p > 0x7E) continue;
+        if (exclude_ambiguous && strchr(PWGEN_AMBIGUOUS_CHARS, *p)) continue;
+        if (memchr(gen->charset, *p, gen->charset_len)) continue;
+        if (gen->charset_len >= PWGEN_MAX_ALPHABET) return;
+
+        gen->charset[gen->charset_len++] = *p;
+        gen->available_classes |= char_class(*p);
+    }
+    gen->charset[gen->charset_len] = '\0';
+}
+
+int password_generator_init(password_generator_t* gen, const password_policy_t* policy) {
+    if (!gen || !policy) return -1;
+
+    memset(gen, 0, sizeof(*gen));
+    gen->policy = *policy;
+    random_pool_init(&gen->pool);
+
+    if (policy->min_length < PWGEN_MIN_LENGTH || policy->max_length > PWGEN_MAX_LENGTH ||
+        policy->min_length > policy->max_length) {
+        return -1;
+    }
+
+    if (policy->alphabet[0] != '\0') {
+        append_chars(gen, policy->alphabet, policy->exclude_ambiguous);
+    } else {
+        append_chars(gen, lower_chars, policy->exclude_ambiguous);
+        append_chars(gen, upper_chars, policy->exclude_ambiguous);
+        append_chars(gen, digit_chars, policy->exclude_ambiguous);
+        append_chars(gen, symbol_chars, policy->exclude_ambiguous);
+    }
+
+    if (gen->charset_len < 2) return -1;
+
+    if ((policy->required_classes & ~gen->available_classes) != 0) return -1;
+
+    if (popcount(policy->required_classes) > policy->min_length) return -1;
+
+    return 0;
+}
+
+int password_generator_next(password_generator_t* gen, char* output, size_t output_len) {
+    if (!gen || !output || gen->charset_len < 2) return -1;
+
+    uint32_t extra = 0;
+    uint32_t span = (uint32_t)(gen->policy.max_length - gen->policy.min_length + 1);
+    if (random_pool_uniform(&gen->pool, span, &extra) != 0) return -1;
+
+    int length = gen->policy.min_length + (int)extra;
+    if ((size_t)length + 1 > output_len) return -1;
+
+    for (int attempt = 0; attempt < PWGEN_MAX_ATTEMPTS; attempt++) {
+        unsigned int seen = 0;
+
+        for (int i = 0; i < length; i++) {
+            uint32_t index;
+            if (random_pool_uniform(&gen->pool, (uint32_t)gen->charset_len, &index) != 0) {
+                secure_cleanup(output, length);
+                return -1;
+            }
+            output[i] = gen->charset[index];
+            seen |= char_class(output[i]);
+        }
+        output[length] = '\0';
+
+        if ((seen & gen->policy.required_classes) == gen->policy.required_classes) {
+            return length;
+        }
+    }
+
+    secure_cleanup(output, length);
+    return -1;
+}
+
+void password_generator_cleanup(password_generator_t* gen) {
+    if (!gen) return;
+    random_pool_cleanup(&gen->pool);
+    secure_cleanup(gen, sizeof(*gen));
+}
@@ -0,0 +1,337 @@
+#include "render.h"
+#include "crypto_engine.h"
+#include "shell.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RENDER_TAG_ARGS 6
+
+typedef struct {
+    render_job_t* jobs;
+    size_t count;
+    const render_refs_t* refs;
+    atomic_size_t next;
+} RenderContext;
+
+static int compare_key(const render_ref_t* ref, const char* service, const char* username,
+                       ref_field_t field) {
+    int cmp = strcmp(ref->service, service);
+    if (cmp == 0) cmp = strcmp(ref->username, username);
+    if (cmp == 0) cmp = (int)ref->ref.field - (int)field;
+    return cmp;
+}
+
+static int find_slot(const render_refs_t* refs, const char* service, const char* username,
+                     ref_field_t field, size_t* slot) {
+    size_t lo = 0, hi = refs->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = compare_key(&refs->refs[mid], service, username, field);
+        if (cmp == 0) {
+            *slot = mid;
+            return 1;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    *slot = lo;
+    return 0;
+}
+
+static int insert_ref(render_refs_t* refs, const char* service, const char* username,
+                      ref_field_t field, size_t source, size_t line) {
+    size_t slot;
+    if (find_slot(refs, service, username, field, &slot)) return RENDER_OK;
+    if (refs->count == RENDER_MAX_REFS) return RENDER_ERR_LIMIT;
+
+    if (refs->count == refs->capacity) {
+        size_t capacity = refs->capacity ? refs->capacity * 2 : 16;
+        render_ref_t* grown = realloc(refs->refs, capacity * sizeof(render_ref_t));
+        if (!grown) return RENDER_ERR_LIMIT;
+        refs->refs = grown;
+        refs->capacity = capacity;
+    }
+
+    memmove(&refs->refs[slot + 1], &refs->refs[slot], (refs->count - slot) * sizeof(render_ref_t));
+    refs->count++;
+
+    render_ref_t* ref = &refs->refs[slot];
+    memset(ref, 0, sizeof(*ref));
+    strcpy(ref->service, service);
+    strcpy(ref->username, username);
+    ref->ref.field = field;
+    ref->ref.entry_index = -1;
+    ref->source = source;
+    ref->line = line;
+    return RENDER_OK;
+}
+
+static int is_vault_tag(const char* tag) {
+    while (*tag == ' ' || *tag == '\t' || *tag == '\n' || *tag == '\r') tag++;
+    return strncmp(tag, "vault", 5) == 0 &&
+           (tag[5] == ' ' || tag[5] == '\t' || tag[5] == '\n' || tag[5] == '\r' || tag[5] == '\0');
+}
+
+static int handle_tag(const char* tag, FILE* out, render_refs_t* refs, size_t source,
+                      size_t line, size_t* substitutions) {
+    if (!is_vault_tag(tag)) {
+        if (out && fprintf(out, "{{%s}}", tag) < 0) return RENDER_ERR_IO;
+        return RENDER_OK;
+    }
+
+    char work[RENDER_TAG_MAX + 1];
+    char* argv[RENDER_TAG_ARGS];
+    strcpy(work, tag);
+    int argc = shell_tokenize(work, argv, RENDER_TAG_ARGS);
+    if (argc < 3 || argc > 4 ||
+        strlen(argv[1]) >= VAULT_SERVICE_LEN || strlen(argv[2]) >= VAULT_USERNAME_LEN) {
+        return RENDER_ERR_SYNTAX;
+    }
+
+    ref_field_t field = REF_FIELD_PASSWORD;
+    if (argc == 4 && vault_ref_parse_field(argv[3], &field) != 0) return RENDER_ERR_SYNTAX;
+
+    if (!out) return insert_ref(refs, argv[1], argv[2], field, source, line);
+
+    size_t slot;
+    if (!find_slot(refs, argv[1], argv[2], field, &slot) || refs->refs[slot].value_len < 0) {
+        return RENDER_ERR_MISSING;
+    }
+
+    const render_ref_t* ref = &refs->refs[slot];
+    if (fwrite(ref->value, 1, (size_t)ref->value_len, out) != (size_t)ref->value_len) {
+        return RENDER_ERR_IO;
+    }
+    if (substitutions) (*substitutions)++;
+    return RENDER_OK;
+}
+
+static int process(FILE* in, FILE* out, render_refs_t* refs, size_t source,
+                   size_t* substitutions, size_t* error_line) {
+    char tag[RENDER_TAG_MAX + 1];
+    size_t line = 1;
+    int c;
+
+    while ((c = getc_unlocked(in)) != EOF) {
+        if (c != '{') {
+            if (c == '\n') line++;
+            if (out && putc_unlocked(c, out) == EOF) return RENDER_ERR_IO;
+            continue;
+        }
+
+        int next = getc_unlocked(in);
+        if (next != '{') {
+            if (out && putc_unlocked('{', out) == EOF) return RENDER_ERR_IO;
+            if (next == EOF) break;
+            ungetc(next, in);
+            continue;
+        }
+
+        size_t tag_line = line;
+        size_t len = 0;
+        int prev = 0, closed = 0;
+        while ((c = getc_unlocked(in)) != EOF) {
+            if (c == '}' && prev == '}') {
+                len--;
+                closed = 1;
+                break;
+            }
+            if (len == RENDER_TAG_MAX) {
+                if (error_line) *error_line = tag_line;
+                return RENDER_ERR_LIMIT;
+            }
+            if (c == '\n') line++;
+            tag[len++] = (char)c;
+            prev = c;
+        }
+
+        if (!closed) {
+            if (error_line) *error_line = tag_line;
+            return ferror(in) ? RENDER_ERR_IO : RENDER_ERR_SYNTAX;
+        }
+        tag[len] = '\0';
+
+        int ret = handle_tag(tag, out, refs, source, tag_line, substitutions);
+        secure_cleanup(tag, len);
+        if (ret != RENDER_OK) {
+            if (error_line) *error_line = tag_line;
+            return ret;
+        }
+    }
+
+    return ferror(in) ? RENDER_ERR_IO : RENDER_OK;
+}
+
+int render_scan(FILE* in, size_t source, render_refs_t* refs, size_t* error_line) {
+    if (!in || !refs) return RENDER_ERR_IO;
+    return process(in, NULL, refs, source, NULL, error_line);
+}
+
+int render_refs_resolve(render_refs_t* refs, size_t* missing) {
+    if (!refs) return RENDER_ERR_IO;
+
+    for (size_t i = 0; i < refs->count; i++) {
+        render_ref_t* ref = &refs->refs[i];
+        ref->ref.service = ref->service;
+        ref->ref.username = ref->username;
+        ref->ref.entry_index = vault_find_entry(ref->service, ref->username);
+        ref->value_len = vault_ref_value(&ref->ref, ref->value, sizeof(ref->value));
+        if (ref->value_len < 0) {
+            if (missing) *missing = i;
+            return RENDER_ERR_MISSING;
+        }
+    }
+    return RENDER_OK;
+}
+
+int render_stream(FILE* in, FILE* out, const render_refs_t* refs,
+                  size_t* substitutions, size_t* error_line) {
+    if (!in || !out || !refs) return RENDER_ERR_IO;
+    return process(in, out, (render_refs_t*)refs, 0, substitutions, error_line);
+}
+
+void render_refs_free(render_refs_t* refs) {
+    if (!refs) return;
+    if (refs->refs) {
+        secure_cleanup(refs->refs, refs->capacity * sizeof(render_ref_t));
+        free(refs->refs);
+    }
+    memset(refs, 0, sizeof(*refs));
+}
+
+int render_output_path(const char* input, char* output, size_t output_len) {
+    if (!input || !output) return -1;
+
+    size_t len = strlen(input);
+    size_t suffix = strlen(RENDER_SUFFIX);
+    if (len <= suffix || strcmp(input + len - suffix, RENDER_SUFFIX) != 0) return -1;
+    if (len - suffix >= output_len) return -1;
+
+    memcpy(output, input, len - suffix);
+    output[len - suffix] = '\0';
+    return 0;
+}
+
+static int render_job(render_job_t* job, const render_refs_t* refs) {
+    FILE* in = fopen(job->input, "r");
+    if (!in) return RENDER_ERR_IO;
+
+    if (strcmp(job->output, "-") == 0) {
+        int ret = render_stream(in, stdout, refs, &job->substitutions, &job->error_line);
+        fclose(in);
+        if (ret == RENDER_OK && fflush(stdout) != 0) ret = RENDER_ERR_IO;
+        return ret;
+    }
+
+    char temp_path[sizeof(job->output) + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", job->output);
+    int fd = mkstemp(temp_path);
+    FILE* out = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!out) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(temp_path);
+        }
+        fclose(in);
+        return RENDER_ERR_IO;
+    }
+
+    int ret = fchmod(fd, S_IRUSR | S_IWUSR) == 0 ? RENDER_OK : RENDER_ERR_IO;
+    if (ret == RENDER_OK) {
+        ret = render_stream(in, out, refs, &job->substitutions, &job->error_line);
+    }
+    fclose(in);
+
+    if (fclose(out) != 0 && ret == RENDER_OK) ret = RENDER_ERR_IO;
+    if (ret == RENDER_OK && rename(temp_path, job->output) != 0) ret = RENDER_ERR_IO;
+    if (ret != RENDER_OK) unlink(temp_path);
+    return ret;
+}
+
+static void* render_worker(void* arg) {
+    RenderContext* ctx = arg;
+
+    for (;;) {
+        size_t i = atomic_fetch_add(&ctx->next, 1);
+        if (i >= ctx->count) break;
+        ctx->jobs[i].status = render_job(&ctx->jobs[i], ctx->refs);
+    }
+    return NULL;
+}
+
+static int first_failure(const render_job_t* jobs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].status != RENDER_OK) return jobs[i].status;
+    }
+    return RENDER_OK;
+}
+
+int render_files(render_job_t* jobs, size_t count, int threads) {
+    if (!jobs) return RENDER_ERR_IO;
+
+    render_refs_t refs;
+    memset(&refs, 0, sizeof(refs));
+
+    for (size_t i = 0; i < count; i++) {
+        jobs[i].substitutions = 0;
+        jobs[i].error_line = 0;
+        FILE* in = fopen(jobs[i].input, "r");
+        jobs[i].status = in ? render_scan(in, i, &refs, &jobs[i].error_line) : RENDER_ERR_IO;
+        if (in) fclose(in);
+        if (jobs[i].status != RENDER_OK) {
+            render_refs_free(&refs);
+            return jobs[i].status;
+        }
+    }
+
+    size_t missing;
+    if (render_refs_resolve(&refs, &missing) != RENDER_OK) {
+        render_job_t* job = &jobs[refs.refs[missing].source];
+        job->status = RENDER_ERR_MISSING;
+        job->error_line = refs.refs[missing].line;
+        render_refs_free(&refs);
+        return RENDER_ERR_MISSING;
+    }
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if ((size_t)threads > count) threads = (int)count;
+    if (threads > RENDER_MAX_THREADS) threads = RENDER_MAX_THREADS;
+
+    RenderContext ctx;
+    ctx.jobs = jobs;
+    ctx.count = count;
+    ctx.refs = &refs;
+    atomic_init(&ctx.next, 0);
+
+    pthread_t workers[RENDER_MAX_THREADS];
+    int started_threads = 0;
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&workers[started_threads], NULL, render_worker, &ctx) != 0) break;
+        started_threads++;
+    }
+    render_worker(&ctx);
+    for (int t = 0; t < started_threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    render_refs_free(&refs);
+    return first_failure(jobs, count);
+}
+
+const char* render_strerror(int status) {
+    switch (status) {
+        case RENDER_OK: return "ok";
+        case RENDER_ERR_IO: return "I/O error";
+        case RENDER_ERR_SYNTAX: return "invalid vault tag";
+        case RENDER_ERR_MISSING: return "entry not found in vault";
+        case RENDER_ERR_LIMIT: return "tag too long or too many references";
+        default: return "unknown error";
+    }
+}
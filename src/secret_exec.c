@@ -0,0 +1,200 @@
+#define _GNU_SOURCE
+#include "secret_exec.h"
+#include "crypto_engine.h"
+#include "shell.h"
+#include "timings.h"
+#include "metrics.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern char** environ;
+
+static int valid_env_name(const char* name) {
+    if (!((*name >= 'A' && *name <= 'Z') || (*name >= 'a' && *name <= 'z') || *name == '_')) {
+        return 0;
+    }
+    for (const char* p = name + 1; *p; p++) {
+        if (!((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') ||
+              (*p >= '0' && *p <= '9') || *p == '_')) {
+            return 0;
+        }
+    }
+    return strlen(name) < EXEC_NAME_MAX;
+}
+
+static int add_binding(exec_manifest_t* manifest, int argc, char** argv, size_t line) {
+    if (argc < 3 || argc > 4 || !valid_env_name(argv[0]) ||
+        strlen(argv[1]) >= VAULT_SERVICE_LEN || strlen(argv[2]) >= VAULT_USERNAME_LEN) {
+        return -1;
+    }
+
+    ref_field_t field = REF_FIELD_PASSWORD;
+    if (argc == 4 && vault_ref_parse_field(argv[3], &field) != 0) return -1;
+
+    for (size_t i = 0; i < manifest->count; i++) {
+        if (strcmp(manifest->bindings[i].name, argv[0]) == 0) return -1;
+    }
+
+    if (manifest->count == manifest->capacity) {
+        size_t capacity = manifest->capacity ? manifest->capacity * 2 : 16;
+        if (capacity > EXEC_MAX_BINDINGS) capacity = EXEC_MAX_BINDINGS;
+        if (capacity == manifest->count) return -1;
+
+        exec_binding_t* bindings = realloc(manifest->bindings, capacity * sizeof(exec_binding_t));
+        if (!bindings) return -1;
+        manifest->bindings = bindings;
+        manifest->capacity = capacity;
+    }
+
+    exec_binding_t* binding = &manifest->bindings[manifest->count++];
+    memset(binding, 0, sizeof(*binding));
+    strcpy(binding->name, argv[0]);
+    strcpy(binding->service, argv[1]);
+    strcpy(binding->username, argv[2]);
+    binding->ref.field = field;
+    binding->ref.entry_index = -1;
+    binding->line = line;
+    return 0;
+}
+
+int exec_manifest_parse(FILE* fp, exec_manifest_t* manifest, size_t* error_line) {
+    if (!fp || !manifest) return -1;
+
+    memset(manifest, 0, sizeof(*manifest));
+    char line[SHELL_LINE_MAX];
+    size_t line_number = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_number++;
+
+        char* argv[SHELL_MAX_ARGS];
+        int argc = shell_tokenize(line, argv, SHELL_MAX_ARGS);
+        if (argc == 0 || (argc > 0 && argv[0][0] == '#')) continue;
+
+        if (argc < 0 || add_binding(manifest, argc, argv, line_number) != 0) {
+            if (error_line) *error_line = line_number;
+            exec_manifest_free(manifest);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int exec_manifest_load(const char* path, exec_manifest_t* manifest, size_t* error_line) {
+    if (!path) return -1;
+    if (error_line) *error_line = 0;
+
+    FILE* fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!fp) return -1;
+
+    int ret = exec_manifest_parse(fp, manifest, error_line);
+    if (fp != stdin) fclose(fp);
+    return ret;
+}
+
+void exec_manifest_free(exec_manifest_t* manifest) {
+    if (!manifest) return;
+    free(manifest->bindings);
+    memset(manifest, 0, sizeof(*manifest));
+}
+
+int exec_manifest_resolve(exec_manifest_t* manifest, size_t* missing_line) {
+    if (!manifest) return -1;
+
+    for (size_t i = 0; i < manifest->count; i++) {
+        exec_binding_t* binding = &manifest->bindings[i];
+        binding->ref.service = binding->service;
+        binding->ref.username = binding->username;
+        binding->ref.entry_index = vault_find_entry(binding->service, binding->username);
+        if (binding->ref.entry_index < 0) {
+            if (missing_line) *missing_line = binding->line;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int overridden(const exec_manifest_t* manifest, const char* var) {
+    const char* eq = strchr(var, '=');
+    size_t len = eq ? (size_t)(eq - var) : strlen(var);
+
+    for (size_t i = 0; i < manifest->count; i++) {
+        if (strlen(manifest->bindings[i].name) == len &&
+            strncmp(manifest->bindings[i].name, var, len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+char** exec_build_environment(const exec_manifest_t* manifest, char* const* base_env) {
+    if (!manifest) return NULL;
+
+    size_t base_count = 0;
+    while (base_env && base_env[base_count]) base_count++;
+
+    char** env = calloc(base_count + manifest->count + 1, sizeof(char*));
+    if (!env) return NULL;
+
+    size_t n = 0;
+    for (size_t i = 0; i < base_count; i++) {
+        if (overridden(manifest, base_env[i])) continue;
+        if (!(env[n] = strdup(base_env[i]))) {
+            exec_free_environment(env);
+            return NULL;
+        }
+        n++;
+    }
+
+    char value[VAULT_PASSWORD_LEN];
+    for (size_t i = 0; i < manifest->count; i++) {
+        const exec_binding_t* binding = &manifest->bindings[i];
+        int len = vault_ref_value(&binding->ref, value, sizeof(value));
+        if (len < 0) {
+            exec_free_environment(env);
+            return NULL;
+        }
+
+        size_t size = strlen(binding->name) + 1 + (size_t)len + 1;
+        env[n] = malloc(size);
+        if (!env[n]) {
+            secure_cleanup(value, sizeof(value));
+            exec_free_environment(env);
+            return NULL;
+        }
+        snprintf(env[n++], size, "%s=%s", binding->name, value);
+    }
+    secure_cleanup(value, sizeof(value));
+
+    return env;
+}
+
+void exec_free_environment(char** env) {
+    if (!env) return;
+    for (char** p = env; *p; p++) {
+        secure_cleanup(*p, strlen(*p));
+        free(*p);
+    }
+    free(env);
+}
+
+int exec_command(const exec_manifest_t* manifest, char* const argv[]) {
+    if (!manifest || !argv || !argv[0]) return -1;
+
+    char** env = exec_build_environment(manifest, environ);
+    if (!env) return -1;
+
+    vault_cleanup();
+    timings_report(stderr);
+    metrics_stop_exporter();
+    fflush(NULL);
+    execvpe(argv[0], argv, env);
+
+    int saved = errno;
+    exec_free_environment(env);
+    errno = saved;
+    return -1;
+}
@@ -0,0 +1,1004 @@
+#define _GNU_SOURCE
+#include "serve.h"
+#include "vault_controller.h"
+#include "crypto_engine.h"
+#include "totp_engine.h"
+#include "utilities.h"
+#include "metrics.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SERVE_READ_CHUNK 65536
+#define SERVE_BUFFER_SIZE (SERVE_MAX_LINE + SERVE_READ_CHUNK)
+/* A socket client with this much unread output is not read from until it catches up. */
+#define SERVE_OUTPUT_LIMIT (1024 * 1024)
+
+typedef enum {
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_BOOL,
+    JSON_NULL
+} json_kind_t;
+
+typedef struct {
+    const char* key;
+    const char* value;
+    json_kind_t kind;
+    char scalar[32];
+} json_field_t;
+
+typedef struct {
+    json_field_t fields[SERVE_MAX_FIELDS];
+    size_t count;
+    const json_field_t* id;
+} request_t;
+
+static const char* skip_ws(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    return p;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int parse_hex4(const char* p, const char* end, uint32_t* value) {
+    if (end - p < 4) return -1;
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hex_value(p[i]);
+        if (h < 0) return -1;
+        *value = (*value << 4) | (uint32_t)h;
+    }
+    return 0;
+}
+
+static char* put_utf8(char* out, uint32_t cp) {
+    if (cp < 0x80) {
+        *out++ = (char)cp;
+    } else if (cp < 0x800) {
+        *out++ = (char)(0xC0 | (cp >> 6));
+        *out++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *out++ = (char)(0xE0 | (cp >> 12));
+        *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (cp >> 18));
+        *out++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+/* Decodes a JSON string in place; *p points at the opening quote. */
+static char* parse_string(char** p, char* end) {
+    char* src = *p + 1;
+    char* dst = src;
+    char* start = src;
+
+    while (src < end && *src != '"') {
+        unsigned char c = (unsigned char)*src;
+        if (c < 0x20) return NULL;
+        if (c != '\\') {
+            *dst++ = *src++;
+            continue;
+        }
+
+        if (++src >= end) return NULL;
+        switch (*src++) {
+            case '"': *dst++ = '"'; break;
+            case '\\': *dst++ = '\\'; break;
+            case '/': *dst++ = '/'; break;
+            case 'b': *dst++ = '\b'; break;
+            case 'f': *dst++ = '\f'; break;
+            case 'n': *dst++ = '\n'; break;
+            case 'r': *dst++ = '\r'; break;
+            case 't': *dst++ = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (parse_hex4(src, end, &cp) != 0) return NULL;
+                src += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - src < 6 || src[0] != '\\' || src[1] != 'u' ||
+                        parse_hex4(src + 2, end, &low) != 0 || low < 0xDC00 || low > 0xDFFF) {
+                        return NULL;
+                    }
+                    src += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return NULL;
+                }
+                if (cp == 0) return NULL;
+                dst = put_utf8(dst, cp);
+                break;
+            }
+            default:
+                return NULL;
+        }
+    }
+
+    if (src >= end) return NULL;
+    *dst = '\0';
+    *p = src + 1;
+    return start;
+}
+
+static int parse_request(char* line, size_t len, request_t* req) {
+    char* p = line;
+    char* end = line + len;
+
+    memset(req, 0, sizeof(*req));
+    p = (char*)skip_ws(p, end);
+    if (p >= end || *p != '{') return -1;
+    p = (char*)skip_ws(p + 1, end);
+
+    if (p < end && *p == '}') {
+        return skip_ws(p + 1, end) == end ? 0 : -1;
+    }
+
+    for (;;) {
+        if (p >= end || *p != '"' || req->count >= SERVE_MAX_FIELDS) return -1;
+
+        json_field_t* field = &req->fields[req->count];
+        field->key = parse_string(&p, end);
+        if (!field->key) return -1;
+
+        p = (char*)skip_ws(p, end);
+        if (p >= end || *p != ':') return -1;
+        p = (char*)skip_ws(p + 1, end);
+        if (p >= end) return -1;
+
+        if (*p == '"') {
+            field->value = parse_string(&p, end);
+            if (!field->value) return -1;
+            field->kind = JSON_STRING;
+        } else {
+            char* start = p;
+            while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t') p++;
+            size_t token_len = (size_t)(p - start);
+
+            if (token_len == 4 && strncmp(start, "true", 4) == 0) {
+                field->kind = JSON_BOOL;
+            } else if (token_len == 5 && strncmp(start, "false", 5) == 0) {
+                field->kind = JSON_BOOL;
+            } else if (token_len == 4 && strncmp(start, "null", 4) == 0) {
+                field->kind = JSON_NULL;
+            } else {
+                char* num_end;
+                strtod(start, &num_end);
+                if (token_len == 0 || num_end != p || !(*start == '-' || (*start >= '0' && *start <= '9'))) return -1;
+                field->kind = JSON_NUMBER;
+            }
+
+            if (token_len >= sizeof(field->scalar)) return -1;
+            memcpy(field->scalar, start, token_len);
+            field->scalar[token_len] = '\0';
+            field->value = field->scalar;
+        }
+
+        req->count++;
+        p = (char*)skip_ws(p, end);
+        if (p < end && *p == ',') {
+            p = (char*)skip_ws(p + 1, end);
+            continue;
+        }
+        if (p < end && *p == '}') {
+            return skip_ws(p + 1, end) == end ? 0 : -1;
+        }
+        return -1;
+    }
+}
+
+static const json_field_t* find_field(const request_t* req, const char* key) {
+    for (size_t i = 0; i < req->count; i++) {
+        if (strcmp(req->fields[i].key, key) == 0) return &req->fields[i];
+    }
+    return NULL;
+}
+
+static const char* string_param(const request_t* req, const char* key) {
+    const json_field_t* field = find_field(req, key);
+    return field && field->kind == JSON_STRING ? field->value : NULL;
+}
+
+static void write_id(FILE* out, const json_field_t* id) {
+    if (!id || id->kind == JSON_NULL) {
+        fputs("null", out);
+    } else if (id->kind == JSON_STRING) {
+        json_write_string(out, id->value);
+    } else {
+        fputs(id->value, out);
+    }
+}
+
+static void begin_result(FILE* out, const request_t* req) {
+    fputs("{\"id\":", out);
+    write_id(out, req ? req->id : NULL);
+    fputs(",\"ok\":true,\"result\":{", out);
+}
+
+static void end_result(FILE* out) {
+    fputs("}}\n", out);
+}
+
+static void write_error_line(FILE* out, const request_t* req, const char* code,
+                             const char* message) {
+    fputs("{\"id\":", out);
+    write_id(out, req ? req->id : NULL);
+    fprintf(out, ",\"ok\":false,\"error\":{\"code\":\"%s\",\"message\":", code);
+    json_write_string(out, message);
+    fputs("}}\n", out);
+}
+
+static void count_error(serve_stats_t* stats) {
+    if (stats) stats->errors++;
+    METRIC_COUNT(METRIC_REQUEST_ERRORS, 1);
+}
+
+static int write_error(FILE* out, const request_t* req, serve_stats_t* stats,
+                       const char* code, const char* message) {
+    write_error_line(out, req, code, message);
+    count_error(stats);
+    return SERVE_CONTINUE;
+}
+
+/*
+ * A change is only answered as successful once its batch is saved. The
+ * answer it gets instead if the save fails is written up front, while the
+ * request id is still at hand.
+ */
+static void write_save_failure(FILE* failed, const request_t* req) {
+    if (failed) {
+        write_error_line(failed, req, "save_failed", "vault could not be saved, changes are lost");
+    }
+}
+
+static int entry_params(const request_t* req, const char** service, const char** username) {
+    *service = string_param(req, "service");
+    *username = string_param(req, "username");
+    return *service && *username && (*service)[0] && (*username)[0] &&
+           strlen(*service) < VAULT_SERVICE_LEN && strlen(*username) < VAULT_USERNAME_LEN ? 0 : -1;
+}
+
+static void write_entry_summary(FILE* out, const VaultEntry* entry) {
+    fputs("{\"service\":", out);
+    json_write_string(out, entry->service);
+    fputs(",\"username\":", out);
+    json_write_string(out, entry->username);
+    fprintf(out, ",\"totp\":%s}", entry->totp_secret[0] ? "true" : "false");
+}
+
+static int op_list(FILE* out, const request_t* req, const char* query) {
+    size_t total = vault_entry_count();
+    size_t* matches = NULL;
+    size_t found = total;
+
+    if (query) {
+        matches = total > 0 ? malloc(total * sizeof(size_t)) : NULL;
+        if (total > 0 && !matches) return -1;
+        found = vault_search(query, matches, total);
+    }
+
+    begin_result(out, req);
+    fprintf(out, "\"count\":%zu,\"entries\":[", found);
+
+    VaultEntry entry;
+    for (size_t i = 0; i < found; i++) {
+        if (vault_get_entry_at(matches ? matches[i] : i, &entry) != 0) continue;
+        if (i > 0) fputc(',', out);
+        write_entry_summary(out, &entry);
+    }
+    secure_cleanup(&entry, sizeof(entry));
+    free(matches);
+
+    fputc(']', out);
+    end_result(out);
+    return 0;
+}
+
+static int op_get(FILE* out, const request_t* req, const VaultEntry* entry) {
+    begin_result(out, req);
+    fputs("\"service\":", out);
+    json_write_string(out, entry->service);
+    fputs(",\"username\":", out);
+    json_write_string(out, entry->username);
+    fputs(",\"password\":", out);
+    json_write_string(out, entry->password);
+    fprintf(out, ",\"totp\":%s,\"password_updated_at\":%llu",
+            entry->totp_secret[0] ? "true" : "false",
+            (unsigned long long)entry->password_updated_at);
+    end_result(out);
+    return 0;
+}
+
+/* Issuing an HOTP code advances the stored counter, so it is a change like store. */
+static int op_totp(FILE* out, FILE* failed, const request_t* req, serve_stats_t* stats,
+                   const VaultEntry* entry) {
+    if (entry->totp_secret[0] == '\0') {
+        return write_error(out, req, stats, "no_totp", "entry has no TOTP secret");
+    }
+
+    int digits = entry->totp_digits ? entry->totp_digits : TOTP_DEFAULT_DIGITS;
+    uint32_t code;
+    uint64_t counter;
+    if (vault_issue_otp(entry->service, entry->username, &code, &counter) != 0) {
+        return write_error(out, req, stats, "internal", "failed to issue code");
+    }
+
+    if (entry->totp_type == OTP_TYPE_HOTP) {
+        write_save_failure(failed, req);
+    }
+    begin_result(out, req);
+    fprintf(out, "\"code\":\"%0*u\",\"digits\":%d", digits, code, digits);
+    if (entry->totp_type == OTP_TYPE_HOTP) {
+        fprintf(out, ",\"type\":\"hotp\",\"counter\":%llu", (unsigned long long)counter);
+    } else {
+        uint32_t period = entry->totp_period ? entry->totp_period : TOTP_DEFAULT_PERIOD;
+        fprintf(out, ",\"type\":\"totp\",\"expires_in\":%lu",
+                (unsigned long)(period - (uint64_t)time(NULL) % period));
+    }
+    end_result(out);
+    return 0;
+}
+
+static int op_store(FILE* out, FILE* failed, const request_t* req, serve_stats_t* stats,
+                    const char* service, const char* username) {
+    const char* password = string_param(req, "password");
+    const char* totp = string_param(req, "totp_secret");
+
+    if (!password || strlen(password) >= VAULT_PASSWORD_LEN) {
+        return write_error(out, req, stats, "invalid_params", "password is required (max 255 bytes)");
+    }
+    if (totp && strlen(totp) >= VAULT_TOTP_LEN) {
+        return write_error(out, req, stats, "invalid_params", "totp_secret is too long");
+    }
+
+    int existing = vault_find_entry(service, username);
+    VaultEntry entry;
+    if (existing >= 0) {
+        vault_get_entry_at((size_t)existing, &entry);
+    } else {
+        memset(&entry, 0, sizeof(entry));
+        strcpy(entry.service, service);
+        strcpy(entry.username, username);
+    }
+
+    memset(entry.password, 0, sizeof(entry.password));
+    strcpy(entry.password, password);
+    if (totp) {
+        memset(entry.totp_secret, 0, sizeof(entry.totp_secret));
+        strcpy(entry.totp_secret, totp);
+    }
+
+    int ret = vault_put_entry(&entry);
+    secure_cleanup(&entry, sizeof(entry));
+    if (ret != 0) {
+        return write_error(out, req, stats, "internal", "failed to store entry");
+    }
+
+    write_save_failure(failed, req);
+    begin_result(out, req);
+    fprintf(out, "\"created\":%s", existing >= 0 ? "false" : "true");
+    end_result(out);
+    return 0;
+}
+
+static const struct {
+    const char* op;
+    metric_histogram_t histogram;
+} op_metrics[] = {
+    {"get", METRIC_REQUEST_GET},
+    {"list", METRIC_REQUEST_LIST},
+    {"search", METRIC_REQUEST_SEARCH},
+    {"store", METRIC_REQUEST_STORE},
+    {"remove", METRIC_REQUEST_REMOVE},
+    {"totp", METRIC_REQUEST_TOTP}
+};
+
+static int handle_request(char* line, size_t len, FILE* out, FILE* failed, serve_stats_t* stats,
+                          metric_histogram_t* histogram) {
+    request_t req;
+    if (stats) stats->requests++;
+
+    if (parse_request(line, len, &req) != 0) {
+        return write_error(out, NULL, stats, "parse_error", "request is not a flat JSON object");
+    }
+
+    req.id = find_field(&req, "id");
+
+    const json_field_t* version = find_field(&req, "v");
+    if (version && (version->kind != JSON_NUMBER || atoi(version->value) != SERVE_PROTOCOL_VERSION)) {
+        return write_error(out, &req, stats, "unsupported_version", "this server speaks protocol version 1");
+    }
+
+    const char* op = string_param(&req, "op");
+    if (!op) {
+        return write_error(out, &req, stats, "invalid_request", "missing \"op\"");
+    }
+    for (size_t i = 0; i < sizeof(op_metrics) / sizeof(op_metrics[0]); i++) {
+        if (strcmp(op, op_metrics[i].op) == 0) {
+            *histogram = op_metrics[i].histogram;
+        }
+    }
+
+    if (strcmp(op, "ping") == 0) {
+        begin_result(out, &req);
+        end_result(out);
+        return SERVE_CONTINUE;
+    }
+    if (strcmp(op, "hello") == 0) {
+        begin_result(out, &req);
+        fprintf(out, "\"protocol\":%d,\"entries\":%zu", SERVE_PROTOCOL_VERSION, vault_entry_count());
+        end_result(out);
+        return SERVE_CONTINUE;
+    }
+    if (strcmp(op, "quit") == 0) {
+        begin_result(out, &req);
+        end_result(out);
+        return SERVE_QUIT;
+    }
+    if (strcmp(op, "list") == 0 || strcmp(op, "search") == 0) {
+        const char* query = NULL;
+        if (op[0] == 's' && !(query = string_param(&req, "query"))) {
+            return write_error(out, &req, stats, "invalid_params", "search needs a \"query\" string");
+        }
+        if (op_list(out, &req, query) != 0) {
+            return write_error(out, &req, stats, "internal", "out of memory");
+        }
+        return SERVE_CONTINUE;
+    }
+
+    int is_get = strcmp(op, "get") == 0;
+    int is_totp = strcmp(op, "totp") == 0;
+    int is_store = strcmp(op, "store") == 0;
+    int is_remove = strcmp(op, "remove") == 0;
+    if (!is_get && !is_totp && !is_store && !is_remove) {
+        char message[96];
+        snprintf(message, sizeof(message), "unknown op \"%.64s\"", op);
+        return write_error(out, &req, stats, "unknown_op", message);
+    }
+
+    const char *service, *username;
+    if (entry_params(&req, &service, &username) != 0) {
+        return write_error(out, &req, stats, "invalid_params", "\"service\" and \"username\" strings are required");
+    }
+
+    if (is_store) {
+        op_store(out, failed, &req, stats, service, username);
+        return SERVE_CONTINUE;
+    }
+
+    int index = vault_find_entry(service, username);
+    if (index < 0) {
+        return write_error(out, &req, stats, "not_found", "no such entry");
+    }
+
+    if (is_remove) {
+        if (vault_remove_entry_at((size_t)index) != 0) {
+            return write_error(out, &req, stats, "internal", "failed to remove entry");
+        }
+        write_save_failure(failed, &req);
+        begin_result(out, &req);
+        end_result(out);
+        return SERVE_CONTINUE;
+    }
+
+    VaultEntry entry;
+    if (vault_get_entry_at((size_t)index, &entry) != 0) {
+        return write_error(out, &req, stats, "internal", "failed to read entry");
+    }
+    if (is_get) {
+        op_get(out, &req, &entry);
+    } else {
+        op_totp(out, failed, &req, stats, &entry);
+    }
+    secure_cleanup(&entry, sizeof(entry));
+    return SERVE_CONTINUE;
+}
+
+/* Store latency excludes the save, which happens once per batch (see serve_stdio). */
+static int serve_request(char* line, size_t len, FILE* out, FILE* failed, serve_stats_t* stats) {
+    metric_histogram_t histogram = METRIC_REQUEST_OTHER;
+    METRIC_START(started);
+    int ret = handle_request(line, len, out, failed, stats, &histogram);
+    METRIC_OBSERVE(started, histogram);
+    return ret;
+}
+
+int serve_handle_request(char* line, size_t len, FILE* out, serve_stats_t* stats) {
+    return serve_request(line, len, out, NULL, stats);
+}
+
+void serve_write_greeting(FILE* out) {
+    fprintf(out, "{\"protocol\":%d,\"server\":\"securekey\",\"entries\":%zu}\n",
+            SERVE_PROTOCOL_VERSION, vault_entry_count());
+    fflush(out);
+}
+
+/* Where a change's answer sits in the pending responses. */
+typedef struct {
+    size_t start;
+    size_t end;
+} ServeChange;
+
+/*
+ * One client. Responses are collected in a memory stream while the vault
+ * batch is open and only released once it has been saved. If the save
+ * fails, the answers to changes are swapped for their save_failed errors
+ * and every other answer is kept. Socket clients
+ * are non-blocking: released output the client has not read yet waits in
+ * output until poll reports the socket writable.
+ */
+typedef struct {
+    int fd;
+    FILE* out;
+    char* buffer;
+    size_t used;
+    size_t touched;
+    int discarding;
+    int quit;
+    char* pending;
+    size_t pending_len;
+    FILE* mem;
+    char* failures;
+    size_t failures_len;
+    FILE* failed;
+    ServeChange* changes;
+    size_t change_count;
+    size_t change_cap;
+    char* output;
+    size_t output_len;
+    size_t output_cap;
+} ServeConnection;
+
+static int g_stop_pipe[2] = {-1, -1};
+
+static int connection_init(ServeConnection* c, int fd, FILE* out) {
+    memset(c, 0, sizeof(*c));
+    c->fd = fd;
+    c->out = out;
+    c->buffer = malloc(SERVE_BUFFER_SIZE);
+    return c->buffer ? 0 : -1;
+}
+
+static void connection_free(ServeConnection* c) {
+    if (c->buffer) {
+        secure_cleanup(c->buffer, c->touched);
+        free(c->buffer);
+        c->buffer = NULL;
+    }
+    if (c->output) {
+        secure_cleanup(c->output, c->output_cap);
+        free(c->output);
+        c->output = NULL;
+    }
+    c->output_len = 0;
+    free(c->changes);
+    c->changes = NULL;
+}
+
+/* Returns the number of bytes read, 0 at end of input and -1 on error. */
+static ssize_t connection_read(ServeConnection* c) {
+    ssize_t n;
+    do {
+        n = read(c->fd, c->buffer + c->used, SERVE_BUFFER_SIZE - c->used);
+    } while (n < 0 && errno == EINTR);
+    if (n > 0) {
+        c->used += (size_t)n;
+        if (c->used > c->touched) c->touched = c->used;
+    }
+    return n;
+}
+
+static void discard_stream(FILE** stream, char** text, size_t* len) {
+    if (*stream) {
+        fclose(*stream);
+        *stream = NULL;
+    }
+    secure_cleanup(*text, *len);
+    free(*text);
+    *text = NULL;
+    *len = 0;
+}
+
+static void discard_pending(ServeConnection* c) {
+    discard_stream(&c->mem, &c->pending, &c->pending_len);
+    discard_stream(&c->failed, &c->failures, &c->failures_len);
+    c->change_count = 0;
+}
+
+static int connection_begin(ServeConnection* c) {
+    c->pending = NULL;
+    c->pending_len = 0;
+    c->failures = NULL;
+    c->failures_len = 0;
+    c->change_count = 0;
+    c->mem = open_memstream(&c->pending, &c->pending_len);
+    c->failed = open_memstream(&c->failures, &c->failures_len);
+    if (!c->mem || !c->failed) {
+        discard_pending(c);
+        return -1;
+    }
+    return 0;
+}
+
+/* Handles one request and remembers where its answer went if it changed the vault. */
+static int connection_request(ServeConnection* c, char* line, size_t len, serve_stats_t* stats) {
+    long start = ftell(c->mem);
+    long failures_before = ftell(c->failed);
+    int ret = serve_request(line, len, c->mem, c->failed, stats);
+    if (ftell(c->failed) == failures_before) {
+        return ret;
+    }
+
+    if (c->change_count == c->change_cap) {
+        size_t cap = c->change_cap ? c->change_cap * 2 : 64;
+        ServeChange* grown = realloc(c->changes, cap * sizeof(ServeChange));
+        if (!grown) {
+            /* Without a record the answer stays as it is; a failed save still fails the batch. */
+            return ret;
+        }
+        c->changes = grown;
+        c->change_cap = cap;
+    }
+    c->changes[c->change_count++] = (ServeChange){(size_t)start, (size_t)ftell(c->mem)};
+    return ret;
+}
+
+/* Rebuilds the pending responses with every change answered by its save_failed error. */
+static void fail_changes(ServeConnection* c, serve_stats_t* stats) {
+    fclose(c->mem);
+    fclose(c->failed);
+    c->mem = c->failed = NULL;
+
+    char* rebuilt = NULL;
+    size_t rebuilt_len = 0;
+    FILE* out = open_memstream(&rebuilt, &rebuilt_len);
+    if (!out) {
+        c->change_count = 0;
+        return;
+    }
+
+    size_t kept = 0;
+    const char* failure = c->failures;
+    for (size_t i = 0; i < c->change_count; i++) {
+        const ServeChange* change = &c->changes[i];
+        size_t left = c->failures_len - (size_t)(failure - c->failures);
+        const char* failure_end = memchr(failure, '\n', left);
+        if (!failure_end) break;
+        fwrite(c->pending + kept, 1, change->start - kept, out);
+        fwrite(failure, 1, (size_t)(failure_end - failure) + 1, out);
+        failure = failure_end + 1;
+        kept = change->end;
+        count_error(stats);
+    }
+    fwrite(c->pending + kept, 1, c->pending_len - kept, out);
+    fclose(out);
+
+    discard_pending(c);
+    c->pending = rebuilt;
+    c->pending_len = rebuilt_len;
+}
+
+/* Answers every complete line; at end of input a final unterminated line too. */
+static void connection_process(ServeConnection* c, int eof, serve_stats_t* stats) {
+    size_t start = 0;
+    while (!c->quit) {
+        char* newline = memchr(c->buffer + start, '\n', c->used - start);
+        size_t line_len;
+        if (newline) {
+            line_len = (size_t)(newline - (c->buffer + start));
+        } else if (eof && c->used > start) {
+            line_len = c->used - start;
+        } else {
+            break;
+        }
+
+        if (c->discarding) {
+            c->discarding = 0;
+        } else if (line_len > 0 && !(line_len == 1 && c->buffer[start] == '\r')) {
+            c->buffer[start + line_len] = '\0';
+            c->quit = connection_request(c, c->buffer + start, line_len, stats) == SERVE_QUIT;
+        }
+        secure_cleanup(c->buffer + start, line_len);
+        start += line_len + (newline ? 1 : 0);
+    }
+
+    memmove(c->buffer, c->buffer + start, c->used - start);
+    c->used -= start;
+
+    if (c->used >= SERVE_MAX_LINE) {
+        write_error(c->mem, NULL, stats, "line_too_long", "request exceeds 65536 bytes");
+        secure_cleanup(c->buffer, c->used);
+        c->used = 0;
+        c->discarding = 1;
+    }
+    if (eof) c->quit = 1;
+}
+
+/* Sends queued output until it is gone or the socket would block. */
+static void connection_flush(ServeConnection* c) {
+    size_t sent = 0;
+    while (sent < c->output_len) {
+        ssize_t n = send(c->fd, c->output + sent, c->output_len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+            /* The client is gone; nothing queued for it can be delivered. */
+            sent = c->output_len;
+            c->quit = 1;
+            break;
+        }
+        sent += (size_t)n;
+    }
+    memmove(c->output, c->output + sent, c->output_len - sent);
+    secure_cleanup(c->output + c->output_len - sent, sent);
+    c->output_len -= sent;
+}
+
+static int connection_queue(ServeConnection* c, const char* data, size_t len) {
+    if (c->output_len + len > c->output_cap) {
+        size_t cap = c->output_cap ? c->output_cap : SERVE_READ_CHUNK;
+        while (cap < c->output_len + len) cap *= 2;
+        char* grown = malloc(cap);
+        if (!grown) return -1;
+        if (c->output) {
+            memcpy(grown, c->output, c->output_len);
+            secure_cleanup(c->output, c->output_cap);
+            free(c->output);
+        }
+        c->output = grown;
+        c->output_cap = cap;
+    }
+    memcpy(c->output + c->output_len, data, len);
+    c->output_len += len;
+    return 0;
+}
+
+static void connection_write(ServeConnection* c, const char* data, size_t len) {
+    if (c->out) {
+        fwrite(data, 1, len, c->out);
+        fflush(c->out);
+        return;
+    }
+    if (connection_queue(c, data, len) != 0) {
+        c->output_len = 0;
+        c->quit = 1;
+        return;
+    }
+    connection_flush(c);
+}
+
+static void connection_release(ServeConnection* c, int saved, serve_stats_t* stats) {
+    if (!saved && c->change_count > 0) {
+        fail_changes(c, stats);
+    }
+    if (c->mem) {
+        fclose(c->mem);
+        c->mem = NULL;
+    }
+    if (c->pending_len > 0) {
+        connection_write(c, c->pending, c->pending_len);
+    } else if (c->out) {
+        fflush(c->out);
+    }
+    discard_pending(c);
+}
+
+static int commit_batch(serve_stats_t* stats) {
+    int ret = vault_commit_batch();
+    if (stats && ret == 0) stats->commits++;
+    return ret;
+}
+
+/*
+ * Requests are handled in the order they arrive. Everything that is already
+ * readable is processed as one vault batch, so a pipelined burst of writes
+ * costs a single save; responses for the burst are released after the save.
+ */
+int serve_stdio(int in_fd, FILE* out, serve_stats_t* stats) {
+    ServeConnection conn;
+    if (connection_init(&conn, in_fd, out) != 0) return 1;
+    if (stats) stats->connections++;
+
+    int ret = 0;
+    serve_write_greeting(out);
+
+    while (!conn.quit) {
+        ssize_t n = connection_read(&conn);
+        if (n < 0) {
+            ret = 1;
+            break;
+        }
+        if (connection_begin(&conn) != 0 || vault_begin_batch() != 0) {
+            discard_pending(&conn);
+            ret = 1;
+            break;
+        }
+
+        connection_process(&conn, n == 0, stats);
+        int saved = commit_batch(stats) == 0;
+        connection_release(&conn, saved, stats);
+        if (!saved) {
+            ret = 1;
+            break;
+        }
+    }
+
+    connection_free(&conn);
+    return ret;
+}
+
+static int open_serve_socket(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    /* A socket left behind by an earlier run is replaced; any other file is not. */
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create socket: %s\n", strerror(errno));
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || chmod(path, 0600) != 0 ||
+        listen(fd, SERVE_MAX_CONNECTIONS) != 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void accept_connection(int listen_fd, ServeConnection* conns, size_t* count,
+                              serve_stats_t* stats) {
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+    if (fd < 0) return;
+
+    ServeConnection* c = &conns[*count];
+    if (connection_init(c, fd, NULL) != 0 || connection_begin(c) != 0) {
+        connection_free(c);
+        close(fd);
+        return;
+    }
+    serve_write_greeting(c->mem);
+    connection_release(c, 1, stats);
+    (*count)++;
+    if (stats) stats->connections++;
+}
+
+/* Async-signal-safe; makes serve_socket() return. */
+void serve_stop(void) {
+    if (g_stop_pipe[1] >= 0) {
+        ssize_t ignored = write(g_stop_pipe[1], "x", 1);
+        (void)ignored;
+    }
+}
+
+/*
+ * Serves up to SERVE_MAX_CONNECTIONS clients on a Unix socket from one
+ * thread until serve_stop(). Each poll round reads every readable client
+ * and answers them all in one vault batch, so stores from different
+ * clients share a save. "quit" closes only the client that sent it, once
+ * its answers have been sent. A client that stops reading only stalls
+ * itself: past SERVE_OUTPUT_LIMIT of unread output its requests wait.
+ */
+int serve_socket(const char* path, serve_stats_t* stats) {
+    int listen_fd = open_serve_socket(path);
+    if (listen_fd < 0) return 1;
+
+    ServeConnection* conns = calloc(SERVE_MAX_CONNECTIONS, sizeof(ServeConnection));
+    struct pollfd* fds = calloc(SERVE_MAX_CONNECTIONS + 2, sizeof(struct pollfd));
+    if (!conns || !fds || pipe2(g_stop_pipe, O_CLOEXEC) != 0) {
+        free(conns);
+        free(fds);
+        close(listen_fd);
+        unlink(path);
+        return 1;
+    }
+
+    size_t count = 0;
+    int ret = 0;
+    for (;;) {
+        fds[0] = (struct pollfd){g_stop_pipe[0], POLLIN, 0};
+        fds[1] = (struct pollfd){listen_fd, count < SERVE_MAX_CONNECTIONS ? POLLIN : 0, 0};
+        for (size_t i = 0; i < count; i++) {
+            const ServeConnection* c = &conns[i];
+            short events = !c->quit && c->output_len < SERVE_OUTPUT_LIMIT ? POLLIN : 0;
+            if (c->output_len > 0) events |= POLLOUT;
+            fds[i + 2] = (struct pollfd){c->fd, events, 0};
+        }
+        if (poll(fds, (nfds_t)count + 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            ret = 1;
+            break;
+        }
+        if (fds[0].revents) break;
+
+        if (vault_begin_batch() != 0) {
+            ret = 1;
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            ServeConnection* c = &conns[i];
+            short revents = fds[i + 2].revents;
+            if (revents & POLLOUT) {
+                connection_flush(c);
+            }
+            if (!(fds[i + 2].events & POLLIN)) {
+                if (revents & (POLLHUP | POLLERR)) {
+                    c->output_len = 0;
+                    c->quit = 1;
+                }
+                continue;
+            }
+            if (!(revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            ssize_t n = connection_read(c);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+            if (n < 0 || connection_begin(c) != 0) {
+                c->output_len = 0;
+                c->quit = 1;
+                continue;
+            }
+            connection_process(c, n == 0, stats);
+        }
+        int saved = commit_batch(stats) == 0;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            ServeConnection* c = &conns[i];
+            if (c->mem) connection_release(c, saved, stats);
+            if (c->quit && c->output_len == 0) {
+                connection_free(c);
+                close(c->fd);
+            } else {
+                conns[kept++] = *c;
+            }
+        }
+        count = kept;
+        if (!saved) {
+            ret = 1;
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            accept_connection(listen_fd, conns, &count, stats);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        connection_free(&conns[i]);
+        close(conns[i].fd);
+    }
+    free(conns);
+    free(fds);
+    close(listen_fd);
+    unlink(path);
+    close(g_stop_pipe[0]);
+    close(g_stop_pipe[1]);
+    g_stop_pipe[0] = g_stop_pipe[1] = -1;
+    return ret;
+}
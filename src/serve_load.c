@@ -0,0 +1,161 @@
+#include "serve_load.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* op_names[LOAD_OP_COUNT] = {"get", "list", "store", "totp"};
+
+const char* load_op_name(load_op_t op) {
+    return op < LOAD_OP_COUNT ? op_names[op] : "unknown";
+}
+
+/* "get=80,list=2,store=10,totp=8"; ops left out get no requests. */
+int load_mix_parse(const char* text, load_mix_t* mix) {
+    if (!text || !mix) return -1;
+
+    memset(mix, 0, sizeof(*mix));
+    const char* p = text;
+    while (*p) {
+        const char* eq = strchr(p, '=');
+        if (!eq) return -1;
+
+        int op = -1;
+        for (int i = 0; i < LOAD_OP_COUNT; i++) {
+            if (strlen(op_names[i]) == (size_t)(eq - p) && strncmp(p, op_names[i], (size_t)(eq - p)) == 0) {
+                op = i;
+            }
+        }
+        char* end;
+        unsigned long weight = strtoul(eq + 1, &end, 10);
+        if (op < 0 || end == eq + 1 || weight > 1000000 || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        mix->weights[op] = (uint32_t)weight;
+        p = end;
+        if (*p == ',' && *++p == '\0') return -1;
+    }
+
+    for (int i = 0; i < LOAD_OP_COUNT; i++) {
+        mix->total += mix->weights[i];
+    }
+    return mix->total > 0 ? 0 : -1;
+}
+
+load_op_t load_mix_pick(const load_mix_t* mix, uint64_t random) {
+    uint32_t ticket = mix->total ? (uint32_t)(random % mix->total) : 0;
+    for (int i = 0; i < LOAD_OP_COUNT; i++) {
+        if (ticket < mix->weights[i]) return (load_op_t)i;
+        ticket -= mix->weights[i];
+    }
+    return LOAD_OP_GET;
+}
+
+static uint32_t bucket_index(uint64_t ns) {
+    if (ns >= (1ull << LATENCY_MAX_BITS)) {
+        ns = (1ull << LATENCY_MAX_BITS) - 1;
+    }
+    if (ns < LATENCY_SUB_BUCKETS) {
+        return (uint32_t)ns;
+    }
+    uint32_t exponent = (uint32_t)(63 - __builtin_clzll(ns)) - LATENCY_SUB_BITS + 1;
+    return exponent * LATENCY_SUB_BUCKETS + (uint32_t)(ns >> (exponent - 1)) - LATENCY_SUB_BUCKETS;
+}
+
+/* Largest value that falls into a bucket. */
+static uint64_t bucket_highest(uint32_t index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+    uint32_t exponent = index / LATENCY_SUB_BUCKETS;
+    uint64_t mantissa = index % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS;
+    return ((mantissa + 1) << (exponent - 1)) - 1;
+}
+
+void latency_record(latency_histogram_t* histogram, uint64_t ns) {
+    histogram->counts[bucket_index(ns)]++;
+    histogram->total++;
+    if (ns > histogram->max_ns) {
+        histogram->max_ns = ns;
+    }
+}
+
+void latency_merge(latency_histogram_t* into, const latency_histogram_t* from) {
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+    if (from->max_ns > into->max_ns) {
+        into->max_ns = from->max_ns;
+    }
+}
+
+/*
+ * The top of the bucket holding the percentile, never above the largest
+ * value seen. Values past the cap are reported as that largest value.
+ */
+uint64_t latency_percentile(const latency_histogram_t* histogram, double percentile) {
+    if (histogram->total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)ceil(percentile / 100.0 * (double)histogram->total);
+    if (rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_highest(i);
+            return value < histogram->max_ns && i < LATENCY_BUCKETS - 1 ? value : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+/* Returns just past the closing quote of the string that starts at p. */
+static const char* string_end(const char* p, const char* end) {
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return NULL;
+}
+
+static const char* skip_spaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+/*
+ * Finds the next "key": "value" pair at or after from. The value is returned
+ * still quoted and escaped, so it can be pasted into a request as it is.
+ */
+const char* load_json_string(const char* from, const char* end, const char* key,
+                             const char** value_end) {
+    if (!from || !end || !key || !value_end) return NULL;
+
+    size_t key_len = strlen(key);
+    const char* p = from;
+    while (p < end) {
+        if (*p != '"') {
+            p++;
+            continue;
+        }
+        const char* token_end = string_end(p, end);
+        if (!token_end) return NULL;
+
+        const char* q = skip_spaces(token_end, end);
+        if (q < end && *q == ':' && (size_t)(token_end - p) == key_len + 2 &&
+            memcmp(p + 1, key, key_len) == 0) {
+            q = skip_spaces(q + 1, end);
+            if (q < end && *q == '"') {
+                *value_end = string_end(q, end);
+                return *value_end ? q : NULL;
+            }
+        }
+        p = token_end;
+    }
+    return NULL;
+}
@@ -0,0 +1,416 @@
+#include "shell.h"
+#include "vault_controller.h"
+#include "crypto_engine.h"
+#include "totp_engine.h"
+#include "utilities.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SHELL_PASSWORD_MAX 256
+#define SHELL_SEARCH_LIMIT 1024
+
+void shell_session_init(shell_session_t* session, const char* vault_path, int interactive, int idle_timeout) {
+    if (!session) return;
+
+    memset(session, 0, sizeof(*session));
+    if (vault_path) {
+        strncpy(session->vault_path, vault_path, sizeof(session->vault_path) - 1);
+    }
+    session->interactive = interactive;
+    session->idle_timeout = idle_timeout;
+}
+
+void shell_session_cleanup(shell_session_t* session) {
+    if (!session) return;
+    secure_cleanup(session->history, sizeof(session->history));
+    session->history_count = 0;
+}
+
+int shell_tokenize(char* line, char** argv, int max_args) {
+    int argc = 0;
+    char* src = line;
+    char* dst = line;
+
+    while (*src) {
+        while (*src == ' ' || *src == '\t' || *src == '\n' || *src == '\r') src++;
+        if (*src == '\0') break;
+
+        if (argc >= max_args) return -1;
+        argv[argc++] = dst;
+
+        char quote = '\0';
+        while (*src) {
+            if (quote) {
+                if (*src == quote) {
+                    quote = '\0';
+                    src++;
+                    continue;
+                }
+                if (*src == '\\' && quote == '"' && (src[1] == '"' || src[1] == '\\')) src++;
+            } else if (*src == '"' || *src == '\'') {
+                quote = *src++;
+                continue;
+            } else if (*src == ' ' || *src == '\t' || *src == '\n' || *src == '\r') {
+                break;
+            } else if (*src == '\\' && src[1]) {
+                src++;
+            }
+            *dst++ = *src++;
+        }
+
+        if (quote) return -1;
+        if (*src) src++;
+        *dst++ = '\0';
+    }
+
+    return argc;
+}
+
+static int is_secret_position(int argc, char** argv, int index) {
+    if (strcmp(argv[0], "store") != 0 && strcmp(argv[0], "add") != 0) return 0;
+    if (strcmp(argv[index - 1], "--totp") == 0) return 1;
+    return index == 3 && argc > 3 && strcmp(argv[3], "--totp") != 0;
+}
+
+void shell_history_add(shell_session_t* session, int argc, char** argv) {
+    if (!session || argc <= 0) return;
+
+    char* slot = session->history[session->history_count % SHELL_HISTORY_SIZE];
+    size_t len = 0;
+    slot[0] = '\0';
+
+    for (int i = 0; i < argc; i++) {
+        const char* token = (i > 0 && is_secret_position(argc, argv, i)) ? SHELL_REDACTED : argv[i];
+        int quoted = strpbrk(token, " \t") != NULL || token[0] == '\0';
+        int written = snprintf(slot + len, SHELL_LINE_MAX - len, "%s%s%s%s",
+                               i > 0 ? " " : "", quoted ? "\"" : "", token, quoted ? "\"" : "");
+        if (written < 0 || (size_t)written >= SHELL_LINE_MAX - len) break;
+        len += (size_t)written;
+    }
+
+    session->history_count++;
+}
+
+const char* shell_history_get(const shell_session_t* session, size_t index) {
+    if (!session) return NULL;
+
+    size_t kept = session->history_count < SHELL_HISTORY_SIZE ? session->history_count : SHELL_HISTORY_SIZE;
+    if (index >= kept) return NULL;
+
+    size_t oldest = session->history_count - kept;
+    return session->history[(oldest + index) % SHELL_HISTORY_SIZE];
+}
+
+static void print_help(void) {
+    printf("Commands:\n");
+    printf("  get <service> <username> [--show]       Show an entry\n");
+    printf("  store <service> <username> [password] [--totp <secret>]\n");
+    printf("                                          Add or update an entry\n");
+    printf("  remove <service> <username>             Delete an entry\n");
+    printf("  list                                    List all entries\n");
+    printf("  search <text>                           Find entries by service or username\n");
+    printf("  totp <service> <username>               Show the current one-time code\n");
+    printf("  history                                 Show previous commands (secrets redacted)\n");
+    printf("  lock                                    Lock the vault until the next command\n");
+    printf("  exit, quit                              Leave the shell\n");
+}
+
+static int shell_unlock(shell_session_t* session) {
+    if (!vault_exists(session->vault_path)) {
+        fprintf(stderr, "Error: Vault does not exist at: %s\n", session->vault_path);
+        return -1;
+    }
+
+    char master_password[SHELL_PASSWORD_MAX];
+    if (read_password_secure("Enter master password: ", master_password, sizeof(master_password)) != 0) {
+        fprintf(stderr, "Error: Failed to read password\n");
+        return -1;
+    }
+
+    int ret = vault_init(master_password, session->vault_path);
+    secure_cleanup(master_password, sizeof(master_password));
+
+    if (ret != 0) {
+        fprintf(stderr, "Error: Failed to open vault (wrong password?)\n");
+        vault_cleanup();
+        return -1;
+    }
+
+    session->locked = 0;
+    return 0;
+}
+
+static void shell_lock(shell_session_t* session) {
+    vault_cleanup();
+    session->locked = 1;
+}
+
+static int require_args(int argc, int needed, const char* usage) {
+    if (argc < needed) {
+        fprintf(stderr, "Usage: %s\n", usage);
+        return -1;
+    }
+    return 0;
+}
+
+static int cmd_get(int argc, char** argv) {
+    if (require_args(argc, 3, "get <service> <username> [--show]") != 0) return SHELL_ERROR;
+
+    int show = argc > 3 && strcmp(argv[3], "--show") == 0;
+    VaultEntry entry;
+    if (vault_get(argv[1], argv[2], &entry) != 0) return SHELL_ERROR;
+
+    printf("Service: %s\n", entry.service);
+    printf("Username: %s\n", entry.username);
+    if (show) {
+        printf("Password: %s\n", entry.password);
+    } else {
+        printf("Password: [hidden] (use --show to display)\n");
+    }
+    if (entry.totp_type == OTP_TYPE_HOTP && entry.totp_secret[0] != '\0') {
+        printf("HOTP Counter: %llu (use 'totp' to issue the next code)\n",
+               (unsigned long long)entry.totp_counter);
+    } else if (entry.totp_secret[0] != '\0') {
+        printf("TOTP Code: %0*u\n", entry.totp_digits ? entry.totp_digits : TOTP_DEFAULT_DIGITS,
+               vault_entry_otp(&entry));
+    }
+
+    secure_cleanup(&entry, sizeof(entry));
+    return SHELL_OK;
+}
+
+static int cmd_store(shell_session_t* session, int argc, char** argv) {
+    if (require_args(argc, 3, "store <service> <username> [password] [--totp <secret>]") != 0) return SHELL_ERROR;
+
+    const char* password = NULL;
+    const char* totp = NULL;
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--totp") == 0 && i + 1 < argc) {
+            totp = argv[++i];
+        } else if (i == 3) {
+            password = argv[i];
+        } else {
+            fprintf(stderr, "Error: Unexpected argument '%s'\n", argv[i]);
+            return SHELL_ERROR;
+        }
+    }
+
+    char prompted[SHELL_PASSWORD_MAX];
+    if (!password) {
+        if (!session->interactive) {
+            fprintf(stderr, "Error: store needs a password argument in scripts\n");
+            return SHELL_ERROR;
+        }
+        if (read_password_secure("Enter password to store: ", prompted, sizeof(prompted)) != 0) {
+            fprintf(stderr, "Error: Failed to read password\n");
+            return SHELL_ERROR;
+        }
+        password = prompted;
+    }
+
+    if (strlen(password) >= VAULT_PASSWORD_LEN || (totp && strlen(totp) >= VAULT_TOTP_LEN)) {
+        fprintf(stderr, "Error: Password or TOTP secret is too long\n");
+        secure_cleanup(prompted, sizeof(prompted));
+        return SHELL_ERROR;
+    }
+
+    /* Like the server's store op: keep an existing entry's OTP settings, change only what was given. */
+    int existing = vault_find_entry(argv[1], argv[2]);
+    VaultEntry entry;
+    if (existing < 0 || vault_get_entry_at((size_t)existing, &entry) != 0) {
+        existing = -1;
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.service, argv[1], VAULT_SERVICE_LEN - 1);
+        strncpy(entry.username, argv[2], VAULT_USERNAME_LEN - 1);
+    }
+
+    memset(entry.password, 0, sizeof(entry.password));
+    strcpy(entry.password, password);
+    if (totp) {
+        memset(entry.totp_secret, 0, sizeof(entry.totp_secret));
+        strcpy(entry.totp_secret, totp);
+    }
+
+    int ret = vault_put_entry(&entry);
+    if (ret == 0) {
+        printf("%s entry for '%s' (%s)\n", existing >= 0 ? "Updated" : "Stored", entry.service, entry.username);
+    }
+    secure_cleanup(&entry, sizeof(entry));
+    secure_cleanup(prompted, sizeof(prompted));
+    return ret == 0 ? SHELL_OK : SHELL_ERROR;
+}
+
+static int cmd_search(int argc, char** argv) {
+    if (require_args(argc, 2, "search <text>") != 0) return SHELL_ERROR;
+
+    size_t matches[SHELL_SEARCH_LIMIT];
+    size_t found = vault_search(argv[1], matches, SHELL_SEARCH_LIMIT);
+    size_t shown = found < SHELL_SEARCH_LIMIT ? found : SHELL_SEARCH_LIMIT;
+
+    VaultEntry entry;
+    for (size_t i = 0; i < shown; i++) {
+        if (vault_get_entry_at(matches[i], &entry) != 0) continue;
+        printf("%3zu. %-30s %-30s%s\n", matches[i] + 1, entry.service, entry.username,
+               entry.totp_secret[0] ? " [TOTP]" : "");
+    }
+    secure_cleanup(&entry, sizeof(entry));
+
+    printf("%zu matching %s\n", found, found == 1 ? "entry" : "entries");
+    return SHELL_OK;
+}
+
+static int cmd_totp(int argc, char** argv) {
+    if (require_args(argc, 3, "totp <service> <username>") != 0) return SHELL_ERROR;
+
+    VaultEntry entry;
+    if (vault_get(argv[1], argv[2], &entry) != 0) return SHELL_ERROR;
+
+    int ret = SHELL_OK;
+    if (entry.totp_secret[0] == '\0') {
+        fprintf(stderr, "Error: No TOTP secret stored for '%s' (%s)\n", argv[1], argv[2]);
+        ret = SHELL_ERROR;
+    } else if (entry.totp_type == OTP_TYPE_HOTP) {
+        uint32_t code;
+        uint64_t counter;
+        if (vault_issue_otp(argv[1], argv[2], &code, &counter) != 0) {
+            ret = SHELL_ERROR;
+        } else {
+            printf("%0*u (counter %llu)\n", entry.totp_digits, code, (unsigned long long)counter);
+        }
+    } else {
+        uint32_t period = entry.totp_period ? entry.totp_period : TOTP_DEFAULT_PERIOD;
+        printf("%0*u (expires in %lus)\n", entry.totp_digits, vault_entry_otp(&entry),
+               (unsigned long)(period - (uint64_t)time(NULL) % period));
+    }
+
+    secure_cleanup(&entry, sizeof(entry));
+    return ret;
+}
+
+int shell_execute(shell_session_t* session, char* line) {
+    if (!session || !line) return SHELL_ERROR;
+
+    char* argv[SHELL_MAX_ARGS];
+    int argc = shell_tokenize(line, argv, SHELL_MAX_ARGS);
+    if (argc < 0) {
+        fprintf(stderr, "Error: Unbalanced quotes or too many arguments\n");
+        return SHELL_ERROR;
+    }
+    if (argc == 0 || argv[0][0] == '#') return SHELL_OK;
+
+    shell_history_add(session, argc, argv);
+    const char* cmd = argv[0];
+
+    if (strcmp(cmd, "exit") == 0 || strcmp(cmd, "quit") == 0) return SHELL_EXIT;
+    if (strcmp(cmd, "help") == 0 || strcmp(cmd, "?") == 0) {
+        print_help();
+        return SHELL_OK;
+    }
+    if (strcmp(cmd, "history") == 0) {
+        for (size_t i = 0; shell_history_get(session, i); i++) {
+            printf("%4zu  %s\n", i + 1, shell_history_get(session, i));
+        }
+        return SHELL_OK;
+    }
+    if (strcmp(cmd, "lock") == 0) {
+        if (!session->interactive) {
+            fprintf(stderr, "Error: lock is only available interactively\n");
+            return SHELL_ERROR;
+        }
+        shell_lock(session);
+        printf("Vault locked\n");
+        return SHELL_OK;
+    }
+
+    if (session->locked && shell_unlock(session) != 0) return SHELL_ERROR;
+
+    if (strcmp(cmd, "get") == 0) return cmd_get(argc, argv);
+    if (strcmp(cmd, "store") == 0 || strcmp(cmd, "add") == 0) return cmd_store(session, argc, argv);
+    if (strcmp(cmd, "search") == 0 || strcmp(cmd, "find") == 0) return cmd_search(argc, argv);
+    if (strcmp(cmd, "totp") == 0) return cmd_totp(argc, argv);
+    if (strcmp(cmd, "list") == 0 || strcmp(cmd, "ls") == 0) {
+        return vault_list() == 0 ? SHELL_OK : SHELL_ERROR;
+    }
+    if (strcmp(cmd, "remove") == 0 || strcmp(cmd, "rm") == 0) {
+        if (require_args(argc, 3, "remove <service> <username>") != 0) return SHELL_ERROR;
+        return vault_remove(argv[1], argv[2]) == 0 ? SHELL_OK : SHELL_ERROR;
+    }
+
+    fprintf(stderr, "Error: Unknown command '%s' (type 'help')\n", cmd);
+    return SHELL_ERROR;
+}
+
+static int wait_for_input(shell_session_t* session, FILE* in) {
+    if (!session->interactive || session->locked || session->idle_timeout <= 0) return 1;
+
+    struct pollfd pfd = { .fd = fileno(in), .events = POLLIN };
+    int ret;
+    do {
+        ret = poll(&pfd, 1, session->idle_timeout * 1000);
+    } while (ret < 0 && errno == EINTR);
+
+    return ret;
+}
+
+static int run_interactive(shell_session_t* session, FILE* in) {
+    char line[SHELL_LINE_MAX];
+    printf("SecureKey shell. Type 'help' for commands.\n");
+
+    for (;;) {
+        printf("securekey%s> ", session->locked ? " (locked)" : "");
+        fflush(stdout);
+
+        if (wait_for_input(session, in) == 0) {
+            shell_lock(session);
+            printf("\nVault locked after %d seconds of inactivity\n", session->idle_timeout);
+            continue;
+        }
+
+        if (!fgets(line, sizeof(line), in)) {
+            printf("\n");
+            break;
+        }
+
+        session->line_number++;
+        int ret = shell_execute(session, line);
+        secure_cleanup(line, sizeof(line));
+        if (ret == SHELL_EXIT) break;
+    }
+
+    return 0;
+}
+
+static int run_script(shell_session_t* session, FILE* in) {
+    char line[SHELL_LINE_MAX];
+    int ret = SHELL_OK;
+
+    if (vault_begin_batch() != 0) return 1;
+
+    while (fgets(line, sizeof(line), in)) {
+        session->line_number++;
+        ret = shell_execute(session, line);
+        secure_cleanup(line, sizeof(line));
+        if (ret != SHELL_OK) break;
+    }
+
+    if (ret == SHELL_ERROR) {
+        fprintf(stderr, "Error: Script failed at line %zu, no changes were saved\n", session->line_number);
+        shell_lock(session);
+        return 1;
+    }
+
+    if (vault_commit_batch() != 0) {
+        fprintf(stderr, "Error: Failed to save vault\n");
+        return 1;
+    }
+    return 0;
+}
+
+int shell_run(shell_session_t* session, FILE* in) {
+    if (!session || !in) return 1;
+    return session->interactive ? run_interactive(session, in) : run_script(session, in);
+}
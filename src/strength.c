@@ -0,0 +1,815 @@
+#include "strength.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MIN_GUESSES_BEFORE_GROWING_LOG10 4.0
+#define MIN_SUBMATCH_GUESSES_SINGLE_CHAR 10.0
+#define MIN_SUBMATCH_GUESSES_MULTI_CHAR 50.0
+#define MIN_YEAR_SPACE 20
+#define MAX_REPEAT_DEPTH 2
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t dict_count;
+    char names[STRENGTH_MAX_DICTS][STRENGTH_DICT_NAME_LEN];
+} DictHeader;
+
+typedef struct {
+    uint32_t first_child;
+    uint16_t child_count;
+    uint8_t ch;
+    uint8_t dict;
+    uint32_t rank;
+} DictNode;
+
+typedef struct {
+    void* map;
+    size_t map_size;
+    const DictHeader* header;
+    const DictNode* nodes;
+} Dictionary;
+
+typedef struct {
+    strength_match_t* items;
+    size_t count;
+    size_t capacity;
+} MatchList;
+
+static Dictionary g_dict = {NULL, 0, NULL, NULL};
+static pthread_once_t g_dict_once = PTHREAD_ONCE_INIT;
+
+static const struct {
+    char from;
+    char to;
+} l33t_table[] = {
+    {'4', 'a'}, {'@', 'a'}, {'8', 'b'}, {'(', 'c'}, {'{', 'c'}, {'[', 'c'},
+    {'<', 'c'}, {'3', 'e'}, {'6', 'g'}, {'9', 'g'}, {'1', 'i'}, {'1', 'l'},
+    {'!', 'i'}, {'|', 'i'}, {'|', 'l'}, {'0', 'o'}, {'$', 's'}, {'5', 's'},
+    {'7', 't'}, {'+', 't'}, {'%', 'x'}, {'2', 'z'}
+};
+
+static double log10_add(double a, double b) {
+    if (a < b) {
+        double tmp = a;
+        a = b;
+        b = tmp;
+    }
+    return a + log10(1.0 + pow(10.0, b - a));
+}
+
+static double log10_binomial(int n, int k) {
+    if (k < 0 || k > n) return -INFINITY;
+    return (lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0)) / log(10.0);
+}
+
+static double log10_factorial(int n) {
+    return lgamma(n + 1.0) / log(10.0);
+}
+
+static int match_push(MatchList* list, const strength_match_t* match) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 64;
+        strength_match_t* items = realloc(list->items, capacity * sizeof(*items));
+        if (!items) return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = *match;
+    return 0;
+}
+
+static int unmap_dictionary(Dictionary* dict) {
+    if (dict->map) {
+        munmap(dict->map, dict->map_size);
+    }
+    memset(dict, 0, sizeof(*dict));
+    return 0;
+}
+
+static int map_dictionary(const char* path, Dictionary* dict) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DictHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const DictHeader* header = (const DictHeader*)map;
+    size_t expected = sizeof(DictHeader) + (size_t)header->node_count * sizeof(DictNode);
+
+    if (memcmp(header->magic, STRENGTH_DICT_MAGIC, 4) != 0 ||
+        header->version != STRENGTH_DICT_VERSION ||
+        header->dict_count > STRENGTH_MAX_DICTS ||
+        header->node_count == 0 ||
+        expected != (size_t)st.st_size) {
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    dict->map = map;
+    dict->map_size = st.st_size;
+    dict->header = header;
+    dict->nodes = (const DictNode*)((const char*)map + sizeof(DictHeader));
+    return 0;
+}
+
+static void load_default_dictionary(void) {
+    if (g_dict.map) return;
+
+    const char* env = getenv(STRENGTH_DICT_ENV);
+    if (env && env[0] && map_dictionary(env, &g_dict) == 0) return;
+
+    char path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len > 0) {
+        path[len] = '\0';
+        char* slash = strrchr(path, '/');
+        if (slash && (size_t)(slash - path) + sizeof(STRENGTH_DICT_FILENAME) + 1 < sizeof(path)) {
+            strcpy(slash + 1, STRENGTH_DICT_FILENAME);
+            if (map_dictionary(path, &g_dict) == 0) return;
+        }
+    }
+
+    const char* home = getenv("HOME");
+    if (home) {
+        snprintf(path, sizeof(path), "%s/.securekey/" STRENGTH_DICT_FILENAME, home);
+        if (map_dictionary(path, &g_dict) == 0) return;
+    }
+
+    map_dictionary("/usr/local/share/securekey/" STRENGTH_DICT_FILENAME, &g_dict);
+}
+
+int strength_load_dictionary(const char* path) {
+    if (!path) return -1;
+
+    Dictionary dict;
+    memset(&dict, 0, sizeof(dict));
+    if (map_dictionary(path, &dict) != 0) {
+        return -1;
+    }
+
+    unmap_dictionary(&g_dict);
+    g_dict = dict;
+    return 0;
+}
+
+void strength_unload_dictionary(void) {
+    unmap_dictionary(&g_dict);
+}
+
+int strength_dictionary_loaded(void) {
+    pthread_once(&g_dict_once, load_default_dictionary);
+    return g_dict.map != NULL;
+}
+
+const char* strength_dict_name(int dict) {
+    if (!g_dict.header || dict < 0 || (uint32_t)dict >= g_dict.header->dict_count) {
+        return "unknown";
+    }
+    return g_dict.header->names[dict];
+}
+
+static const DictNode* dict_child(const DictNode* node, unsigned char ch) {
+    uint32_t lo = node->first_child;
+    uint32_t hi = lo + node->child_count;
+
+    if (hi > g_dict.header->node_count || hi < lo) return NULL;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        unsigned char mid_ch = g_dict.nodes[mid].ch;
+        if (mid_ch == ch) return &g_dict.nodes[mid];
+        if (mid_ch < ch) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+static double uppercase_variations_log10(const char* token, size_t len) {
+    int upper = 0, lower = 0;
+    for (size_t k = 0; k < len; k++) {
+        if (isupper((unsigned char)token[k])) upper++;
+        else if (islower((unsigned char)token[k])) lower++;
+    }
+
+    if (upper == 0) return 0.0;
+
+    int first_upper = isupper((unsigned char)token[0]) && upper == 1;
+    int last_upper = isupper((unsigned char)token[len - 1]) && upper == 1;
+    if (lower == 0 || first_upper || last_upper) return log10(2.0);
+
+    double total = -INFINITY;
+    int limit = upper < lower ? upper : lower;
+    for (int k = 1; k <= limit; k++) {
+        total = log10_add(total, log10_binomial(upper + lower, k));
+    }
+    return total;
+}
+
+static double l33t_variations_log10(const char* lower, const char* subs, size_t len) {
+    double total = 0.0;
+
+    for (size_t k = 0; k < len; k++) {
+        if (!subs[k]) continue;
+
+        int seen = 0;
+        for (size_t m = 0; m < k; m++) {
+            if (subs[m] == subs[k] && lower[m] == lower[k]) {
+                seen = 1;
+                break;
+            }
+        }
+        if (seen) continue;
+
+        int subbed = 0, unsubbed = 0;
+        for (size_t m = 0; m < len; m++) {
+            if (subs[m] == subs[k] && lower[m] == lower[k]) subbed++;
+            else if (!subs[m] && lower[m] == subs[k]) unsubbed++;
+        }
+
+        if (unsubbed == 0) {
+            total += log10(2.0);
+        } else {
+            double variations = -INFINITY;
+            int limit = subbed < unsubbed ? subbed : unsubbed;
+            for (int i = 1; i <= limit; i++) {
+                variations = log10_add(variations, log10_binomial(subbed + unsubbed, i));
+            }
+            total += variations;
+        }
+    }
+
+    return total;
+}
+
+typedef struct {
+    const char* original;
+    const char* lower;
+    size_t len;
+    size_t start;
+    int reversed;
+    int allow_l33t;
+    char subs[STRENGTH_MAX_LENGTH];
+    MatchList* out;
+} DictWalk;
+
+static void dict_walk(DictWalk* walk, const DictNode* node, size_t pos, int l33t) {
+    if (pos > walk->start && node->rank > 0) {
+        size_t token_len = pos - walk->start;
+        strength_match_t match;
+        memset(&match, 0, sizeof(match));
+
+        match.pattern = MATCH_DICTIONARY;
+        match.rank = node->rank;
+        match.dict = node->dict;
+        match.l33t = l33t;
+        match.reversed = walk->reversed;
+        match.guesses_log10 = log10((double)node->rank) +
+            uppercase_variations_log10(walk->original + walk->start, token_len) +
+            (l33t ? l33t_variations_log10(walk->lower + walk->start, walk->subs + walk->start, token_len) : 0.0) +
+            (walk->reversed ? log10(2.0) : 0.0);
+
+        if (walk->reversed) {
+            match.i = walk->len - pos;
+            match.j = walk->len - 1 - walk->start;
+        } else {
+            match.i = walk->start;
+            match.j = pos - 1;
+        }
+        match_push(walk->out, &match);
+    }
+
+    if (pos >= walk->len) return;
+
+    unsigned char ch = (unsigned char)walk->lower[pos];
+    const DictNode* child = dict_child(node, ch);
+    if (child) {
+        walk->subs[pos] = 0;
+        dict_walk(walk, child, pos + 1, l33t);
+    }
+
+    if (!walk->allow_l33t) return;
+
+    for (size_t k = 0; k < sizeof(l33t_table) / sizeof(l33t_table[0]); k++) {
+        if (l33t_table[k].from != (char)ch) continue;
+
+        child = dict_child(node, (unsigned char)l33t_table[k].to);
+        if (child) {
+            walk->subs[pos] = l33t_table[k].to;
+            dict_walk(walk, child, pos + 1, 1);
+            walk->subs[pos] = 0;
+        }
+    }
+}
+
+static void dictionary_match(const char* password, size_t len, MatchList* out) {
+    if (!g_dict.map || len > STRENGTH_MAX_LENGTH) return;
+
+    char lower[STRENGTH_MAX_LENGTH + 1];
+    char reversed[STRENGTH_MAX_LENGTH + 1];
+    char reversed_lower[STRENGTH_MAX_LENGTH + 1];
+
+    for (size_t k = 0; k < len; k++) {
+        lower[k] = (char)tolower((unsigned char)password[k]);
+        reversed[k] = password[len - 1 - k];
+        reversed_lower[len - 1 - k] = lower[k];
+    }
+    lower[len] = reversed[len] = reversed_lower[len] = '\0';
+
+    DictWalk walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.len = len;
+    walk.out = out;
+
+    for (size_t start = 0; start < len; start++) {
+        walk.original = password;
+        walk.lower = lower;
+        walk.reversed = 0;
+        walk.allow_l33t = 1;
+        walk.start = start;
+        dict_walk(&walk, &g_dict.nodes[0], start, 0);
+
+        walk.original = reversed;
+        walk.lower = reversed_lower;
+        walk.reversed = 1;
+        walk.allow_l33t = 0;
+        dict_walk(&walk, &g_dict.nodes[0], start, 0);
+    }
+
+    memset(lower, 0, sizeof(lower));
+    memset(reversed, 0, sizeof(reversed));
+    memset(reversed_lower, 0, sizeof(reversed_lower));
+}
+
+static double estimate_log10(const char* password, size_t len, int depth, strength_result_t* result);
+
+static void repeat_match(const char* password, size_t len, int depth, MatchList* out) {
+    if (depth >= MAX_REPEAT_DEPTH) return;
+
+    for (size_t i = 0; i < len; i++) {
+        for (size_t base_len = 1; i + base_len * 2 <= len; base_len++) {
+            size_t repeats = 1;
+            while (i + base_len * (repeats + 1) <= len &&
+                   memcmp(password + i, password + i + base_len * repeats, base_len) == 0) {
+                repeats++;
+            }
+
+            if (repeats < 2 || (base_len == 1 && repeats < 3)) continue;
+
+            strength_match_t match;
+            memset(&match, 0, sizeof(match));
+            match.pattern = MATCH_REPEAT;
+            match.i = i;
+            match.j = i + base_len * repeats - 1;
+            match.guesses_log10 = estimate_log10(password + i, base_len, depth + 1, NULL) +
+                                  log10((double)repeats);
+            match_push(out, &match);
+        }
+    }
+}
+
+static void sequence_match(const char* password, size_t len, MatchList* out) {
+    size_t i = 0;
+
+    while (i + 2 < len) {
+        int delta = (unsigned char)password[i + 1] - (unsigned char)password[i];
+        if (delta == 0 || delta > 5 || delta < -5) {
+            i++;
+            continue;
+        }
+
+        size_t j = i + 1;
+        while (j + 1 < len && (unsigned char)password[j + 1] - (unsigned char)password[j] == delta) {
+            j++;
+        }
+
+        size_t seq_len = j - i + 1;
+        if (seq_len >= 3) {
+            char first = password[i];
+            double base;
+            if (strchr("aAzZ019", first)) base = 4.0;
+            else if (isdigit((unsigned char)first)) base = 10.0;
+            else if (isupper((unsigned char)first)) base = 26.0 * 2.0;
+            else base = 26.0;
+
+            strength_match_t match;
+            memset(&match, 0, sizeof(match));
+            match.pattern = MATCH_SEQUENCE;
+            match.i = i;
+            match.j = j;
+            match.guesses_log10 = log10(base * seq_len * (delta < 0 ? 2.0 : 1.0));
+            match_push(out, &match);
+            i = j;
+        } else {
+            i++;
+        }
+    }
+}
+
+static void year_match(const char* password, size_t len, MatchList* out) {
+    time_t now = time(NULL);
+    struct tm tm_now;
+    gmtime_r(&now, &tm_now);
+    int reference_year = tm_now.tm_year + 1900;
+
+    for (size_t i = 0; i + 4 <= len; i++) {
+        if (!isdigit((unsigned char)password[i]) || !isdigit((unsigned char)password[i + 1]) ||
+            !isdigit((unsigned char)password[i + 2]) || !isdigit((unsigned char)password[i + 3])) {
+            continue;
+        }
+
+        int year = (password[i] - '0') * 1000 + (password[i + 1] - '0') * 100 +
+                   (password[i + 2] - '0') * 10 + (password[i + 3] - '0');
+        if (year < 1900 || year > 2099) continue;
+
+        int space = abs(year - reference_year);
+        if (space < MIN_YEAR_SPACE) space = MIN_YEAR_SPACE;
+
+        strength_match_t match;
+        memset(&match, 0, sizeof(match));
+        match.pattern = MATCH_YEAR;
+        match.i = i;
+        match.j = i + 3;
+        match.guesses_log10 = log10((double)space);
+        match_push(out, &match);
+    }
+}
+
+static double bruteforce_log10(size_t token_len) {
+    double guesses = (double)token_len;
+    double minimum = log10(token_len == 1 ? MIN_SUBMATCH_GUESSES_SINGLE_CHAR + 1
+                                          : MIN_SUBMATCH_GUESSES_MULTI_CHAR + 1);
+    return guesses > minimum ? guesses : minimum;
+}
+
+static double estimate_log10(const char* password, size_t len, int depth, strength_result_t* result) {
+    if (len == 0) return 0.0;
+
+    MatchList matches = {NULL, 0, 0};
+    dictionary_match(password, len, &matches);
+    repeat_match(password, len, depth, &matches);
+    sequence_match(password, len, &matches);
+    year_match(password, len, &matches);
+
+    for (size_t m = 0; m < matches.count; m++) {
+        strength_match_t* match = &matches.items[m];
+        size_t token_len = match->j - match->i + 1;
+        if (token_len < len) {
+            double minimum = log10(token_len == 1 ? MIN_SUBMATCH_GUESSES_SINGLE_CHAR
+                                                  : MIN_SUBMATCH_GUESSES_MULTI_CHAR);
+            if (match->guesses_log10 < minimum) match->guesses_log10 = minimum;
+        }
+    }
+
+    size_t stride = len + 1;
+    double* best = malloc(len * stride * sizeof(double));
+    long* back = malloc(len * stride * sizeof(long));
+    if (!best || !back) {
+        free(best);
+        free(back);
+        free(matches.items);
+        return (double)len;
+    }
+
+    for (size_t k = 0; k < len * stride; k++) {
+        best[k] = INFINITY;
+        back[k] = 0;
+    }
+
+    for (size_t k = 0; k < len; k++) {
+        for (size_t m = 0; m < matches.count; m++) {
+            const strength_match_t* match = &matches.items[m];
+            if (match->j != k) continue;
+
+            if (match->i == 0) {
+                if (match->guesses_log10 < best[k * stride + 1]) {
+                    best[k * stride + 1] = match->guesses_log10;
+                    back[k * stride + 1] = (long)m + 1;
+                }
+                continue;
+            }
+
+            for (size_t l = 1; l <= match->i; l++) {
+                double prev = best[(match->i - 1) * stride + l];
+                if (prev == INFINITY) continue;
+                double candidate = prev + match->guesses_log10;
+                if (candidate < best[k * stride + l + 1]) {
+                    best[k * stride + l + 1] = candidate;
+                    back[k * stride + l + 1] = (long)m + 1;
+                }
+            }
+        }
+
+        for (size_t i = 0; i <= k; i++) {
+            double guesses = bruteforce_log10(k - i + 1);
+            if (i == 0) {
+                if (guesses < best[k * stride + 1]) {
+                    best[k * stride + 1] = guesses;
+                    back[k * stride + 1] = -1;
+                }
+                continue;
+            }
+
+            for (size_t l = 1; l <= i; l++) {
+                double prev = best[(i - 1) * stride + l];
+                if (prev == INFINITY) continue;
+                double candidate = prev + guesses;
+                if (candidate < best[k * stride + l + 1]) {
+                    best[k * stride + l + 1] = candidate;
+                    back[k * stride + l + 1] = -(long)i - 1;
+                }
+            }
+        }
+    }
+
+    double total = INFINITY;
+    size_t best_l = 1;
+    for (size_t l = 1; l <= len; l++) {
+        double product = best[(len - 1) * stride + l];
+        if (product == INFINITY) continue;
+
+        double guesses = log10_add(log10_factorial((int)l) + product,
+                                   (l - 1) * MIN_GUESSES_BEFORE_GROWING_LOG10);
+        if (guesses < total) {
+            total = guesses;
+            best_l = l;
+        }
+    }
+
+    if (result) {
+        strength_match_t sequence[STRENGTH_MAX_LENGTH];
+        size_t count = 0;
+        size_t k = len - 1;
+        size_t l = best_l;
+
+        while (l > 0 && count < STRENGTH_MAX_LENGTH) {
+            long ref = back[k * stride + l];
+            strength_match_t match;
+
+            if (ref > 0) {
+                match = matches.items[ref - 1];
+            } else {
+                memset(&match, 0, sizeof(match));
+                match.pattern = MATCH_BRUTEFORCE;
+                match.i = ref == -1 ? 0 : (size_t)(-ref - 1);
+                match.j = k;
+                match.guesses_log10 = bruteforce_log10(k - match.i + 1);
+            }
+
+            sequence[count++] = match;
+            if (match.i == 0) break;
+            k = match.i - 1;
+            l--;
+        }
+
+        result->match_count = count < STRENGTH_MAX_SEQUENCE ? count : STRENGTH_MAX_SEQUENCE;
+        for (size_t m = 0; m < result->match_count; m++) {
+            result->sequence[m] = sequence[count - 1 - m];
+        }
+    }
+
+    free(best);
+    free(back);
+    free(matches.items);
+    return total;
+}
+
+int strength_estimate(const char* password, strength_result_t* result) {
+    if (!password || !result) return -1;
+
+    size_t len = strlen(password);
+    if (len == 0 || len > STRENGTH_MAX_LENGTH) return -1;
+
+    pthread_once(&g_dict_once, load_default_dictionary);
+
+    memset(result, 0, sizeof(*result));
+    result->guesses_log10 = estimate_log10(password, len, 0, result);
+    result->entropy_bits = result->guesses_log10 * log2(10.0);
+
+    double guesses = result->guesses_log10;
+    if (guesses < log10(1e3 + 5)) result->score = 0;
+    else if (guesses < log10(1e6 + 5)) result->score = 1;
+    else if (guesses < log10(1e8 + 5)) result->score = 2;
+    else if (guesses < log10(1e10 + 5)) result->score = 3;
+    else result->score = 4;
+
+    return 0;
+}
+
+const char* strength_score_label(int score) {
+    switch (score) {
+        case 0: return "VERY WEAK";
+        case 1: return "WEAK";
+        case 2: return "FAIR";
+        case 3: return "STRONG";
+        case 4: return "VERY STRONG";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* strength_pattern_name(match_pattern_t pattern) {
+    switch (pattern) {
+        case MATCH_BRUTEFORCE: return "bruteforce";
+        case MATCH_DICTIONARY: return "dictionary";
+        case MATCH_REPEAT: return "repeat";
+        case MATCH_SEQUENCE: return "sequence";
+        case MATCH_YEAR: return "year";
+        default: return "unknown";
+    }
+}
+
+typedef struct {
+    uint8_t ch;
+    uint8_t dict;
+    uint32_t rank;
+    uint32_t* children;
+    uint32_t child_count;
+    uint32_t child_capacity;
+} BuildNode;
+
+typedef struct {
+    BuildNode* nodes;
+    uint32_t count;
+    uint32_t capacity;
+} BuildTrie;
+
+static int build_new_node(BuildTrie* trie, uint8_t ch, uint32_t* index) {
+    if (trie->count == trie->capacity) {
+        uint32_t capacity = trie->capacity ? trie->capacity * 2 : 1024;
+        BuildNode* nodes = realloc(trie->nodes, capacity * sizeof(*nodes));
+        if (!nodes) return -1;
+        trie->nodes = nodes;
+        trie->capacity = capacity;
+    }
+
+    memset(&trie->nodes[trie->count], 0, sizeof(BuildNode));
+    trie->nodes[trie->count].ch = ch;
+    *index = trie->count++;
+    return 0;
+}
+
+static int build_child(BuildTrie* trie, uint32_t parent, uint8_t ch, uint32_t* child) {
+    BuildNode* node = &trie->nodes[parent];
+    uint32_t lo = 0, hi = node->child_count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint8_t mid_ch = trie->nodes[node->children[mid]].ch;
+        if (mid_ch == ch) {
+            *child = node->children[mid];
+            return 0;
+        }
+        if (mid_ch < ch) lo = mid + 1;
+        else hi = mid;
+    }
+
+    uint32_t index;
+    if (build_new_node(trie, ch, &index) != 0) return -1;
+    node = &trie->nodes[parent];
+
+    if (node->child_count == node->child_capacity) {
+        uint32_t capacity = node->child_capacity ? node->child_capacity * 2 : 4;
+        uint32_t* children = realloc(node->children, capacity * sizeof(*children));
+        if (!children) return -1;
+        node->children = children;
+        node->child_capacity = capacity;
+    }
+
+    memmove(&node->children[lo + 1], &node->children[lo],
+            (node->child_count - lo) * sizeof(uint32_t));
+    node->children[lo] = index;
+    node->child_count++;
+    *child = index;
+    return 0;
+}
+
+static int build_insert_list(BuildTrie* trie, const char* path, uint8_t dict) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Failed to open word list %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char line[STRENGTH_MAX_LENGTH + 2];
+    uint32_t rank = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        size_t len = strcspn(line, "\r\n");
+        line[len] = '\0';
+        if (len == 0) continue;
+
+        rank++;
+        uint32_t node = 0;
+        for (size_t k = 0; k < len; k++) {
+            uint8_t ch = (uint8_t)tolower((unsigned char)line[k]);
+            if (build_child(trie, node, ch, &node) != 0) {
+                fclose(fp);
+                return -1;
+            }
+        }
+
+        if (trie->nodes[node].rank == 0 || rank < trie->nodes[node].rank) {
+            trie->nodes[node].rank = rank;
+            trie->nodes[node].dict = dict;
+        }
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+int strength_dict_build(const char* const* list_paths, const char* const* names,
+                        size_t list_count, const char* out_path) {
+    if (!list_paths || !names || !out_path || list_count == 0 || list_count > STRENGTH_MAX_DICTS) {
+        return -1;
+    }
+
+    BuildTrie trie = {NULL, 0, 0};
+    uint32_t root;
+    int ret = -1;
+    uint32_t* order = NULL;
+    uint32_t* position = NULL;
+    FILE* out = NULL;
+
+    if (build_new_node(&trie, 0, &root) != 0) goto done;
+
+    for (size_t d = 0; d < list_count; d++) {
+        if (build_insert_list(&trie, list_paths[d], (uint8_t)d) != 0) goto done;
+    }
+
+    order = malloc(trie.count * sizeof(uint32_t));
+    position = malloc(trie.count * sizeof(uint32_t));
+    if (!order || !position) goto done;
+
+    uint32_t head = 0, tail = 0;
+    order[tail++] = root;
+    while (head < tail) {
+        uint32_t index = order[head];
+        position[index] = head++;
+        for (uint32_t c = 0; c < trie.nodes[index].child_count; c++) {
+            order[tail++] = trie.nodes[index].children[c];
+        }
+    }
+
+    out = fopen(out_path, "wb");
+    if (!out) {
+        fprintf(stderr, "Failed to create %s: %s\n", out_path, strerror(errno));
+        goto done;
+    }
+
+    DictHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STRENGTH_DICT_MAGIC, 4);
+    header.version = STRENGTH_DICT_VERSION;
+    header.node_count = trie.count;
+    header.dict_count = (uint32_t)list_count;
+    for (size_t d = 0; d < list_count; d++) {
+        strncpy(header.names[d], names[d], STRENGTH_DICT_NAME_LEN - 1);
+    }
+
+    if (fwrite(&header, sizeof(header), 1, out) != 1) goto done;
+
+    for (uint32_t k = 0; k < trie.count; k++) {
+        const BuildNode* node = &trie.nodes[order[k]];
+        DictNode packed;
+        memset(&packed, 0, sizeof(packed));
+        packed.first_child = node->child_count ? position[node->children[0]] : 0;
+        packed.child_count = (uint16_t)node->child_count;
+        packed.ch = node->ch;
+        packed.dict = node->dict;
+        packed.rank = node->rank;
+        if (fwrite(&packed, sizeof(packed), 1, out) != 1) goto done;
+    }
+
+    ret = 0;
+
+done:
+    if (out && fclose(out) != 0) ret = -1;
+    for (uint32_t k = 0; k < trie.count; k++) {
+        free(trie.nodes[k].children);
+    }
+    free(trie.nodes);
+    free(order);
+    free(position);
+    return ret;
+}
@@ -0,0 +1,132 @@
+#include "timings.h"
+#include "metrics.h"
+#include <stdatomic.h>
+#include <time.h>
+
+static const char* phase_names[TIMING_PHASE_COUNT] = {
+    "lock_wait", "file_read", "kdf", "decrypt", "decompress", "index_build",
+    "backup", "compress", "encrypt", "file_write", "fsync", "rename"
+};
+
+static const char* counter_names[TIMING_COUNTER_COUNT] = {
+    "bytes_read", "bytes_written", "entries_loaded", "entries_scanned"
+};
+
+static atomic_int g_format = TIMINGS_OFF;
+static atomic_uint_fast64_t g_phase_ns[TIMING_PHASE_COUNT];
+static atomic_uint_fast64_t g_phase_calls[TIMING_PHASE_COUNT];
+static atomic_uint_fast64_t g_counters[TIMING_COUNTER_COUNT];
+
+void timings_enable(timings_format_t format) {
+    atomic_store(&g_format, (int)format);
+}
+
+timings_format_t timings_format(void) {
+    return (timings_format_t)atomic_load_explicit(&g_format, memory_order_relaxed);
+}
+
+const char* timings_phase_name(timing_phase_t phase) {
+    return phase < TIMING_PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+const char* timings_counter_name(timing_counter_t counter) {
+    return counter < TIMING_COUNTER_COUNT ? counter_names[counter] : "unknown";
+}
+
+/*
+ * Returns 0 while both timings and metrics are off, which makes the matching
+ * timings_add() a no-op. Phases also feed the metrics histograms.
+ */
+uint64_t timings_now(void) {
+    if (timings_format() == TIMINGS_OFF && !metrics_enabled()) {
+        return 0;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void timings_add(timing_phase_t phase, uint64_t start) {
+    if (start == 0 || phase >= TIMING_PHASE_COUNT) {
+        return;
+    }
+    uint64_t now = timings_now();
+    if (now < start) {
+        return;
+    }
+    if (timings_format() != TIMINGS_OFF) {
+        atomic_fetch_add_explicit(&g_phase_ns[phase], now - start, memory_order_relaxed);
+        atomic_fetch_add_explicit(&g_phase_calls[phase], 1, memory_order_relaxed);
+    }
+    metrics_observe_ns((metric_histogram_t)(METRIC_PHASE_FIRST + phase), now - start);
+}
+
+void timings_count(timing_counter_t counter, uint64_t amount) {
+    if (counter >= TIMING_COUNTER_COUNT) {
+        return;
+    }
+    if (timings_format() != TIMINGS_OFF) {
+        atomic_fetch_add_explicit(&g_counters[counter], amount, memory_order_relaxed);
+    }
+    metrics_count((metric_counter_t)(METRIC_TIMING_COUNTER_FIRST + counter), amount);
+}
+
+void timings_reset(void) {
+    for (int i = 0; i < TIMING_PHASE_COUNT; i++) {
+        atomic_store(&g_phase_ns[i], 0);
+        atomic_store(&g_phase_calls[i], 0);
+    }
+    for (int i = 0; i < TIMING_COUNTER_COUNT; i++) {
+        atomic_store(&g_counters[i], 0);
+    }
+}
+
+double timings_phase_ms(timing_phase_t phase) {
+    return phase < TIMING_PHASE_COUNT ? atomic_load(&g_phase_ns[phase]) / 1e6 : 0.0;
+}
+
+uint64_t timings_phase_calls(timing_phase_t phase) {
+    return phase < TIMING_PHASE_COUNT ? atomic_load(&g_phase_calls[phase]) : 0;
+}
+
+uint64_t timings_counter(timing_counter_t counter) {
+    return counter < TIMING_COUNTER_COUNT ? atomic_load(&g_counters[counter]) : 0;
+}
+
+/* Phases that never ran are left out of the text report. */
+void timings_report(FILE* out) {
+    timings_format_t format = timings_format();
+    if (!out || format == TIMINGS_OFF) {
+        return;
+    }
+
+    if (format == TIMINGS_JSON) {
+        fprintf(out, "{\"phases\":{");
+        for (int i = 0; i < TIMING_PHASE_COUNT; i++) {
+            fprintf(out, "%s\"%s\":{\"ms\":%.3f,\"calls\":%llu}", i ? "," : "", phase_names[i],
+                    timings_phase_ms((timing_phase_t)i),
+                    (unsigned long long)timings_phase_calls((timing_phase_t)i));
+        }
+        fprintf(out, "},\"counters\":{");
+        for (int i = 0; i < TIMING_COUNTER_COUNT; i++) {
+            fprintf(out, "%s\"%s\":%llu", i ? "," : "", counter_names[i],
+                    (unsigned long long)timings_counter((timing_counter_t)i));
+        }
+        fprintf(out, "}}\n");
+        return;
+    }
+
+    fprintf(out, "Timings (summed over threads):\n");
+    for (int i = 0; i < TIMING_PHASE_COUNT; i++) {
+        uint64_t calls = timings_phase_calls((timing_phase_t)i);
+        if (calls > 0) {
+            fprintf(out, "  %-12s %10.2f ms %6llu call%s\n", phase_names[i],
+                    timings_phase_ms((timing_phase_t)i), (unsigned long long)calls,
+                    calls == 1 ? "" : "s");
+        }
+    }
+    for (int i = 0; i < TIMING_COUNTER_COUNT; i++) {
+        fprintf(out, "  %-15s %10llu\n", counter_names[i],
+                (unsigned long long)timings_counter((timing_counter_t)i));
+    }
+}
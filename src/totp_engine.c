@@ -3,9 +3,10 @@
 #include <openssl/rand.h>
 #include <time.h>
 #include <string.h>
+#include <strings.h>
 
-#define TOTP_TIME_STEP 30
-#define TOTP_CODE_DIGITS 6
+#define TOTP_TIME_STEP TOTP_DEFAULT_PERIOD
+#define TOTP_CODE_DIGITS TOTP_DEFAULT_DIGITS
 
 static uint32_t power10(int exponent) {
     uint32_t result = 1;
@@ -34,7 +35,7 @@ int base32_decode(const char* encoded, unsigned char* result, size_t buf_len) {
         const char* p = strchr(base32_chars, ch);
         if (!p) continue;
         
-        buffer = (buffer << 5) | (p - base32_chars);
+        buffer = ((buffer & 0xFF) << 5) | (p - base32_chars);
         bits += 5;
         
         if (bits >= 8) {
@@ -64,10 +65,11 @@ int base32_encode(const unsigned char* data, size_t len, char* result, size_t bu
     while (bits > 0 || index < len) {
         if (bits < 5) {
             if (index < len) {
-                buffer = (buffer << 8) | data[index++];
+                buffer = ((buffer & 0xFF) << 8) | data[index++];
                 bits += 8;
             } else {
-                break;
+                buffer <<= 5 - bits;
+                bits = 5;
             }
         }
         
@@ -79,35 +81,82 @@ int base32_encode(const unsigned char* data, size_t len, char* result, size_t bu
     return count;
 }
 
-uint32_t generate_totp(const char* base32_secret) {
+static const EVP_MD* totp_digest(totp_algorithm_t algorithm) {
+    switch (algorithm) {
+        case TOTP_ALG_SHA1: return EVP_sha1();
+        case TOTP_ALG_SHA256: return EVP_sha256();
+        case TOTP_ALG_SHA512: return EVP_sha512();
+        default: return NULL;
+    }
+}
+
+const char* totp_algorithm_name(totp_algorithm_t algorithm) {
+    switch (algorithm) {
+        case TOTP_ALG_SHA1: return "SHA1";
+        case TOTP_ALG_SHA256: return "SHA256";
+        case TOTP_ALG_SHA512: return "SHA512";
+        default: return "unknown";
+    }
+}
+
+int totp_algorithm_from_name(const char* name, totp_algorithm_t* algorithm) {
+    if (!name || !algorithm) return -1;
+
+    if (strcasecmp(name, "SHA1") == 0) {
+        *algorithm = TOTP_ALG_SHA1;
+    } else if (strcasecmp(name, "SHA256") == 0) {
+        *algorithm = TOTP_ALG_SHA256;
+    } else if (strcasecmp(name, "SHA512") == 0) {
+        *algorithm = TOTP_ALG_SHA512;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+uint32_t generate_otp(const char* base32_secret, totp_algorithm_t algorithm,
+                      int digits, uint64_t counter) {
     if (!base32_secret) return 0;
-    
-    unsigned char secret[32];
+    if (digits < TOTP_MIN_DIGITS || digits > TOTP_MAX_DIGITS) return 0;
+
+    const EVP_MD* md = totp_digest(algorithm);
+    if (!md) return 0;
+
+    unsigned char secret[TOTP_MAX_SECRET_BYTES];
     int secret_len = base32_decode(base32_secret, secret, sizeof(secret));
     if (secret_len <= 0) return 0;
-    
-    uint64_t time_steps = (uint64_t)time(NULL) / TOTP_TIME_STEP;
 
-    unsigned char time_bytes[8];
+    unsigned char counter_bytes[8];
     for (int i = 7; i >= 0; i--) {
-        time_bytes[i] = time_steps & 0xFF;
-        time_steps >>= 8;
+        counter_bytes[i] = counter & 0xFF;
+        counter >>= 8;
     }
-    
-    unsigned char hmac[20];
+
+    unsigned char hmac[EVP_MAX_MD_SIZE];
     unsigned int hmac_len;
-    HMAC(EVP_sha1(), secret, secret_len, time_bytes, 8, hmac, &hmac_len);
-    
+    HMAC(md, secret, secret_len, counter_bytes, 8, hmac, &hmac_len);
+    memset(secret, 0, sizeof(secret));
+
     int offset = hmac[hmac_len - 1] & 0x0F;
     uint32_t code = ((hmac[offset] & 0x7F) << 24) |
                    (hmac[offset + 1] << 16) |
                    (hmac[offset + 2] << 8) |
                    hmac[offset + 3];
 
-    uint32_t totp_code = code % power10(TOTP_CODE_DIGITS);
-    
-    memset(secret, 0, sizeof(secret));
-    return totp_code;
+    memset(hmac, 0, sizeof(hmac));
+    return code % power10(digits);
+}
+
+uint32_t generate_totp_at(const char* base32_secret, totp_algorithm_t algorithm,
+                          int digits, uint32_t period, time_t now) {
+    if (period == 0 || now < 0) return 0;
+    return generate_otp(base32_secret, algorithm, digits, (uint64_t)now / period);
+}
+
+uint32_t generate_totp(const char* base32_secret) {
+    return generate_totp_at(base32_secret, TOTP_ALG_SHA1, TOTP_CODE_DIGITS,
+                            TOTP_TIME_STEP, time(NULL));
 }
 
 int generate_totp_secret(char* output, size_t output_len) {
@@ -131,31 +180,7 @@ int validate_totp(const char* base32_secret, uint32_t code) {
         return 0;
     }
     
-    time_t old_time = time(NULL) - TOTP_TIME_STEP;
-    uint64_t old_steps = (uint64_t)old_time / TOTP_TIME_STEP;
-    
-    unsigned char secret[32];
-    int secret_len = base32_decode(base32_secret, secret, sizeof(secret));
-    if (secret_len <= 0) return -1;
-    
-    unsigned char time_bytes[8];
-    for (int i = 7; i >= 0; i--) {
-        time_bytes[i] = old_steps & 0xFF;
-        old_steps >>= 8;
-    }
-    
-    unsigned char hmac[20];
-    unsigned int hmac_len;
-    HMAC(EVP_sha1(), secret, secret_len, time_bytes, 8, hmac, &hmac_len);
-    
-    int offset = hmac[hmac_len - 1] & 0x0F;
-    uint32_t old_code = ((hmac[offset] & 0x7F) << 24) |
-                       (hmac[offset + 1] << 16) |
-                       (hmac[offset + 2] << 8) |
-                       hmac[offset + 3];
-    
-    uint32_t old_totp = old_code % power10(TOTP_CODE_DIGITS);
-    
-    memset(secret, 0, sizeof(secret));
+    uint32_t old_totp = generate_totp_at(base32_secret, TOTP_ALG_SHA1, TOTP_CODE_DIGITS,
+                                         TOTP_TIME_STEP, time(NULL) - TOTP_TIME_STEP);
     return (old_totp == code) ? 0 : -1;
 }
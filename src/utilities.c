@@ -1,4 +1,7 @@
 #include "utilities.h"
+#include "password_gen.h"
+#include "strength.h"
+#include "crypto_engine.h"
 #include <stdio.h>
 #include <string.h>
 #include <termios.h>
@@ -9,20 +12,12 @@ int check_password_strength(const char* password) {
         return -1;
     }
 
-    int length = strlen(password);
-    int has_lower = 0, has_upper = 0, has_digit = 0, has_special = 0;
-
-    for (int i = 0; i < length; i++) {
-        if (password[i] >= 'a' && password[i] <= 'z') has_lower = 1;
-        else if (password[i] >= 'A' && password[i] <= 'Z') has_upper = 1;
-        else if (password[i] >= '0' && password[i] <= '9') has_digit = 1;
-        else has_special = 1;
+    strength_result_t result;
+    if (strength_estimate(password, &result) != 0) {
+        return -1;
     }
 
-    int score = (length >= 12 ? 2 : length >= 8 ? 1 : 0) +
-                has_lower + has_upper + has_digit + has_special;
-
-    return score;
+    return result.score;
 }
 
 int generate_random_password(char* output, size_t output_len, int length) {
@@ -34,25 +29,18 @@ int generate_random_password(char* output, size_t output_len, int length) {
         return -1;
     }
 
-    const char charset[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*()-_=+";
+    password_policy_t policy;
+    password_policy_default(&policy, length);
 
-    FILE* urandom = fopen("/dev/urandom", "r");
-    if (!urandom) {
+    password_generator_t generator;
+    if (password_generator_init(&generator, &policy) != 0) {
         return -1;
     }
 
-    for (int i = 0; i < length; i++) {
-        unsigned char byte;
-        if (fread(&byte, 1, 1, urandom) != 1) {
-            fclose(urandom);
-            return -1;
-        }
-        output[i] = charset[byte % (sizeof(charset) - 1)];
-    }
-    output[length] = '\0';
+    int result = password_generator_next(&generator, output, output_len);
+    password_generator_cleanup(&generator);
 
-    fclose(urandom);
-    return 0;
+    return result == length ? 0 : -1;
 }
 
 int read_password_secure(const char* prompt, char* password, size_t max_len) {
@@ -92,3 +80,51 @@ int read_password_secure(const char* prompt, char* password, size_t max_len) {
 
     return 0;
 }
+
+int read_password_fd(int fd, char* password, size_t max_len) {
+    if (fd < 0 || !password || max_len == 0) {
+        return -1;
+    }
+
+    size_t len = 0;
+    char c;
+    ssize_t n;
+
+    while ((n = read(fd, &c, 1)) == 1 && c != '\n') {
+        if (len + 1 >= max_len) {
+            secure_cleanup(password, max_len);
+            return -1;
+        }
+        password[len++] = c;
+    }
+    password[len] = '\0';
+
+    if (n < 0 || (n == 0 && len == 0)) {
+        return -1;
+    }
+    if (len > 0 && password[len - 1] == '\r') {
+        password[--len] = '\0';
+    }
+
+    return 0;
+}
+
+void json_write_string(FILE* out, const char* value) {
+    fputc('"', out);
+    for (const unsigned char* p = (const unsigned char*)value; *p; p++) {
+        switch (*p) {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:
+                if (*p < 0x20) {
+                    fprintf(out, "\\u%04x", *p);
+                } else {
+                    fputc(*p, out);
+                }
+        }
+    }
+    fputc('"', out);
+}
@@ -0,0 +1,324 @@
+#include "vault_audit.h"
+#include "vault_controller.h"
+#include "crypto_engine.h"
+#include "strength.h"
+#include "utilities.h"
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define AUDIT_CHUNK 64
+#define AUDIT_DIGEST_SIZE 32
+#define SECONDS_PER_DAY 86400
+
+typedef struct {
+    unsigned char digest[AUDIT_DIGEST_SIZE];
+    size_t index;
+    int valid;
+} ReuseKey;
+
+typedef struct {
+    const audit_options_t* options;
+    audit_report_t* report;
+    ReuseKey* keys;
+    unsigned char hmac_key[AUDIT_DIGEST_SIZE];
+    atomic_size_t next;
+    atomic_int failed;
+} AuditContext;
+
+static const struct {
+    unsigned int flag;
+    const char* name;
+} flag_names[] = {
+    {AUDIT_FLAG_REUSED, "reused"},
+    {AUDIT_FLAG_WEAK, "weak"},
+    {AUDIT_FLAG_BREACHED, "breached"},
+    {AUDIT_FLAG_NO_TOTP, "no_totp"},
+    {AUDIT_FLAG_STALE, "stale"},
+    {AUDIT_FLAG_OTP_ONLY, "otp_only"}
+};
+
+void audit_options_default(audit_options_t* options) {
+    if (!options) return;
+
+    options->threads = 0;
+    options->stale_days = AUDIT_DEFAULT_STALE_DAYS;
+    options->weak_score = AUDIT_DEFAULT_WEAK_SCORE;
+    options->breach_db = NULL;
+    options->now = 0;
+}
+
+const char* audit_flag_name(unsigned int flag) {
+    for (size_t i = 0; i < sizeof(flag_names) / sizeof(flag_names[0]); i++) {
+        if (flag_names[i].flag == flag) return flag_names[i].name;
+    }
+    return "unknown";
+}
+
+static void audit_entry(AuditContext* ctx, size_t index, VaultEntry* entry) {
+    const audit_options_t* options = ctx->options;
+    audit_entry_result_t* result = &ctx->report->entries[index];
+    ReuseKey* key = &ctx->keys[index];
+
+    memset(result, 0, sizeof(*result));
+    key->index = index;
+    key->valid = 0;
+
+    if (vault_get_entry_at(index, entry) != 0) {
+        atomic_store(&ctx->failed, 1);
+        return;
+    }
+
+    if (entry->totp_secret[0] == '\0') {
+        result->flags |= AUDIT_FLAG_NO_TOTP;
+    }
+
+    /* OTP-only entries (e.g. from an otpauth import) have no password to judge. */
+    if (entry->password[0] == '\0') {
+        result->flags |= AUDIT_FLAG_OTP_ONLY;
+        result->age_days = -1;
+        return;
+    }
+
+    strength_result_t strength;
+    if (strength_estimate(entry->password, &strength) == 0) {
+        result->score = strength.score;
+        result->guesses_log10 = strength.guesses_log10;
+    }
+    if (result->score < options->weak_score) {
+        result->flags |= AUDIT_FLAG_WEAK;
+    }
+
+    if (options->breach_db &&
+        breach_db_check_password(options->breach_db, entry->password, &result->breach_count) > 0) {
+        result->flags |= AUDIT_FLAG_BREACHED;
+    }
+
+    if (entry->password_updated_at == 0) {
+        result->age_days = -1;
+    } else {
+        int64_t age = (int64_t)options->now - (int64_t)entry->password_updated_at;
+        result->age_days = age > 0 ? age / SECONDS_PER_DAY : 0;
+        if (result->age_days >= options->stale_days) {
+            result->flags |= AUDIT_FLAG_STALE;
+        }
+    }
+
+    size_t len = strlen(entry->password);
+    unsigned int digest_len = 0;
+    if (len > 0 && HMAC(EVP_sha256(), ctx->hmac_key, sizeof(ctx->hmac_key),
+                        (const unsigned char*)entry->password, len,
+                        key->digest, &digest_len) != NULL) {
+        key->valid = 1;
+    }
+}
+
+static void* audit_worker(void* arg) {
+    AuditContext* ctx = (AuditContext*)arg;
+    size_t total = ctx->report->total;
+    VaultEntry entry;
+
+    for (;;) {
+        size_t start = atomic_fetch_add(&ctx->next, AUDIT_CHUNK);
+        if (start >= total) break;
+
+        size_t end = start + AUDIT_CHUNK < total ? start + AUDIT_CHUNK : total;
+        for (size_t i = start; i < end; i++) {
+            audit_entry(ctx, i, &entry);
+        }
+    }
+
+    secure_cleanup(&entry, sizeof(entry));
+    return NULL;
+}
+
+static int compare_reuse_keys(const void* a, const void* b) {
+    const ReuseKey* ka = (const ReuseKey*)a;
+    const ReuseKey* kb = (const ReuseKey*)b;
+
+    if (ka->valid != kb->valid) return kb->valid - ka->valid;
+    int cmp = memcmp(ka->digest, kb->digest, AUDIT_DIGEST_SIZE);
+    if (cmp != 0) return cmp;
+    return ka->index < kb->index ? -1 : ka->index > kb->index;
+}
+
+static void group_reused(AuditContext* ctx) {
+    audit_report_t* report = ctx->report;
+    ReuseKey* keys = ctx->keys;
+
+    qsort(keys, report->total, sizeof(ReuseKey), compare_reuse_keys);
+
+    size_t i = 0;
+    while (i < report->total && keys[i].valid) {
+        size_t j = i + 1;
+        while (j < report->total && keys[j].valid &&
+               memcmp(keys[i].digest, keys[j].digest, AUDIT_DIGEST_SIZE) == 0) {
+            j++;
+        }
+
+        if (j - i > 1) {
+            report->reuse_groups++;
+            for (size_t k = i; k < j; k++) {
+                audit_entry_result_t* result = &report->entries[keys[k].index];
+                result->flags |= AUDIT_FLAG_REUSED;
+                result->reuse_group = report->reuse_groups;
+                result->reuse_count = j - i;
+            }
+        }
+        i = j;
+    }
+}
+
+static int pick_thread_count(const audit_options_t* options, size_t total) {
+    int threads = options->threads;
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    size_t useful = total / AUDIT_MIN_ENTRIES_PER_THREAD + 1;
+    if ((size_t)threads > useful) threads = (int)useful;
+    if (threads > AUDIT_MAX_THREADS) threads = AUDIT_MAX_THREADS;
+    return threads < 1 ? 1 : threads;
+}
+
+int vault_audit(const audit_options_t* options, audit_report_t* report) {
+    if (!options || !report) return -1;
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    memset(report, 0, sizeof(*report));
+    report->total = vault_entry_count();
+    report->breach_checked = options->breach_db != NULL;
+
+    audit_options_t effective = *options;
+    if (effective.now == 0) effective.now = time(NULL);
+
+    AuditContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.options = &effective;
+    ctx.report = report;
+    atomic_init(&ctx.next, 0);
+    atomic_init(&ctx.failed, 0);
+
+    if (report->total > 0) {
+        report->entries = calloc(report->total, sizeof(audit_entry_result_t));
+        ctx.keys = calloc(report->total, sizeof(ReuseKey));
+        if (!report->entries || !ctx.keys || RAND_bytes(ctx.hmac_key, sizeof(ctx.hmac_key)) != 1) {
+            free(ctx.keys);
+            audit_report_free(report);
+            return -1;
+        }
+    }
+
+    report->threads_used = pick_thread_count(&effective, report->total);
+    pthread_t workers[AUDIT_MAX_THREADS];
+    int started_threads = 0;
+
+    strength_dictionary_loaded();
+
+    for (int t = 1; t < report->threads_used; t++) {
+        if (pthread_create(&workers[started_threads], NULL, audit_worker, &ctx) != 0) break;
+        started_threads++;
+    }
+    audit_worker(&ctx);
+    for (int t = 0; t < started_threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    report->threads_used = started_threads + 1;
+
+    secure_cleanup(ctx.hmac_key, sizeof(ctx.hmac_key));
+
+    if (atomic_load(&ctx.failed)) {
+        secure_cleanup(ctx.keys, report->total * sizeof(ReuseKey));
+        free(ctx.keys);
+        audit_report_free(report);
+        return -1;
+    }
+
+    if (report->total > 0) {
+        group_reused(&ctx);
+        secure_cleanup(ctx.keys, report->total * sizeof(ReuseKey));
+        free(ctx.keys);
+    }
+
+    for (size_t i = 0; i < report->total; i++) {
+        const audit_entry_result_t* result = &report->entries[i];
+        if (result->flags & AUDIT_FLAG_REUSED) report->reused++;
+        if (result->flags & AUDIT_FLAG_WEAK) report->weak++;
+        if (result->flags & AUDIT_FLAG_BREACHED) report->breached++;
+        if (result->flags & AUDIT_FLAG_NO_TOTP) report->no_totp++;
+        if (result->flags & AUDIT_FLAG_STALE) report->stale++;
+        if (result->flags & AUDIT_FLAG_OTP_ONLY) report->otp_only++;
+        else if (result->age_days < 0) report->undated++;
+    }
+
+    struct timespec finished;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    report->elapsed_seconds = (finished.tv_sec - started.tv_sec) +
+                              (finished.tv_nsec - started.tv_nsec) / 1e9;
+    return 0;
+}
+
+int audit_report_write_json(const audit_report_t* report, FILE* out) {
+    if (!report || !out) return -1;
+
+    fprintf(out, "{\n  \"entries\": %zu,\n", report->total);
+    fprintf(out, "  \"breach_checked\": %s,\n", report->breach_checked ? "true" : "false");
+    fprintf(out, "  \"summary\": {\"reused\": %zu, \"reuse_groups\": %zu, \"weak\": %zu, "
+                 "\"breached\": %zu, \"no_totp\": %zu, \"stale\": %zu, \"undated\": %zu, "
+                 "\"otp_only\": %zu},\n",
+            report->reused, report->reuse_groups, report->weak, report->breached,
+            report->no_totp, report->stale, report->undated, report->otp_only);
+    fprintf(out, "  \"findings\": [");
+
+    VaultEntry entry;
+    int first = 1;
+    for (size_t i = 0; i < report->total; i++) {
+        const audit_entry_result_t* result = &report->entries[i];
+        if (result->flags == 0 || vault_get_entry_at(i, &entry) != 0) continue;
+
+        fprintf(out, "%s\n    {\"service\": ", first ? "" : ",");
+        json_write_string(out, entry.service);
+        fprintf(out, ", \"username\": ");
+        json_write_string(out, entry.username);
+        fprintf(out, ", \"flags\": [");
+
+        int first_flag = 1;
+        for (size_t f = 0; f < sizeof(flag_names) / sizeof(flag_names[0]); f++) {
+            if (result->flags & flag_names[f].flag) {
+                fprintf(out, "%s\"%s\"", first_flag ? "" : ", ", flag_names[f].name);
+                first_flag = 0;
+            }
+        }
+
+        fprintf(out, "], \"score\": %d, \"guesses_log10\": %.2f", result->score, result->guesses_log10);
+        if (result->reuse_group) {
+            fprintf(out, ", \"reuse_group\": %zu, \"reuse_count\": %zu", result->reuse_group, result->reuse_count);
+        }
+        if (result->flags & AUDIT_FLAG_BREACHED) {
+            fprintf(out, ", \"breach_count\": %u", result->breach_count);
+        }
+        if (result->age_days >= 0) {
+            fprintf(out, ", \"password_age_days\": %lld", (long long)result->age_days);
+        }
+        fprintf(out, "}");
+        first = 0;
+    }
+    secure_cleanup(&entry, sizeof(entry));
+
+    fprintf(out, "%s]\n}\n", first ? "" : "\n  ");
+    return ferror(out) ? -1 : 0;
+}
+
+void audit_report_free(audit_report_t* report) {
+    if (!report) return;
+    free(report->entries);
+    report->entries = NULL;
+}
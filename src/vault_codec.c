@@ -0,0 +1,244 @@
+#include "vault_codec.h"
+#include <limits.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#define VAULT_ZLIB_LEVEL 1
+#define VAULT_ZSTD_LEVEL 3
+
+static const struct {
+    vault_codec_t codec;
+    const char* name;
+} codec_names[] = {
+    {VAULT_CODEC_NONE, "none"},
+    {VAULT_CODEC_ZLIB, "zlib"},
+    {VAULT_CODEC_ZLIB_DICT, "zlib-dict"},
+    {VAULT_CODEC_ZSTD, "zstd"},
+    {VAULT_CODEC_ZSTD_DICT, "zstd-dict"}
+};
+
+/*
+ * Preset dictionary for the *-dict codecs, built from the strings that make
+ * up typical entries. It lets small vaults and single shards compress well
+ * from the first entry. Files record which dictionary they were written
+ * with, so this text must never change; a new one needs a new codec value.
+ * The most common strings are at the end, where matches are cheapest.
+ */
+static const char entry_dictionary[] =
+    "otpauth://totp/?secret=&issuer=&algorithm=SHA1&digits=6&period=30"
+    "JBSWY3DPEHPK3PXP"
+    "admin administrator root test info support contact hello"
+    "bank.com shop.com cloud.com mail.com"
+    "stackoverflow.com wordpress.com atlassian.net heroku.com digitalocean.com"
+    "steampowered.com discord.com twitch.tv instagram.com tiktok.com zoom.us"
+    "ebay.com adobe.com paypal.com dropbox.com slack.com reddit.com"
+    "amazon.com microsoft.com apple.com facebook.com twitter.com linkedin.com"
+    "netflix.com spotify.com gitlab.com bitbucket.org"
+    "https://www.http://.org.net.io.co.uk.de"
+    "@hotmail.com@yahoo.com@icloud.com@protonmail.com@proton.me@outlook.com"
+    "user@example.com"
+    "GitHub github.com Google google.com accounts.google.com"
+    "@gmail.com";
+
+static bool uses_dictionary(vault_codec_t codec) {
+    return codec == VAULT_CODEC_ZLIB_DICT || codec == VAULT_CODEC_ZSTD_DICT;
+}
+
+int vault_codec_parse(const char* name, vault_codec_t* codec) {
+    if (!name || !codec) return -1;
+
+    for (size_t i = 0; i < sizeof(codec_names) / sizeof(codec_names[0]); i++) {
+        if (strcmp(codec_names[i].name, name) == 0) {
+            *codec = codec_names[i].codec;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* vault_codec_name(vault_codec_t codec) {
+    for (size_t i = 0; i < sizeof(codec_names) / sizeof(codec_names[0]); i++) {
+        if (codec_names[i].codec == codec) return codec_names[i].name;
+    }
+    return "unknown";
+}
+
+bool vault_codec_available(vault_codec_t codec) {
+    switch (codec) {
+        case VAULT_CODEC_NONE:
+        case VAULT_CODEC_ZLIB:
+        case VAULT_CODEC_ZLIB_DICT:
+            return true;
+        case VAULT_CODEC_ZSTD:
+        case VAULT_CODEC_ZSTD_DICT:
+#ifdef WITH_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+size_t vault_codec_bound(vault_codec_t codec, size_t size) {
+    switch (codec) {
+        case VAULT_CODEC_NONE:
+            return size;
+        case VAULT_CODEC_ZLIB:
+        case VAULT_CODEC_ZLIB_DICT:
+            /* compressBound() plus the 4-byte dictionary id. */
+            return size + (size >> 12) + (size >> 14) + (size >> 25) + 13 + 4;
+        case VAULT_CODEC_ZSTD:
+        case VAULT_CODEC_ZSTD_DICT:
+#ifdef WITH_ZSTD
+            return ZSTD_compressBound(size);
+#else
+            return 0;
+#endif
+    }
+    return 0;
+}
+
+static int zlib_compress(bool dictionary, const void* src, size_t size, unsigned char* dst,
+                         size_t* dst_size) {
+    if (size > UINT_MAX || *dst_size > UINT_MAX) {
+        return -1;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit(&stream, VAULT_ZLIB_LEVEL) != Z_OK) {
+        return -1;
+    }
+    if (dictionary && deflateSetDictionary(&stream, (const Bytef*)entry_dictionary,
+                                           sizeof(entry_dictionary) - 1) != Z_OK) {
+        deflateEnd(&stream);
+        return -1;
+    }
+
+    stream.next_in = (Bytef*)src;
+    stream.avail_in = (uInt)size;
+    stream.next_out = dst;
+    stream.avail_out = (uInt)*dst_size;
+    int ret = deflate(&stream, Z_FINISH);
+    *dst_size = stream.total_out;
+    deflateEnd(&stream);
+    return ret == Z_STREAM_END ? 0 : -1;
+}
+
+static int zlib_decompress(const unsigned char* src, size_t size, void* dst, size_t dst_size) {
+    if (size > UINT_MAX || dst_size > UINT_MAX) {
+        return -1;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit(&stream) != Z_OK) {
+        return -1;
+    }
+
+    stream.next_in = (Bytef*)src;
+    stream.avail_in = (uInt)size;
+    stream.next_out = (Bytef*)dst;
+    stream.avail_out = (uInt)dst_size;
+    int ret = inflate(&stream, Z_FINISH);
+    if (ret == Z_NEED_DICT) {
+        if (inflateSetDictionary(&stream, (const Bytef*)entry_dictionary,
+                                 sizeof(entry_dictionary) - 1) != Z_OK) {
+            inflateEnd(&stream);
+            return -1;
+        }
+        ret = inflate(&stream, Z_FINISH);
+    }
+
+    bool complete = ret == Z_STREAM_END && stream.total_out == dst_size;
+    inflateEnd(&stream);
+    return complete ? 0 : -1;
+}
+
+#ifdef WITH_ZSTD
+static int zstd_compress(bool dictionary, const void* src, size_t size, unsigned char* dst,
+                         size_t* dst_size) {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    if (!cctx) {
+        return -1;
+    }
+
+    size_t written = ZSTD_compress_usingDict(cctx, dst, *dst_size, src, size,
+                                             dictionary ? entry_dictionary : NULL,
+                                             dictionary ? sizeof(entry_dictionary) - 1 : 0,
+                                             VAULT_ZSTD_LEVEL);
+    ZSTD_freeCCtx(cctx);
+    if (ZSTD_isError(written)) {
+        return -1;
+    }
+    *dst_size = written;
+    return 0;
+}
+
+static int zstd_decompress(bool dictionary, const unsigned char* src, size_t size, void* dst,
+                           size_t dst_size) {
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    if (!dctx) {
+        return -1;
+    }
+
+    size_t read = ZSTD_decompress_usingDict(dctx, dst, dst_size, src, size,
+                                            dictionary ? entry_dictionary : NULL,
+                                            dictionary ? sizeof(entry_dictionary) - 1 : 0);
+    ZSTD_freeDCtx(dctx);
+    return !ZSTD_isError(read) && read == dst_size ? 0 : -1;
+}
+#endif
+
+/* On entry *dst_size is the capacity of dst, at least vault_codec_bound(). */
+int vault_codec_compress(vault_codec_t codec, const void* src, size_t size,
+                         unsigned char* dst, size_t* dst_size) {
+    if (!src || !dst || !dst_size) return -1;
+
+    switch (codec) {
+        case VAULT_CODEC_NONE:
+            if (*dst_size < size) return -1;
+            memcpy(dst, src, size);
+            *dst_size = size;
+            return 0;
+        case VAULT_CODEC_ZLIB:
+        case VAULT_CODEC_ZLIB_DICT:
+            return zlib_compress(uses_dictionary(codec), src, size, dst, dst_size);
+        case VAULT_CODEC_ZSTD:
+        case VAULT_CODEC_ZSTD_DICT:
+#ifdef WITH_ZSTD
+            return zstd_compress(uses_dictionary(codec), src, size, dst, dst_size);
+#else
+            break;
+#endif
+    }
+    return -1;
+}
+
+/* Fails unless src expands to exactly dst_size bytes. */
+int vault_codec_decompress(vault_codec_t codec, const unsigned char* src, size_t size,
+                           void* dst, size_t dst_size) {
+    if (!src || !dst) return -1;
+
+    switch (codec) {
+        case VAULT_CODEC_NONE:
+            if (size != dst_size) return -1;
+            memcpy(dst, src, size);
+            return 0;
+        case VAULT_CODEC_ZLIB:
+        case VAULT_CODEC_ZLIB_DICT:
+            return zlib_decompress(src, size, dst, dst_size);
+        case VAULT_CODEC_ZSTD:
+        case VAULT_CODEC_ZSTD_DICT:
+#ifdef WITH_ZSTD
+            return zstd_decompress(uses_dictionary(codec), src, size, dst, dst_size);
+#else
+            break;
+#endif
+    }
+    return -1;
+}
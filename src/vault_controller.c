@@ -1,22 +1,256 @@
+#define _GNU_SOURCE
 #include "vault_controller.h"
+#include "vault_codec.h"
+#include "timings.h"
+#include "metrics.h"
 #include "crypto_engine.h"
+#include "totp_engine.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <libgen.h>
+#include <fcntl.h>
 #include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <openssl/rand.h>
 
-static VaultState g_vault = {
-    .vault_path = {0},
-    .key = {0},
-    .header = {{0}},
-    .entries = NULL,
-    .is_open = false,
-    .auto_backup = true
+#define VAULT_PATH_MAX 512
+#define VAULT_READER_SLOTS 64
+#define VAULT_SHARD_PATH_MAX (VAULT_PATH_MAX + 32)
+#define VAULT_UNLOCK_THREADS 16
+#define VAULT_MANIFEST_MAGIC "SKVS"
+#define VAULT_MANIFEST_VERSION 1
+#define VAULT_HEADER_V3_SIZE offsetof(VaultHeader, codec)
+
+/*
+ * Readers never lock. They pin the current epoch in a reader slot, load the
+ * published snapshot and read it. Writers work on a private copy-on-write
+ * draft and publish it with one atomic exchange. A replaced snapshot, and the
+ * entries only it still references, are wiped and freed once no reader is
+ * pinned at or before the epoch it was retired in and no caller holds a
+ * reference to it. Retired snapshots are reclaimed oldest first, so an entry
+ * parked on one snapshot's garbage list outlives every older snapshot.
+ */
+struct VaultSnapshot {
+    atomic_uint refs;
+    uint32_t count;
+    uint32_t capacity;
+    VaultEntry** entries;
+    uint32_t* index;
+    uint32_t index_mask;
+    VaultEntry** garbage;
+    size_t garbage_count;
+    size_t garbage_capacity;
+    uint64_t retired_epoch;
+    struct VaultSnapshot* next;
 };
 
+typedef struct {
+    atomic_uint_fast64_t epoch;
+    char pad[64 - sizeof(atomic_uint_fast64_t)];
+} ReaderSlot;
+
+/*
+ * A sharded vault is a directory holding a manifest and shard files named
+ * shard-000, shard-001 and so on. Each shard is an ordinary vault file with
+ * the same salt, and an entry lives in the shard picked by the hash of its
+ * service and username. A single-file vault is handled as one shard.
+ */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t shard_count;
+    unsigned char salt[SALT_SIZE];
+} VaultManifest;
+
+typedef struct {
+    struct stat st;
+    uint64_t written_capture;
+} VaultShard;
+
+typedef struct {
+    VaultHeader header;
+    unsigned char* ciphertext;
+    size_t ciphertext_size;
+    VaultEntry* entries;
+} ShardLoad;
+
+/* Filled by the reader thread of vault_handle_open() while the key is derived. */
+typedef struct {
+    vault_handle_t* vault;
+    ShardLoad* loads;
+    bool unlock;
+    uint32_t loaded;
+    bool failed;
+    double read_ms;
+    pthread_t thread;
+    bool threaded;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} ShardPrefetch;
+
+typedef struct {
+    ShardLoad* loads;
+    uint32_t count;
+    const unsigned char* key;
+    ShardPrefetch* prefetch;
+    atomic_uint next;
+    atomic_bool failed;
+} ShardDecryptJob;
+
+struct VaultState {
+    char vault_path[VAULT_PATH_MAX];
+    unsigned char key[32];
+    VaultHeader header;
+    bool auto_backup;
+    int batch_depth;
+    bool batch_dirty;
+    bool batch_backed_up;
+    int lock_fd;
+    bool read_only;
+    uint32_t pending_changes;
+    uint64_t pending_since_ms;
+    bool group_running;
+    bool group_stop;
+    pthread_t group_thread;
+    pthread_cond_t group_cond;
+    VaultEntry* slab;
+    size_t slab_count;
+    _Atomic(vault_snapshot_t*) current;
+    vault_snapshot_t* draft;
+    vault_snapshot_t* retired_head;
+    vault_snapshot_t* retired_tail;
+    size_t retired_count;
+    atomic_uint_fast64_t epoch;
+    ReaderSlot readers[VAULT_READER_SLOTS];
+    atomic_ulong batch_owner;
+    pthread_mutex_t write_lock;
+    pthread_mutex_t save_lock;
+    uint64_t save_capture;
+    vault_open_timings_t open_timings;
+    bool sharded;
+    uint32_t shard_count;
+    VaultShard* shards;
+    bool* dirty_shards;
+    bool* saver_dirty;
+    bool saver_running;
+    bool saver_stop;
+    int saver_delay_ms;
+    int flush_requests;
+    int saver_error;
+    uint64_t change_seq;
+    uint64_t saved_seq;
+    uint64_t attempted_seq;
+    pthread_t saver_thread;
+    pthread_mutex_t saver_lock;
+    pthread_cond_t saver_cond;
+    pthread_cond_t flush_cond;
+    vault_save_error_fn on_save_error;
+    void* on_save_error_context;
+    atomic_uint_fast64_t generation;
+    bool watch_running;
+    int watch_fd;
+    int watch_pipe[2];
+    pthread_t watch_thread;
+    vault_reload_fn on_reload;
+    void* on_reload_context;
+};
+
+static vault_handle_t* g_vault = NULL;
+
+static atomic_ulong g_next_thread_id = 1;
+static _Thread_local unsigned long tl_thread_id = 0;
+
+static int g_lock_timeout_ms = VAULT_LOCK_TIMEOUT_MS;
+static vault_durability_t g_durability = VAULT_DURABILITY_FSYNC;
+static void (*g_save_hook)(vault_save_stage_t stage) = NULL;
+static vault_codec_t g_compression = VAULT_CODEC_NONE;
+static bool g_compression_set = false;
+
+static const struct {
+    vault_durability_t mode;
+    const char* name;
+} durability_names[] = {
+    {VAULT_DURABILITY_NONE, "none"},
+    {VAULT_DURABILITY_FSYNC, "fsync"},
+    {VAULT_DURABILITY_GROUP, "group"}
+};
+
+typedef struct {
+    char service[VAULT_SERVICE_LEN];
+    char username[VAULT_USERNAME_LEN];
+    char password[VAULT_PASSWORD_LEN];
+    char totp_secret[64];
+} VaultEntryV1;
+
+typedef struct {
+    char service[VAULT_SERVICE_LEN];
+    char username[VAULT_USERNAME_LEN];
+    char password[VAULT_PASSWORD_LEN];
+    char totp_secret[VAULT_TOTP_LEN];
+    uint64_t totp_counter;
+    uint32_t totp_period;
+    uint8_t totp_type;
+    uint8_t totp_algorithm;
+    uint8_t totp_digits;
+    uint8_t reserved;
+} VaultEntryV2;
+
+static size_t entry_size_for_version(uint32_t version) {
+    switch (version) {
+        case 1: return sizeof(VaultEntryV1);
+        case 2: return sizeof(VaultEntryV2);
+        default: return sizeof(VaultEntry);
+    }
+}
+
+static void normalize_otp_fields(VaultEntry* entry) {
+    if (entry->totp_secret[0] == '\0') {
+        entry->totp_counter = 0;
+        entry->totp_period = 0;
+        entry->totp_type = OTP_TYPE_TOTP;
+        entry->totp_algorithm = TOTP_ALG_SHA1;
+        entry->totp_digits = 0;
+        return;
+    }
+
+    if (entry->totp_period == 0) {
+        entry->totp_period = TOTP_DEFAULT_PERIOD;
+    }
+    if (entry->totp_digits == 0) {
+        entry->totp_digits = TOTP_DEFAULT_DIGITS;
+    }
+}
+
+static void upgrade_entry(const unsigned char* raw, uint32_t version, VaultEntry* entry) {
+    memset(entry, 0, sizeof(*entry));
+
+    if (version == 1) {
+        const VaultEntryV1* old = (const VaultEntryV1*)raw;
+        memcpy(entry->service, old->service, sizeof(old->service));
+        memcpy(entry->username, old->username, sizeof(old->username));
+        memcpy(entry->password, old->password, sizeof(old->password));
+        memcpy(entry->totp_secret, old->totp_secret, sizeof(old->totp_secret));
+        normalize_otp_fields(entry);
+        return;
+    }
+
+    if (version == 2) {
+        memcpy(entry, raw, sizeof(VaultEntryV2));
+        return;
+    }
+
+    memcpy(entry, raw, sizeof(*entry));
+}
+
 static void expand_path(const char* path, char* expanded, size_t size) {
     if (path[0] == '~') {
         const char* home = getenv("HOME");
@@ -56,21 +290,84 @@ bool vault_exists(const char* vault_path) {
     return access(expanded_path, F_OK) == 0;
 }
 
-size_t vault_entry_count(void) {
-    if (!g_vault.is_open) {
-        return 0;
+
+static uint32_t index_hash(const char* service, const char* username) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)service; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
     }
-    return g_vault.header.entry_count;
+    hash = (hash ^ 0xFFu) * 16777619u;
+    for (const unsigned char* p = (const unsigned char*)username; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
 }
 
-int vault_find_entry(const char* service, const char* username) {
-    if (!g_vault.is_open || !g_vault.entries) {
+static void index_insert(vault_snapshot_t* snap, uint32_t entry_index) {
+    const VaultEntry* entry = snap->entries[entry_index];
+    uint32_t slot = index_hash(entry->service, entry->username) & snap->index_mask;
+
+    while (snap->index[slot] != 0) {
+        slot = (slot + 1) & snap->index_mask;
+    }
+    snap->index[slot] = entry_index + 1;
+}
+
+static void index_free(vault_snapshot_t* snap) {
+    free(snap->index);
+    snap->index = NULL;
+    snap->index_mask = 0;
+}
+
+static void index_rebuild(vault_snapshot_t* snap) {
+    TIMING_START(started);
+    uint32_t slots = VAULT_INDEX_MIN_SLOTS;
+    while (slots < snap->count * 2u) {
+        slots <<= 1;
+    }
+
+    if (slots - 1 != snap->index_mask || !snap->index) {
+        index_free(snap);
+        snap->index = (uint32_t*)calloc(slots, sizeof(uint32_t));
+        if (!snap->index) {
+            TIMING_STOP(started, TIMING_INDEX_BUILD);
+            return;
+        }
+        snap->index_mask = slots - 1;
+    } else {
+        memset(snap->index, 0, slots * sizeof(uint32_t));
+    }
+
+    for (uint32_t i = 0; i < snap->count; i++) {
+        index_insert(snap, i);
+    }
+    TIMING_STOP(started, TIMING_INDEX_BUILD);
+}
+
+static void index_add(vault_snapshot_t* snap, uint32_t entry_index) {
+    if (!snap->index || (entry_index + 1) * 2u > snap->index_mask + 1) {
+        index_rebuild(snap);
+    } else {
+        index_insert(snap, entry_index);
+    }
+}
+
+static int snapshot_find(const vault_snapshot_t* snap, const char* service, const char* username) {
+    if (snap->index) {
+        uint32_t slot = index_hash(service, username) & snap->index_mask;
+        while (snap->index[slot] != 0) {
+            const VaultEntry* entry = snap->entries[snap->index[slot] - 1];
+            if (strcmp(entry->service, service) == 0 && strcmp(entry->username, username) == 0) {
+                return (int)(snap->index[slot] - 1);
+            }
+            slot = (slot + 1) & snap->index_mask;
+        }
         return -1;
     }
 
-    for (uint32_t i = 0; i < g_vault.header.entry_count; i++) {
-        if (strcmp(g_vault.entries[i].service, service) == 0 &&
-            strcmp(g_vault.entries[i].username, username) == 0) {
+    for (uint32_t i = 0; i < snap->count; i++) {
+        if (strcmp(snap->entries[i]->service, service) == 0 &&
+            strcmp(snap->entries[i]->username, username) == 0) {
             return (int)i;
         }
     }
@@ -78,6 +375,294 @@ int vault_find_entry(const char* service, const char* username) {
     return -1;
 }
 
+static uint32_t shard_of(const vault_handle_t* v, const VaultEntry* entry) {
+    if (v->shard_count <= 1) {
+        return 0;
+    }
+    return index_hash(entry->service, entry->username) % v->shard_count;
+}
+
+static void shard_path(const vault_handle_t* v, uint32_t shard, char* path, size_t size) {
+    if (v->sharded) {
+        snprintf(path, size, "%s/%s%03u", v->vault_path, VAULT_SHARD_PREFIX, shard);
+    } else {
+        snprintf(path, size, "%s", v->vault_path);
+    }
+}
+
+static unsigned long thread_id(void) {
+    if (tl_thread_id == 0) {
+        tl_thread_id = atomic_fetch_add(&g_next_thread_id, 1);
+    }
+    return tl_thread_id;
+}
+
+static bool is_batch_owner(vault_handle_t* v) {
+    return atomic_load_explicit(&v->batch_owner, memory_order_relaxed) == thread_id();
+}
+
+static size_t reader_enter(vault_handle_t* v) {
+    uint_fast64_t epoch = atomic_load(&v->epoch);
+    size_t slot = thread_id() % VAULT_READER_SLOTS;
+
+    for (;;) {
+        uint_fast64_t idle = 0;
+        if (atomic_compare_exchange_weak(&v->readers[slot].epoch, &idle, epoch)) {
+            return slot;
+        }
+        slot = (slot + 1) % VAULT_READER_SLOTS;
+    }
+}
+
+static void reader_exit(vault_handle_t* v, size_t slot) {
+    if (slot < VAULT_READER_SLOTS) {
+        atomic_store(&v->readers[slot].epoch, 0);
+    }
+}
+
+/* The thread running a batch reads its own unpublished draft. */
+static const vault_snapshot_t* read_begin(vault_handle_t* v, size_t* slot) {
+    if (is_batch_owner(v)) {
+        *slot = VAULT_READER_SLOTS;
+        return v->draft ? v->draft : atomic_load(&v->current);
+    }
+
+    *slot = reader_enter(v);
+    return atomic_load(&v->current);
+}
+
+static void write_begin(vault_handle_t* v) {
+    if (!is_batch_owner(v)) {
+        pthread_mutex_lock(&v->write_lock);
+    }
+}
+
+static void write_end(vault_handle_t* v) {
+    if (!is_batch_owner(v)) {
+        pthread_mutex_unlock(&v->write_lock);
+    }
+}
+
+static vault_snapshot_t* latest_snapshot(vault_handle_t* v) {
+    return v->draft ? v->draft : atomic_load(&v->current);
+}
+
+static VaultEntry* entry_alloc(void) {
+    VaultEntry* entry = (VaultEntry*)malloc(sizeof(VaultEntry));
+    if (entry) {
+        metrics_gauge_add(METRIC_RESIDENT_SECRET_BYTES, (int64_t)sizeof(VaultEntry));
+    }
+    return entry;
+}
+
+static void entry_release(vault_handle_t* v, VaultEntry* entry) {
+    uintptr_t p = (uintptr_t)entry;
+    uintptr_t slab = (uintptr_t)v->slab;
+
+    secure_cleanup(entry, sizeof(*entry));
+    if (p < slab || p >= slab + v->slab_count * sizeof(VaultEntry)) {
+        free(entry);
+        metrics_gauge_add(METRIC_RESIDENT_SECRET_BYTES, -(int64_t)sizeof(VaultEntry));
+    }
+}
+
+static void slab_free(vault_handle_t* v) {
+    if (v->slab) {
+        free(v->slab);
+        metrics_gauge_add(METRIC_RESIDENT_SECRET_BYTES,
+                          -(int64_t)(v->slab_count * sizeof(VaultEntry)));
+    }
+}
+
+static void snapshot_free(vault_handle_t* v, vault_snapshot_t* snap) {
+    for (size_t i = 0; i < snap->garbage_count; i++) {
+        entry_release(v, snap->garbage[i]);
+    }
+    free(snap->garbage);
+    free(snap->entries);
+    index_free(snap);
+    free(snap);
+}
+
+static vault_snapshot_t* snapshot_clone(const vault_snapshot_t* src) {
+    vault_snapshot_t* snap = (vault_snapshot_t*)calloc(1, sizeof(vault_snapshot_t));
+    if (!snap) {
+        return NULL;
+    }
+
+    snap->count = src->count;
+    snap->capacity = src->count + 16;
+    snap->entries = (VaultEntry**)malloc(snap->capacity * sizeof(VaultEntry*));
+    if (!snap->entries) {
+        free(snap);
+        return NULL;
+    }
+    memcpy(snap->entries, src->entries, src->count * sizeof(VaultEntry*));
+
+    if (src->index) {
+        size_t slots = (size_t)src->index_mask + 1;
+        snap->index = (uint32_t*)malloc(slots * sizeof(uint32_t));
+        if (snap->index) {
+            memcpy(snap->index, src->index, slots * sizeof(uint32_t));
+            snap->index_mask = src->index_mask;
+        }
+    }
+
+    return snap;
+}
+
+static vault_snapshot_t* writable_snapshot(vault_handle_t* v) {
+    if (!v->draft) {
+        v->draft = snapshot_clone(atomic_load(&v->current));
+        if (!v->draft) {
+            fprintf(stderr, "Memory allocation failed\n");
+        }
+    }
+    return v->draft;
+}
+
+/*
+ * An entry the draft no longer references is freed right away if it was
+ * created in the draft. If the published snapshot still shares it, it is
+ * parked until that snapshot is reclaimed.
+ */
+/* Makes room for one more garbage entry, so drop_entry() cannot fail after a swap. */
+static int reserve_garbage(vault_snapshot_t* draft) {
+    if (draft->garbage_count < draft->garbage_capacity) {
+        return 0;
+    }
+
+    size_t capacity = draft->garbage_capacity ? draft->garbage_capacity * 2 : 16;
+    VaultEntry** grown = (VaultEntry**)realloc(draft->garbage, capacity * sizeof(VaultEntry*));
+    if (!grown) {
+        return -1;
+    }
+    draft->garbage = grown;
+    draft->garbage_capacity = capacity;
+    return 0;
+}
+
+/* Call reserve_garbage() first; entries still visible to readers wait in the garbage list. */
+static void drop_entry(vault_handle_t* v, vault_snapshot_t* draft, VaultEntry* entry) {
+    const vault_snapshot_t* current = atomic_load(&v->current);
+    int index = snapshot_find(current, entry->service, entry->username);
+    if (index < 0 || current->entries[index] != entry) {
+        entry_release(v, entry);
+        return;
+    }
+
+    draft->garbage[draft->garbage_count++] = entry;
+}
+
+static void discard_draft(vault_handle_t* v) {
+    vault_snapshot_t* draft = v->draft;
+    if (!draft) {
+        return;
+    }
+
+    const vault_snapshot_t* current = atomic_load(&v->current);
+    for (uint32_t i = 0; i < draft->count; i++) {
+        VaultEntry* entry = draft->entries[i];
+        int index = snapshot_find(current, entry->service, entry->username);
+        if (index < 0 || current->entries[index] != entry) {
+            entry_release(v, entry);
+        }
+    }
+
+    draft->garbage_count = 0;
+    snapshot_free(v, draft);
+    v->draft = NULL;
+}
+
+static void reclaim_snapshots(vault_handle_t* v) {
+    uint_fast64_t oldest = UINT_FAST64_MAX;
+    for (size_t i = 0; i < VAULT_READER_SLOTS; i++) {
+        uint_fast64_t epoch = atomic_load(&v->readers[i].epoch);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    while (v->retired_head && v->retired_head->retired_epoch < oldest &&
+           atomic_load(&v->retired_head->refs) == 0) {
+        vault_snapshot_t* snap = v->retired_head;
+        v->retired_head = snap->next;
+        if (!v->retired_head) {
+            v->retired_tail = NULL;
+        }
+        v->retired_count--;
+        snapshot_free(v, snap);
+    }
+}
+
+static void publish_draft(vault_handle_t* v) {
+    vault_snapshot_t* next = v->draft;
+    if (!next) {
+        return;
+    }
+    v->draft = NULL;
+
+    vault_snapshot_t* old = atomic_exchange(&v->current, next);
+    old->garbage = next->garbage;
+    old->garbage_count = next->garbage_count;
+    old->garbage_capacity = next->garbage_capacity;
+    next->garbage = NULL;
+    next->garbage_count = 0;
+    next->garbage_capacity = 0;
+
+    old->retired_epoch = atomic_fetch_add(&v->epoch, 1);
+    old->next = NULL;
+    if (v->retired_tail) {
+        v->retired_tail->next = old;
+    } else {
+        v->retired_head = old;
+    }
+    v->retired_tail = old;
+    v->retired_count++;
+
+    reclaim_snapshots(v);
+}
+
+static bool contains_ignore_case(const char* haystack, const char* needle) {
+    size_t needle_len = strlen(needle);
+    if (needle_len == 0) {
+        return true;
+    }
+
+    for (const char* p = haystack; *p; p++) {
+        if (strncasecmp(p, needle, needle_len) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t vault_handle_search(vault_handle_t* v, const char* query, size_t* matches,
+                          size_t max_matches) {
+    if (!v || !query) {
+        return 0;
+    }
+
+    size_t slot;
+    const vault_snapshot_t* snap = read_begin(v, &slot);
+
+    size_t found = 0;
+    TIMING_COUNT(TIMING_ENTRIES_SCANNED, snap->count);
+    for (uint32_t i = 0; i < snap->count; i++) {
+        if (contains_ignore_case(snap->entries[i]->service, query) ||
+            contains_ignore_case(snap->entries[i]->username, query)) {
+            if (matches && found < max_matches) {
+                matches[found] = i;
+            }
+            found++;
+        }
+    }
+
+    reader_exit(v, slot);
+    return found;
+}
+
 static int copy_file(const char* src_path, const char* dst_path) {
     FILE* src = fopen(src_path, "rb");
     if (!src) {
@@ -107,396 +692,2134 @@ static int copy_file(const char* src_path, const char* dst_path) {
     return 0;
 }
 
-static int save_vault(void) {
-    FILE* fp = fopen(g_vault.vault_path, "rb+");
-    if (!fp) {
-        fprintf(stderr, "Failed to open vault for writing\n");
+int vault_set_durability(vault_durability_t mode) {
+    if (mode != VAULT_DURABILITY_NONE && mode != VAULT_DURABILITY_FSYNC &&
+        mode != VAULT_DURABILITY_GROUP) {
         return -1;
     }
+    g_durability = mode;
+    return 0;
+}
 
-    // Write header
-    rewind(fp);
-    if (fwrite(&g_vault.header, sizeof(VaultHeader), 1, fp) != 1) {
-        fprintf(stderr, "Failed to write vault header\n");
-        fclose(fp);
-        return -1;
-    }
+int vault_parse_durability(const char* name, vault_durability_t* mode) {
+    if (!name || !mode) return -1;
 
-    if (g_vault.header.entry_count == 0) {
-        ftruncate(fileno(fp), sizeof(VaultHeader));
-        fclose(fp);
-        return 0;
+    for (size_t i = 0; i < sizeof(durability_names) / sizeof(durability_names[0]); i++) {
+        if (strcmp(durability_names[i].name, name) == 0) {
+            *mode = durability_names[i].mode;
+            return 0;
+        }
     }
+    return -1;
+}
 
-    size_t plaintext_size = g_vault.header.entry_count * sizeof(VaultEntry);
-    unsigned char* ciphertext = (unsigned char*)malloc(plaintext_size + IV_SIZE + 64);
-    if (!ciphertext) {
-        fprintf(stderr, "Memory allocation failed\n");
-        fclose(fp);
+/*
+ * Once set, the codec applies to every vault opened afterwards, from its next
+ * save on. Until then a vault keeps the codec it was written with.
+ */
+int vault_set_compression(vault_codec_t codec) {
+    if (!vault_codec_available(codec)) {
         return -1;
     }
+    g_compression = codec;
+    g_compression_set = true;
+    return 0;
+}
 
-    int cipher_len = encrypt_data((unsigned char*)g_vault.entries, plaintext_size,
-                                  g_vault.key, ciphertext);
-    if (cipher_len <= 0) {
-        fprintf(stderr, "Encryption failed\n");
-        free(ciphertext);
-        fclose(fp);
-        return -1;
-    }
+void vault_set_save_hook(void (*hook)(vault_save_stage_t stage)) {
+    g_save_hook = hook;
+}
 
-    fseek(fp, sizeof(VaultHeader), SEEK_SET);
-    if (fwrite(ciphertext, 1, cipher_len, fp) != (size_t)cipher_len) {
-        fprintf(stderr, "Failed to write encrypted data\n");
-        free(ciphertext);
-        fclose(fp);
-        return -1;
+static void save_stage(vault_save_stage_t stage) {
+    if (g_save_hook) {
+        g_save_hook(stage);
     }
+}
 
-    ftruncate(fileno(fp), sizeof(VaultHeader) + cipher_len);
-    free(ciphertext);
-    fclose(fp);
-
-    return 0;
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
 }
 
+static double elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
 
-static int read_vault_header(FILE* fp, VaultHeader* header) {
-    rewind(fp);
+static int sync_parent_directory(const char* path) {
+    char dir[VAULT_PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
 
-    if (fread(header, sizeof(VaultHeader), 1, fp) != 1) {
-        fprintf(stderr, "Failed to read vault header\n");
-        return -1;
+    char* slash = strrchr(dir, '/');
+    if (!slash) {
+        strcpy(dir, ".");
+    } else if (slash == dir) {
+        dir[1] = '\0';
+    } else {
+        *slash = '\0';
     }
 
-    if (memcmp(header->magic, VAULT_MAGIC, 4) != 0) {
-        fprintf(stderr, "Invalid vault file format\n");
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
         return -1;
     }
+    int ret = fsync(fd);
+    close(fd);
+    return ret;
+}
 
-    if (header->version != VAULT_VERSION) {
-        fprintf(stderr, "Unsupported vault version: %u\n", header->version);
+static int write_header(const VaultHeader* header, uint32_t payload_size, FILE* fp) {
+    VaultHeader stored = *header;
+    stored.payload_size = payload_size;
+    TIMING_START(writing);
+    size_t written = fwrite(&stored, sizeof(VaultHeader), 1, fp);
+    TIMING_STOP(writing, TIMING_FILE_WRITE);
+    if (written != 1) {
+        fprintf(stderr, "Failed to write vault header\n");
         return -1;
     }
-
+    TIMING_COUNT(TIMING_BYTES_WRITTEN, sizeof(VaultHeader));
+    save_stage(VAULT_SAVE_HEADER_WRITTEN);
     return 0;
 }
 
-static int read_vault_entries(FILE* fp) {
-    if (g_vault.header.entry_count == 0) {
-        g_vault.entries = NULL;
-        return 0;
+/*
+ * The entry array is compressed with the header's codec before it is
+ * encrypted. The header records the compressed size, so readers can size
+ * their buffers without trusting the file length.
+ */
+static int write_vault_body(const VaultHeader* header, VaultEntry* const* entries, uint32_t count,
+                            const unsigned char* key, FILE* fp) {
+    if (count == 0) {
+        return write_header(header, 0, fp);
+    }
+
+    size_t plaintext_size = count * sizeof(VaultEntry);
+    size_t payload_size = vault_codec_bound((vault_codec_t)header->codec, plaintext_size);
+    VaultEntry* plaintext = (VaultEntry*)malloc(plaintext_size);
+    unsigned char* payload = (unsigned char*)malloc(payload_size);
+    unsigned char* ciphertext = (unsigned char*)malloc(payload_size + IV_SIZE + 64);
+    if (!plaintext || !payload || !ciphertext) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(plaintext);
+        free(payload);
+        free(ciphertext);
+        return -1;
     }
 
-    size_t plaintext_size = g_vault.header.entry_count * sizeof(VaultEntry);
-    size_t ciphertext_max_size = plaintext_size + IV_SIZE + 64;
-
-    unsigned char* ciphertext = (unsigned char*)malloc(ciphertext_max_size);
-    if (!ciphertext) {
-        fprintf(stderr, "Memory allocation failed\n");
+    for (uint32_t i = 0; i < count; i++) {
+        plaintext[i] = *entries[i];
+    }
+    TIMING_START(compressing);
+    int ret = vault_codec_compress((vault_codec_t)header->codec, plaintext, plaintext_size,
+                                   payload, &payload_size);
+    TIMING_STOP(compressing, TIMING_COMPRESS);
+    secure_cleanup(plaintext, plaintext_size);
+    free(plaintext);
+    if (ret != 0 || payload_size > UINT32_MAX) {
+        fprintf(stderr, "Failed to compress vault data\n");
+        secure_cleanup(payload, payload_size);
+        free(payload);
+        free(ciphertext);
         return -1;
     }
 
-    fseek(fp, sizeof(VaultHeader), SEEK_SET);
-    size_t ciphertext_size = fread(ciphertext, 1, ciphertext_max_size, fp);
-    if (ciphertext_size == 0) {
-        fprintf(stderr, "Failed to read encrypted data\n");
+    if (write_header(header, (uint32_t)payload_size, fp) != 0) {
+        secure_cleanup(payload, payload_size);
+        free(payload);
         free(ciphertext);
         return -1;
     }
 
-    unsigned char* plaintext = (unsigned char*)malloc(plaintext_size);
-    if (!plaintext) {
-        fprintf(stderr, "Memory allocation failed\n");
+    int cipher_len = encrypt_data(payload, payload_size, key, ciphertext);
+    secure_cleanup(payload, payload_size);
+    free(payload);
+    if (cipher_len <= 0) {
+        fprintf(stderr, "Encryption failed\n");
         free(ciphertext);
         return -1;
     }
 
-    int decrypted_len = decrypt_data(ciphertext, ciphertext_size,
-                                     g_vault.key, plaintext);
+    TIMING_START(writing);
+    size_t written = fwrite(ciphertext, 1, cipher_len, fp);
+    TIMING_STOP(writing, TIMING_FILE_WRITE);
     free(ciphertext);
-
-    if (decrypted_len < 0 || (size_t)decrypted_len != plaintext_size) {
-        fprintf(stderr, "Decryption failed or wrong password\n");
-        free(plaintext);
+    if (written != (size_t)cipher_len) {
+        fprintf(stderr, "Failed to write encrypted data\n");
         return -1;
     }
 
-    g_vault.entries = (VaultEntry*)plaintext;
+    TIMING_COUNT(TIMING_BYTES_WRITTEN, written);
     return 0;
 }
 
-int vault_init(const char* master_password, const char* vault_path) {
-    if (!master_password) {
-        fprintf(stderr, "Master password is required\n");
+static int write_vault_file(const char* path, const VaultHeader* header, VaultEntry* const* entries,
+                            uint32_t count, const unsigned char* key) {
+    bool durable = g_durability != VAULT_DURABILITY_NONE;
+    char temp_path[VAULT_SHARD_PATH_MAX + 16];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp.XXXXXX", path);
+
+    int fd = mkstemp(temp_path);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open vault for writing: %s\n", strerror(errno));
         return -1;
     }
+    fchmod(fd, 0600);
 
-    if (g_vault.is_open) {
-        vault_cleanup();
+    FILE* fp = fdopen(fd, "wb");
+    if (!fp) {
+        close(fd);
+        unlink(temp_path);
+        fprintf(stderr, "Failed to open vault for writing\n");
+        return -1;
     }
+    save_stage(VAULT_SAVE_TEMP_CREATED);
 
-    if (crypto_init() != 0) {
-        fprintf(stderr, "Failed to initialize crypto engine\n");
-        return -1;
+    int ret = write_vault_body(header, entries, count, key, fp);
+    if (ret == 0) {
+        save_stage(VAULT_SAVE_BODY_WRITTEN);
+        TIMING_START(syncing);
+        if (fflush(fp) != 0 || (durable && fsync(fd) != 0)) {
+            fprintf(stderr, "Failed to flush vault: %s\n", strerror(errno));
+            ret = -1;
+        }
+        TIMING_STOP(syncing, TIMING_FSYNC);
+    }
+    if (fclose(fp) != 0 && ret == 0) {
+        ret = -1;
+    }
+
+    if (ret == 0) {
+        save_stage(VAULT_SAVE_SYNCED);
+        TIMING_START(renaming);
+        if (rename(temp_path, path) != 0) {
+            fprintf(stderr, "Failed to replace vault: %s\n", strerror(errno));
+            ret = -1;
+        }
+        TIMING_STOP(renaming, TIMING_RENAME);
     }
 
-    if (vault_ensure_directory() != 0) {
+    if (ret != 0) {
+        int err = errno;
+        unlink(temp_path);
+        errno = err;
         return -1;
     }
+    save_stage(VAULT_SAVE_RENAMED);
 
-    const char* path = vault_path ? vault_path : vault_get_default_path();
-    expand_path(path, g_vault.vault_path, sizeof(g_vault.vault_path));
+    TIMING_START(syncing);
+    if (durable && sync_parent_directory(path) != 0) {
+        fprintf(stderr, "Warning: Failed to sync vault directory\n");
+    }
+    TIMING_STOP(syncing, TIMING_FSYNC);
 
-    FILE* fp;
-    bool is_new_vault = !vault_exists(g_vault.vault_path);
+    return 0;
+}
 
-    if (is_new_vault) {
-        fp = fopen(g_vault.vault_path, "wb+");
-        if (!fp) {
-            fprintf(stderr, "Failed to create vault file: %s\n", strerror(errno));
-            return -1;
+static int group_by_shard(const vault_handle_t* v, const vault_snapshot_t* snap,
+                          VaultEntry*** grouped, uint32_t** offsets) {
+    *grouped = (VaultEntry**)malloc((snap->count ? snap->count : 1) * sizeof(VaultEntry*));
+    *offsets = (uint32_t*)calloc(v->shard_count + 1, sizeof(uint32_t));
+    uint32_t* cursor = (uint32_t*)malloc(v->shard_count * sizeof(uint32_t));
+    if (!*grouped || !*offsets || !cursor) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(*grouped);
+        free(*offsets);
+        free(cursor);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < snap->count; i++) {
+        (*offsets)[shard_of(v, snap->entries[i]) + 1]++;
+    }
+    for (uint32_t s = 0; s < v->shard_count; s++) {
+        (*offsets)[s + 1] += (*offsets)[s];
+        cursor[s] = (*offsets)[s];
+    }
+    for (uint32_t i = 0; i < snap->count; i++) {
+        (*grouped)[cursor[shard_of(v, snap->entries[i])]++] = snap->entries[i];
+    }
+
+    free(cursor);
+    return 0;
+}
+
+/*
+ * Every save captures its state under the write lock and gets an increasing
+ * capture number. Only the shards changed since the previous capture are
+ * written. Files are written under save_lock, and each shard skips a capture
+ * older than the one already on disk, so a slow background save can never
+ * overwrite a newer synchronous one.
+ */
+static int write_captured(vault_handle_t* v, uint64_t capture, const VaultHeader* header,
+                          const vault_snapshot_t* snap, const unsigned char* key,
+                          const bool* dirty) {
+    METRIC_START(save_started);
+    VaultEntry** grouped = NULL;
+    uint32_t* offsets = NULL;
+    if (v->shard_count > 1 && group_by_shard(v, snap, &grouped, &offsets) != 0) {
+        METRIC_COUNT(METRIC_SAVE_ERRORS, 1);
+        return -1;
+    }
+
+    pthread_mutex_lock(&v->save_lock);
+    int ret = 0;
+    for (uint32_t s = 0; s < v->shard_count && ret == 0; s++) {
+        if (!dirty[s] || capture <= v->shards[s].written_capture) {
+            continue;
+        }
+
+        VaultHeader shard_header = *header;
+        VaultEntry* const* entries = grouped ? grouped + offsets[s] : snap->entries;
+        shard_header.entry_count = grouped ? offsets[s + 1] - offsets[s] : snap->count;
+
+        char path[VAULT_SHARD_PATH_MAX];
+        shard_path(v, s, path, sizeof(path));
+        ret = write_vault_file(path, &shard_header, entries, shard_header.entry_count, key);
+        if (ret == 0) {
+            v->shards[s].written_capture = capture;
         }
+    }
+    pthread_mutex_unlock(&v->save_lock);
+
+    if (ret == 0) {
+        METRIC_OBSERVE(save_started, METRIC_SAVE);
+    } else {
+        METRIC_COUNT(METRIC_SAVE_ERRORS, 1);
+    }
+
+    int err = errno;
+    free(grouped);
+    free(offsets);
+    errno = err;
+    return ret;
+}
+
+static int save_vault(vault_handle_t* v) {
+    int ret = write_captured(v, ++v->save_capture, &v->header, latest_snapshot(v), v->key,
+                             v->dirty_shards);
+    if (ret == 0) {
+        memset(v->dirty_shards, 0, v->shard_count * sizeof(bool));
+        v->pending_changes = 0;
+    }
+    return ret;
+}
+
+/* Called with the write lock held, after a change has been published. */
+static int request_save(vault_handle_t* v) {
+    if (!v->saver_running) {
+        return save_vault(v);
+    }
+
+    pthread_mutex_lock(&v->saver_lock);
+    v->change_seq++;
+    pthread_cond_signal(&v->saver_cond);
+    pthread_mutex_unlock(&v->saver_lock);
+    return 0;
+}
+
+static int sync_pending(vault_handle_t* v) {
+    if (v->pending_changes == 0) {
+        return 0;
+    }
+    return save_vault(v);
+}
+
+int vault_handle_sync(vault_handle_t* v) {
+    if (!v) {
+        return 0;
+    }
+    if (v->saver_running && !is_batch_owner(v)) {
+        return vault_handle_flush(v);
+    }
+
+    write_begin(v);
+    int ret = sync_pending(v);
+    write_end(v);
+    return ret;
+}
+
+static size_t header_size_for_version(uint32_t version) {
+    return version < 4 ? VAULT_HEADER_V3_SIZE : sizeof(VaultHeader);
+}
+
+static int read_vault_header(FILE* fp, VaultHeader* header) {
+    rewind(fp);
+    memset(header, 0, sizeof(*header));
+
+    if (fread(header, VAULT_HEADER_V3_SIZE, 1, fp) != 1) {
+        fprintf(stderr, "Failed to read vault header\n");
+        return -1;
+    }
 
-        chmod(g_vault.vault_path, 0600);
+    if (memcmp(header->magic, VAULT_MAGIC, 4) != 0) {
+        fprintf(stderr, "Invalid vault file format\n");
+        return -1;
+    }
 
-        memcpy(g_vault.header.magic, VAULT_MAGIC, 4);
-        g_vault.header.version = VAULT_VERSION;
-        g_vault.header.entry_count = 0;
+    if (header->version < VAULT_MIN_VERSION || header->version > VAULT_VERSION) {
+        fprintf(stderr, "Unsupported vault version: %u\n", header->version);
+        return -1;
+    }
 
-        if (RAND_bytes(g_vault.header.salt, SALT_SIZE) != 1) {
-            fprintf(stderr, "Failed to generate salt\n");
-            fclose(fp);
+    if (header->version >= 4) {
+        size_t rest = sizeof(VaultHeader) - VAULT_HEADER_V3_SIZE;
+        if (fread((unsigned char*)header + VAULT_HEADER_V3_SIZE, rest, 1, fp) != 1) {
+            fprintf(stderr, "Failed to read vault header\n");
+            return -1;
+        }
+        if (!vault_codec_available((vault_codec_t)header->codec)) {
+            fprintf(stderr, "Vault is compressed with an unsupported codec (%s)\n",
+                    vault_codec_name((vault_codec_t)header->codec));
             return -1;
         }
+    }
 
-        rewind(fp);
-        if (fwrite(&g_vault.header, sizeof(VaultHeader), 1, fp) != 1) {
-            fprintf(stderr, "Failed to write vault header\n");
-            fclose(fp);
+    return 0;
+}
+
+static int read_vault_ciphertext(const VaultHeader* header, FILE* fp, unsigned char** ciphertext,
+                                 size_t* ciphertext_size) {
+    size_t stored_entry_size = entry_size_for_version(header->version);
+    size_t payload_size = header->entry_count * stored_entry_size;
+    if (header->version >= 4) {
+        if (header->payload_size > vault_codec_bound((vault_codec_t)header->codec, payload_size)) {
+            fprintf(stderr, "Invalid vault payload size\n");
             return -1;
         }
+        payload_size = header->payload_size;
+    }
+    size_t ciphertext_max_size = payload_size + IV_SIZE + 64;
 
-        printf("Created new vault: %s\n", g_vault.vault_path);
+    *ciphertext = (unsigned char*)malloc(ciphertext_max_size);
+    if (!*ciphertext) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
 
-    } else {
-        fp = fopen(g_vault.vault_path, "rb+");
-        if (!fp) {
-            fprintf(stderr, "Failed to open vault file: %s\n", strerror(errno));
+    fseek(fp, header_size_for_version(header->version), SEEK_SET);
+    *ciphertext_size = fread(*ciphertext, 1, ciphertext_max_size, fp);
+    if (*ciphertext_size == 0) {
+        fprintf(stderr, "Failed to read encrypted data\n");
+        free(*ciphertext);
+        *ciphertext = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Inflates straight into the entry array that becomes the vault's slab. */
+static VaultEntry* decompress_vault_entries(const VaultHeader* header, const unsigned char* key,
+                                            const unsigned char* ciphertext,
+                                            size_t ciphertext_size) {
+    unsigned char* payload = (unsigned char*)malloc(header->payload_size + 64);
+    VaultEntry* entries = (VaultEntry*)malloc(header->entry_count * sizeof(VaultEntry));
+    if (!payload || !entries) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(payload);
+        free(entries);
+        return NULL;
+    }
+
+    int decrypted_len = decrypt_data(ciphertext, ciphertext_size, key, payload);
+    int ret = -1;
+    if (decrypted_len >= 0 && (size_t)decrypted_len == header->payload_size) {
+        TIMING_START(decompressing);
+        ret = vault_codec_decompress((vault_codec_t)header->codec, payload, header->payload_size,
+                                     entries, header->entry_count * sizeof(VaultEntry));
+        TIMING_STOP(decompressing, TIMING_DECOMPRESS);
+    }
+    secure_cleanup(payload, header->payload_size + 64);
+    free(payload);
+
+    if (ret != 0) {
+        fprintf(stderr, "Decryption failed or wrong password\n");
+        secure_cleanup(entries, header->entry_count * sizeof(VaultEntry));
+        free(entries);
+        return NULL;
+    }
+    return entries;
+}
+
+static VaultEntry* decrypt_vault_entries(const VaultHeader* header, const unsigned char* key,
+                                         const unsigned char* ciphertext, size_t ciphertext_size) {
+    if (header->version >= 4 && header->codec != VAULT_CODEC_NONE) {
+        return decompress_vault_entries(header, key, ciphertext, ciphertext_size);
+    }
+
+    size_t stored_entry_size = entry_size_for_version(header->version);
+    size_t plaintext_size = header->entry_count * stored_entry_size;
+
+    unsigned char* plaintext = (unsigned char*)malloc(plaintext_size);
+    if (!plaintext) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+
+    int decrypted_len = decrypt_data(ciphertext, ciphertext_size, key, plaintext);
+
+    if (decrypted_len < 0 || (size_t)decrypted_len != plaintext_size) {
+        fprintf(stderr, "Decryption failed or wrong password\n");
+        free(plaintext);
+        return NULL;
+    }
+
+    if (header->version >= 3) {
+        return (VaultEntry*)plaintext;
+    }
+
+    VaultEntry* entries = (VaultEntry*)malloc(header->entry_count * sizeof(VaultEntry));
+    if (!entries) {
+        fprintf(stderr, "Memory allocation failed\n");
+        secure_cleanup(plaintext, plaintext_size);
+        free(plaintext);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        upgrade_entry(plaintext + i * stored_entry_size, header->version, &entries[i]);
+    }
+
+    secure_cleanup(plaintext, plaintext_size);
+    free(plaintext);
+    return entries;
+}
+
+void vault_set_lock_timeout(int timeout_ms) {
+    g_lock_timeout_ms = timeout_ms < 0 ? 0 : timeout_ms;
+}
+
+bool vault_handle_is_read_only(const vault_handle_t* v) {
+    return v && v->read_only;
+}
+
+static void vault_unlock(vault_handle_t* v) {
+    if (v->lock_fd >= 0) {
+        close(v->lock_fd);
+        v->lock_fd = -1;
+    }
+}
+
+static int vault_lock(vault_handle_t* v, int operation) {
+    char lock_path[VAULT_PATH_MAX + sizeof(VAULT_LOCK_SUFFIX)];
+    snprintf(lock_path, sizeof(lock_path), "%s%s", v->vault_path, VAULT_LOCK_SUFFIX);
+
+    int fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0 && operation == LOCK_SH) {
+        fd = open(lock_path, O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open lock file %s: %s\n", lock_path, strerror(errno));
+        return -1;
+    }
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long delay_us = 1000;
+
+    TIMING_START(waiting);
+    while (flock(fd, operation | LOCK_NB) != 0) {
+        if (errno != EWOULDBLOCK && errno != EINTR) {
+            fprintf(stderr, "Failed to lock vault: %s\n", strerror(errno));
+            close(fd);
             return -1;
         }
 
-        if (read_vault_header(fp, &g_vault.header) != 0) {
-            fclose(fp);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long waited_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (waited_ms >= g_lock_timeout_ms) {
+            fprintf(stderr, "Vault is locked by another process (gave up after %d ms)\n",
+                    g_lock_timeout_ms);
+            close(fd);
             return -1;
         }
+
+        struct timespec pause = {0, delay_us * 1000};
+        nanosleep(&pause, NULL);
+        if (delay_us < 50000) delay_us *= 2;
     }
+    TIMING_STOP(waiting, TIMING_LOCK_WAIT);
 
-    if (derive_key_with_salt(master_password, g_vault.header.salt, SALT_SIZE, g_vault.key) != 0) {
-        fprintf(stderr, "Failed to derive encryption key\n");
-        fclose(fp);
+    v->lock_fd = fd;
+    return 0;
+}
+
+static int read_header_file(const char* path, VaultHeader* header) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open vault file: %s\n", strerror(errno));
         return -1;
     }
+    int ret = read_vault_header(fp, header);
+    fclose(fp);
+    return ret;
+}
 
-    if (!is_new_vault && g_vault.header.entry_count > 0) {
-        if (read_vault_entries(fp) != 0) {
-            fclose(fp);
-            secure_cleanup(g_vault.key, sizeof(g_vault.key));
-            return -1;
+static int read_shard(const char* path, ShardLoad* load, struct stat* st) {
+    TIMING_START(reading);
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open vault file: %s\n", strerror(errno));
+        return -1;
+    }
+
+    int ret = read_vault_header(fp, &load->header);
+    if (ret == 0 && load->header.entry_count > 0) {
+        ret = read_vault_ciphertext(&load->header, fp, &load->ciphertext, &load->ciphertext_size);
+    }
+    if (ret == 0) {
+        fstat(fileno(fp), st);
+        TIMING_COUNT(TIMING_BYTES_READ, header_size_for_version(load->header.version) +
+                                        load->ciphertext_size);
+    }
+    fclose(fp);
+    TIMING_STOP(reading, TIMING_FILE_READ);
+    return ret;
+}
+
+static void free_shard_loads(ShardLoad* loads, uint32_t count) {
+    if (!loads) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        free(loads[i].ciphertext);
+        if (loads[i].entries) {
+            secure_cleanup(loads[i].entries, loads[i].header.entry_count * sizeof(VaultEntry));
+            free(loads[i].entries);
+        }
+    }
+    free(loads);
+}
+
+static bool wait_for_shard(ShardPrefetch* prefetch, uint32_t shard) {
+    pthread_mutex_lock(&prefetch->lock);
+    while (prefetch->loaded <= shard && !prefetch->failed) {
+        pthread_cond_wait(&prefetch->cond, &prefetch->lock);
+    }
+    bool loaded = prefetch->loaded > shard;
+    pthread_mutex_unlock(&prefetch->lock);
+    return loaded;
+}
+
+static void* decrypt_shard_worker(void* arg) {
+    ShardDecryptJob* job = (ShardDecryptJob*)arg;
+
+    for (;;) {
+        uint32_t i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->count) {
+            return NULL;
+        }
+
+        if (job->prefetch && !wait_for_shard(job->prefetch, i)) {
+            atomic_store(&job->failed, true);
+            return NULL;
+        }
+
+        ShardLoad* load = &job->loads[i];
+        if (load->ciphertext) {
+            load->entries = decrypt_vault_entries(&load->header, job->key, load->ciphertext,
+                                                  load->ciphertext_size);
+            if (!load->entries) {
+                atomic_store(&job->failed, true);
+            }
+        }
+    }
+}
+
+/*
+ * All shards use the same key, so they are decrypted in parallel. With a
+ * prefetch, each shard is decrypted as soon as the reader thread has it.
+ */
+static int decrypt_shards(ShardLoad* loads, uint32_t count, const unsigned char* key,
+                          ShardPrefetch* prefetch) {
+    ShardDecryptJob job;
+    job.loads = loads;
+    job.count = count;
+    job.key = key;
+    job.prefetch = prefetch;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, false);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t workers = count < VAULT_UNLOCK_THREADS ? count : VAULT_UNLOCK_THREADS;
+    if (cpus > 0 && (uint32_t)cpus < workers) {
+        workers = (uint32_t)cpus;
+    }
+
+    pthread_t threads[VAULT_UNLOCK_THREADS];
+    uint32_t started = 0;
+    while (started + 1 < workers &&
+           pthread_create(&threads[started], NULL, decrypt_shard_worker, &job) == 0) {
+        started++;
+    }
+    decrypt_shard_worker(&job);
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    return atomic_load(&job.failed) ? -1 : 0;
+}
+
+static void* prefetch_main(void* arg) {
+    ShardPrefetch* prefetch = (ShardPrefetch*)arg;
+    vault_handle_t* v = prefetch->vault;
+    char path[VAULT_SHARD_PATH_MAX];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint32_t s = 0; v->shard_count > 1 && s < v->shard_count; s++) {
+        shard_path(v, s, path, sizeof(path));
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            close(fd);
+        }
+    }
+
+    for (uint32_t s = 0; s < v->shard_count; s++) {
+        shard_path(v, s, path, sizeof(path));
+        bool ok = read_shard(path, &prefetch->loads[s], &v->shards[s].st) == 0;
+        if (ok && memcmp(prefetch->loads[s].header.salt, v->header.salt, SALT_SIZE) != 0) {
+            fprintf(stderr, "Vault shard %u does not belong to this vault\n", s);
+            ok = false;
         }
+
+        pthread_mutex_lock(&prefetch->lock);
+        if (ok) {
+            prefetch->loaded++;
+        } else {
+            prefetch->failed = true;
+        }
+        pthread_cond_broadcast(&prefetch->cond);
+        pthread_mutex_unlock(&prefetch->lock);
+        if (!ok) {
+            break;
+        }
+    }
+
+    prefetch->read_ms = elapsed_ms(&start);
+    if (prefetch->unlock) {
+        vault_unlock(v);
+    }
+    return NULL;
+}
+
+static void start_prefetch(vault_handle_t* v, ShardPrefetch* prefetch, ShardLoad* loads,
+                           bool unlock) {
+    memset(prefetch, 0, sizeof(*prefetch));
+    prefetch->vault = v;
+    prefetch->loads = loads;
+    prefetch->unlock = unlock;
+    pthread_mutex_init(&prefetch->lock, NULL);
+    pthread_cond_init(&prefetch->cond, NULL);
+
+    prefetch->threaded = pthread_create(&prefetch->thread, NULL, prefetch_main, prefetch) == 0;
+    if (!prefetch->threaded) {
+        prefetch_main(prefetch);
+    }
+}
+
+static int finish_prefetch(ShardPrefetch* prefetch) {
+    if (prefetch->threaded) {
+        pthread_join(prefetch->thread, NULL);
     }
+    pthread_mutex_destroy(&prefetch->lock);
+    pthread_cond_destroy(&prefetch->cond);
+    return prefetch->failed ? -1 : 0;
+}
+
+static int read_manifest(const char* dir, VaultManifest* manifest) {
+    char path[VAULT_SHARD_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, VAULT_MANIFEST_NAME);
 
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open vault manifest: %s\n", strerror(errno));
+        return -1;
+    }
+    size_t read = fread(manifest, sizeof(*manifest), 1, fp);
     fclose(fp);
-    g_vault.is_open = true;
 
+    if (read != 1 || memcmp(manifest->magic, VAULT_MANIFEST_MAGIC, 4) != 0 ||
+        manifest->version != VAULT_MANIFEST_VERSION || manifest->shard_count == 0 ||
+        manifest->shard_count > VAULT_MAX_SHARDS) {
+        fprintf(stderr, "Invalid vault manifest: %s\n", path);
+        return -1;
+    }
     return 0;
 }
 
-int vault_store(const char* service, const char* username,
-                const char* password, const char* totp_secret, bool force) {
-    if (!g_vault.is_open) {
-        fprintf(stderr, "Vault is not open\n");
+/* Moves the decrypted shards into one slab, rejecting entries in the wrong shard. */
+static int assemble_slab(vault_handle_t* v, ShardLoad* loads) {
+    if (v->shard_count == 1) {
+        v->slab = loads[0].entries;
+        v->slab_count = loads[0].header.entry_count;
+        loads[0].entries = NULL;
+        if (v->slab) {
+            metrics_gauge_add(METRIC_RESIDENT_SECRET_BYTES,
+                              (int64_t)(v->slab_count * sizeof(VaultEntry)));
+        }
+        return 0;
+    }
+
+    size_t total = 0;
+    for (uint32_t s = 0; s < v->shard_count; s++) {
+        total += loads[s].header.entry_count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    v->slab = (VaultEntry*)calloc(total, sizeof(VaultEntry));
+    if (!v->slab) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+    v->slab_count = total;
+    metrics_gauge_add(METRIC_RESIDENT_SECRET_BYTES, (int64_t)(total * sizeof(VaultEntry)));
+
+    size_t n = 0;
+    for (uint32_t s = 0; s < v->shard_count; s++) {
+        for (uint32_t i = 0; i < loads[s].header.entry_count; i++) {
+            if (shard_of(v, &loads[s].entries[i]) != s) {
+                fprintf(stderr, "Vault shard %u is corrupted\n", s);
+                return -1;
+            }
+            v->slab[n++] = loads[s].entries[i];
+        }
+    }
+    return 0;
+}
+
+static int create_vault_file(vault_handle_t* v) {
+    FILE* fp = fopen(v->vault_path, "wb+");
+    if (!fp) {
+        fprintf(stderr, "Failed to create vault file: %s\n", strerror(errno));
+        return -1;
+    }
+
+    chmod(v->vault_path, 0600);
+
+    memcpy(v->header.magic, VAULT_MAGIC, 4);
+    v->header.version = VAULT_VERSION;
+    v->header.entry_count = 0;
+    v->header.codec = g_compression;
+
+    if (RAND_bytes(v->header.salt, SALT_SIZE) != 1) {
+        fprintf(stderr, "Failed to generate salt\n");
+        fclose(fp);
         return -1;
     }
 
-    if (!service || !username || !password) {
-        fprintf(stderr, "Service, username and password are required\n");
+    if (fwrite(&v->header, sizeof(VaultHeader), 1, fp) != 1 || fflush(fp) != 0) {
+        fprintf(stderr, "Failed to write vault header\n");
+        fclose(fp);
+        return -1;
+    }
+
+    fstat(fileno(fp), &v->shards[0].st);
+    fclose(fp);
+    printf("Created new vault: %s\n", v->vault_path);
+    return 0;
+}
+
+static vault_handle_t* open_failed(vault_handle_t* v, ShardLoad* loads) {
+    free_shard_loads(loads, v->shard_count);
+    if (v->slab) {
+        secure_cleanup(v->slab, v->slab_count * sizeof(VaultEntry));
+    }
+    slab_free(v);
+    free(v->shards);
+    free(v->dirty_shards);
+    secure_cleanup(v->key, sizeof(v->key));
+    vault_unlock(v);
+    free(v);
+    return NULL;
+}
+
+vault_handle_t* vault_handle_open(const char* master_password, const char* vault_path,
+                                  unsigned int flags) {
+    struct timespec opened;
+    clock_gettime(CLOCK_MONOTONIC, &opened);
+    if (!master_password) {
+        fprintf(stderr, "Master password is required\n");
+        return NULL;
+    }
+
+    if (crypto_init() != 0) {
+        fprintf(stderr, "Failed to initialize crypto engine\n");
+        return NULL;
+    }
+
+    bool read_only = (flags & VAULT_OPEN_READ_ONLY) != 0;
+    if (!read_only && vault_ensure_directory() != 0) {
+        return NULL;
+    }
+
+    vault_handle_t* v = (vault_handle_t*)calloc(1, sizeof(vault_handle_t));
+    if (!v) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return NULL;
+    }
+    v->auto_backup = true;
+    v->lock_fd = -1;
+
+    const char* path = vault_path ? vault_path : vault_get_default_path();
+    expand_path(path, v->vault_path, sizeof(v->vault_path));
+
+    bool is_new_vault = !vault_exists(v->vault_path);
+    if (is_new_vault && read_only) {
+        fprintf(stderr, "Vault does not exist: %s\n", v->vault_path);
+        return open_failed(v, NULL);
+    }
+
+    if (vault_lock(v, read_only ? LOCK_SH : LOCK_EX) != 0) {
+        return open_failed(v, NULL);
+    }
+
+    struct stat st;
+    VaultManifest manifest;
+    is_new_vault = !vault_exists(v->vault_path);
+    v->sharded = !is_new_vault && stat(v->vault_path, &st) == 0 && S_ISDIR(st.st_mode);
+    if (v->sharded && read_manifest(v->vault_path, &manifest) != 0) {
+        return open_failed(v, NULL);
+    }
+
+    v->shard_count = v->sharded ? manifest.shard_count : 1;
+    v->shards = (VaultShard*)calloc(v->shard_count, sizeof(VaultShard));
+    v->dirty_shards = (bool*)calloc(v->shard_count, sizeof(bool));
+    ShardLoad* loads = (ShardLoad*)calloc(v->shard_count, sizeof(ShardLoad));
+    if (!v->shards || !v->dirty_shards || !loads) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return open_failed(v, loads);
+    }
+
+    /*
+     * Only the salt is needed to start the key derivation. The shards are
+     * read on a separate thread meanwhile, and decrypted as soon as both the
+     * key and the shard are ready.
+     */
+    ShardPrefetch prefetch;
+    if (is_new_vault) {
+        if (create_vault_file(v) != 0) {
+            return open_failed(v, loads);
+        }
+    } else {
+        if (v->sharded) {
+            memcpy(v->header.salt, manifest.salt, SALT_SIZE);
+        } else if (read_header_file(v->vault_path, &v->header) != 0) {
+            return open_failed(v, loads);
+        }
+        start_prefetch(v, &prefetch, loads, read_only);
+    }
+
+    struct timespec phase;
+    clock_gettime(CLOCK_MONOTONIC, &phase);
+    int ret = derive_key_with_salt(master_password, v->header.salt, SALT_SIZE, v->key);
+    v->open_timings.kdf_ms = elapsed_ms(&phase);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to derive encryption key\n");
+    }
+
+    if (!is_new_vault) {
+        clock_gettime(CLOCK_MONOTONIC, &phase);
+        if (ret == 0) {
+            ret = decrypt_shards(loads, v->shard_count, v->key, &prefetch);
+        }
+        v->open_timings.decrypt_ms = elapsed_ms(&phase);
+        if (finish_prefetch(&prefetch) != 0) {
+            ret = -1;
+        }
+        v->open_timings.read_ms = prefetch.read_ms;
+        if (ret == 0) {
+            v->header = loads[0].header;
+            ret = assemble_slab(v, loads);
+            TIMING_COUNT(TIMING_ENTRIES_LOADED, v->slab_count);
+        }
+    }
+    if (ret != 0) {
+        return open_failed(v, loads);
+    }
+    free_shard_loads(loads, v->shard_count);
+
+    v->header.version = VAULT_VERSION;
+    if (g_compression_set) {
+        v->header.codec = g_compression;
+    }
+    v->read_only = read_only;
+
+    vault_snapshot_t* snap = (vault_snapshot_t*)calloc(1, sizeof(vault_snapshot_t));
+    if (snap) {
+        snap->count = (uint32_t)v->slab_count;
+        snap->capacity = snap->count + 16;
+        snap->entries = (VaultEntry**)malloc(snap->capacity * sizeof(VaultEntry*));
+    }
+    if (!snap || !snap->entries) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(snap);
+        return open_failed(v, NULL);
+    }
+    for (uint32_t i = 0; i < snap->count; i++) {
+        snap->entries[i] = &v->slab[i];
+    }
+    index_rebuild(snap);
+
+    atomic_init(&v->current, snap);
+    atomic_init(&v->epoch, 1);
+    atomic_init(&v->batch_owner, 0);
+    atomic_init(&v->generation, 0);
+    v->watch_fd = v->watch_pipe[0] = v->watch_pipe[1] = -1;
+    for (size_t i = 0; i < VAULT_READER_SLOTS; i++) {
+        atomic_init(&v->readers[i].epoch, 0);
+    }
+    pthread_mutex_init(&v->write_lock, NULL);
+    pthread_mutex_init(&v->save_lock, NULL);
+    pthread_mutex_init(&v->saver_lock, NULL);
+    pthread_cond_init(&v->saver_cond, NULL);
+    pthread_cond_init(&v->flush_cond, NULL);
+    pthread_condattr_t group_attr;
+    pthread_condattr_init(&group_attr);
+    pthread_condattr_setclock(&group_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&v->group_cond, &group_attr);
+    pthread_condattr_destroy(&group_attr);
+
+    v->open_timings.total_ms = elapsed_ms(&opened);
+    return v;
+}
+
+static bool has_unsaved_changes(vault_handle_t* v) {
+    if (v->pending_changes > 0) {
+        return true;
+    }
+    if (!v->saver_running) {
+        return false;
+    }
+
+    pthread_mutex_lock(&v->saver_lock);
+    bool unsaved = v->change_seq != v->saved_seq;
+    pthread_mutex_unlock(&v->saver_lock);
+    return unsaved;
+}
+
+static void backup_before_change(vault_handle_t* v) {
+    if (!v->auto_backup || v->sharded || has_unsaved_changes(v)) {
+        return;
+    }
+
+    if (v->batch_depth > 0) {
+        if (v->batch_backed_up) {
+            return;
+        }
+        v->batch_backed_up = true;
+    }
+
+    TIMING_START(copying);
+    vault_backup(v->vault_path);
+    TIMING_STOP(copying, TIMING_BACKUP);
+}
+
+/*
+ * Group commit deadline: writes held-back changes once the window since the
+ * first one has passed, so a lone change does not wait for the next one.
+ * Runs with the write lock held except while it waits.
+ */
+static void* group_commit_main(void* arg) {
+    vault_handle_t* v = (vault_handle_t*)arg;
+
+    pthread_mutex_lock(&v->write_lock);
+    while (!v->group_stop) {
+        if (v->pending_changes == 0) {
+            pthread_cond_wait(&v->group_cond, &v->write_lock);
+            continue;
+        }
+
+        uint64_t due = v->pending_since_ms + VAULT_GROUP_COMMIT_WINDOW_MS;
+        if (monotonic_ms() < due) {
+            struct timespec deadline = {(time_t)(due / 1000), (long)(due % 1000) * 1000000};
+            pthread_cond_timedwait(&v->group_cond, &v->write_lock, &deadline);
+            continue;
+        }
+        if (save_vault(v) != 0) {
+            /* Try again one window later rather than spinning on the failure. */
+            v->pending_since_ms = monotonic_ms();
+        }
+    }
+    pthread_mutex_unlock(&v->write_lock);
+    return NULL;
+}
+
+/* Called with the write lock held when a change is held back. */
+static void arm_group_commit(vault_handle_t* v) {
+    if (v->group_running) {
+        pthread_cond_signal(&v->group_cond);
+        return;
+    }
+    v->group_stop = false;
+    if (pthread_create(&v->group_thread, NULL, group_commit_main, v) == 0) {
+        v->group_running = true;
+    }
+}
+
+static void stop_group_commit(vault_handle_t* v) {
+    if (!v->group_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&v->write_lock);
+    v->group_stop = true;
+    pthread_cond_signal(&v->group_cond);
+    pthread_mutex_unlock(&v->write_lock);
+
+    pthread_join(v->group_thread, NULL);
+    v->group_running = false;
+}
+
+static int persist_change(vault_handle_t* v) {
+    if (v->batch_depth > 0) {
+        v->batch_dirty = true;
+        return 0;
+    }
+
+    publish_draft(v);
+
+    if (v->saver_running) {
+        return request_save(v);
+    }
+
+    if (g_durability == VAULT_DURABILITY_GROUP) {
+        uint64_t now = monotonic_ms();
+        if (v->pending_changes++ == 0) {
+            v->pending_since_ms = now;
+        }
+        if (v->pending_changes < VAULT_GROUP_COMMIT_MAX &&
+            now - v->pending_since_ms < VAULT_GROUP_COMMIT_WINDOW_MS) {
+            if (v->pending_changes == 1) {
+                arm_group_commit(v);
+            }
+            return 0;
+        }
+    }
+
+    return save_vault(v);
+}
+
+static int reject_read_only(const vault_handle_t* v) {
+    if (v->read_only) {
+        fprintf(stderr, "Vault is open read-only\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int put_entry(vault_handle_t* v, const VaultEntry* entry) {
+    if (reject_read_only(v) != 0) {
+        return -1;
+    }
+
+    backup_before_change(v);
+
+    vault_snapshot_t* draft = writable_snapshot(v);
+    VaultEntry* new_entry = entry_alloc();
+    if (!draft || !new_entry) {
+        fprintf(stderr, "Memory allocation failed\n");
+        if (new_entry) {
+            entry_release(v, new_entry);
+        }
+        return -1;
+    }
+
+    *new_entry = *entry;
+    new_entry->service[VAULT_SERVICE_LEN - 1] = '\0';
+    new_entry->username[VAULT_USERNAME_LEN - 1] = '\0';
+    new_entry->password[VAULT_PASSWORD_LEN - 1] = '\0';
+    new_entry->totp_secret[VAULT_TOTP_LEN - 1] = '\0';
+    normalize_otp_fields(new_entry);
+
+    int existing_index = snapshot_find(draft, new_entry->service, new_entry->username);
+    if (existing_index >= 0 &&
+        strcmp(draft->entries[existing_index]->password, new_entry->password) == 0) {
+        new_entry->password_updated_at = draft->entries[existing_index]->password_updated_at;
+    } else if (new_entry->password_updated_at == 0) {
+        new_entry->password_updated_at = (uint64_t)time(NULL);
+    }
+
+    if (existing_index >= 0 && reserve_garbage(draft) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        entry_release(v, new_entry);
+        return -1;
+    }
+
+    v->dirty_shards[shard_of(v, new_entry)] = true;
+    if (existing_index >= 0) {
+        VaultEntry* old_entry = draft->entries[existing_index];
+        draft->entries[existing_index] = new_entry;
+        drop_entry(v, draft, old_entry);
+    } else {
+        if (draft->count == draft->capacity) {
+            uint32_t capacity = draft->capacity * 2;
+            VaultEntry** grown = (VaultEntry**)realloc(draft->entries,
+                                                       capacity * sizeof(VaultEntry*));
+            if (!grown) {
+                fprintf(stderr, "Memory allocation failed\n");
+                entry_release(v, new_entry);
+                return -1;
+            }
+            draft->entries = grown;
+            draft->capacity = capacity;
+        }
+        draft->entries[draft->count++] = new_entry;
+        index_add(draft, draft->count - 1);
+    }
+
+    return persist_change(v);
+}
+
+static int not_open(void) {
+    fprintf(stderr, "Vault is not open\n");
+    return -1;
+}
+
+int vault_handle_store(vault_handle_t* v, const char* service, const char* username,
+                       const char* password, const char* totp_secret, bool force) {
+    if (!v) {
+        return not_open();
+    }
+
+    if (!service || !username || !password) {
+        fprintf(stderr, "Service, username and password are required\n");
+        return -1;
+    }
+
+    if (totp_secret && strlen(totp_secret) >= VAULT_TOTP_LEN) {
+        fprintf(stderr, "TOTP secret is too long (max %d characters)\n", VAULT_TOTP_LEN - 1);
+        return -1;
+    }
+
+    write_begin(v);
+    bool exists = snapshot_find(latest_snapshot(v), service, username) >= 0;
+
+    /* Callers ask before overwriting; the write lock is never held across a prompt. */
+    if (exists && !force) {
+        write_end(v);
+        fprintf(stderr, "Entry for '%s' (%s) already exists\n", service, username);
+        return -1;
+    }
+
+    VaultEntry new_entry = {0};
+    strncpy(new_entry.service, service, VAULT_SERVICE_LEN - 1);
+    strncpy(new_entry.username, username, VAULT_USERNAME_LEN - 1);
+    strncpy(new_entry.password, password, VAULT_PASSWORD_LEN - 1);
+    if (totp_secret) {
+        strncpy(new_entry.totp_secret, totp_secret, VAULT_TOTP_LEN - 1);
+    }
+
+    int ret = put_entry(v, &new_entry);
+    write_end(v);
+    secure_cleanup(&new_entry, sizeof(new_entry));
+
+    if (ret != 0) {
+        return -1;
+    }
+
+    if (exists) {
+        printf("Updated entry for '%s' (%s)\n", service, username);
+    } else {
+        printf("Stored entry for '%s' (%s)\n", service, username);
+    }
+
+    return 0;
+}
+
+int vault_handle_put_entry(vault_handle_t* v, const VaultEntry* entry) {
+    if (!v) {
+        return not_open();
+    }
+
+    if (!entry || entry->service[0] == '\0' || entry->username[0] == '\0') {
+        fprintf(stderr, "Service and username are required\n");
+        return -1;
+    }
+
+    write_begin(v);
+    int ret = put_entry(v, entry);
+    write_end(v);
+    return ret;
+}
+
+/*
+ * A batch holds the write lock from begin to commit, so writes from other
+ * threads wait for it and readers keep seeing the last published snapshot.
+ * The batch's own thread sees its changes immediately.
+ */
+int vault_handle_begin_batch(vault_handle_t* v) {
+    if (!v) {
+        return not_open();
+    }
+
+    if (is_batch_owner(v)) {
+        v->batch_depth++;
+        return 0;
+    }
+
+    pthread_mutex_lock(&v->write_lock);
+    if (sync_pending(v) != 0) {
+        pthread_mutex_unlock(&v->write_lock);
+        return -1;
+    }
+    v->batch_depth = 1;
+    atomic_store(&v->batch_owner, thread_id());
+    return 0;
+}
+
+int vault_handle_commit_batch(vault_handle_t* v) {
+    if (!v || !is_batch_owner(v) || v->batch_depth == 0) {
+        fprintf(stderr, "No batch in progress\n");
+        return -1;
+    }
+
+    if (--v->batch_depth > 0) {
+        return 0;
+    }
+
+    bool dirty = v->batch_dirty;
+    v->batch_dirty = false;
+    v->batch_backed_up = false;
+
+    publish_draft(v);
+    int ret = dirty ? request_save(v) : 0;
+
+    atomic_store(&v->batch_owner, 0);
+    pthread_mutex_unlock(&v->write_lock);
+    return ret;
+}
+
+uint32_t vault_entry_otp(const VaultEntry* entry) {
+    if (!entry || entry->totp_secret[0] == '\0') {
+        return 0;
+    }
+
+    int digits = entry->totp_digits ? entry->totp_digits : TOTP_DEFAULT_DIGITS;
+
+    if (entry->totp_type == OTP_TYPE_HOTP) {
+        return generate_otp(entry->totp_secret, (totp_algorithm_t)entry->totp_algorithm,
+                            digits, entry->totp_counter);
+    }
+
+    uint32_t period = entry->totp_period ? entry->totp_period : TOTP_DEFAULT_PERIOD;
+    return generate_totp_at(entry->totp_secret, (totp_algorithm_t)entry->totp_algorithm,
+                            digits, period, time(NULL));
+}
+
+/*
+ * The one-time code to use now. An HOTP code is valid once, so issuing it
+ * moves the stored counter past it and saves the entry, which needs a
+ * writable handle; *counter is the counter the code was made from. TOTP
+ * codes only depend on the time and change nothing.
+ */
+int vault_handle_issue_otp(vault_handle_t* v, const char* service, const char* username,
+                           uint32_t* code, uint64_t* counter) {
+    if (!v) {
+        return not_open();
+    }
+
+    if (!service || !username || !code) {
+        fprintf(stderr, "Invalid parameters\n");
+        return -1;
+    }
+
+    VaultEntry entry;
+    size_t slot;
+    const vault_snapshot_t* snap = read_begin(v, &slot);
+    int index = snapshot_find(snap, service, username);
+    if (index >= 0) {
+        entry = *snap->entries[index];
+    }
+    reader_exit(v, slot);
+
+    int ret = -1;
+    if (index < 0) {
+        fprintf(stderr, "Entry not found: %s (%s)\n", service, username);
+        *code = 0;
+        return -1;
+    }
+    if (entry.totp_secret[0] == '\0') {
+        fprintf(stderr, "No TOTP secret stored for '%s' (%s)\n", service, username);
+        secure_cleanup(&entry, sizeof(entry));
+        *code = 0;
+        return -1;
+    }
+
+    /* A TOTP code changes nothing, so it is served from the snapshot, also on read-only handles. */
+    if (entry.totp_type != OTP_TYPE_HOTP) {
+        *code = vault_entry_otp(&entry);
+        if (counter) {
+            *counter = entry.totp_counter;
+        }
+        secure_cleanup(&entry, sizeof(entry));
+        return 0;
+    }
+
+    /* HOTP: look the entry up again under the write lock so concurrent issuers never share a counter. */
+    write_begin(v);
+    snap = latest_snapshot(v);
+    index = snapshot_find(snap, service, username);
+    if (index < 0 || snap->entries[index]->totp_type != OTP_TYPE_HOTP) {
+        fprintf(stderr, "Entry changed while issuing a code: %s (%s)\n", service, username);
+    } else {
+        entry = *snap->entries[index];
+        *code = vault_entry_otp(&entry);
+        if (counter) {
+            *counter = entry.totp_counter;
+        }
+        entry.totp_counter++;
+        ret = put_entry(v, &entry);
+    }
+    write_end(v);
+    secure_cleanup(&entry, sizeof(entry));
+
+    if (ret != 0) {
+        *code = 0;
+    }
+    return ret;
+}
+
+int vault_handle_get(vault_handle_t* v, const char* service, const char* username,
+                     VaultEntry* entry) {
+    if (!v) {
+        return not_open();
+    }
+
+    if (!service || !username || !entry) {
+        fprintf(stderr, "Invalid parameters\n");
+        return -1;
+    }
+
+    size_t slot;
+    const vault_snapshot_t* snap = read_begin(v, &slot);
+    int index = snapshot_find(snap, service, username);
+    if (index >= 0) {
+        *entry = *snap->entries[index];
+    }
+    reader_exit(v, slot);
+    METRIC_COUNT(index >= 0 ? METRIC_LOOKUP_HITS : METRIC_LOOKUP_MISSES, 1);
+
+    if (index < 0) {
+        fprintf(stderr, "Entry not found: %s (%s)\n", service, username);
+        return -1;
+    }
+    return 0;
+}
+
+int vault_handle_get_entry_at(vault_handle_t* v, size_t index, VaultEntry* entry) {
+    if (!v || !entry) {
+        return -1;
+    }
+
+    size_t slot;
+    const vault_snapshot_t* snap = read_begin(v, &slot);
+    int ret = -1;
+    if (index < snap->count) {
+        *entry = *snap->entries[index];
+        ret = 0;
+    }
+    reader_exit(v, slot);
+    return ret;
+}
+
+size_t vault_handle_entry_count(vault_handle_t* v) {
+    if (!v) {
+        return 0;
+    }
+
+    size_t slot;
+    const vault_snapshot_t* snap = read_begin(v, &slot);
+    size_t count = snap->count;
+    reader_exit(v, slot);
+    return count;
+}
+
+int vault_handle_find_entry(vault_handle_t* v, const char* service, const char* username) {
+    if (!v || !service || !username) {
+        return -1;
+    }
+
+    size_t slot;
+    const vault_snapshot_t* snap = read_begin(v, &slot);
+    int index = snapshot_find(snap, service, username);
+    reader_exit(v, slot);
+    METRIC_COUNT(index >= 0 ? METRIC_LOOKUP_HITS : METRIC_LOOKUP_MISSES, 1);
+    return index;
+}
+
+int vault_handle_list(vault_handle_t* v) {
+    if (!v) {
+        return not_open();
+    }
+
+    size_t slot;
+    const vault_snapshot_t* snap = read_begin(v, &slot);
+    if (snap->count == 0) {
+        printf("Vault is empty.\n");
+        reader_exit(v, slot);
+        return 0;
+    }
+
+    printf("\n=== Vault Entries (%u) ===\n\n", snap->count);
+    TIMING_COUNT(TIMING_ENTRIES_SCANNED, snap->count);
+
+    for (uint32_t i = 0; i < snap->count; i++) {
+        printf("%3u. %-30s %-30s", i + 1,
+               snap->entries[i]->service,
+               snap->entries[i]->username);
+
+        if (strlen(snap->entries[i]->totp_secret) > 0) {
+            printf(" [TOTP]");
+        }
+
+        printf("\n");
+    }
+
+    printf("\n");
+    reader_exit(v, slot);
+    return 0;
+}
+
+const vault_snapshot_t* vault_snapshot_acquire(vault_handle_t* v) {
+    if (!v) {
+        return NULL;
+    }
+
+    size_t slot = reader_enter(v);
+    vault_snapshot_t* snap = atomic_load(&v->current);
+    atomic_fetch_add(&snap->refs, 1);
+    reader_exit(v, slot);
+    return snap;
+}
+
+void vault_snapshot_release(vault_handle_t* v, const vault_snapshot_t* snapshot) {
+    if (!v || !snapshot) {
+        return;
+    }
+
+    vault_snapshot_t* snap = (vault_snapshot_t*)snapshot;
+    if (atomic_fetch_sub(&snap->refs, 1) == 1 && pthread_mutex_trylock(&v->write_lock) == 0) {
+        reclaim_snapshots(v);
+        pthread_mutex_unlock(&v->write_lock);
+    }
+}
+
+size_t vault_snapshot_count(const vault_snapshot_t* snapshot) {
+    return snapshot ? snapshot->count : 0;
+}
+
+const VaultEntry* vault_snapshot_entry(const vault_snapshot_t* snapshot, size_t index) {
+    if (!snapshot || index >= snapshot->count) {
+        return NULL;
+    }
+    return snapshot->entries[index];
+}
+
+int vault_snapshot_find(const vault_snapshot_t* snapshot, const char* service,
+                        const char* username) {
+    if (!snapshot || !service || !username) {
+        return -1;
+    }
+    return snapshot_find(snapshot, service, username);
+}
+
+size_t vault_handle_retired_snapshots(vault_handle_t* v) {
+    if (!v) {
+        return 0;
+    }
+
+    write_begin(v);
+    reclaim_snapshots(v);
+    size_t retired = v->retired_count;
+    write_end(v);
+    return retired;
+}
+
+static int remove_entry_at(vault_handle_t* v, size_t index) {
+    if (reject_read_only(v) != 0) {
+        return -1;
+    }
+
+    vault_snapshot_t* draft = writable_snapshot(v);
+    if (!draft || index >= draft->count) {
+        return -1;
+    }
+    if (reserve_garbage(draft) != 0) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+
+    backup_before_change(v);
+
+    VaultEntry* old_entry = draft->entries[index];
+    v->dirty_shards[shard_of(v, old_entry)] = true;
+    memmove(&draft->entries[index], &draft->entries[index + 1],
+            (draft->count - index - 1) * sizeof(VaultEntry*));
+    draft->count--;
+    index_rebuild(draft);
+    drop_entry(v, draft, old_entry);
+
+    return persist_change(v);
+}
+
+int vault_handle_remove_entry_at(vault_handle_t* v, size_t index) {
+    if (!v) {
+        return -1;
+    }
+
+    write_begin(v);
+    int ret = remove_entry_at(v, index);
+    write_end(v);
+    return ret;
+}
+
+int vault_handle_remove(vault_handle_t* v, const char* service, const char* username) {
+    if (!v) {
+        return not_open();
+    }
+
+    if (!service || !username) {
+        fprintf(stderr, "Service and username are required\n");
+        return -1;
+    }
+
+    write_begin(v);
+    int index = snapshot_find(latest_snapshot(v), service, username);
+    int ret = index >= 0 ? remove_entry_at(v, (size_t)index) : -1;
+    write_end(v);
+
+    if (index < 0) {
+        fprintf(stderr, "Entry not found: %s (%s)\n", service, username);
+        return -1;
+    }
+    if (ret != 0) {
+        return -1;
+    }
+
+    printf("Removed entry for '%s' (%s)\n", service, username);
+    return 0;
+}
+
+static int saver_write(vault_handle_t* v, uint64_t* target) {
+    VaultHeader header;
+    unsigned char key[sizeof(v->key)];
+
+    pthread_mutex_lock(&v->write_lock);
+    vault_snapshot_t* snap = atomic_load(&v->current);
+    atomic_fetch_add(&snap->refs, 1);
+    uint64_t capture = ++v->save_capture;
+    header = v->header;
+    memcpy(key, v->key, sizeof(key));
+    memcpy(v->saver_dirty, v->dirty_shards, v->shard_count * sizeof(bool));
+    memset(v->dirty_shards, 0, v->shard_count * sizeof(bool));
+    pthread_mutex_lock(&v->saver_lock);
+    *target = v->change_seq;
+    pthread_mutex_unlock(&v->saver_lock);
+    pthread_mutex_unlock(&v->write_lock);
+
+    int ret = write_captured(v, capture, &header, snap, key, v->saver_dirty);
+    int err = errno;
+    secure_cleanup(key, sizeof(key));
+    vault_snapshot_release(v, snap);
+
+    if (ret != 0) {
+        pthread_mutex_lock(&v->write_lock);
+        for (uint32_t s = 0; s < v->shard_count; s++) {
+            v->dirty_shards[s] = v->dirty_shards[s] || v->saver_dirty[s];
+        }
+        pthread_mutex_unlock(&v->write_lock);
+    }
+    errno = err;
+    return ret;
+}
+
+static void wait_for_deadline(vault_handle_t* v, const struct timespec* deadline) {
+    while (!v->saver_stop && v->flush_requests == 0) {
+        if (pthread_cond_timedwait(&v->saver_cond, &v->saver_lock, deadline) != 0) {
+            return;
+        }
+    }
+}
+
+static void* saver_main(void* arg) {
+    vault_handle_t* v = (vault_handle_t*)arg;
+
+    pthread_mutex_lock(&v->saver_lock);
+    for (;;) {
+        while (!v->saver_stop && v->change_seq == v->attempted_seq) {
+            pthread_cond_wait(&v->saver_cond, &v->saver_lock);
+        }
+        if (v->change_seq == v->saved_seq && v->saver_stop) {
+            break;
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += v->saver_delay_ms / 1000;
+        deadline.tv_nsec += (long)(v->saver_delay_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        wait_for_deadline(v, &deadline);
+        pthread_mutex_unlock(&v->saver_lock);
+
+        uint64_t target = 0;
+        int ret = saver_write(v, &target);
+        int err = ret != 0 ? (errno ? errno : EIO) : 0;
+
+        if (ret != 0 && v->on_save_error) {
+            v->on_save_error(v, err, v->on_save_error_context);
+        }
+
+        pthread_mutex_lock(&v->saver_lock);
+        v->attempted_seq = target;
+        v->saver_error = err;
+        if (ret == 0 && target > v->saved_seq) {
+            v->saved_seq = target;
+        }
+        pthread_cond_broadcast(&v->flush_cond);
+        if (v->saver_stop) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&v->saver_lock);
+    return NULL;
+}
+
+int vault_handle_start_saver(vault_handle_t* v, int delay_ms, vault_save_error_fn on_error,
+                             void* context) {
+    if (!v) {
+        return not_open();
+    }
+    if (reject_read_only(v) != 0) {
+        return -1;
+    }
+
+    write_begin(v);
+    int ret = 0;
+    if (v->saver_running) {
+        fprintf(stderr, "Background saver is already running\n");
+        ret = -1;
+    } else if (sync_pending(v) != 0) {
+        ret = -1;
+    } else {
+        v->saver_delay_ms = delay_ms < 0 ? 0 : delay_ms;
+        if (!v->saver_dirty) {
+            v->saver_dirty = (bool*)calloc(v->shard_count, sizeof(bool));
+        }
+        v->on_save_error = on_error;
+        v->on_save_error_context = context;
+        v->saver_stop = false;
+        if (!v->saver_dirty || pthread_create(&v->saver_thread, NULL, saver_main, v) != 0) {
+            fprintf(stderr, "Failed to start background saver\n");
+            ret = -1;
+        } else {
+            v->saver_running = true;
+        }
+    }
+    write_end(v);
+    return ret;
+}
+
+int vault_handle_flush(vault_handle_t* v) {
+    if (!v) {
+        return 0;
+    }
+    if (is_batch_owner(v)) {
+        fprintf(stderr, "Cannot flush the vault inside a batch\n");
+        return -1;
+    }
+    if (!v->saver_running) {
+        write_begin(v);
+        int ret = sync_pending(v);
+        write_end(v);
+        return ret;
+    }
+
+    pthread_mutex_lock(&v->saver_lock);
+    uint64_t target = v->change_seq;
+    v->flush_requests++;
+    pthread_cond_signal(&v->saver_cond);
+    while (v->saved_seq < target && !(v->attempted_seq >= target && v->saver_error != 0)) {
+        pthread_cond_wait(&v->flush_cond, &v->saver_lock);
+    }
+    int ret = v->saved_seq >= target ? 0 : -1;
+    v->flush_requests--;
+    pthread_mutex_unlock(&v->saver_lock);
+    return ret;
+}
+
+static void stop_saver(vault_handle_t* v) {
+    if (!v->saver_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&v->saver_lock);
+    v->saver_stop = true;
+    pthread_cond_signal(&v->saver_cond);
+    pthread_mutex_unlock(&v->saver_lock);
+
+    pthread_join(v->saver_thread, NULL);
+    v->saver_running = false;
+    if (v->saved_seq != v->change_seq) {
+        fprintf(stderr, "Failed to save pending vault changes\n");
+    }
+}
+
+static bool same_file(const struct stat* a, const struct stat* b) {
+    return a->st_dev == b->st_dev && a->st_ino == b->st_ino && a->st_size == b->st_size &&
+           a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
+
+static int load_changed_shards(vault_handle_t* v, ShardLoad* loads, const bool* changed,
+                               struct stat* stats) {
+    if (vault_lock(v, LOCK_SH) != 0) {
         return -1;
     }
 
-    int existing_index = vault_find_entry(service, username);
+    int ret = 0;
+    for (uint32_t s = 0; s < v->shard_count && ret == 0; s++) {
+        if (!changed[s]) {
+            continue;
+        }
 
-    if (existing_index >= 0 && !force) {
-        printf("Entry for '%s' (%s) already exists.\n", service, username);
-        printf("Overwrite? (y/n): ");
-        char answer;
-        scanf(" %c", &answer);
-        if (answer != 'y' && answer != 'Y') {
-            printf("Cancelled.\n");
-            return -1;
+        char path[VAULT_SHARD_PATH_MAX];
+        shard_path(v, s, path, sizeof(path));
+        ret = read_shard(path, &loads[s], &stats[s]);
+        if (ret == 0 && memcmp(loads[s].header.salt, v->header.salt, SALT_SIZE) != 0) {
+            fprintf(stderr, "Vault master password changed, reopen the vault to reload it\n");
+            ret = -1;
         }
     }
+    vault_unlock(v);
 
-    if (g_vault.auto_backup) {
-        vault_backup(g_vault.vault_path);
-    }
+    return ret == 0 ? decrypt_shards(loads, v->shard_count, v->key, NULL) : -1;
+}
 
-    VaultEntry new_entry = {0};
-    strncpy(new_entry.service, service, VAULT_SERVICE_LEN - 1);
-    strncpy(new_entry.username, username, VAULT_USERNAME_LEN - 1);
-    strncpy(new_entry.password, password, VAULT_PASSWORD_LEN - 1);
-    if (totp_secret) {
-        strncpy(new_entry.totp_secret, totp_secret, VAULT_TOTP_LEN - 1);
+/*
+ * Entries of unchanged shards stay shared with the old version. Entries of
+ * changed shards are replaced by the reloaded ones and parked on the old
+ * version's garbage list, so readers still inside it are not affected.
+ */
+static int publish_reload(vault_handle_t* v, const ShardLoad* loads, const bool* changed) {
+    const vault_snapshot_t* current = atomic_load(&v->current);
+    size_t added = 0;
+    for (uint32_t s = 0; s < v->shard_count; s++) {
+        if (changed[s]) {
+            added += loads[s].header.entry_count;
+        }
     }
 
-    if (existing_index >= 0) {
-        g_vault.entries[existing_index] = new_entry;
-    } else {
-        VaultEntry* new_entries = (VaultEntry*)realloc(g_vault.entries,
-                                          (g_vault.header.entry_count + 1) * sizeof(VaultEntry));
-        if (!new_entries) {
-            fprintf(stderr, "Memory allocation failed\n");
-            return -1;
+    vault_snapshot_t* next = (vault_snapshot_t*)calloc(1, sizeof(vault_snapshot_t));
+    if (next) {
+        next->capacity = (uint32_t)(current->count + added + 16);
+        next->entries = (VaultEntry**)malloc(next->capacity * sizeof(VaultEntry*));
+        next->garbage = (VaultEntry**)malloc((current->count + 1) * sizeof(VaultEntry*));
+        next->garbage_capacity = current->count + 1;
+    }
+    if (!next || !next->entries || !next->garbage) {
+        fprintf(stderr, "Memory allocation failed\n");
+        if (next) {
+            free(next->entries);
+            free(next->garbage);
+            free(next);
         }
-        g_vault.entries = new_entries;
-        g_vault.entries[g_vault.header.entry_count] = new_entry;
-        g_vault.header.entry_count++;
+        return -1;
     }
 
-    if (save_vault() != 0) {
-        return -1;
+    for (uint32_t i = 0; i < current->count; i++) {
+        VaultEntry* entry = current->entries[i];
+        if (changed[shard_of(v, entry)]) {
+            next->garbage[next->garbage_count++] = entry;
+        } else {
+            next->entries[next->count++] = entry;
+        }
     }
 
-    if (existing_index >= 0) {
-        printf("Updated entry for '%s' (%s)\n", service, username);
-    } else {
-        printf("Stored entry for '%s' (%s)\n", service, username);
+    v->draft = next;
+    for (uint32_t s = 0; s < v->shard_count; s++) {
+        for (uint32_t i = 0; changed[s] && i < loads[s].header.entry_count; i++) {
+            VaultEntry* entry = NULL;
+            if (shard_of(v, &loads[s].entries[i]) != s) {
+                fprintf(stderr, "Vault shard %u is corrupted\n", s);
+            } else if (!(entry = entry_alloc())) {
+                fprintf(stderr, "Memory allocation failed\n");
+            }
+            if (!entry) {
+                discard_draft(v);
+                return -1;
+            }
+            *entry = loads[s].entries[i];
+            next->entries[next->count++] = entry;
+        }
     }
 
+    index_rebuild(next);
+    publish_draft(v);
     return 0;
 }
 
-int vault_get(const char* service, const char* username, VaultEntry* entry) {
-    if (!g_vault.is_open) {
-        fprintf(stderr, "Vault is not open\n");
-        return -1;
+/*
+ * Reloading reuses the key derived at open, so a changed shard costs one read
+ * and one decryption instead of a key derivation, and unchanged shards are
+ * not read at all. A new salt means the master password changed, and the
+ * vault has to be reopened. Called with the write lock held.
+ */
+static int reload_vault(vault_handle_t* v) {
+    struct stat* stats = (struct stat*)calloc(v->shard_count, sizeof(struct stat));
+    bool* changed = (bool*)calloc(v->shard_count, sizeof(bool));
+    ShardLoad* loads = (ShardLoad*)calloc(v->shard_count, sizeof(ShardLoad));
+    int ret = 0;
+    if (!stats || !changed || !loads) {
+        fprintf(stderr, "Memory allocation failed\n");
+        ret = -1;
+    }
+
+    bool any_changed = false;
+    for (uint32_t s = 0; ret == 0 && s < v->shard_count; s++) {
+        char path[VAULT_SHARD_PATH_MAX];
+        shard_path(v, s, path, sizeof(path));
+        if (stat(path, &stats[s]) != 0) {
+            fprintf(stderr, "Failed to check vault file: %s\n", strerror(errno));
+            ret = -1;
+        } else {
+            changed[s] = !same_file(&stats[s], &v->shards[s].st);
+            any_changed = any_changed || changed[s];
+        }
     }
 
-    if (!service || !username || !entry) {
-        fprintf(stderr, "Invalid parameters\n");
-        return -1;
+    if (ret == 0 && any_changed) {
+        ret = load_changed_shards(v, loads, changed, stats);
+        if (ret == 0) {
+            ret = publish_reload(v, loads, changed);
+        }
+        if (ret == 0) {
+            for (uint32_t s = 0; s < v->shard_count; s++) {
+                if (changed[s]) {
+                    v->shards[s].st = stats[s];
+                }
+            }
+            atomic_fetch_add(&v->generation, 1);
+            METRIC_COUNT(METRIC_RELOADS, 1);
+            ret = 1;
+        }
     }
 
-    int index = vault_find_entry(service, username);
-    if (index < 0) {
-        fprintf(stderr, "Entry not found: %s (%s)\n", service, username);
-        return -1;
+    free_shard_loads(loads, v->shard_count);
+    free(stats);
+    free(changed);
+    return ret;
+}
+
+int vault_handle_reload(vault_handle_t* v) {
+    if (!v) {
+        return not_open();
+    }
+    if (!v->read_only) {
+        return 0;
     }
 
-    *entry = g_vault.entries[index];
-    return 0;
+    write_begin(v);
+    int ret = reload_vault(v);
+    write_end(v);
+    return ret;
 }
 
-int vault_list(void) {
-    if (!g_vault.is_open) {
-        fprintf(stderr, "Vault is not open\n");
-        return -1;
-    }
+uint64_t vault_handle_generation(vault_handle_t* v) {
+    return v ? atomic_load(&v->generation) : 0;
+}
 
-    if (g_vault.header.entry_count == 0) {
-        printf("Vault is empty.\n");
-        return 0;
+static bool watched_name(const vault_handle_t* v, const char* name, const char* vault_name) {
+    if (v->sharded) {
+        return strncmp(name, VAULT_SHARD_PREFIX, strlen(VAULT_SHARD_PREFIX)) == 0 &&
+               !strstr(name, ".tmp.");
     }
+    return strcmp(name, vault_name) == 0;
+}
 
-    printf("\n=== Vault Entries (%u) ===\n\n", g_vault.header.entry_count);
+static bool watched_event(const vault_handle_t* v, const char* buffer, ssize_t length,
+                          const char* vault_name) {
+    bool matched = false;
+    for (ssize_t offset = 0; offset < length;) {
+        const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+        if ((event->mask & IN_Q_OVERFLOW) ||
+            (event->len > 0 && watched_name(v, event->name, vault_name))) {
+            matched = true;
+        }
+        offset += (ssize_t)(sizeof(struct inotify_event) + event->len);
+    }
+    return matched;
+}
 
-    for (uint32_t i = 0; i < g_vault.header.entry_count; i++) {
-        printf("%3u. %-30s %-30s", i + 1,
-               g_vault.entries[i].service,
-               g_vault.entries[i].username);
+static void* watch_main(void* arg) {
+    vault_handle_t* v = (vault_handle_t*)arg;
+    char path[VAULT_PATH_MAX];
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    memcpy(path, v->vault_path, sizeof(path));
+    const char* name = basename(path);
+    struct pollfd fds[2] = {
+        {v->watch_pipe[0], POLLIN, 0},
+        {v->watch_fd, POLLIN, 0}
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) {
+            break;
+        }
 
-        if (strlen(g_vault.entries[i].totp_secret) > 0) {
-            printf(" [TOTP]");
+        ssize_t length = read(v->watch_fd, buffer, sizeof(buffer));
+        if (length <= 0 || !watched_event(v, buffer, length, name)) {
+            continue;
         }
 
-        printf("\n");
+        pthread_mutex_lock(&v->write_lock);
+        int ret = reload_vault(v);
+        pthread_mutex_unlock(&v->write_lock);
+        if (ret > 0 && v->on_reload) {
+            v->on_reload(v, v->on_reload_context);
+        }
     }
-
-    printf("\n");
-    return 0;
+    return NULL;
 }
 
-int vault_remove(const char* service, const char* username) {
-    if (!g_vault.is_open) {
-        fprintf(stderr, "Vault is not open\n");
+/*
+ * Saves replace the vault or a shard with a rename, so the watch is on the
+ * directory holding them and filters events by file name.
+ */
+int vault_handle_watch(vault_handle_t* v, vault_reload_fn on_reload, void* context) {
+    if (!v) {
+        return not_open();
+    }
+    if (!v->read_only) {
+        fprintf(stderr, "Only read-only vaults can be watched\n");
         return -1;
     }
-
-    if (!service || !username) {
-        fprintf(stderr, "Service and username are required\n");
+    if (v->watch_running) {
+        fprintf(stderr, "Vault is already being watched\n");
         return -1;
     }
 
-    int index = vault_find_entry(service, username);
-    if (index < 0) {
-        fprintf(stderr, "Entry not found: %s (%s)\n", service, username);
+    char dir[VAULT_PATH_MAX];
+    memcpy(dir, v->vault_path, sizeof(dir));
+    v->watch_fd = inotify_init1(IN_CLOEXEC);
+    if (v->watch_fd < 0 ||
+        inotify_add_watch(v->watch_fd, v->sharded ? v->vault_path : dirname(dir),
+                          IN_MOVED_TO | IN_CLOSE_WRITE) < 0 ||
+        pipe2(v->watch_pipe, O_CLOEXEC) != 0) {
+        fprintf(stderr, "Failed to watch vault: %s\n", strerror(errno));
+        if (v->watch_fd >= 0) close(v->watch_fd);
+        v->watch_fd = -1;
         return -1;
     }
 
-    if (g_vault.auto_backup) {
-        vault_backup(g_vault.vault_path);
+    v->on_reload = on_reload;
+    v->on_reload_context = context;
+    if (pthread_create(&v->watch_thread, NULL, watch_main, v) != 0) {
+        fprintf(stderr, "Failed to start vault watcher\n");
+        close(v->watch_fd);
+        close(v->watch_pipe[0]);
+        close(v->watch_pipe[1]);
+        v->watch_fd = v->watch_pipe[0] = v->watch_pipe[1] = -1;
+        return -1;
     }
+    v->watch_running = true;
+    return 0;
+}
 
-    for (uint32_t i = index; i < g_vault.header.entry_count - 1; i++) {
-        g_vault.entries[i] = g_vault.entries[i + 1];
+static void stop_watch(vault_handle_t* v) {
+    if (!v->watch_running) {
+        return;
     }
 
-    g_vault.header.entry_count--;
+    ssize_t written = write(v->watch_pipe[1], "", 1);
+    (void)written;
+    pthread_join(v->watch_thread, NULL);
+    close(v->watch_fd);
+    close(v->watch_pipe[0]);
+    close(v->watch_pipe[1]);
+    v->watch_running = false;
+}
 
-    if (g_vault.header.entry_count > 0) {
-        VaultEntry* new_entries = (VaultEntry*)realloc(g_vault.entries,
-                                          g_vault.header.entry_count * sizeof(VaultEntry));
-        if (new_entries) {
-            g_vault.entries = new_entries;
-        }
-    } else {
-        free(g_vault.entries);
-        g_vault.entries = NULL;
+/*
+ * Callers must make sure no other thread still uses the handle. An
+ * uncommitted batch is discarded, and the background saver writes
+ * everything published before it stops.
+ */
+void vault_handle_close(vault_handle_t* v) {
+    if (!v) {
+        return;
     }
 
-    if (save_vault() != 0) {
-        return -1;
+    if (is_batch_owner(v)) {
+        discard_draft(v);
+        v->batch_depth = 0;
+        v->batch_dirty = false;
+        v->batch_backed_up = false;
+        atomic_store(&v->batch_owner, 0);
+        pthread_mutex_unlock(&v->write_lock);
     }
+    stop_saver(v);
+    stop_watch(v);
+    stop_group_commit(v);
 
-    printf("Removed entry for '%s' (%s)\n", service, username);
-    return 0;
-}
-
-void vault_cleanup(void) {
-    if (!g_vault.is_open) {
-        return;
+    pthread_mutex_lock(&v->write_lock);
+    if (sync_pending(v) != 0) {
+        fprintf(stderr, "Failed to save pending vault changes\n");
     }
+    vault_unlock(v);
+    discard_draft(v);
 
-    secure_cleanup(g_vault.key, sizeof(g_vault.key));
+    secure_cleanup(v->key, sizeof(v->key));
 
-    if (g_vault.entries) {
-        secure_cleanup(g_vault.entries,
-                       g_vault.header.entry_count * sizeof(VaultEntry));
-        free(g_vault.entries);
-        g_vault.entries = NULL;
+    while (v->retired_head) {
+        vault_snapshot_t* snap = v->retired_head;
+        v->retired_head = snap->next;
+        snapshot_free(v, snap);
     }
 
-    memset(&g_vault.header, 0, sizeof(VaultHeader));
-    memset(g_vault.vault_path, 0, sizeof(g_vault.vault_path));
+    vault_snapshot_t* current = atomic_load(&v->current);
+    for (uint32_t i = 0; i < current->count; i++) {
+        entry_release(v, current->entries[i]);
+    }
+    snapshot_free(v, current);
+    slab_free(v);
+    free(v->shards);
+    free(v->dirty_shards);
+    free(v->saver_dirty);
 
-    g_vault.is_open = false;
+    pthread_mutex_unlock(&v->write_lock);
+    pthread_mutex_destroy(&v->write_lock);
+    pthread_mutex_destroy(&v->save_lock);
+    pthread_mutex_destroy(&v->saver_lock);
+    pthread_cond_destroy(&v->saver_cond);
+    pthread_cond_destroy(&v->flush_cond);
+    pthread_cond_destroy(&v->group_cond);
 
-    crypto_cleanup();
+    secure_cleanup(v, sizeof(*v));
+    free(v);
 }
 
 int vault_backup(const char* vault_path) {
     if (!vault_path) {
-        vault_path = g_vault.vault_path;
+        if (!g_vault) {
+            fprintf(stderr, "Vault is not open\n");
+            return -1;
+        }
+        vault_path = g_vault->vault_path;
     }
 
     char expanded_vault[512];
@@ -543,24 +2866,23 @@ int vault_restore(const char* backup_path, const char* vault_path) {
     return 0;
 }
 
-int vault_change_master_password(const char* old_password, const char* new_password) {
-    if (!g_vault.is_open) {
-        fprintf(stderr, "Vault is not open\n");
+static int change_master_password(vault_handle_t* v, const char* old_password,
+                                  const char* new_password) {
+    if (reject_read_only(v) != 0) {
         return -1;
     }
-
-    if (!old_password || !new_password) {
-        fprintf(stderr, "Old and new passwords are required\n");
+    if (v->sharded) {
+        fprintf(stderr, "Cannot change the master password of a sharded vault, reshard it to one file first\n");
         return -1;
     }
 
     unsigned char old_key[32];
-    if (derive_key_with_salt(old_password, g_vault.header.salt, SALT_SIZE, old_key) != 0) {
+    if (derive_key_with_salt(old_password, v->header.salt, SALT_SIZE, old_key) != 0) {
         fprintf(stderr, "Failed to derive old key\n");
         return -1;
     }
 
-    if (memcmp(old_key, g_vault.key, 32) != 0) {
+    if (memcmp(old_key, v->key, 32) != 0) {
         fprintf(stderr, "Wrong old password\n");
         secure_cleanup(old_key, sizeof(old_key));
         return -1;
@@ -568,39 +2890,245 @@ int vault_change_master_password(const char* old_password, const char* new_passw
 
     secure_cleanup(old_key, sizeof(old_key));
 
-    if (g_vault.auto_backup) {
-        vault_backup(g_vault.vault_path);
+    if (v->auto_backup) {
+        vault_backup(v->vault_path);
     }
 
-    if (RAND_bytes(g_vault.header.salt, SALT_SIZE) != 1) {
+    if (RAND_bytes(v->header.salt, SALT_SIZE) != 1) {
         fprintf(stderr, "Failed to generate new salt\n");
         return -1;
     }
 
     unsigned char new_key[32];
-    if (derive_key_with_salt(new_password, g_vault.header.salt, SALT_SIZE, new_key) != 0) {
+    if (derive_key_with_salt(new_password, v->header.salt, SALT_SIZE, new_key) != 0) {
         fprintf(stderr, "Failed to derive new key\n");
         return -1;
     }
 
     unsigned char old_vault_key[32];
-    memcpy(old_vault_key, g_vault.key, 32);
+    memcpy(old_vault_key, v->key, 32);
 
-    memcpy(g_vault.key, new_key, 32);
+    memcpy(v->key, new_key, 32);
     secure_cleanup(new_key, sizeof(new_key));
 
-    if (save_vault() != 0) {
-        memcpy(g_vault.key, old_vault_key, 32);
+    v->dirty_shards[0] = true;
+    if (save_vault(v) != 0) {
+        memcpy(v->key, old_vault_key, 32);
         secure_cleanup(old_vault_key, sizeof(old_vault_key));
         return -1;
     }
 
     secure_cleanup(old_vault_key, sizeof(old_vault_key));
 
-    printf("Master password changed successfully\n");
     return 0;
 }
 
+int vault_handle_change_master_password(vault_handle_t* v, const char* old_password,
+                                        const char* new_password) {
+    if (!v) {
+        return not_open();
+    }
+
+    if (!old_password || !new_password) {
+        fprintf(stderr, "Old and new passwords are required\n");
+        return -1;
+    }
+
+    write_begin(v);
+    int ret = change_master_password(v, old_password, new_password);
+    write_end(v);
+
+    if (ret == 0) {
+        printf("Master password changed successfully\n");
+    }
+    return ret;
+}
+
+uint32_t vault_handle_shard_count(const vault_handle_t* v) {
+    return v && v->sharded ? v->shard_count : 1;
+}
+
+vault_codec_t vault_handle_compression(const vault_handle_t* v) {
+    return v ? (vault_codec_t)v->header.codec : VAULT_CODEC_NONE;
+}
+
+void vault_handle_open_timings(const vault_handle_t* v, vault_open_timings_t* timings) {
+    if (v && timings) {
+        *timings = v->open_timings;
+    }
+}
+
+/*
+ * Reads the headers on disk, so version and codec describe the files as
+ * they are now rather than what the next save will write.
+ */
+int vault_handle_layout(vault_handle_t* v, vault_layout_t* layout) {
+    if (!v) {
+        return not_open();
+    }
+    if (!layout) {
+        return -1;
+    }
+
+    memset(layout, 0, sizeof(*layout));
+    layout->shards = vault_handle_shard_count(v);
+    for (uint32_t s = 0; s < layout->shards; s++) {
+        char path[VAULT_SHARD_PATH_MAX];
+        shard_path(v, s, path, sizeof(path));
+        struct stat st;
+        VaultHeader header;
+        if (stat(path, &st) != 0 || read_header_file(path, &header) != 0) {
+            return -1;
+        }
+        if (s == 0) {
+            layout->version = header.version;
+            layout->codec = header.version >= 4 ? (vault_codec_t)header.codec : VAULT_CODEC_NONE;
+        }
+        layout->file_bytes += (uint64_t)st.st_size;
+        layout->ciphertext_bytes += (uint64_t)st.st_size - header_size_for_version(header.version);
+    }
+
+    char path[VAULT_SHARD_PATH_MAX + 16];
+    struct stat st;
+    if (v->sharded) {
+        snprintf(path, sizeof(path), "%s/%s", v->vault_path, VAULT_MANIFEST_NAME);
+        if (stat(path, &st) == 0) {
+            layout->file_bytes += (uint64_t)st.st_size;
+        }
+    } else {
+        snprintf(path, sizeof(path), "%s.backup", v->vault_path);
+        if (stat(path, &st) == 0) {
+            layout->backup_bytes = (uint64_t)st.st_size;
+        }
+    }
+    return 0;
+}
+
+static int write_manifest(const char* dir, const VaultManifest* manifest) {
+    char path[VAULT_SHARD_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, VAULT_MANIFEST_NAME);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create vault manifest: %s\n", strerror(errno));
+        return -1;
+    }
+
+    bool durable = g_durability != VAULT_DURABILITY_NONE;
+    int ret = write(fd, manifest, sizeof(*manifest)) == (ssize_t)sizeof(*manifest) ? 0 : -1;
+    if (ret == 0 && durable && fsync(fd) != 0) {
+        ret = -1;
+    }
+    close(fd);
+
+    if (ret != 0) {
+        fprintf(stderr, "Failed to write vault manifest\n");
+        return -1;
+    }
+    if (durable && sync_parent_directory(path) != 0) {
+        fprintf(stderr, "Warning: Failed to sync vault directory\n");
+    }
+    return 0;
+}
+
+/*
+ * The manifest is written last, so a directory left behind by a failed
+ * create is not mistaken for a vault.
+ */
+int vault_create_sharded(const char* vault_dir, uint32_t shards) {
+    if (!vault_dir || shards == 0 || shards > VAULT_MAX_SHARDS) {
+        fprintf(stderr, "Shard count must be between 1 and %d\n", VAULT_MAX_SHARDS);
+        return -1;
+    }
+
+    char dir[VAULT_PATH_MAX];
+    expand_path(vault_dir, dir, sizeof(dir));
+    if (mkdir(dir, 0700) != 0) {
+        fprintf(stderr, "Failed to create vault directory %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    VaultManifest manifest;
+    memset(&manifest, 0, sizeof(manifest));
+    memcpy(manifest.magic, VAULT_MANIFEST_MAGIC, 4);
+    manifest.version = VAULT_MANIFEST_VERSION;
+    manifest.shard_count = shards;
+    if (RAND_bytes(manifest.salt, SALT_SIZE) != 1) {
+        fprintf(stderr, "Failed to generate salt\n");
+        return -1;
+    }
+
+    VaultHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, VAULT_MAGIC, 4);
+    header.version = VAULT_VERSION;
+    header.codec = g_compression;
+    memcpy(header.salt, manifest.salt, SALT_SIZE);
+
+    for (uint32_t s = 0; s < shards; s++) {
+        char path[VAULT_SHARD_PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s%03u", dir, VAULT_SHARD_PREFIX, s);
+        if (write_vault_file(path, &header, NULL, 0, NULL) != 0) {
+            return -1;
+        }
+    }
+    if (write_manifest(dir, &manifest) != 0) {
+        return -1;
+    }
+
+    printf("Created sharded vault: %s (%u shards)\n", dir, shards);
+    return 0;
+}
+
+/* A shard count of 1 writes an ordinary single-file vault. */
+int vault_reshard(const char* master_password, const char* source, const char* destination,
+                  uint32_t shards) {
+    if (!master_password || !source || !destination) {
+        return -1;
+    }
+    if (shards == 0 || shards > VAULT_MAX_SHARDS) {
+        fprintf(stderr, "Shard count must be between 1 and %d\n", VAULT_MAX_SHARDS);
+        return -1;
+    }
+    if (vault_exists(destination)) {
+        fprintf(stderr, "Destination already exists: %s\n", destination);
+        return -1;
+    }
+
+    vault_handle_t* src = vault_handle_open(master_password, source, VAULT_OPEN_READ_ONLY);
+    if (!src) {
+        return -1;
+    }
+    if (shards > 1 && vault_create_sharded(destination, shards) != 0) {
+        vault_handle_close(src);
+        return -1;
+    }
+
+    vault_handle_t* dst = vault_handle_open(master_password, destination, 0);
+    if (!dst) {
+        vault_handle_close(src);
+        return -1;
+    }
+    dst->auto_backup = false;
+    if (!g_compression_set) {
+        dst->header.codec = src->header.codec;
+    }
+
+    const vault_snapshot_t* snap = vault_snapshot_acquire(src);
+    int ret = vault_handle_begin_batch(dst);
+    for (uint32_t i = 0; ret == 0 && i < snap->count; i++) {
+        ret = vault_handle_put_entry(dst, snap->entries[i]);
+    }
+    if (ret == 0) {
+        ret = vault_handle_commit_batch(dst);
+    }
+    vault_snapshot_release(src, snap);
+
+    vault_handle_close(dst);
+    vault_handle_close(src);
+    return ret;
+}
+
 bool vault_verify_password(const char* vault_path, const char* master_password) {
     if (!vault_path || !master_password) {
         return false;
@@ -613,19 +3141,11 @@ bool vault_verify_password(const char* vault_path, const char* master_password)
         return false;
     }
 
-    FILE* fp = fopen(expanded_path, "rb");
-    if (!fp) {
-        return false;
-    }
-
     VaultHeader header;
-    if (read_vault_header(fp, &header) != 0) {
-        fclose(fp);
+    if (read_header_file(expanded_path, &header) != 0) {
         return false;
     }
 
-    fclose(fp);
-
     unsigned char key[32];
     if (derive_key_with_salt(master_password, header.salt, SALT_SIZE, key) != 0) {
         return false;
@@ -634,3 +3154,115 @@ bool vault_verify_password(const char* vault_path, const char* master_password)
     secure_cleanup(key, sizeof(key));
     return true;
 }
+
+/*
+ * The original single-vault API. Each call forwards to the process-wide
+ * default handle opened by vault_open().
+ */
+int vault_init(const char* master_password, const char* vault_path) {
+    return vault_open(master_password, vault_path, 0);
+}
+
+int vault_open(const char* master_password, const char* vault_path, unsigned int flags) {
+    if (g_vault) {
+        vault_cleanup();
+    }
+
+    g_vault = vault_handle_open(master_password, vault_path, flags);
+    return g_vault ? 0 : -1;
+}
+
+void vault_cleanup(void) {
+    if (!g_vault) {
+        return;
+    }
+
+    vault_handle_close(g_vault);
+    g_vault = NULL;
+    crypto_cleanup();
+}
+
+vault_handle_t* vault_default_handle(void) {
+    return g_vault;
+}
+
+bool vault_is_read_only(void) {
+    return vault_handle_is_read_only(g_vault);
+}
+
+int vault_sync(void) {
+    return vault_handle_sync(g_vault);
+}
+
+int vault_start_saver(int delay_ms, vault_save_error_fn on_error, void* context) {
+    return vault_handle_start_saver(g_vault, delay_ms, on_error, context);
+}
+
+int vault_flush(void) {
+    return vault_handle_flush(g_vault);
+}
+
+int vault_reload(void) {
+    return vault_handle_reload(g_vault);
+}
+
+int vault_watch(vault_reload_fn on_reload, void* context) {
+    return vault_handle_watch(g_vault, on_reload, context);
+}
+
+int vault_store(const char* service, const char* username,
+                const char* password, const char* totp_secret, bool force) {
+    return vault_handle_store(g_vault, service, username, password, totp_secret, force);
+}
+
+int vault_put_entry(const VaultEntry* entry) {
+    return vault_handle_put_entry(g_vault, entry);
+}
+
+int vault_begin_batch(void) {
+    return vault_handle_begin_batch(g_vault);
+}
+
+int vault_commit_batch(void) {
+    return vault_handle_commit_batch(g_vault);
+}
+
+int vault_get(const char* service, const char* username, VaultEntry* entry) {
+    return vault_handle_get(g_vault, service, username, entry);
+}
+
+int vault_get_entry_at(size_t index, VaultEntry* entry) {
+    return vault_handle_get_entry_at(g_vault, index, entry);
+}
+
+int vault_issue_otp(const char* service, const char* username, uint32_t* code, uint64_t* counter) {
+    return vault_handle_issue_otp(g_vault, service, username, code, counter);
+}
+
+int vault_list(void) {
+    return vault_handle_list(g_vault);
+}
+
+int vault_remove(const char* service, const char* username) {
+    return vault_handle_remove(g_vault, service, username);
+}
+
+int vault_remove_entry_at(size_t index) {
+    return vault_handle_remove_entry_at(g_vault, index);
+}
+
+int vault_change_master_password(const char* old_password, const char* new_password) {
+    return vault_handle_change_master_password(g_vault, old_password, new_password);
+}
+
+size_t vault_entry_count(void) {
+    return vault_handle_entry_count(g_vault);
+}
+
+int vault_find_entry(const char* service, const char* username) {
+    return vault_handle_find_entry(g_vault, service, username);
+}
+
+size_t vault_search(const char* query, size_t* matches, size_t max_matches) {
+    return vault_handle_search(g_vault, query, matches, max_matches);
+}
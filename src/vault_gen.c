@@ -0,0 +1,132 @@
+#include "vault_gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GEN_TIME_BASE 1600000000ull
+#define GEN_TIME_SPAN (5ull * 365 * 24 * 3600)
+
+static const char* service_names[] = {
+    "github", "google", "amazon", "netflix", "bank", "work-vpn", "reddit", "slack",
+    "dropbox", "paypal", "spotify", "gitlab", "mail", "router", "nas", "aws"
+};
+
+static const char* domains[] = {
+    "@gmail.com", "@outlook.com", "@example.com", "@proton.me", "@yahoo.com", "@icloud.com"
+};
+
+static const char base32_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+static const char lower_alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+/* splitmix64: every entry depends only on the seed and its index. */
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint32_t pick_length(uint64_t* state, vault_gen_range_t range) {
+    return range.min + (uint32_t)(next_random(state) % (range.max - range.min + 1));
+}
+
+static void fill_random(uint64_t* state, char* out, size_t len, const char* alphabet,
+                        size_t alphabet_len) {
+    for (size_t i = 0; i < len; i++) {
+        out[i] = alphabet[next_random(state) % alphabet_len];
+    }
+}
+
+void vault_gen_defaults(vault_gen_config_t* config) {
+    if (!config) return;
+
+    config->seed = VAULT_GEN_DEFAULT_SEED;
+    config->service_len = (vault_gen_range_t){8, 24};
+    config->username_len = (vault_gen_range_t){10, 32};
+    config->password_len = (vault_gen_range_t){12, 24};
+    config->totp_percent = 10;
+}
+
+/* Accepts "N" or "MIN-MAX" with 1 <= MIN <= MAX <= limit. */
+int vault_gen_parse_range(const char* text, uint32_t limit, vault_gen_range_t* range) {
+    if (!text || !range) return -1;
+
+    char* end;
+    unsigned long min = strtoul(text, &end, 10);
+    unsigned long max = min;
+    if (end == text) return -1;
+    if (*end == '-') {
+        const char* rest = end + 1;
+        max = strtoul(rest, &end, 10);
+        if (end == rest) return -1;
+    }
+    if (*end != '\0' || min < 1 || min > max || max > limit) return -1;
+
+    range->min = (uint32_t)min;
+    range->max = (uint32_t)max;
+    return 0;
+}
+
+/*
+ * The service always ends in "-<index>" so every generated entry has its own
+ * key; a length too short for the suffix is stretched to fit it.
+ */
+void vault_gen_entry(const vault_gen_config_t* config, size_t index, VaultEntry* entry) {
+    memset(entry, 0, sizeof(*entry));
+    uint64_t state = config->seed ^ ((uint64_t)index * 0xD1B54A32D192ED03ull);
+
+    char suffix[24];
+    int suffix_len = snprintf(suffix, sizeof(suffix), "-%zu", index);
+    uint32_t len = pick_length(&state, config->service_len);
+    if (len < (uint32_t)suffix_len + 1) len = (uint32_t)suffix_len + 1;
+    if (len > VAULT_SERVICE_LEN - 1) len = VAULT_SERVICE_LEN - 1;
+    size_t prefix_len = len - (size_t)suffix_len;
+    const char* name = service_names[next_random(&state) %
+                                     (sizeof(service_names) / sizeof(service_names[0]))];
+    size_t name_len = strlen(name) < prefix_len ? strlen(name) : prefix_len;
+    memcpy(entry->service, name, name_len);
+    fill_random(&state, entry->service + name_len, prefix_len - name_len, lower_alphabet, 26);
+    memcpy(entry->service + prefix_len, suffix, (size_t)suffix_len);
+
+    len = pick_length(&state, config->username_len);
+    const char* domain = domains[next_random(&state) % (sizeof(domains) / sizeof(domains[0]))];
+    size_t domain_len = strlen(domain);
+    if (len > domain_len) {
+        fill_random(&state, entry->username, len - domain_len, lower_alphabet,
+                    sizeof(lower_alphabet) - 1);
+        memcpy(entry->username + len - domain_len, domain, domain_len);
+    } else {
+        fill_random(&state, entry->username, len, lower_alphabet, sizeof(lower_alphabet) - 1);
+    }
+
+    len = pick_length(&state, config->password_len);
+    for (uint32_t i = 0; i < len; i++) {
+        entry->password[i] = (char)('!' + next_random(&state) % 94);
+    }
+
+    if (next_random(&state) % 100 < config->totp_percent) {
+        fill_random(&state, entry->totp_secret, 32, base32_alphabet, 32);
+        entry->totp_period = 30;
+        entry->totp_digits = 6;
+    }
+    entry->password_updated_at = GEN_TIME_BASE + next_random(&state) % GEN_TIME_SPAN;
+}
+
+/* Adds entries first .. first + count - 1 in one batch and saves once. */
+int vault_gen_fill(vault_handle_t* vault, const vault_gen_config_t* config, size_t first,
+                   size_t count) {
+    if (!vault || !config) return -1;
+
+    if (vault_handle_begin_batch(vault) != 0) {
+        return -1;
+    }
+    for (size_t i = first; i < first + count; i++) {
+        VaultEntry entry;
+        vault_gen_entry(config, i, &entry);
+        if (vault_handle_put_entry(vault, &entry) != 0) {
+            vault_handle_commit_batch(vault);
+            return -1;
+        }
+    }
+    return vault_handle_commit_batch(vault);
+}
@@ -0,0 +1,76 @@
+#include "vault_refs.h"
+#include "vault_controller.h"
+#include "crypto_engine.h"
+#include "totp_engine.h"
+#include <stdio.h>
+#include <string.h>
+
+static const struct {
+    ref_field_t field;
+    const char* name;
+} field_names[] = {
+    {REF_FIELD_PASSWORD, "password"},
+    {REF_FIELD_USERNAME, "username"},
+    {REF_FIELD_SERVICE, "service"},
+    {REF_FIELD_TOTP, "totp"},
+    {REF_FIELD_TOTP_SECRET, "totp_secret"}
+};
+
+int vault_ref_parse_field(const char* name, ref_field_t* field) {
+    if (!name || !field) return -1;
+
+    for (size_t i = 0; i < sizeof(field_names) / sizeof(field_names[0]); i++) {
+        if (strcmp(field_names[i].name, name) == 0) {
+            *field = field_names[i].field;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* vault_ref_field_name(ref_field_t field) {
+    for (size_t i = 0; i < sizeof(field_names) / sizeof(field_names[0]); i++) {
+        if (field_names[i].field == field) return field_names[i].name;
+    }
+    return "unknown";
+}
+
+int vault_ref_value(const vault_ref_t* ref, char* out, size_t out_len) {
+    if (!ref || !out || out_len == 0 || ref->entry_index < 0) return -1;
+
+    VaultEntry entry;
+    if (vault_get_entry_at((size_t)ref->entry_index, &entry) != 0) return -1;
+
+    int written = -1;
+    switch (ref->field) {
+        case REF_FIELD_PASSWORD:
+            written = snprintf(out, out_len, "%s", entry.password);
+            break;
+        case REF_FIELD_USERNAME:
+            written = snprintf(out, out_len, "%s", entry.username);
+            break;
+        case REF_FIELD_SERVICE:
+            written = snprintf(out, out_len, "%s", entry.service);
+            break;
+        case REF_FIELD_TOTP_SECRET:
+            written = snprintf(out, out_len, "%s", entry.totp_secret);
+            break;
+        case REF_FIELD_TOTP:
+            /* HOTP codes are single-use and references are resolved from a read-only vault. */
+            if (entry.totp_type == OTP_TYPE_HOTP) {
+                fprintf(stderr, "Error: '%s' (%s) uses HOTP; issue its codes with 'securekey totp'\n",
+                        entry.service, entry.username);
+            } else if (entry.totp_secret[0] != '\0') {
+                int digits = entry.totp_digits ? entry.totp_digits : TOTP_DEFAULT_DIGITS;
+                written = snprintf(out, out_len, "%0*u", digits, vault_entry_otp(&entry));
+            }
+            break;
+    }
+
+    secure_cleanup(&entry, sizeof(entry));
+    if (written < 0 || (size_t)written >= out_len) {
+        secure_cleanup(out, out_len);
+        return -1;
+    }
+    return written;
+}
@@ -0,0 +1,166 @@
+#include "vault_stats.h"
+#include "crypto_engine.h"
+#include "utilities.h"
+#include "vault_codec.h"
+#include <string.h>
+
+#define STATS_FIXED_BYTES (sizeof(VaultEntry) - VAULT_SERVICE_LEN - VAULT_USERNAME_LEN - \
+                           VAULT_PASSWORD_LEN - VAULT_TOTP_LEN)
+
+static const char* field_names[STATS_FIELD_COUNT] = {
+    "service", "username", "password", "totp_secret"
+};
+
+static const char* bucket_labels[STATS_LENGTH_BUCKETS] = {
+    "0", "1-8", "9-16", "17-32", "33-64", "65-128", "129+"
+};
+
+const char* stats_field_name(stats_field_t field) {
+    return field < STATS_FIELD_COUNT ? field_names[field] : "unknown";
+}
+
+const char* stats_bucket_label(int bucket) {
+    return bucket >= 0 && bucket < STATS_LENGTH_BUCKETS ? bucket_labels[bucket] : "unknown";
+}
+
+static int length_bucket(size_t length) {
+    int bucket = 0;
+    if (length > 0) {
+        bucket = 1;
+        for (size_t limit = 8; length > limit && bucket < STATS_LENGTH_BUCKETS - 1; limit <<= 1) {
+            bucket++;
+        }
+    }
+    return bucket;
+}
+
+static void add_length(stats_histogram_t* histogram, const char* field, size_t capacity) {
+    size_t length = strnlen(field, capacity);
+    histogram->counts[length_bucket(length)]++;
+    histogram->total_length += length;
+    if (length > histogram->max_length) {
+        histogram->max_length = length;
+    }
+}
+
+/* The unlock figures are this process's own open of the vault. */
+int vault_stats_collect(vault_handle_t* vault, vault_stats_t* stats) {
+    if (!vault || !stats) return -1;
+
+    memset(stats, 0, sizeof(*stats));
+    if (vault_handle_layout(vault, &stats->layout) != 0) {
+        return -1;
+    }
+    vault_handle_open_timings(vault, &stats->unlock);
+    stats->kdf_name = KDF_NAME;
+    stats->kdf_iterations = KDF_ITERATIONS;
+
+    size_t count = vault_handle_entry_count(vault);
+    VaultEntry entry;
+    for (size_t i = 0; i < count; i++) {
+        if (vault_handle_get_entry_at(vault, i, &entry) != 0) {
+            secure_cleanup(&entry, sizeof(entry));
+            return -1;
+        }
+        add_length(&stats->fields[STATS_FIELD_SERVICE], entry.service, sizeof(entry.service));
+        add_length(&stats->fields[STATS_FIELD_USERNAME], entry.username, sizeof(entry.username));
+        add_length(&stats->fields[STATS_FIELD_PASSWORD], entry.password, sizeof(entry.password));
+        add_length(&stats->fields[STATS_FIELD_TOTP], entry.totp_secret, sizeof(entry.totp_secret));
+        if (entry.totp_secret[0]) {
+            stats->totp_entries++;
+        }
+    }
+    secure_cleanup(&entry, sizeof(entry));
+
+    stats->entries = count;
+    stats->allocated_bytes = (uint64_t)count * sizeof(VaultEntry);
+    stats->useful_bytes = (uint64_t)count * STATS_FIXED_BYTES;
+    for (int f = 0; f < STATS_FIELD_COUNT; f++) {
+        stats->useful_bytes += stats->fields[f].total_length;
+    }
+    return 0;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+static double mib(uint64_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+void vault_stats_print(const vault_stats_t* stats, FILE* out) {
+    if (!stats || !out) return;
+
+    const vault_layout_t* layout = &stats->layout;
+    fprintf(out, "Entries:           %zu (%zu with TOTP)\n", stats->entries, stats->totp_entries);
+    fprintf(out, "Entry size:        %zu bytes allocated per entry\n", sizeof(VaultEntry));
+    fprintf(out, "Useful bytes:      %llu of %llu allocated (%.1f%%, %.2f MiB padding)\n",
+            (unsigned long long)stats->useful_bytes, (unsigned long long)stats->allocated_bytes,
+            percent(stats->useful_bytes, stats->allocated_bytes),
+            mib(stats->allocated_bytes - stats->useful_bytes));
+    fprintf(out, "Format:            version %u, %s, %u shard%s\n", layout->version,
+            vault_codec_name(layout->codec), layout->shards, layout->shards == 1 ? "" : "s");
+    fprintf(out, "File size:         %llu bytes (%llu ciphertext, %.1f%% of allocated)\n",
+            (unsigned long long)layout->file_bytes, (unsigned long long)layout->ciphertext_bytes,
+            percent(layout->ciphertext_bytes, stats->allocated_bytes));
+    if (layout->shards == 1) {
+        fprintf(out, "Backup size:       %llu bytes\n", (unsigned long long)layout->backup_bytes);
+    }
+    fprintf(out, "KDF:               %s, %u iterations\n", stats->kdf_name, stats->kdf_iterations);
+    fprintf(out, "Unlock:            %.1f ms (read %.1f, kdf %.1f, decrypt %.1f)\n",
+            stats->unlock.total_ms, stats->unlock.read_ms, stats->unlock.kdf_ms,
+            stats->unlock.decrypt_ms);
+
+    fprintf(out, "\nField lengths:   ");
+    for (int b = 0; b < STATS_LENGTH_BUCKETS; b++) {
+        fprintf(out, " %7s", bucket_labels[b]);
+    }
+    fprintf(out, " %7s %7s\n", "max", "mean");
+    for (int f = 0; f < STATS_FIELD_COUNT; f++) {
+        const stats_histogram_t* histogram = &stats->fields[f];
+        fprintf(out, "  %-14s", field_names[f]);
+        for (int b = 0; b < STATS_LENGTH_BUCKETS; b++) {
+            fprintf(out, " %7zu", histogram->counts[b]);
+        }
+        fprintf(out, " %7zu %7.1f\n", histogram->max_length,
+                stats->entries ? (double)histogram->total_length / stats->entries : 0.0);
+    }
+}
+
+int vault_stats_write_json(const vault_stats_t* stats, FILE* out) {
+    if (!stats || !out) return -1;
+
+    const vault_layout_t* layout = &stats->layout;
+    fprintf(out, "{\n  \"entries\": %zu,\n  \"totp_entries\": %zu,\n", stats->entries,
+            stats->totp_entries);
+    fprintf(out, "  \"entry_size\": %zu,\n  \"useful_bytes\": %llu,\n  \"allocated_bytes\": %llu,\n",
+            sizeof(VaultEntry), (unsigned long long)stats->useful_bytes,
+            (unsigned long long)stats->allocated_bytes);
+    fprintf(out, "  \"layout\": {\"version\": %u, \"codec\": ", layout->version);
+    json_write_string(out, vault_codec_name(layout->codec));
+    fprintf(out, ", \"shards\": %u, \"file_bytes\": %llu, \"ciphertext_bytes\": %llu, "
+                 "\"backup_bytes\": %llu},\n",
+            layout->shards, (unsigned long long)layout->file_bytes,
+            (unsigned long long)layout->ciphertext_bytes, (unsigned long long)layout->backup_bytes);
+    fprintf(out, "  \"kdf\": {\"name\": ");
+    json_write_string(out, stats->kdf_name);
+    fprintf(out, ", \"iterations\": %u},\n", stats->kdf_iterations);
+    fprintf(out, "  \"unlock_ms\": {\"read\": %.3f, \"kdf\": %.3f, \"decrypt\": %.3f, "
+                 "\"total\": %.3f},\n",
+            stats->unlock.read_ms, stats->unlock.kdf_ms, stats->unlock.decrypt_ms,
+            stats->unlock.total_ms);
+    fprintf(out, "  \"fields\": {");
+    for (int f = 0; f < STATS_FIELD_COUNT; f++) {
+        const stats_histogram_t* histogram = &stats->fields[f];
+        fprintf(out, "%s\n    \"%s\": {\"max\": %zu, \"total\": %llu, \"histogram\": {", f ? "," : "",
+                field_names[f], histogram->max_length,
+                (unsigned long long)histogram->total_length);
+        for (int b = 0; b < STATS_LENGTH_BUCKETS; b++) {
+            fprintf(out, "%s\"%s\": %zu", b ? ", " : "", bucket_labels[b], histogram->counts[b]);
+        }
+        fprintf(out, "}}");
+    }
+    fprintf(out, "\n  }\n}\n");
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+extern "C" {
+    #include "vault_controller.h"
+    #include "vault_audit.h"
+    #include "breach_check.h"
+}
+
+class AuditTest : public ::testing::Test {
+protected:
+    const char* test_vault_path = "/tmp/test_audit_vault.dat";
+    const char* test_backup_path = "/tmp/test_audit_vault.dat.backup";
+    const char* master_password = "audit_master_password";
+    audit_options_t options;
+    audit_report_t report;
+
+    void SetUp() override {
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        memset(&report, 0, sizeof(report));
+        audit_options_default(&options);
+
+        ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+        ASSERT_EQ(vault_begin_batch(), 0);
+        ASSERT_EQ(vault_store("github", "alice", "x7#Kq9!vLm2$Wp4z", "JBSWY3DPEHPK3PXP", true), 0);
+        ASSERT_EQ(vault_store("gitlab", "alice", "Qz8!vR2#mK9@pL4w", NULL, true), 0);
+        ASSERT_EQ(vault_store("bitbucket", "alice", "Qz8!vR2#mK9@pL4w", NULL, true), 0);
+        ASSERT_EQ(vault_store("forum", "bob", "password", NULL, true), 0);
+
+        VaultEntry old_entry;
+        memset(&old_entry, 0, sizeof(old_entry));
+        strcpy(old_entry.service, "bank");
+        strcpy(old_entry.username, "carol");
+        strcpy(old_entry.password, "Wn3$Tb7!rY5^hJ2&");
+        strcpy(old_entry.totp_secret, "JBSWY3DPEHPK3PXP");
+        old_entry.password_updated_at = (uint64_t)time(NULL) - 400 * 86400ULL;
+        ASSERT_EQ(vault_put_entry(&old_entry), 0);
+        ASSERT_EQ(vault_commit_batch(), 0);
+    }
+
+    void TearDown() override {
+        audit_report_free(&report);
+        vault_cleanup();
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+    }
+
+    const audit_entry_result_t& result_for(const char* service) {
+        for (size_t i = 0; i < report.total; i++) {
+            VaultEntry entry;
+            if (vault_get_entry_at(i, &entry) == 0 && strcmp(entry.service, service) == 0) {
+                return report.entries[i];
+            }
+        }
+        static audit_entry_result_t missing;
+        ADD_FAILURE() << "No audit result for " << service;
+        return missing;
+    }
+};
+
+TEST_F(AuditTest, FlagsReusedWeakMissingTotpAndStale) {
+    ASSERT_EQ(vault_audit(&options, &report), 0);
+
+    EXPECT_EQ(report.total, 5u);
+    EXPECT_EQ(report.reused, 2u);
+    EXPECT_EQ(report.reuse_groups, 1u);
+    EXPECT_EQ(report.weak, 1u);
+    EXPECT_EQ(report.breached, 0u);
+    EXPECT_EQ(report.no_totp, 3u);
+    EXPECT_EQ(report.stale, 1u);
+    EXPECT_EQ(report.undated, 0u);
+    EXPECT_FALSE(report.breach_checked);
+
+    EXPECT_EQ(result_for("github").flags, 0u);
+    EXPECT_EQ(result_for("gitlab").flags, AUDIT_FLAG_REUSED | AUDIT_FLAG_NO_TOTP);
+    EXPECT_EQ(result_for("gitlab").reuse_group, result_for("bitbucket").reuse_group);
+    EXPECT_EQ(result_for("gitlab").reuse_count, 2u);
+    EXPECT_TRUE(result_for("forum").flags & AUDIT_FLAG_WEAK);
+    EXPECT_EQ(result_for("bank").flags, AUDIT_FLAG_STALE);
+    EXPECT_GE(result_for("bank").age_days, 400);
+}
+
+TEST_F(AuditTest, ThreadCountDoesNotChangeResults) {
+    options.threads = 1;
+    ASSERT_EQ(vault_audit(&options, &report), 0);
+    std::vector<unsigned int> single;
+    for (size_t i = 0; i < report.total; i++) single.push_back(report.entries[i].flags);
+    audit_report_free(&report);
+
+    options.threads = 4;
+    ASSERT_EQ(vault_audit(&options, &report), 0);
+    ASSERT_EQ(report.total, single.size());
+    for (size_t i = 0; i < report.total; i++) {
+        EXPECT_EQ(report.entries[i].flags, single[i]);
+    }
+}
+
+TEST_F(AuditTest, ReportsBreachedPasswords) {
+    const char* dump_path = "/tmp/test_audit_dump.txt";
+    const char* db_path = "/tmp/test_audit_breach.db";
+    FILE* dump = fopen(dump_path, "w+");
+    ASSERT_NE(dump, nullptr);
+    fputs("5BAA61E4C9B93F3F0682250B6CF8331B7EE68FD8:9545824\n", dump);
+    rewind(dump);
+
+    breach_build_stats_t stats;
+    ASSERT_EQ(breach_db_build(dump, db_path, NULL, &stats), 0);
+    fclose(dump);
+
+    breach_db_t db;
+    ASSERT_EQ(breach_db_open(&db, db_path), 0);
+    options.breach_db = &db;
+
+    ASSERT_EQ(vault_audit(&options, &report), 0);
+    EXPECT_TRUE(report.breach_checked);
+    EXPECT_EQ(report.breached, 1u);
+    EXPECT_TRUE(result_for("forum").flags & AUDIT_FLAG_BREACHED);
+    EXPECT_EQ(result_for("forum").breach_count, 9545824u);
+
+    breach_db_close(&db);
+    remove(dump_path);
+    remove(db_path);
+}
+
+TEST_F(AuditTest, JsonReportOmitsPasswords) {
+    ASSERT_EQ(vault_audit(&options, &report), 0);
+
+    char* buffer = NULL;
+    size_t size = 0;
+    FILE* out = open_memstream(&buffer, &size);
+    ASSERT_NE(out, nullptr);
+    ASSERT_EQ(audit_report_write_json(&report, out), 0);
+    fclose(out);
+
+    std::string json(buffer, size);
+    free(buffer);
+
+    EXPECT_NE(json.find("\"entries\": 5"), std::string::npos);
+    EXPECT_NE(json.find("\"reuse_groups\": 1"), std::string::npos);
+    EXPECT_NE(json.find("\"service\": \"gitlab\""), std::string::npos);
+    EXPECT_NE(json.find("\"stale\""), std::string::npos);
+    EXPECT_EQ(json.find("\"service\": \"github\""), std::string::npos);
+    EXPECT_EQ(json.find("Qz8!vR2#mK9@pL4w"), std::string::npos);
+    EXPECT_EQ(json.find("password\""), std::string::npos);
+}
+
+TEST_F(AuditTest, OtpOnlyEntriesAreNotJudgedAsPasswords) {
+    VaultEntry otp_entry;
+    memset(&otp_entry, 0, sizeof(otp_entry));
+    strcpy(otp_entry.service, "imported");
+    strcpy(otp_entry.username, "dave");
+    strcpy(otp_entry.totp_secret, "JBSWY3DPEHPK3PXP");
+    otp_entry.password_updated_at = (uint64_t)time(NULL) - 400 * 86400ULL;
+    ASSERT_EQ(vault_put_entry(&otp_entry), 0);
+
+    ASSERT_EQ(vault_audit(&options, &report), 0);
+
+    EXPECT_EQ(report.total, 6u);
+    EXPECT_EQ(report.otp_only, 1u);
+    EXPECT_EQ(report.weak, 1u);
+    EXPECT_EQ(report.stale, 1u);
+    EXPECT_EQ(report.undated, 0u);
+    EXPECT_EQ(result_for("imported").flags, AUDIT_FLAG_OTP_ONLY);
+    EXPECT_STREQ(audit_flag_name(AUDIT_FLAG_OTP_ONLY), "otp_only");
+}
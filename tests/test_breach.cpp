@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+extern "C" {
+    #include "breach_check.h"
+}
+
+static const char* kDumpPath = "/tmp/test_breach_dump.txt";
+static const char* kDbPath = "/tmp/test_breach.db";
+
+static const char* kSortedDump =
+    "5BAA61E4C9B93F3F0682250B6CF8331B7EE68FD8:9545824\r\n"
+    "7C4A8D09CA3762AF61E59520943DC26494F8941B:37359195\r\n"
+    "7c4a8d09ca3762af61e59520943dc26494f8941b:5\r\n"
+    "not-a-hash\r\n"
+    "B1B3773A05C0ED0176787A4F1574FF0075F7521E:10556095\r\n"
+    "F3BBBD66A63D4BF1747940578EC3D0103530E21D:30\r\n";
+
+class BreachCheckTest : public ::testing::Test {
+protected:
+    breach_db_t db;
+    breach_build_stats_t stats;
+
+    void SetUp() override {
+        memset(&db, 0, sizeof(db));
+        write_dump(kSortedDump);
+    }
+
+    void TearDown() override {
+        breach_db_close(&db);
+        remove(kDumpPath);
+        remove(kDbPath);
+    }
+
+    void write_dump(const char* contents) {
+        FILE* fp = fopen(kDumpPath, "w");
+        ASSERT_NE(fp, nullptr);
+        fputs(contents, fp);
+        fclose(fp);
+    }
+
+    int build(int prefix_bits, int bloom_bits) {
+        breach_build_options_t options = {prefix_bits, bloom_bits};
+        FILE* input = fopen(kDumpPath, "r");
+        if (!input) return -1;
+        int ret = breach_db_build(input, kDbPath, &options, &stats);
+        fclose(input);
+        return ret;
+    }
+};
+
+TEST_F(BreachCheckTest, BuildsAndFindsKnownPasswords) {
+    ASSERT_EQ(build(0, 0), 0);
+    EXPECT_EQ(stats.records, 4u);
+    EXPECT_EQ(stats.duplicates, 1u);
+    EXPECT_EQ(stats.skipped, 1u);
+
+    ASSERT_EQ(breach_db_open(&db, kDbPath), 0);
+    EXPECT_EQ(db.header->prefix_bits, (uint32_t)BREACH_MIN_PREFIX_BITS);
+
+    uint32_t count = 0;
+    EXPECT_EQ(breach_db_check_password(&db, "password", &count), 1);
+    EXPECT_EQ(count, 9545824u);
+    EXPECT_EQ(breach_db_check_password(&db, "123456", &count), 1);
+    EXPECT_EQ(count, 37359200u);
+    EXPECT_EQ(breach_db_check_password(&db, "hunter2", &count), 1);
+    EXPECT_EQ(breach_db_check_password(&db, "letmein", &count), 0);
+    EXPECT_EQ(count, 0u);
+    EXPECT_EQ(breach_db_check_password(&db, "correcthorsebatterystaple", &count), 0);
+}
+
+TEST_F(BreachCheckTest, BloomFilterAndWidePrefixAgree) {
+    ASSERT_EQ(build(BREACH_MAX_PREFIX_BITS, 10), 0);
+    ASSERT_EQ(breach_db_open(&db, kDbPath), 0);
+    EXPECT_EQ(db.header->prefix_bits, (uint32_t)BREACH_MAX_PREFIX_BITS);
+    EXPECT_GT(db.header->bloom_hashes, 0u);
+    ASSERT_NE(db.bloom, nullptr);
+
+    const char* present[] = {"password", "123456", "qwerty", "hunter2"};
+    for (const char* password : present) {
+        EXPECT_EQ(breach_db_check_password(&db, password, NULL), 1) << password;
+    }
+
+    int false_positives = 0;
+    for (int i = 0; i < 1000; i++) {
+        std::string candidate = "absent-" + std::to_string(i);
+        false_positives += breach_db_check_password(&db, candidate.c_str(), NULL);
+    }
+    EXPECT_EQ(false_positives, 0);
+}
+
+TEST_F(BreachCheckTest, RejectsUnsortedInput) {
+    write_dump("F3BBBD66A63D4BF1747940578EC3D0103530E21D:30\n"
+               "5BAA61E4C9B93F3F0682250B6CF8331B7EE68FD8:9545824\n");
+    EXPECT_EQ(build(0, 0), -1);
+
+    FILE* fp = fopen(kDbPath, "r");
+    EXPECT_EQ(fp, nullptr) << "Partial database should be removed";
+    if (fp) fclose(fp);
+}
+
+TEST_F(BreachCheckTest, RejectsCorruptDatabase) {
+    ASSERT_EQ(build(0, 0), 0);
+
+    FILE* fp = fopen(kDbPath, "r+b");
+    ASSERT_NE(fp, nullptr);
+    fseek(fp, offsetof(breach_db_header_t, record_count), SEEK_SET);
+    uint64_t bogus = 1000000;
+    fwrite(&bogus, sizeof(bogus), 1, fp);
+    fclose(fp);
+
+    EXPECT_EQ(breach_db_open(&db, kDbPath), -1);
+    EXPECT_EQ(breach_db_open(&db, "/tmp/does_not_exist.db"), -1);
+    EXPECT_EQ(breach_db_check_password(&db, "password", NULL), -1);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+extern "C" {
+    #include "vault_controller.h"
+    #include "vault_codec.h"
+    #include "crypto_engine.h"
+}
+#include "vault_test_util.h"
+
+class VaultCodecTest : public VaultFileTest {
+protected:
+    VaultCodecTest() : VaultFileTest("/tmp/test_codec_vault.dat", "codec_master_password") {}
+
+    void TearDown() override {
+        vault_set_compression(VAULT_CODEC_NONE);
+        VaultFileTest::TearDown();
+    }
+
+    static VaultEntry make_entry(int i) {
+        char service[64], username[64], password[64];
+        snprintf(service, sizeof(service), "service%d.example.com", i);
+        snprintf(username, sizeof(username), "user%d@gmail.com", i);
+        snprintf(password, sizeof(password), "Pw-%d-x7Q!", i);
+        return make_test_entry(service, username, password);
+    }
+
+    void fill_vault(int count) {
+        vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+        ASSERT_NE(vault, nullptr);
+        ASSERT_EQ(vault_handle_begin_batch(vault), 0);
+        for (int i = 0; i < count; i++) {
+            VaultEntry entry = make_entry(i);
+            ASSERT_EQ(vault_handle_put_entry(vault, &entry), 0);
+        }
+        ASSERT_EQ(vault_handle_commit_batch(vault), 0);
+        vault_handle_close(vault);
+    }
+
+    VaultHeader read_header() {
+        VaultHeader header;
+        memset(&header, 0, sizeof(header));
+        FILE* fp = fopen(test_vault_path, "rb");
+        EXPECT_NE(fp, nullptr);
+        if (fp) {
+            EXPECT_EQ(fread(&header, sizeof(header), 1, fp), 1u);
+            fclose(fp);
+        }
+        return header;
+    }
+};
+
+TEST_F(VaultCodecTest, RoundTripsEveryAvailableCodec) {
+    std::vector<VaultEntry> entries;
+    for (int i = 0; i < 50; i++) {
+        entries.push_back(make_entry(i));
+    }
+    size_t size = entries.size() * sizeof(VaultEntry);
+
+    const vault_codec_t codecs[] = {VAULT_CODEC_NONE, VAULT_CODEC_ZLIB, VAULT_CODEC_ZLIB_DICT,
+                                    VAULT_CODEC_ZSTD, VAULT_CODEC_ZSTD_DICT};
+    for (vault_codec_t codec : codecs) {
+        if (!vault_codec_available(codec)) {
+            EXPECT_NE(vault_set_compression(codec), 0);
+            continue;
+        }
+        std::vector<unsigned char> packed(vault_codec_bound(codec, size));
+        size_t packed_size = packed.size();
+        ASSERT_EQ(vault_codec_compress(codec, entries.data(), size, packed.data(), &packed_size), 0)
+            << vault_codec_name(codec);
+        if (codec != VAULT_CODEC_NONE) {
+            EXPECT_LT(packed_size, size / 10) << vault_codec_name(codec);
+        }
+
+        std::vector<VaultEntry> out(entries.size());
+        ASSERT_EQ(vault_codec_decompress(codec, packed.data(), packed_size, out.data(), size), 0);
+        EXPECT_EQ(memcmp(out.data(), entries.data(), size), 0);
+        EXPECT_NE(vault_codec_decompress(codec, packed.data(), packed_size, out.data(),
+                                         size - sizeof(VaultEntry)), 0);
+    }
+}
+
+TEST_F(VaultCodecTest, DictionaryHelpsSmallPayloads) {
+    VaultEntry entry = make_entry(1);
+    unsigned char plain[256], dict[256];
+    size_t plain_size = sizeof(plain), dict_size = sizeof(dict);
+    ASSERT_EQ(vault_codec_compress(VAULT_CODEC_ZLIB, &entry, sizeof(entry), plain, &plain_size), 0);
+    ASSERT_EQ(vault_codec_compress(VAULT_CODEC_ZLIB_DICT, &entry, sizeof(entry), dict, &dict_size), 0);
+    EXPECT_LT(dict_size, plain_size);
+}
+
+TEST_F(VaultCodecTest, CompressedVaultReopens) {
+    ASSERT_EQ(vault_set_compression(VAULT_CODEC_ZLIB_DICT), 0);
+    fill_vault(200);
+
+    VaultHeader header = read_header();
+    EXPECT_EQ(header.version, (uint32_t)VAULT_VERSION);
+    EXPECT_EQ(header.codec, (uint32_t)VAULT_CODEC_ZLIB_DICT);
+    EXPECT_EQ(header.entry_count, 200u);
+    EXPECT_LT(test_file_size(test_vault_path), (off_t)(200 * sizeof(VaultEntry) / 10));
+
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_compression(vault), VAULT_CODEC_ZLIB_DICT);
+    EXPECT_EQ(vault_handle_entry_count(vault), 200u);
+    VaultEntry out;
+    ASSERT_EQ(vault_handle_get(vault, "service123.example.com", "user123@gmail.com", &out), 0);
+    EXPECT_STREQ(out.password, "Pw-123-x7Q!");
+    vault_handle_close(vault);
+
+    ASSERT_EQ(vault_set_compression(VAULT_CODEC_NONE), 0);
+    vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    VaultEntry extra = make_entry(500);
+    ASSERT_EQ(vault_handle_put_entry(vault, &extra), 0);
+    vault_handle_close(vault);
+    EXPECT_EQ(read_header().codec, (uint32_t)VAULT_CODEC_NONE);
+    EXPECT_GT(test_file_size(test_vault_path), (off_t)(201 * sizeof(VaultEntry)));
+}
+
+TEST_F(VaultCodecTest, ReshardConvertsCodec) {
+    const char* converted_path = "/tmp/test_codec_converted.dat";
+    unlink(converted_path);
+    fill_vault(200);
+    EXPECT_EQ(read_header().codec, (uint32_t)VAULT_CODEC_NONE);
+
+    ASSERT_EQ(vault_set_compression(VAULT_CODEC_ZLIB_DICT), 0);
+    ASSERT_EQ(vault_reshard(master_password, test_vault_path, converted_path, 1), 0);
+
+    vault_handle_t* vault = vault_handle_open(master_password, converted_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_compression(vault), VAULT_CODEC_ZLIB_DICT);
+    EXPECT_EQ(vault_handle_entry_count(vault), 200u);
+    VaultEntry out;
+    ASSERT_EQ(vault_handle_get(vault, "service42.example.com", "user42@gmail.com", &out), 0);
+    EXPECT_STREQ(out.password, "Pw-42-x7Q!");
+    vault_handle_close(vault);
+
+    struct stat st;
+    ASSERT_EQ(stat(converted_path, &st), 0);
+    EXPECT_LT(st.st_size, test_file_size(test_vault_path) / 10);
+    unlink(converted_path);
+    unlink((std::string(converted_path) + ".lock").c_str());
+}
+
+TEST_F(VaultCodecTest, TamperedPayloadIsRejected) {
+    ASSERT_EQ(vault_set_compression(VAULT_CODEC_ZLIB), 0);
+    fill_vault(100);
+
+    FILE* fp = fopen(test_vault_path, "r+b");
+    ASSERT_NE(fp, nullptr);
+    long offset = (long)sizeof(VaultHeader) + (long)(test_file_size(test_vault_path) - sizeof(VaultHeader)) / 2;
+    fseek(fp, offset, SEEK_SET);
+    int byte = fgetc(fp);
+    fseek(fp, offset, SEEK_SET);
+    fputc(byte ^ 0x40, fp);
+    fclose(fp);
+
+    EXPECT_EQ(vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), nullptr);
+}
+
+TEST_F(VaultCodecTest, ReadsVersion3Files) {
+    std::vector<VaultEntry> entries = {make_entry(1), make_entry(2)};
+    VaultHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, VAULT_MAGIC, 4);
+    header.version = 3;
+    memset(header.salt, 0x3C, SALT_SIZE);
+    header.entry_count = 2;
+
+    unsigned char key[KEY_LEN];
+    ASSERT_EQ(derive_key_with_salt(master_password, header.salt, SALT_SIZE, key), 0);
+    std::vector<unsigned char> ciphertext(2 * sizeof(VaultEntry) + 64);
+    int cipher_len = encrypt_data((unsigned char*)entries.data(), 2 * sizeof(VaultEntry), key,
+                                  ciphertext.data());
+    ASSERT_GT(cipher_len, 0);
+
+    FILE* fp = fopen(test_vault_path, "wb");
+    ASSERT_NE(fp, nullptr);
+    fwrite(&header, offsetof(VaultHeader, codec), 1, fp);
+    fwrite(ciphertext.data(), 1, cipher_len, fp);
+    fclose(fp);
+
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_compression(vault), VAULT_CODEC_NONE);
+    VaultEntry out;
+    ASSERT_EQ(vault_handle_get(vault, "service2.example.com", "user2@gmail.com", &out), 0);
+    EXPECT_STREQ(out.password, "Pw-2-x7Q!");
+    VaultEntry extra = make_entry(3);
+    ASSERT_EQ(vault_handle_put_entry(vault, &extra), 0);
+    vault_handle_close(vault);
+
+    EXPECT_EQ(read_header().version, (uint32_t)VAULT_VERSION);
+    vault = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_entry_count(vault), 3u);
+    vault_handle_close(vault);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
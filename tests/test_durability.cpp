@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <cstdio>
+#include <cstring>
+extern "C" {
+    #include "vault_controller.h"
+}
+
+static int g_crash_stage = -1;
+
+static void crash_at_stage(vault_save_stage_t stage) {
+    if ((int)stage == g_crash_stage) {
+        _exit(42);
+    }
+}
+
+static int g_saves = 0;
+
+static void count_saves(vault_save_stage_t stage) {
+    if (stage == VAULT_SAVE_RENAMED) {
+        g_saves++;
+    }
+}
+
+class VaultDurabilityTest : public ::testing::Test {
+protected:
+    const char* test_vault_path = "/tmp/test_durability_vault.dat";
+    const char* test_backup_path = "/tmp/test_durability_vault.dat.backup";
+    const char* test_lock_path = "/tmp/test_durability_vault.dat.lock";
+    const char* master_password = "durability_master_password";
+
+    void SetUp() override {
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        unlink(test_lock_path);
+        ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+        ASSERT_EQ(vault_store("seed", "user", "seed-pass", nullptr, true), 0);
+        vault_cleanup();
+        g_saves = 0;
+    }
+
+    void TearDown() override {
+        vault_cleanup();
+        vault_set_save_hook(nullptr);
+        vault_set_durability(VAULT_DURABILITY_FSYNC);
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        unlink(test_lock_path);
+    }
+
+    static VaultEntry make_entry(const char* service) {
+        VaultEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        strcpy(entry.service, service);
+        strcpy(entry.username, "user");
+        strcpy(entry.password, "pw");
+        return entry;
+    }
+
+    int leftover_temp_files() {
+        int count = 0;
+        DIR* dir = opendir("/tmp");
+        if (!dir) return -1;
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != nullptr) {
+            if (strncmp(ent->d_name, "test_durability_vault.dat.tmp.", 30) == 0) {
+                count++;
+                std::string path = std::string("/tmp/") + ent->d_name;
+                unlink(path.c_str());
+            }
+        }
+        closedir(dir);
+        return count;
+    }
+};
+
+TEST_F(VaultDurabilityTest, ParsesModes) {
+    vault_durability_t mode;
+    ASSERT_EQ(vault_parse_durability("none", &mode), 0);
+    EXPECT_EQ(mode, VAULT_DURABILITY_NONE);
+    ASSERT_EQ(vault_parse_durability("group", &mode), 0);
+    EXPECT_EQ(mode, VAULT_DURABILITY_GROUP);
+    EXPECT_NE(vault_parse_durability("always", &mode), 0);
+    EXPECT_NE(vault_set_durability((vault_durability_t)7), 0);
+}
+
+TEST_F(VaultDurabilityTest, CrashAtEveryStageLeavesOldOrNewVault) {
+    const vault_save_stage_t stages[] = {
+        VAULT_SAVE_TEMP_CREATED, VAULT_SAVE_HEADER_WRITTEN, VAULT_SAVE_BODY_WRITTEN,
+        VAULT_SAVE_SYNCED, VAULT_SAVE_RENAMED
+    };
+
+    for (vault_save_stage_t stage : stages) {
+        fflush(NULL);
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            g_crash_stage = (int)stage;
+            vault_set_save_hook(crash_at_stage);
+            VaultEntry entry = make_entry("crash");
+            if (vault_open(master_password, test_vault_path, 0) != 0) _exit(1);
+            vault_put_entry(&entry);
+            _exit(0);
+        }
+
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 42) << "stage " << stage;
+
+        ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0)
+            << "stage " << stage;
+        EXPECT_GE(vault_find_entry("seed", "user"), 0);
+        bool committed = vault_find_entry("crash", "user") >= 0;
+        EXPECT_EQ(committed, stage == VAULT_SAVE_RENAMED) << "stage " << stage;
+        EXPECT_EQ(vault_entry_count(), committed ? 2u : 1u);
+        vault_cleanup();
+
+        if (committed) {
+            ASSERT_EQ(vault_open(master_password, test_vault_path, 0), 0);
+            ASSERT_EQ(vault_remove("crash", "user"), 0);
+            vault_cleanup();
+        }
+        leftover_temp_files();
+    }
+}
+
+TEST_F(VaultDurabilityTest, SavesAreAtomicReplacements) {
+    ASSERT_EQ(vault_open(master_password, test_vault_path, 0), 0);
+    VaultEntry entry = make_entry("atomic");
+    ASSERT_EQ(vault_put_entry(&entry), 0);
+    vault_cleanup();
+
+    struct stat st;
+    ASSERT_EQ(stat(test_vault_path, &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600u);
+    EXPECT_EQ(leftover_temp_files(), 0);
+
+    vault_set_durability(VAULT_DURABILITY_NONE);
+    ASSERT_EQ(vault_open(master_password, test_vault_path, 0), 0);
+    ASSERT_EQ(vault_remove("atomic", "user"), 0);
+    vault_cleanup();
+    ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_EQ(vault_entry_count(), 1u);
+}
+
+TEST_F(VaultDurabilityTest, GroupCommitCoalescesBursts) {
+    vault_set_durability(VAULT_DURABILITY_GROUP);
+    vault_set_save_hook(count_saves);
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, 0), 0);
+    const int writes = VAULT_GROUP_COMMIT_MAX + 10;
+    for (int i = 0; i < writes; i++) {
+        char service[32];
+        snprintf(service, sizeof(service), "burst%d", i);
+        VaultEntry entry = make_entry(service);
+        ASSERT_EQ(vault_put_entry(&entry), 0);
+    }
+    EXPECT_GE(g_saves, 1);
+    EXPECT_LT(g_saves, writes / 4);
+
+    int before_sync = g_saves;
+    ASSERT_EQ(vault_sync(), 0);
+    EXPECT_LE(g_saves, before_sync + 1);
+    EXPECT_EQ(vault_sync(), 0);
+
+    VaultEntry last = make_entry("after-sync");
+    ASSERT_EQ(vault_put_entry(&last), 0);
+    vault_cleanup();
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_EQ(vault_entry_count(), (size_t)(writes + 2));
+    EXPECT_GE(vault_find_entry("after-sync", "user"), 0);
+}
+
+TEST_F(VaultDurabilityTest, BatchCommitFlushesPendingGroup) {
+    vault_set_durability(VAULT_DURABILITY_GROUP);
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, 0), 0);
+    vault_set_save_hook(count_saves);
+    VaultEntry pending = make_entry("pending");
+    ASSERT_EQ(vault_put_entry(&pending), 0);
+
+    // Written here at the latest; the group deadline may have beaten the batch to it.
+    ASSERT_EQ(vault_begin_batch(), 0);
+    EXPECT_EQ(g_saves, 1);
+    VaultEntry batched = make_entry("batched");
+    ASSERT_EQ(vault_put_entry(&batched), 0);
+    ASSERT_EQ(vault_commit_batch(), 0);
+    EXPECT_EQ(g_saves, 2);
+    vault_cleanup();
+    EXPECT_EQ(g_saves, 2);
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_GE(vault_find_entry("pending", "user"), 0);
+    EXPECT_GE(vault_find_entry("batched", "user"), 0);
+}
+
+TEST_F(VaultDurabilityTest, GroupCommitWritesLoneChangeAfterWindow) {
+    vault_set_durability(VAULT_DURABILITY_GROUP);
+
+    fflush(NULL);
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        VaultEntry entry = make_entry("lone");
+        if (vault_open(master_password, test_vault_path, 0) != 0 || vault_put_entry(&entry) != 0) {
+            _exit(1);
+        }
+        // No further change, sync or close: only the deadline can write it.
+        usleep(VAULT_GROUP_COMMIT_WINDOW_MS * 10 * 1000);
+        _exit(0);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_GE(vault_find_entry("lone", "user"), 0);
+    EXPECT_EQ(leftover_temp_files(), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
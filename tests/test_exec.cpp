@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "secret_exec.h"
+    #include "vault_controller.h"
+}
+
+class ExecTest : public ::testing::Test {
+protected:
+    const char* test_vault_path = "/tmp/test_exec_vault.dat";
+    const char* test_backup_path = "/tmp/test_exec_vault.dat.backup";
+    const char* master_password = "exec_master_password";
+    exec_manifest_t manifest;
+
+    void SetUp() override {
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        memset(&manifest, 0, sizeof(manifest));
+        ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+        ASSERT_EQ(vault_store("postgres", "app", "db pass with spaces", nullptr, true), 0);
+        ASSERT_EQ(vault_store("github", "alice", "gh-pass", "JBSWY3DPEHPK3PXP", true), 0);
+    }
+
+    void TearDown() override {
+        exec_manifest_free(&manifest);
+        vault_cleanup();
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+    }
+
+    int parse(const std::string& text, size_t* error_line = nullptr) {
+        FILE* fp = fmemopen((void*)text.data(), text.size(), "r");
+        int ret = exec_manifest_parse(fp, &manifest, error_line);
+        fclose(fp);
+        return ret;
+    }
+
+    static std::string lookup(char** env, const char* name) {
+        size_t len = strlen(name);
+        for (char** p = env; *p; p++) {
+            if (strncmp(*p, name, len) == 0 && (*p)[len] == '=') return *p + len + 1;
+        }
+        return "<unset>";
+    }
+};
+
+TEST_F(ExecTest, ParsesManifestLines) {
+    ASSERT_EQ(parse("# database\n"
+                    "DB_PASSWORD postgres app\n"
+                    "\n"
+                    "GH_USER \"github\" alice username\n"
+                    "GH_OTP github alice totp\n"), 0);
+    ASSERT_EQ(manifest.count, 3u);
+    EXPECT_STREQ(manifest.bindings[0].name, "DB_PASSWORD");
+    EXPECT_EQ(manifest.bindings[0].ref.field, REF_FIELD_PASSWORD);
+    EXPECT_EQ(manifest.bindings[0].line, 2u);
+    EXPECT_STREQ(manifest.bindings[1].service, "github");
+    EXPECT_EQ(manifest.bindings[1].ref.field, REF_FIELD_USERNAME);
+    EXPECT_EQ(manifest.bindings[2].ref.field, REF_FIELD_TOTP);
+}
+
+TEST_F(ExecTest, RejectsInvalidLines) {
+    size_t line = 0;
+    EXPECT_NE(parse("OK postgres app\n1BAD postgres app\n", &line), 0);
+    EXPECT_EQ(line, 2u);
+    EXPECT_NE(parse("A postgres app\nA github alice\n", &line), 0);
+    EXPECT_EQ(line, 2u);
+    EXPECT_NE(parse("A postgres app pin\n", &line), 0);
+    EXPECT_NE(parse("A postgres\n", &line), 0);
+    EXPECT_NE(parse("A \"postgres app\n", &line), 0);
+}
+
+TEST_F(ExecTest, ResolvesAndBuildsEnvironment) {
+    ASSERT_EQ(parse("HOME postgres app\nGH_USER github alice username\n"), 0);
+    ASSERT_EQ(exec_manifest_resolve(&manifest, nullptr), 0);
+
+    char* base[] = {(char*)"HOME=/root", (char*)"PATH=/bin", nullptr};
+    char** env = exec_build_environment(&manifest, base);
+    ASSERT_NE(env, nullptr);
+    EXPECT_EQ(lookup(env, "HOME"), "db pass with spaces");
+    EXPECT_EQ(lookup(env, "PATH"), "/bin");
+    EXPECT_EQ(lookup(env, "GH_USER"), "alice");
+
+    size_t count = 0;
+    while (env[count]) count++;
+    EXPECT_EQ(count, 3u);
+    exec_free_environment(env);
+
+    exec_manifest_free(&manifest);
+    size_t missing = 0;
+    ASSERT_EQ(parse("A postgres app\nB github nobody\n"), 0);
+    EXPECT_NE(exec_manifest_resolve(&manifest, &missing), 0);
+    EXPECT_EQ(missing, 2u);
+}
+
+TEST_F(ExecTest, ChildSeesSecretsInEnvironment) {
+    ASSERT_EQ(parse("DB_PASSWORD postgres app\n"), 0);
+    ASSERT_EQ(exec_manifest_resolve(&manifest, nullptr), 0);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    fflush(NULL);
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        char* argv[] = {(char*)"sh", (char*)"-c", (char*)"printf %s \"$DB_PASSWORD\"", nullptr};
+        exec_command(&manifest, argv);
+        _exit(127);
+    }
+    close(fds[1]);
+
+    std::string output;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) output.append(buffer, n);
+    close(fds[0]);
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(output, "db pass with spaces");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstring>
+#include <set>
+#include <string>
+extern "C" {
+    #include "vault_controller.h"
+    #include "vault_gen.h"
+}
+#include "vault_test_util.h"
+
+class VaultGenTest : public VaultFileTest {
+protected:
+    vault_gen_config_t config;
+
+    VaultGenTest() : VaultFileTest("/tmp/test_gen_vault.dat", "gen_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        vault_gen_defaults(&config);
+    }
+};
+
+TEST_F(VaultGenTest, SameSeedSameEntries) {
+    VaultEntry a, b;
+    for (size_t i = 0; i < 100; i++) {
+        vault_gen_entry(&config, i, &a);
+        vault_gen_entry(&config, i, &b);
+        EXPECT_EQ(memcmp(&a, &b, sizeof(a)), 0);
+    }
+
+    vault_gen_config_t other = config;
+    other.seed = 2;
+    vault_gen_entry(&config, 5, &a);
+    vault_gen_entry(&other, 5, &b);
+    EXPECT_STRNE(a.password, b.password);
+}
+
+TEST_F(VaultGenTest, LengthsStayInRange) {
+    config.service_len = {20, 30};
+    config.username_len = {5, 5};
+    config.password_len = {40, 64};
+    config.totp_percent = 100;
+
+    for (size_t i = 0; i < 500; i++) {
+        VaultEntry entry;
+        vault_gen_entry(&config, i, &entry);
+        EXPECT_GE(strlen(entry.service), 20u);
+        EXPECT_LE(strlen(entry.service), 30u);
+        EXPECT_EQ(strlen(entry.username), 5u);
+        EXPECT_GE(strlen(entry.password), 40u);
+        EXPECT_LE(strlen(entry.password), 64u);
+        EXPECT_EQ(strlen(entry.totp_secret), 32u);
+        EXPECT_NE(entry.password_updated_at, 0u);
+    }
+}
+
+TEST_F(VaultGenTest, ServicesAreUniqueEvenWhenShort) {
+    config.service_len = {1, 1};
+    std::set<std::string> services;
+    for (size_t i = 0; i < 2000; i++) {
+        VaultEntry entry;
+        vault_gen_entry(&config, i, &entry);
+        services.insert(entry.service);
+    }
+    EXPECT_EQ(services.size(), 2000u);
+}
+
+TEST_F(VaultGenTest, ParseRange) {
+    vault_gen_range_t range;
+    ASSERT_EQ(vault_gen_parse_range("12", 255, &range), 0);
+    EXPECT_EQ(range.min, 12u);
+    EXPECT_EQ(range.max, 12u);
+    ASSERT_EQ(vault_gen_parse_range("8-64", 255, &range), 0);
+    EXPECT_EQ(range.min, 8u);
+    EXPECT_EQ(range.max, 64u);
+
+    EXPECT_EQ(vault_gen_parse_range("0", 255, &range), -1);
+    EXPECT_EQ(vault_gen_parse_range("9-8", 255, &range), -1);
+    EXPECT_EQ(vault_gen_parse_range("1-256", 255, &range), -1);
+    EXPECT_EQ(vault_gen_parse_range("8-", 255, &range), -1);
+    EXPECT_EQ(vault_gen_parse_range("abc", 255, &range), -1);
+}
+
+TEST_F(VaultGenTest, FillWritesEveryEntry) {
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    ASSERT_EQ(vault_gen_fill(vault, &config, 0, 1000), 0);
+    vault_handle_close(vault);
+
+    vault = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_entry_count(vault), 1000u);
+
+    VaultEntry wanted, found;
+    vault_gen_entry(&config, 777, &wanted);
+    ASSERT_EQ(vault_handle_get(vault, wanted.service, wanted.username, &found), 0);
+    EXPECT_STREQ(found.password, wanted.password);
+    EXPECT_EQ(found.password_updated_at, wanted.password_updated_at);
+    vault_handle_close(vault);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+extern "C" {
+    #include "vault_controller.h"
+}
+#include "vault_test_util.h"
+
+class VaultHandleTest : public VaultFileTest {
+protected:
+    const char* path_b = "/tmp/test_handle_b.dat";
+
+    VaultHandleTest() : VaultFileTest("/tmp/test_handle_a.dat", "handle_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        remove_vault_files(path_b);
+    }
+
+    void TearDown() override {
+        vault_cleanup();
+        remove_vault_files(path_b);
+        VaultFileTest::TearDown();
+    }
+};
+
+TEST_F(VaultHandleTest, TwoVaultsOpenAtOnce) {
+    vault_handle_t* a = vault_handle_open(master_password, test_vault_path, 0);
+    vault_handle_t* b = vault_handle_open("other_master", path_b, 0);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+
+    VaultEntry entry = make_test_entry("mail", "alice", "in-a");
+    ASSERT_EQ(vault_handle_put_entry(a, &entry), 0);
+    entry = make_test_entry("mail", "alice", "in-b");
+    ASSERT_EQ(vault_handle_put_entry(b, &entry), 0);
+    entry = make_test_entry("git", "bob", "only-b");
+    ASSERT_EQ(vault_handle_put_entry(b, &entry), 0);
+
+    EXPECT_EQ(vault_handle_entry_count(a), 1u);
+    EXPECT_EQ(vault_handle_entry_count(b), 2u);
+
+    VaultEntry out;
+    ASSERT_EQ(vault_handle_get(a, "mail", "alice", &out), 0);
+    EXPECT_STREQ(out.password, "in-a");
+    ASSERT_EQ(vault_handle_get(b, "mail", "alice", &out), 0);
+    EXPECT_STREQ(out.password, "in-b");
+    EXPECT_LT(vault_handle_find_entry(a, "git", "bob"), 0);
+
+    vault_handle_close(a);
+    vault_handle_close(b);
+
+    vault_handle_t* reopened = vault_handle_open("other_master", path_b, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(reopened, nullptr);
+    EXPECT_TRUE(vault_handle_is_read_only(reopened));
+    EXPECT_EQ(vault_handle_entry_count(reopened), 2u);
+    vault_handle_close(reopened);
+}
+
+TEST_F(VaultHandleTest, CompatibilityWrappersUseDefaultHandle) {
+    EXPECT_EQ(vault_default_handle(), nullptr);
+    EXPECT_NE(vault_put_entry(nullptr), 0);
+    EXPECT_EQ(vault_entry_count(), 0u);
+
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    vault_handle_t* handle = vault_default_handle();
+    ASSERT_NE(handle, nullptr);
+
+    ASSERT_EQ(vault_store("svc", "user", "pw", nullptr, true), 0);
+    EXPECT_EQ(vault_handle_entry_count(handle), 1u);
+    EXPECT_EQ(vault_handle_find_entry(handle, "svc", "user"), vault_find_entry("svc", "user"));
+
+    vault_cleanup();
+    EXPECT_EQ(vault_default_handle(), nullptr);
+    EXPECT_NE(vault_find_entry("svc", "user"), 0);
+}
+
+TEST_F(VaultHandleTest, StoreWithoutForceKeepsExistingEntry) {
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+
+    ASSERT_EQ(vault_handle_store(vault, "svc", "user", "first", nullptr, false), 0);
+    EXPECT_NE(vault_handle_store(vault, "svc", "user", "second", nullptr, false), 0);
+
+    VaultEntry out;
+    ASSERT_EQ(vault_handle_get(vault, "svc", "user", &out), 0);
+    EXPECT_STREQ(out.password, "first");
+
+    ASSERT_EQ(vault_handle_store(vault, "svc", "user", "second", nullptr, true), 0);
+    ASSERT_EQ(vault_handle_get(vault, "svc", "user", &out), 0);
+    EXPECT_STREQ(out.password, "second");
+    vault_handle_close(vault);
+}
+
+struct ThreadArgs {
+    vault_handle_t* vault;
+    int id;
+    std::atomic<bool>* stop;
+    std::atomic<int>* failures;
+};
+
+static void* reader_thread(void* arg) {
+    ThreadArgs* args = static_cast<ThreadArgs*>(arg);
+    size_t last = 0;
+    while (!args->stop->load()) {
+        VaultEntry entry;
+        size_t count = vault_handle_entry_count(args->vault);
+        if (count < last ||
+            vault_handle_get(args->vault, "seed", "user", &entry) != 0 ||
+            strcmp(entry.password, "seed-pass") != 0 ||
+            vault_handle_search(args->vault, "seed", nullptr, 0) != 1) {
+            args->failures->fetch_add(1);
+        }
+        last = count;
+    }
+    return nullptr;
+}
+
+static void* writer_thread(void* arg) {
+    ThreadArgs* args = static_cast<ThreadArgs*>(arg);
+    for (int i = 0; i < 25; i++) {
+        char service[32];
+        snprintf(service, sizeof(service), "writer%d-%d", args->id, i);
+        VaultEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        strcpy(entry.service, service);
+        strcpy(entry.username, "user");
+        strcpy(entry.password, service);
+        if (vault_handle_put_entry(args->vault, &entry) != 0) {
+            args->failures->fetch_add(1);
+        }
+    }
+    return nullptr;
+}
+
+TEST_F(VaultHandleTest, ConcurrentReadersAndWriters) {
+    const int readers = 4, writers = 3;
+    vault_set_durability(VAULT_DURABILITY_NONE);
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    VaultEntry seed = make_test_entry("seed", "user", "seed-pass");
+    ASSERT_EQ(vault_handle_put_entry(vault, &seed), 0);
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> failures(0);
+    pthread_t threads[readers + writers];
+    ThreadArgs args[readers + writers];
+
+    for (int t = 0; t < readers + writers; t++) {
+        args[t] = ThreadArgs{vault, t - readers, &stop, &failures};
+        ASSERT_EQ(pthread_create(&threads[t], nullptr,
+                                 t < readers ? reader_thread : writer_thread, &args[t]), 0);
+    }
+    for (int t = readers; t < readers + writers; t++) {
+        pthread_join(threads[t], nullptr);
+    }
+    stop.store(true);
+    for (int t = 0; t < readers; t++) {
+        pthread_join(threads[t], nullptr);
+    }
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(vault_handle_entry_count(vault), (size_t)(1 + writers * 25));
+    vault_handle_close(vault);
+    vault_set_durability(VAULT_DURABILITY_FSYNC);
+
+    vault = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_entry_count(vault), (size_t)(1 + writers * 25));
+    VaultEntry out;
+    ASSERT_EQ(vault_handle_get(vault, "writer2-24", "user", &out), 0);
+    EXPECT_STREQ(out.password, "writer2-24");
+    vault_handle_close(vault);
+}
+
+TEST_F(VaultHandleTest, PipelinedOpenReportsPhases) {
+    vault_set_durability(VAULT_DURABILITY_NONE);
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    vault_open_timings_t timings;
+    vault_handle_open_timings(vault, &timings);
+    EXPECT_GT(timings.kdf_ms, 0.0);
+    EXPECT_EQ(timings.read_ms, 0.0);
+
+    ASSERT_EQ(vault_handle_begin_batch(vault), 0);
+    for (int i = 0; i < 200; i++) {
+        char service[32];
+        snprintf(service, sizeof(service), "svc%d", i);
+        VaultEntry entry = make_test_entry(service, "user", service);
+        ASSERT_EQ(vault_handle_put_entry(vault, &entry), 0);
+    }
+    ASSERT_EQ(vault_handle_commit_batch(vault), 0);
+    vault_handle_close(vault);
+    vault_set_durability(VAULT_DURABILITY_FSYNC);
+
+    EXPECT_EQ(vault_handle_open("wrong_password", test_vault_path, VAULT_OPEN_READ_ONLY), nullptr);
+
+    vault_handle_t* reader = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(reader, nullptr);
+    vault_handle_open_timings(reader, &timings);
+    EXPECT_GT(timings.read_ms, 0.0);
+    EXPECT_GT(timings.kdf_ms, 0.0);
+    EXPECT_GE(timings.total_ms, timings.kdf_ms + timings.decrypt_ms);
+    VaultEntry out;
+    ASSERT_EQ(vault_handle_get(reader, "svc199", "user", &out), 0);
+    EXPECT_STREQ(out.password, "svc199");
+
+    vault_handle_t* writer = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(writer, nullptr);
+    vault_handle_close(writer);
+    vault_handle_close(reader);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
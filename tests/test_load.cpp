@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "serve_load.h"
+}
+
+TEST(LoadMixTest, ParsesWeights) {
+    load_mix_t mix;
+    ASSERT_EQ(load_mix_parse(LOAD_DEFAULT_MIX, &mix), 0);
+    EXPECT_EQ(mix.weights[LOAD_OP_GET], 80u);
+    EXPECT_EQ(mix.weights[LOAD_OP_LIST], 2u);
+    EXPECT_EQ(mix.weights[LOAD_OP_STORE], 10u);
+    EXPECT_EQ(mix.weights[LOAD_OP_TOTP], 8u);
+    EXPECT_EQ(mix.total, 100u);
+
+    ASSERT_EQ(load_mix_parse("store=1", &mix), 0);
+    EXPECT_EQ(mix.weights[LOAD_OP_GET], 0u);
+    EXPECT_EQ(mix.total, 1u);
+
+    const char* invalid[] = {"", "get", "get=", "get=x", "fetch=1", "get=0", "get=1,", "get=1;list=2"};
+    for (const char* text : invalid) {
+        EXPECT_NE(load_mix_parse(text, &mix), 0) << text;
+    }
+}
+
+TEST(LoadMixTest, PickFollowsWeights) {
+    load_mix_t mix;
+    ASSERT_EQ(load_mix_parse("get=3,totp=1", &mix), 0);
+    int counts[LOAD_OP_COUNT] = {0};
+    for (uint64_t r = 0; r < 400; r++) {
+        counts[load_mix_pick(&mix, r)]++;
+    }
+    EXPECT_EQ(counts[LOAD_OP_GET], 300);
+    EXPECT_EQ(counts[LOAD_OP_TOTP], 100);
+    EXPECT_EQ(counts[LOAD_OP_LIST] + counts[LOAD_OP_STORE], 0);
+}
+
+TEST(LatencyHistogramTest, PercentilesStayWithinBucketError) {
+    latency_histogram_t* h = new latency_histogram_t();
+    for (uint64_t us = 1; us <= 10000; us++) {
+        latency_record(h, us * 1000);
+    }
+    EXPECT_EQ(h->total, 10000u);
+    EXPECT_EQ(h->max_ns, 10000000u);
+
+    const double checks[][2] = {{50, 5000000}, {99, 9900000}, {99.9, 9990000}};
+    for (const auto& check : checks) {
+        double value = (double)latency_percentile(h, check[0]);
+        EXPECT_GE(value, check[1]) << check[0];
+        EXPECT_LE(value, check[1] * (1.0 + 1.0 / LATENCY_SUB_BUCKETS)) << check[0];
+    }
+    EXPECT_EQ(latency_percentile(h, 100), 10000000u);
+    delete h;
+}
+
+TEST(LatencyHistogramTest, MergeAndOutliers) {
+    latency_histogram_t* a = new latency_histogram_t();
+    latency_histogram_t* b = new latency_histogram_t();
+    EXPECT_EQ(latency_percentile(a, 99), 0u);
+
+    for (int i = 0; i < 998; i++) latency_record(a, 100000);
+    latency_record(b, 50000000);
+    latency_record(b, 1ull << 40);
+    latency_merge(a, b);
+
+    EXPECT_EQ(a->total, 1000u);
+    EXPECT_LE(latency_percentile(a, 99), 101600u);
+    EXPECT_GE(latency_percentile(a, 99.9), 50000000u);
+    EXPECT_EQ(latency_percentile(a, 100), 1ull << 40);
+    delete a;
+    delete b;
+}
+
+TEST(LoadJsonTest, FindsRawStringValues) {
+    std::string line = "{\"id\":0,\"ok\":true,\"result\":{\"count\":2,\"entries\":["
+                       "{\"service\":\"a\\\"service\\\":\\\"x\",\"username\":\"u\\\\1\",\"totp\":true},"
+                       "{\"service\" : \"b\",\"username\":\"u2\",\"totp\":false}]}}";
+    const char* end = line.data() + line.size();
+    const char* value_end;
+
+    const char* value = load_json_string(line.data(), end, "service", &value_end);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(std::string(value, value_end), "\"a\\\"service\\\":\\\"x\"");
+
+    value = load_json_string(value_end, end, "username", &value_end);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(std::string(value, value_end), "\"u\\\\1\"");
+    EXPECT_EQ(strncmp(value_end, ",\"totp\":true", 12), 0);
+
+    value = load_json_string(value_end, end, "service", &value_end);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(std::string(value, value_end), "\"b\"");
+
+    EXPECT_EQ(load_json_string(value_end, end, "service", &value_end), nullptr);
+    EXPECT_EQ(load_json_string(line.data(), end, "count", &value_end), nullptr);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+extern "C" {
+    #include "vault_controller.h"
+}
+
+class VaultLockTest : public ::testing::Test {
+protected:
+    const char* test_vault_path = "/tmp/test_lock_vault.dat";
+    const char* test_backup_path = "/tmp/test_lock_vault.dat.backup";
+    const char* test_lock_path = "/tmp/test_lock_vault.dat.lock";
+    const char* master_password = "lock_master_password";
+
+    void SetUp() override {
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        unlink(test_lock_path);
+        ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+        ASSERT_EQ(vault_store("seed", "user", "seed-pass", nullptr, true), 0);
+        vault_cleanup();
+        vault_set_lock_timeout(VAULT_LOCK_TIMEOUT_MS);
+    }
+
+    void TearDown() override {
+        vault_cleanup();
+        vault_set_lock_timeout(VAULT_LOCK_TIMEOUT_MS);
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        unlink(test_lock_path);
+    }
+
+    int try_exclusive() {
+        int fd = open(test_lock_path, O_RDWR | O_CREAT, 0600);
+        if (fd < 0) return -1;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    static VaultEntry make_entry(const char* service, const char* username) {
+        VaultEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        strcpy(entry.service, service);
+        strcpy(entry.username, username);
+        strcpy(entry.password, "pw");
+        return entry;
+    }
+};
+
+TEST_F(VaultLockTest, ReadOnlyOpenRejectsWrites) {
+    ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_TRUE(vault_is_read_only());
+    EXPECT_EQ(vault_entry_count(), 1u);
+
+    VaultEntry entry = make_entry("new", "user");
+    EXPECT_NE(vault_put_entry(&entry), 0);
+    EXPECT_NE(vault_remove("seed", "user"), 0);
+    EXPECT_NE(vault_change_master_password(master_password, "other"), 0);
+    vault_cleanup();
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, 0), 0);
+    EXPECT_FALSE(vault_is_read_only());
+    EXPECT_EQ(vault_entry_count(), 1u);
+    vault_cleanup();
+
+    EXPECT_NE(vault_open(master_password, "/tmp/test_lock_missing.dat", VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_NE(access("/tmp/test_lock_missing.dat", F_OK), 0);
+}
+
+TEST_F(VaultLockTest, WritersHoldLockReadersDoNot) {
+    ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    int fd = try_exclusive();
+    EXPECT_GE(fd, 0);
+    close(fd);
+    vault_cleanup();
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, 0), 0);
+    EXPECT_LT(try_exclusive(), 0);
+    vault_cleanup();
+
+    fd = try_exclusive();
+    EXPECT_GE(fd, 0);
+    close(fd);
+}
+
+TEST_F(VaultLockTest, BoundedWaitTimesOut) {
+    int fd = try_exclusive();
+    ASSERT_GE(fd, 0);
+
+    vault_set_lock_timeout(100);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    EXPECT_NE(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_NE(vault_open(master_password, test_vault_path, 0), 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double waited = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    EXPECT_GE(waited, 0.2);
+    EXPECT_LT(waited, 2.0);
+
+    close(fd);
+    EXPECT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+}
+
+TEST_F(VaultLockTest, ConcurrentReadersAndWritersDoNotCorrupt) {
+    const int writers = 3, readers = 3, stores = 4, reads = 6;
+    pid_t pids[writers + readers];
+
+    fflush(NULL);
+    for (int p = 0; p < writers + readers; p++) {
+        pids[p] = fork();
+        ASSERT_GE(pids[p], 0);
+        if (pids[p] != 0) continue;
+
+        vault_set_lock_timeout(60000);
+        int failed = 0;
+        if (p < writers) {
+            for (int i = 0; i < stores && !failed; i++) {
+                char service[32];
+                snprintf(service, sizeof(service), "writer%d-%d", p, i);
+                VaultEntry entry = make_entry(service, "user");
+                failed = vault_open(master_password, test_vault_path, 0) != 0 ||
+                         vault_put_entry(&entry) != 0;
+                vault_cleanup();
+            }
+        } else {
+            size_t last = 0;
+            for (int i = 0; i < reads && !failed; i++) {
+                failed = vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY) != 0 ||
+                         vault_entry_count() < last || vault_find_entry("seed", "user") < 0;
+                last = vault_entry_count();
+                vault_cleanup();
+            }
+        }
+        _exit(failed ? 1 : 0);
+    }
+
+    for (int p = 0; p < writers + readers; p++) {
+        int status = 0;
+        ASSERT_EQ(waitpid(pids[p], &status, 0), pids[p]);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0) << "process " << p;
+    }
+
+    ASSERT_EQ(vault_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY), 0);
+    EXPECT_EQ(vault_entry_count(), (size_t)(1 + writers * stores));
+    for (int p = 0; p < writers; p++) {
+        for (int i = 0; i < stores; i++) {
+            char service[32];
+            snprintf(service, sizeof(service), "writer%d-%d", p, i);
+            EXPECT_GE(vault_find_entry(service, "user"), 0) << service;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
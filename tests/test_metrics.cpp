@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+extern "C" {
+    #include "metrics.h"
+    #include "serve.h"
+    #include "vault_controller.h"
+}
+#include "vault_test_util.h"
+
+class MetricsTest : public VaultFileTest {
+protected:
+    const char* textfile_path = "/tmp/test_metrics.prom";
+    const char* socket_path = "/tmp/test_metrics.sock";
+
+    MetricsTest() : VaultFileTest("/tmp/test_metrics_vault.dat", "metrics_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        unlink(textfile_path);
+        unlink(socket_path);
+        metrics_reset();
+    }
+
+    void TearDown() override {
+        metrics_stop_exporter();
+        metrics_enable(false);
+        metrics_reset();
+        unlink(textfile_path);
+        unlink(socket_path);
+        VaultFileTest::TearDown();
+    }
+
+    static std::string exposition() {
+        char* buffer = nullptr;
+        size_t len = 0;
+        FILE* out = open_memstream(&buffer, &len);
+        EXPECT_EQ(metrics_write(out), 0);
+        fclose(out);
+        std::string text(buffer, len);
+        free(buffer);
+        return text;
+    }
+
+    static uint64_t value_of(const std::string& text, const std::string& series) {
+        size_t at = text.find("\n" + series + " ");
+        if (at == std::string::npos) return UINT64_MAX;
+        return strtoull(text.c_str() + at + series.size() + 2, nullptr, 10);
+    }
+};
+
+TEST_F(MetricsTest, DisabledRecordsNothing) {
+    EXPECT_EQ(metrics_now(), 0u);
+    metrics_observe_ns(METRIC_REQUEST_GET, 1000);
+    metrics_count(METRIC_LOOKUP_HITS, 5);
+    EXPECT_EQ(metrics_histogram_count(METRIC_REQUEST_GET), 0u);
+    EXPECT_EQ(metrics_counter(METRIC_LOOKUP_HITS), 0u);
+}
+
+TEST_F(MetricsTest, QuantilesStayWithinBucketError) {
+    metrics_enable(true);
+    for (uint64_t us = 1; us <= 10000; us++) {
+        metrics_observe_ns(METRIC_REQUEST_GET, us * 1000);
+    }
+    EXPECT_EQ(metrics_histogram_count(METRIC_REQUEST_GET), 10000u);
+
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    for (double q : quantiles) {
+        double expected = q * 10000 * 1000;
+        double got = (double)metrics_histogram_quantile_ns(METRIC_REQUEST_GET, q);
+        EXPECT_GE(got, expected * 0.99) << q;
+        EXPECT_LE(got, expected * 1.125) << q;
+    }
+    EXPECT_EQ(metrics_histogram_quantile_ns(METRIC_REQUEST_LIST, 0.5), 0u);
+}
+
+TEST_F(MetricsTest, ThreadsAreSummedAfterExit) {
+    metrics_enable(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; i++) {
+                metrics_count(METRIC_LOOKUP_HITS, 1);
+                metrics_observe_ns(METRIC_SAVE, 1000000);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    metrics_count(METRIC_LOOKUP_HITS, 1);
+
+    EXPECT_EQ(metrics_counter(METRIC_LOOKUP_HITS), 4001u);
+    EXPECT_EQ(metrics_histogram_count(METRIC_SAVE), 4000u);
+}
+
+TEST_F(MetricsTest, ExpositionHasCumulativeBuckets) {
+    metrics_enable(true);
+    metrics_observe_ns(METRIC_REQUEST_STORE, 1500);
+    metrics_observe_ns(METRIC_REQUEST_STORE, 3000000);
+    metrics_count(METRIC_REQUEST_ERRORS, 2);
+
+    std::string text = exposition();
+    EXPECT_NE(text.find("# TYPE securekey_request_duration_seconds histogram\n"), std::string::npos);
+    EXPECT_EQ(value_of(text, "securekey_request_errors_total"), 2u);
+    EXPECT_EQ(value_of(text, "securekey_request_duration_seconds_bucket{op=\"store\",le=\"1.024e-06\"}"), 0u);
+    EXPECT_EQ(value_of(text, "securekey_request_duration_seconds_bucket{op=\"store\",le=\"2.048e-06\"}"), 1u);
+    EXPECT_EQ(value_of(text, "securekey_request_duration_seconds_bucket{op=\"store\",le=\"0.004194304\"}"), 2u);
+    EXPECT_EQ(value_of(text, "securekey_request_duration_seconds_bucket{op=\"store\",le=\"+Inf\"}"), 2u);
+    EXPECT_EQ(value_of(text, "securekey_request_duration_seconds_count{op=\"store\"}"), 2u);
+    EXPECT_EQ(text.find("op=\"get\""), std::string::npos);
+}
+
+TEST_F(MetricsTest, VaultRecordsPhasesLookupsAndResidentBytes) {
+    metrics_enable(true);
+    int64_t baseline = metrics_gauge(METRIC_RESIDENT_SECRET_BYTES);
+
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    ASSERT_EQ(vault_handle_store(vault, "mail", "me", "pw", nullptr, true), 0);
+    ASSERT_EQ(vault_handle_store(vault, "git", "me", "pw", nullptr, true), 0);
+    EXPECT_EQ(metrics_gauge(METRIC_RESIDENT_SECRET_BYTES) - baseline, 2 * (int64_t)sizeof(VaultEntry));
+    vault_handle_close(vault);
+    EXPECT_EQ(metrics_gauge(METRIC_RESIDENT_SECRET_BYTES), baseline);
+
+    metrics_reset();
+    vault = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(metrics_gauge(METRIC_RESIDENT_SECRET_BYTES) - baseline, 2 * (int64_t)sizeof(VaultEntry));
+    VaultEntry entry;
+    EXPECT_EQ(vault_handle_get(vault, "mail", "me", &entry), 0);
+    EXPECT_EQ(vault_handle_find_entry(vault, "none", "me"), -1);
+    vault_handle_close(vault);
+
+    EXPECT_EQ(metrics_histogram_count((metric_histogram_t)(METRIC_PHASE_FIRST + TIMING_KDF)), 1u);
+    EXPECT_EQ(metrics_counter(METRIC_LOOKUP_HITS), 1u);
+    EXPECT_EQ(metrics_counter(METRIC_LOOKUP_MISSES), 1u);
+    EXPECT_EQ(metrics_counter((metric_counter_t)(METRIC_TIMING_COUNTER_FIRST + TIMING_ENTRIES_LOADED)), 2u);
+    EXPECT_EQ(metrics_gauge(METRIC_RESIDENT_SECRET_BYTES), baseline);
+}
+
+TEST_F(MetricsTest, ServeRequestsAreTimedByOp) {
+    metrics_enable(true);
+    char ping[] = "{\"op\":\"ping\"}";
+    char bad[] = "{\"op\":\"get\"}";
+    char* out_buffer = nullptr;
+    size_t out_len = 0;
+    FILE* out = open_memstream(&out_buffer, &out_len);
+    serve_handle_request(ping, strlen(ping), out, nullptr);
+    serve_handle_request(bad, strlen(bad), out, nullptr);
+    fclose(out);
+    free(out_buffer);
+
+    EXPECT_EQ(metrics_histogram_count(METRIC_REQUEST_OTHER), 1u);
+    EXPECT_EQ(metrics_histogram_count(METRIC_REQUEST_GET), 1u);
+    EXPECT_EQ(metrics_counter(METRIC_REQUEST_ERRORS), 1u);
+}
+
+TEST_F(MetricsTest, TextfileIsReplacedAtomically) {
+    metrics_enable(true);
+    metrics_count(METRIC_RELOADS, 3);
+    ASSERT_EQ(metrics_write_textfile(textfile_path), 0);
+
+    struct stat st;
+    EXPECT_NE(stat((std::string(textfile_path) + ".tmp").c_str(), &st), 0);
+    FILE* in = fopen(textfile_path, "r");
+    ASSERT_NE(in, nullptr);
+    char line[256];
+    bool found = false;
+    while (fgets(line, sizeof(line), in)) {
+        found = found || strcmp(line, "securekey_reloads_total 3\n") == 0;
+    }
+    fclose(in);
+    EXPECT_TRUE(found);
+}
+
+TEST_F(MetricsTest, ExporterAnswersOnSocketAndWritesFile) {
+    ASSERT_EQ(metrics_start_exporter(textfile_path, socket_path, 60), 0);
+    EXPECT_TRUE(metrics_enabled());
+    metrics_count(METRIC_SAVE_ERRORS, 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    ASSERT_EQ(connect(fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+    ASSERT_EQ(write(fd, request, sizeof(request) - 1), (ssize_t)(sizeof(request) - 1));
+
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        response.append(buffer, (size_t)n);
+    }
+    close(fd);
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.0 200 OK"), 0);
+    EXPECT_EQ(value_of(response, "securekey_save_errors_total"), 1u);
+
+    metrics_stop_exporter();
+    struct stat st;
+    EXPECT_NE(stat(socket_path, &st), 0);
+    EXPECT_EQ(stat(textfile_path, &st), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+extern "C" {
+    #include "otpauth.h"
+    #include "vault_controller.h"
+    #include "totp_engine.h"
+}
+
+class OTPAuthTest : public ::testing::Test {
+protected:
+    otpauth_uri_t uri;
+
+    void SetUp() override {
+        memset(&uri, 0, sizeof(uri));
+    }
+};
+
+TEST_F(OTPAuthTest, ParseMinimalTOTP) {
+    ASSERT_EQ(otpauth_parse("otpauth://totp/alice@example.com?secret=JBSWY3DPEHPK3PXP", &uri), 0);
+
+    EXPECT_EQ(uri.type, OTP_TYPE_TOTP);
+    EXPECT_STREQ(uri.issuer, "");
+    EXPECT_STREQ(uri.account, "alice@example.com");
+    EXPECT_STREQ(uri.secret, "JBSWY3DPEHPK3PXP");
+    EXPECT_EQ(uri.algorithm, TOTP_ALG_SHA1);
+    EXPECT_EQ(uri.digits, 6);
+    EXPECT_EQ(uri.period, 30u);
+}
+
+TEST_F(OTPAuthTest, ParseLabelIssuerAndParameters) {
+    const char* text = "otpauth://totp/ACME%20Co:john.doe@email.com"
+                       "?secret=hxdm vjec jjws rb3h wizr 4ifu gftm xboz"
+                       "&issuer=ACME%20Co&algorithm=SHA256&digits=8&period=60";
+    ASSERT_EQ(otpauth_parse(text, &uri), 0);
+
+    EXPECT_STREQ(uri.issuer, "ACME Co");
+    EXPECT_STREQ(uri.account, "john.doe@email.com");
+    EXPECT_STREQ(uri.secret, "HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+    EXPECT_EQ(uri.algorithm, TOTP_ALG_SHA256);
+    EXPECT_EQ(uri.digits, 8);
+    EXPECT_EQ(uri.period, 60u);
+}
+
+TEST_F(OTPAuthTest, IssuerParameterWithoutLabelPrefix) {
+    ASSERT_EQ(otpauth_parse("otpauth://totp/bob?issuer=Example+Corp&secret=JBSWY3DPEHPK3PXP", &uri), 0);
+    EXPECT_STREQ(uri.issuer, "Example Corp");
+    EXPECT_STREQ(uri.account, "bob");
+}
+
+TEST_F(OTPAuthTest, ParseHOTPRequiresCounter) {
+    EXPECT_NE(otpauth_parse("otpauth://hotp/Svc:bob?secret=JBSWY3DPEHPK3PXP", &uri), 0);
+
+    ASSERT_EQ(otpauth_parse("otpauth://hotp/Svc:bob?secret=JBSWY3DPEHPK3PXP&counter=42", &uri), 0);
+    EXPECT_EQ(uri.type, OTP_TYPE_HOTP);
+    EXPECT_EQ(uri.counter, 42u);
+}
+
+TEST_F(OTPAuthTest, RejectsInvalidURIs) {
+    const char* invalid[] = {
+        "https://example.com/?secret=JBSWY3DPEHPK3PXP",
+        "otpauth://motp/Svc:bob?secret=JBSWY3DPEHPK3PXP",
+        "otpauth://totp/Svc:bob",
+        "otpauth://totp/Svc:bob?secret=NOT-BASE32-189",
+        "otpauth://totp/Svc:bob?secret=JBSWY3DPEHPK3PXP&digits=12",
+        "otpauth://totp/Svc:bob?secret=JBSWY3DPEHPK3PXP&algorithm=MD5",
+        "otpauth://totp/Svc:bob?secret=JBSWY3DPEHPK3PXP&period=0",
+        "otpauth://totp/Svc:%ZZbob?secret=JBSWY3DPEHPK3PXP",
+        "otpauth://totp/Svc:?secret=JBSWY3DPEHPK3PXP"
+    };
+
+    for (const char* text : invalid) {
+        EXPECT_NE(otpauth_parse(text, &uri), 0) << text;
+    }
+}
+
+TEST_F(OTPAuthTest, LongSecretIsKeptOrRejectedNeverTruncated) {
+    std::string secret(VAULT_TOTP_LEN - 1, 'A');
+    std::string text = "otpauth://totp/Svc:bob?secret=" + secret;
+    ASSERT_EQ(otpauth_parse(text.c_str(), &uri), 0);
+    EXPECT_EQ(strlen(uri.secret), secret.size());
+
+    std::string too_long = "otpauth://totp/Svc:bob?secret=" + secret + "A";
+    EXPECT_NE(otpauth_parse(too_long.c_str(), &uri), 0);
+}
+
+TEST_F(OTPAuthTest, EntryCarriesParameters) {
+    ASSERT_EQ(otpauth_parse("otpauth://totp/GitHub:dev?secret=JBSWY3DPEHPK3PXP&algorithm=SHA512&digits=7&period=45", &uri), 0);
+
+    VaultEntry entry;
+    ASSERT_EQ(otpauth_to_entry(&uri, &entry), 0);
+    EXPECT_STREQ(entry.service, "GitHub");
+    EXPECT_STREQ(entry.username, "dev");
+    EXPECT_STREQ(entry.totp_secret, "JBSWY3DPEHPK3PXP");
+    EXPECT_EQ(entry.totp_algorithm, TOTP_ALG_SHA512);
+    EXPECT_EQ(entry.totp_digits, 7);
+    EXPECT_EQ(entry.totp_period, 45u);
+
+    EXPECT_LT(vault_entry_otp(&entry), 10000000u);
+}
+
+class OTPAuthImportTest : public ::testing::Test {
+protected:
+    char vault_path[256];
+    char backup_path[300];
+    char import_path[256];
+    const char* master_password = "import_master_password";
+
+    void SetUp() override {
+        snprintf(vault_path, sizeof(vault_path), "/tmp/test_otpauth_vault_%d.dat", getpid());
+        snprintf(backup_path, sizeof(backup_path), "%s.backup", vault_path);
+        snprintf(import_path, sizeof(import_path), "/tmp/test_otpauth_import_%d.txt", getpid());
+        unlink(vault_path);
+        unlink(backup_path);
+    }
+
+    void TearDown() override {
+        vault_cleanup();
+        unlink(vault_path);
+        unlink(backup_path);
+        unlink(import_path);
+    }
+
+    void write_import_file(const char* content) {
+        FILE* fp = fopen(import_path, "w");
+        ASSERT_NE(fp, nullptr);
+        fputs(content, fp);
+        fclose(fp);
+    }
+};
+
+TEST_F(OTPAuthImportTest, ImportsFileInOneBatch) {
+    ASSERT_EQ(vault_init(master_password, vault_path), 0);
+    ASSERT_EQ(vault_store("GitHub", "dev", "existing_password", nullptr, true), 0);
+
+    write_import_file(
+        "# exported from authenticator\n"
+        "otpauth://totp/GitHub:dev?secret=JBSWY3DPEHPK3PXP&issuer=GitHub\n"
+        "\n"
+        "otpauth://totp/Google:me%40gmail.com?secret=HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ&digits=8\r\n"
+        "steam://not-supported\n"
+        "otpauth://hotp/Bank:me?secret=GEZDGNBVGY3TQOJQ&counter=7\n");
+
+    otpauth_import_stats_t stats;
+    ASSERT_EQ(otpauth_import_file(import_path, &stats), 0);
+    EXPECT_EQ(stats.imported, 2u);
+    EXPECT_EQ(stats.updated, 1u);
+    EXPECT_EQ(stats.failed, 1u);
+    EXPECT_EQ(vault_entry_count(), 3u);
+
+    vault_cleanup();
+    ASSERT_EQ(vault_init(master_password, vault_path), 0);
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_get("GitHub", "dev", &entry), 0);
+    EXPECT_STREQ(entry.password, "existing_password");
+    EXPECT_STREQ(entry.totp_secret, "JBSWY3DPEHPK3PXP");
+
+    ASSERT_EQ(vault_get("Google", "me@gmail.com", &entry), 0);
+    EXPECT_EQ(entry.totp_digits, 8);
+
+    ASSERT_EQ(vault_get("Bank", "me", &entry), 0);
+    EXPECT_EQ(entry.totp_type, OTP_TYPE_HOTP);
+    EXPECT_EQ(entry.totp_counter, 7u);
+}
+
+TEST_F(OTPAuthImportTest, IssuingHotpCodeAdvancesCounter) {
+    ASSERT_EQ(vault_init(master_password, vault_path), 0);
+    write_import_file("otpauth://hotp/Bank:me?secret=GEZDGNBVGY3TQOJQ&counter=7\n"
+                      "otpauth://totp/GitHub:dev?secret=JBSWY3DPEHPK3PXP\n");
+    otpauth_import_stats_t stats;
+    ASSERT_EQ(otpauth_import_file(import_path, &stats), 0);
+
+    uint32_t code;
+    uint64_t counter;
+    for (uint64_t expected = 7; expected < 10; expected++) {
+        ASSERT_EQ(vault_issue_otp("Bank", "me", &code, &counter), 0);
+        EXPECT_EQ(counter, expected);
+        EXPECT_EQ(code, generate_otp("GEZDGNBVGY3TQOJQ", TOTP_ALG_SHA1, 6, expected));
+    }
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_get("GitHub", "dev", &entry), 0);
+    ASSERT_EQ(vault_issue_otp("GitHub", "dev", &code, &counter), 0);
+    ASSERT_EQ(vault_get("GitHub", "dev", &entry), 0);
+    EXPECT_EQ(entry.totp_counter, 0u);
+    EXPECT_NE(vault_issue_otp("Missing", "me", &code, &counter), 0);
+
+    vault_cleanup();
+    ASSERT_EQ(vault_open(master_password, vault_path, VAULT_OPEN_READ_ONLY), 0);
+    ASSERT_EQ(vault_get("Bank", "me", &entry), 0);
+    EXPECT_EQ(entry.totp_counter, 10u);
+    EXPECT_NE(vault_issue_otp("Bank", "me", &code, &counter), 0);
+    ASSERT_EQ(vault_get("Bank", "me", &entry), 0);
+    EXPECT_EQ(entry.totp_counter, 10u);
+
+    uint32_t before = generate_totp("JBSWY3DPEHPK3PXP");
+    ASSERT_EQ(vault_issue_otp("GitHub", "dev", &code, &counter), 0);
+    uint32_t after = generate_totp("JBSWY3DPEHPK3PXP");
+    EXPECT_TRUE(code == before || code == after);
+}
+
+TEST_F(OTPAuthImportTest, MissingFileFails) {
+    ASSERT_EQ(vault_init(master_password, vault_path), 0);
+
+    otpauth_import_stats_t stats;
+    EXPECT_NE(otpauth_import_file("/nonexistent/otpauth.txt", &stats), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -3,6 +3,7 @@
 
 extern "C" {
     #include "arg_parse.h"
+    #include "timings.h"
 }
 
 class ArgParseTest : public ::testing::Test {
@@ -24,7 +25,8 @@ TEST_F(ArgParseTest, ParseCommandsWithoutRequiredArgs) {
         {{"securekey", "ls"}, 2, CMD_LIST},
         {{"securekey", "generate"}, 2, CMD_GENERATE},
         {{"securekey", "gen"}, 2, CMD_GENERATE},
-        {{"securekey", "init"}, 2, CMD_INIT}
+        {{"securekey", "init"}, 2, CMD_INIT},
+        {{"securekey", "stats"}, 2, CMD_STATS}
     };
     
     for (const auto& test_case : test_cases) {
@@ -138,6 +140,100 @@ TEST_F(ArgParseTest, InvalidPasswordLength) {
     EXPECT_EQ(parse_arguments(argc, (char**)argv, &args), -1);
 }
 
+TEST_F(ArgParseTest, ParseBulkGenerateOptions) {
+    const char* argv[] = {
+        "securekey", "generate",
+        "--length", "12-20",
+        "--count", "500",
+        "--require", "lower,digit",
+        "--no-ambiguous"
+    };
+    int argc = sizeof(argv) / sizeof(argv[0]);
+
+    EXPECT_EQ(parse_arguments(argc, (char**)argv, &args), 0);
+    EXPECT_EQ(args.password_length, 12);
+    EXPECT_EQ(args.password_max_length, 20);
+    EXPECT_EQ(args.count, 500);
+    EXPECT_STREQ(args.require_classes, "lower,digit");
+    EXPECT_EQ(args.exclude_ambiguous, 1);
+
+    const char* bad_range[] = {"securekey", "generate", "--length", "20-12"};
+    EXPECT_EQ(parse_arguments(4, (char**)bad_range, &args), -1);
+
+    const char* bad_count[] = {"securekey", "generate", "--count", "0"};
+    EXPECT_EQ(parse_arguments(4, (char**)bad_count, &args), -1);
+}
+
+TEST_F(ArgParseTest, ParseExecCommand) {
+    const char* argv[] = {
+        "securekey", "exec", "--manifest", "app.env", "--",
+        "./server", "--verbose", "-v", "x"
+    };
+    int argc = sizeof(argv) / sizeof(argv[0]);
+
+    EXPECT_EQ(parse_arguments(argc, (char**)argv, &args), 0);
+    EXPECT_EQ(args.command, CMD_EXEC);
+    EXPECT_STREQ(args.manifest, "app.env");
+    EXPECT_EQ(args.verbose, 0);
+    ASSERT_EQ(args.rest_argc, 4);
+    EXPECT_STREQ(args.rest_argv[0], "./server");
+    EXPECT_STREQ(args.rest_argv[3], "x");
+
+    const char* no_command[] = {"securekey", "exec", "--manifest", "app.env"};
+    EXPECT_EQ(parse_arguments(4, (char**)no_command, &args), -1);
+
+    const char* no_manifest[] = {"securekey", "exec", "--", "true"};
+    EXPECT_EQ(parse_arguments(4, (char**)no_manifest, &args), -1);
+}
+
+TEST_F(ArgParseTest, ParseTimingsOption) {
+    const char* verbose[] = {"securekey", "list", "--verbose"};
+    EXPECT_EQ(parse_arguments(3, (char**)verbose, &args), 0);
+    EXPECT_EQ(args.timings, TIMINGS_TEXT);
+
+    const char* json[] = {"securekey", "list", "--timings=json", "--verbose"};
+    EXPECT_EQ(parse_arguments(4, (char**)json, &args), 0);
+    EXPECT_EQ(args.timings, TIMINGS_JSON);
+    EXPECT_EQ(args.verbose, 1);
+
+    const char* none[] = {"securekey", "list"};
+    EXPECT_EQ(parse_arguments(2, (char**)none, &args), 0);
+    EXPECT_EQ(args.timings, TIMINGS_OFF);
+
+    const char* bad[] = {"securekey", "list", "--timings=xml"};
+    EXPECT_EQ(parse_arguments(3, (char**)bad, &args), -1);
+}
+
+TEST_F(ArgParseTest, ParseServeModes) {
+    const char* stdio[] = {"securekey", "serve", "--stdio"};
+    EXPECT_EQ(parse_arguments(3, (char**)stdio, &args), 0);
+    EXPECT_EQ(args.serve_stdio, 1);
+    EXPECT_STREQ(args.serve_listen, "");
+
+    const char* listen[] = {"securekey", "serve", "--listen", "/tmp/sk.sock"};
+    EXPECT_EQ(parse_arguments(4, (char**)listen, &args), 0);
+    EXPECT_EQ(args.serve_stdio, 0);
+    EXPECT_STREQ(args.serve_listen, "/tmp/sk.sock");
+
+    const char* neither[] = {"securekey", "serve"};
+    EXPECT_EQ(parse_arguments(2, (char**)neither, &args), -1);
+
+    const char* both[] = {"securekey", "serve", "--stdio", "--listen", "/tmp/sk.sock"};
+    EXPECT_EQ(parse_arguments(5, (char**)both, &args), -1);
+}
+
+TEST_F(ArgParseTest, ParseTotpForStoredEntry) {
+    const char* stored[] = {"securekey", "totp", "-s", "bank", "-u", "me"};
+    ASSERT_EQ(parse_arguments(6, (char**)stored, &args), 0);
+    EXPECT_EQ(args.command, CMD_TOTP);
+    EXPECT_STREQ(args.totp_secret, "");
+    EXPECT_STREQ(args.service, "bank");
+    EXPECT_STREQ(args.username, "me");
+
+    const char* service_only[] = {"securekey", "totp", "-s", "bank"};
+    EXPECT_EQ(parse_arguments(4, (char**)service_only, &args), -1);
+}
+
 TEST_F(ArgParseTest, MissingRequiredArgs) {
     const char* test_cases[][4] = {
         {"securekey", "store", "--service", "github"},
@@ -184,6 +280,7 @@ TEST_F(ArgParseTest, CommandToString) {
     EXPECT_STREQ(command_to_string(CMD_CHECK), "check");
     EXPECT_STREQ(command_to_string(CMD_GENERATE), "generate");
     EXPECT_STREQ(command_to_string(CMD_INIT), "init");
+    EXPECT_STREQ(command_to_string(CMD_STATS), "stats");
     EXPECT_STREQ(command_to_string(CMD_NONE), "unknown");
 }
 
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include "passphrase.h"
+}
+
+static std::vector<std::string> split(const std::string& text, const std::string& sep) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    size_t pos;
+    while ((pos = text.find(sep, start)) != std::string::npos) {
+        parts.push_back(text.substr(start, pos - start));
+        start = pos + sep.size();
+    }
+    parts.push_back(text.substr(start));
+    return parts;
+}
+
+static std::string lower(std::string word) {
+    for (char& c : word) c = (char)tolower((unsigned char)c);
+    return word;
+}
+
+class PassphraseTest : public ::testing::Test {
+protected:
+    passphrase_policy_t policy;
+    passphrase_generator_t generator;
+    char phrase[PASSPHRASE_MAX_LENGTH + 1];
+    std::set<std::string> words;
+
+    void SetUp() override {
+        passphrase_policy_default(&policy);
+        memset(&generator, 0, sizeof(generator));
+        for (size_t i = 0; i < passphrase_wordlist_size(); i++) {
+            words.insert(passphrase_word(i));
+        }
+    }
+
+    void TearDown() override {
+        passphrase_generator_cleanup(&generator);
+    }
+};
+
+TEST_F(PassphraseTest, EmbeddedWordlistIsDicewareSized) {
+    EXPECT_EQ(passphrase_wordlist_size(), 7776u);
+    EXPECT_EQ(words.size(), passphrase_wordlist_size());
+    EXPECT_EQ(passphrase_word(passphrase_wordlist_size()), nullptr);
+
+    for (const std::string& word : words) {
+        EXPECT_GE(word.size(), 3u);
+        EXPECT_LE(word.size(), (size_t)PASSPHRASE_MAX_WORD_LEN);
+    }
+}
+
+TEST_F(PassphraseTest, DefaultPolicyProducesListWords) {
+    ASSERT_EQ(passphrase_generator_init(&generator, &policy), 0);
+
+    for (int i = 0; i < 200; i++) {
+        int length = passphrase_generator_next(&generator, phrase, sizeof(phrase));
+        ASSERT_GT(length, 0);
+        EXPECT_EQ(strlen(phrase), (size_t)length);
+
+        std::vector<std::string> parts = split(phrase, "-");
+        ASSERT_EQ(parts.size(), 6u);
+        for (const std::string& part : parts) {
+            EXPECT_TRUE(words.count(part)) << part;
+        }
+    }
+}
+
+TEST_F(PassphraseTest, SeparatorAndCapitalization) {
+    policy.words = 4;
+    strcpy(policy.separator, " :: ");
+    policy.capitalize = PASSPHRASE_CAPS_FIRST;
+    ASSERT_EQ(passphrase_generator_init(&generator, &policy), 0);
+    ASSERT_GT(passphrase_generator_next(&generator, phrase, sizeof(phrase)), 0);
+
+    std::vector<std::string> parts = split(phrase, " :: ");
+    ASSERT_EQ(parts.size(), 4u);
+    for (const std::string& part : parts) {
+        EXPECT_TRUE(isupper((unsigned char)part[0])) << part;
+        EXPECT_EQ(lower(part.substr(1)), part.substr(1));
+        EXPECT_TRUE(words.count(lower(part)));
+    }
+
+    passphrase_generator_cleanup(&generator);
+    policy.capitalize = PASSPHRASE_CAPS_ALL;
+    ASSERT_EQ(passphrase_generator_init(&generator, &policy), 0);
+    ASSERT_GT(passphrase_generator_next(&generator, phrase, sizeof(phrase)), 0);
+    for (const char* p = phrase; *p; p++) {
+        EXPECT_FALSE(islower((unsigned char)*p));
+    }
+
+    passphrase_generator_cleanup(&generator);
+    policy.capitalize = PASSPHRASE_CAPS_RANDOM;
+    ASSERT_EQ(passphrase_generator_init(&generator, &policy), 0);
+    int upper = 0;
+    int total = 0;
+    for (int i = 0; i < 500; i++) {
+        ASSERT_GT(passphrase_generator_next(&generator, phrase, sizeof(phrase)), 0);
+        for (const std::string& part : split(phrase, " :: ")) {
+            upper += isupper((unsigned char)part[0]) ? 1 : 0;
+            total++;
+        }
+    }
+    EXPECT_GT(upper, total / 3);
+    EXPECT_LT(upper, total * 2 / 3);
+}
+
+TEST_F(PassphraseTest, EntropyAndLimits) {
+    double per_word = log2(7776.0);
+    EXPECT_NEAR(passphrase_entropy_bits(&policy), 6 * per_word, 1e-9);
+
+    policy.capitalize = PASSPHRASE_CAPS_RANDOM;
+    EXPECT_NEAR(passphrase_entropy_bits(&policy), 6 * per_word + 6, 1e-9);
+
+    policy.words = PASSPHRASE_MIN_WORDS - 1;
+    EXPECT_NE(passphrase_generator_init(&generator, &policy), 0);
+    policy.words = PASSPHRASE_MAX_WORDS + 1;
+    EXPECT_NE(passphrase_generator_init(&generator, &policy), 0);
+
+    policy.words = PASSPHRASE_MAX_WORDS;
+    strcpy(policy.separator, "12345678");
+    ASSERT_EQ(passphrase_generator_init(&generator, &policy), 0);
+    EXPECT_GT(passphrase_generator_next(&generator, phrase, sizeof(phrase)), 0);
+
+    char small[16];
+    EXPECT_EQ(passphrase_generator_next(&generator, small, sizeof(small)), -1);
+
+    passphrase_caps_t caps;
+    EXPECT_EQ(passphrase_parse_capitalize("random", &caps), 0);
+    EXPECT_EQ(caps, PASSPHRASE_CAPS_RANDOM);
+    EXPECT_NE(passphrase_parse_capitalize("shout", &caps), 0);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <cmath>
+
+extern "C" {
+    #include "password_gen.h"
+}
+
+class PasswordGenTest : public ::testing::Test {
+protected:
+    password_policy_t policy;
+    password_generator_t generator;
+    char password[PWGEN_MAX_LENGTH + 1];
+
+    void SetUp() override {
+        password_policy_default(&policy, 16);
+        memset(&generator, 0, sizeof(generator));
+    }
+
+    void TearDown() override {
+        password_generator_cleanup(&generator);
+    }
+};
+
+TEST_F(PasswordGenTest, DefaultPolicyGeneratesRequestedLength) {
+    ASSERT_EQ(password_generator_init(&generator, &policy), 0);
+    EXPECT_EQ(generator.charset_len, 76u);
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(password_generator_next(&generator, password, sizeof(password)), 16);
+        EXPECT_EQ(strlen(password), 16u);
+    }
+}
+
+TEST_F(PasswordGenTest, LengthRangeIsRespected) {
+    policy.min_length = 10;
+    policy.max_length = 14;
+    ASSERT_EQ(password_generator_init(&generator, &policy), 0);
+
+    bool seen[15] = {false};
+    for (int i = 0; i < 500; i++) {
+        int length = password_generator_next(&generator, password, sizeof(password));
+        ASSERT_GE(length, 10);
+        ASSERT_LE(length, 14);
+        seen[length] = true;
+    }
+
+    for (int length = 10; length <= 14; length++) {
+        EXPECT_TRUE(seen[length]) << "Length " << length << " never produced";
+    }
+}
+
+TEST_F(PasswordGenTest, RequiredClassesAlwaysPresent) {
+    policy.min_length = 4;
+    policy.max_length = 4;
+    policy.required_classes = PWGEN_CLASS_ALL;
+    ASSERT_EQ(password_generator_init(&generator, &policy), 0);
+
+    for (int i = 0; i < 200; i++) {
+        ASSERT_EQ(password_generator_next(&generator, password, sizeof(password)), 4);
+
+        bool lower = false, upper = false, digit = false, symbol = false;
+        for (const char* p = password; *p; p++) {
+            if (*p >= 'a' && *p <= 'z') lower = true;
+            else if (*p >= 'A' && *p <= 'Z') upper = true;
+            else if (*p >= '0' && *p <= '9') digit = true;
+            else symbol = true;
+        }
+        EXPECT_TRUE(lower && upper && digit && symbol) << password;
+    }
+}
+
+TEST_F(PasswordGenTest, ExcludesAmbiguousCharacters) {
+    policy.exclude_ambiguous = 1;
+    ASSERT_EQ(password_generator_init(&generator, &policy), 0);
+
+    for (int i = 0; i < 200; i++) {
+        ASSERT_GT(password_generator_next(&generator, password, sizeof(password)), 0);
+        EXPECT_EQ(strpbrk(password, PWGEN_AMBIGUOUS_CHARS), nullptr) << password;
+    }
+}
+
+TEST_F(PasswordGenTest, CustomAlphabetIsDeduplicated) {
+    strcpy(policy.alphabet, "abcabc");
+    ASSERT_EQ(password_generator_init(&generator, &policy), 0);
+    EXPECT_EQ(generator.charset_len, 3u);
+
+    ASSERT_GT(password_generator_next(&generator, password, sizeof(password)), 0);
+    EXPECT_EQ(strspn(password, "abc"), strlen(password));
+}
+
+TEST_F(PasswordGenTest, RejectsUnsatisfiablePolicies) {
+    password_policy_t bad = policy;
+    strcpy(bad.alphabet, "abcdef");
+    bad.required_classes = PWGEN_CLASS_DIGIT;
+    EXPECT_NE(password_generator_init(&generator, &bad), 0);
+
+    bad = policy;
+    bad.min_length = 20;
+    bad.max_length = 10;
+    EXPECT_NE(password_generator_init(&generator, &bad), 0);
+
+    bad = policy;
+    strcpy(bad.alphabet, "aaaa");
+    EXPECT_NE(password_generator_init(&generator, &bad), 0);
+}
+
+TEST_F(PasswordGenTest, ParseClassList) {
+    unsigned int classes = 0;
+    ASSERT_EQ(password_policy_parse_classes("lower,digit", &classes), 0);
+    EXPECT_EQ(classes, PWGEN_CLASS_LOWER | PWGEN_CLASS_DIGIT);
+
+    ASSERT_EQ(password_policy_parse_classes("all", &classes), 0);
+    EXPECT_EQ(classes, PWGEN_CLASS_ALL);
+
+    EXPECT_NE(password_policy_parse_classes("lower,emoji", &classes), 0);
+}
+
+TEST_F(PasswordGenTest, UniformOverNonPowerOfTwoAlphabet) {
+    ASSERT_EQ(password_generator_init(&generator, &policy), 0);
+
+    const int samples = 20000;
+    unsigned long counts[256] = {0};
+    for (int i = 0; i < samples; i++) {
+        ASSERT_EQ(password_generator_next(&generator, password, sizeof(password)), 16);
+        for (const char* p = password; *p; p++) {
+            counts[(unsigned char)*p]++;
+        }
+    }
+
+    double expected = samples * 16.0 / generator.charset_len;
+    double chi_square = 0.0;
+    for (size_t i = 0; i < generator.charset_len; i++) {
+        double diff = counts[(unsigned char)generator.charset[i]] - expected;
+        chi_square += diff * diff / expected;
+    }
+
+    // 75 degrees of freedom: p < 0.0001 above ~130.
+    EXPECT_LT(chi_square, 130.0);
+}
+
+TEST_F(PasswordGenTest, RandomPoolUniformLargeBound) {
+    random_pool_t pool;
+    random_pool_init(&pool);
+
+    for (int i = 0; i < 1000; i++) {
+        uint32_t value;
+        ASSERT_EQ(random_pool_uniform(&pool, 7776, &value), 0);
+        EXPECT_LT(value, 7776u);
+    }
+
+    uint32_t value;
+    EXPECT_NE(random_pool_uniform(&pool, 0, &value), 0);
+    random_pool_cleanup(&pool);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "vault_controller.h"
+}
+#include "vault_test_util.h"
+
+static void count_reloads(vault_handle_t*, void* context) {
+    static_cast<std::atomic<int>*>(context)->fetch_add(1);
+}
+
+class VaultReloadTest : public VaultFileTest {
+protected:
+    vault_handle_t* reader = nullptr;
+
+    VaultReloadTest() : VaultFileTest("/tmp/test_reload_vault.dat", "reload_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        ASSERT_EQ(write_entry("seed", "seed-pass"), 0);
+        reader = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+        ASSERT_NE(reader, nullptr);
+    }
+
+    void TearDown() override {
+        vault_handle_close(reader);
+        VaultFileTest::TearDown();
+    }
+
+    int write_entry(const char* service, const char* password) {
+        vault_handle_t* writer = vault_handle_open(master_password, test_vault_path, 0);
+        if (!writer) return -1;
+        int ret = vault_handle_store(writer, service, "user", password, nullptr, true);
+        vault_handle_close(writer);
+        return ret;
+    }
+};
+
+TEST_F(VaultReloadTest, ReloadPicksUpExternalChanges) {
+    EXPECT_EQ(vault_handle_reload(reader), 0);
+    EXPECT_EQ(vault_handle_generation(reader), 0u);
+
+    const vault_snapshot_t* old_snapshot = vault_snapshot_acquire(reader);
+    ASSERT_EQ(write_entry("mail", "m1"), 0);
+    ASSERT_EQ(write_entry("seed", "seed-new"), 0);
+    EXPECT_LT(vault_handle_find_entry(reader, "mail", "user"), 0);
+
+    EXPECT_EQ(vault_handle_reload(reader), 1);
+    EXPECT_EQ(vault_handle_generation(reader), 1u);
+    EXPECT_EQ(vault_handle_reload(reader), 0);
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_handle_get(reader, "mail", "user", &entry), 0);
+    EXPECT_STREQ(entry.password, "m1");
+    ASSERT_EQ(vault_handle_get(reader, "seed", "user", &entry), 0);
+    EXPECT_STREQ(entry.password, "seed-new");
+
+    EXPECT_EQ(vault_snapshot_count(old_snapshot), 1u);
+    EXPECT_STREQ(vault_snapshot_entry(old_snapshot, 0)->password, "seed-pass");
+    vault_snapshot_release(reader, old_snapshot);
+    EXPECT_EQ(vault_handle_retired_snapshots(reader), 0u);
+}
+
+TEST_F(VaultReloadTest, MasterPasswordChangeKeepsOldData) {
+    vault_handle_t* writer = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(writer, nullptr);
+    ASSERT_EQ(vault_handle_change_master_password(writer, master_password, "rotated"), 0);
+    vault_handle_close(writer);
+
+    EXPECT_EQ(vault_handle_reload(reader), -1);
+    EXPECT_EQ(vault_handle_generation(reader), 0u);
+    EXPECT_GE(vault_handle_find_entry(reader, "seed", "user"), 0);
+}
+
+TEST_F(VaultReloadTest, WatcherReloadsAfterSave) {
+    std::atomic<int> reloads(0);
+    ASSERT_EQ(vault_handle_watch(reader, count_reloads, &reloads), 0);
+    EXPECT_NE(vault_handle_watch(reader, nullptr, nullptr), 0);
+
+    ASSERT_EQ(write_entry("watched", "w1"), 0);
+    for (int i = 0; i < 200 && vault_handle_find_entry(reader, "watched", "user") < 0; i++) {
+        usleep(10000);
+    }
+    EXPECT_GE(vault_handle_find_entry(reader, "watched", "user"), 0);
+    EXPECT_GE(reloads.load(), 1);
+    EXPECT_GE(vault_handle_generation(reader), 1u);
+
+    vault_handle_t* writer = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(writer, nullptr);
+    EXPECT_NE(vault_handle_watch(writer, nullptr, nullptr), 0);
+    EXPECT_EQ(vault_handle_reload(writer), 0);
+    vault_handle_close(writer);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
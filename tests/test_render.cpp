@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+extern "C" {
+    #include "render.h"
+    #include "vault_controller.h"
+}
+
+class RenderTest : public ::testing::Test {
+protected:
+    const char* test_vault_path = "/tmp/test_render_vault.dat";
+    const char* test_backup_path = "/tmp/test_render_vault.dat.backup";
+    const char* master_password = "render_master_password";
+    render_refs_t refs;
+
+    void SetUp() override {
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        memset(&refs, 0, sizeof(refs));
+        ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+        ASSERT_EQ(vault_store("postgres", "app", "db-secret", nullptr, true), 0);
+        ASSERT_EQ(vault_store("smtp relay", "mailer", "smtp-secret", nullptr, true), 0);
+    }
+
+    void TearDown() override {
+        render_refs_free(&refs);
+        vault_cleanup();
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+    }
+
+    int scan(const std::string& text, size_t* line = nullptr) {
+        FILE* in = fmemopen((void*)text.data(), text.size(), "r");
+        int ret = render_scan(in, 0, &refs, line);
+        fclose(in);
+        return ret;
+    }
+
+    std::string render(const std::string& text, size_t* substitutions = nullptr) {
+        FILE* in = fmemopen((void*)text.data(), text.size(), "r");
+        char* buffer = nullptr;
+        size_t len = 0;
+        FILE* out = open_memstream(&buffer, &len);
+        EXPECT_EQ(render_stream(in, out, &refs, substitutions, nullptr), RENDER_OK);
+        fclose(in);
+        fclose(out);
+        std::string result(buffer, len);
+        free(buffer);
+        return result;
+    }
+
+    static void write_file(const char* path, const std::string& text) {
+        std::ofstream(path) << text;
+    }
+
+    static std::string read_file(const char* path) {
+        std::ifstream in(path);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+};
+
+TEST_F(RenderTest, SubstitutesVaultReferences) {
+    const std::string tmpl =
+        "url = postgres://{{ vault \"postgres\" \"app\" \"username\" }}:"
+        "{{ vault \"postgres\" \"app\" \"password\" }}@db/{x}\n"
+        "smtp = {{vault \"smtp relay\" mailer}}\n"
+        "again = {{ vault postgres app }}\n"
+        "other = {{ .Values.port }} { }\n";
+
+    ASSERT_EQ(scan(tmpl), RENDER_OK);
+    EXPECT_EQ(refs.count, 3u);
+    ASSERT_EQ(render_refs_resolve(&refs, nullptr), RENDER_OK);
+
+    size_t substitutions = 0;
+    EXPECT_EQ(render(tmpl, &substitutions),
+              "url = postgres://app:db-secret@db/{x}\n"
+              "smtp = smtp-secret\n"
+              "again = db-secret\n"
+              "other = {{ .Values.port }} { }\n");
+    EXPECT_EQ(substitutions, 4u);
+}
+
+TEST_F(RenderTest, ReportsErrorsWithLineNumbers) {
+    size_t line = 0;
+    EXPECT_EQ(scan("a\nb\n{{ vault postgres }}\n", &line), RENDER_ERR_SYNTAX);
+    EXPECT_EQ(line, 3u);
+    EXPECT_EQ(scan("{{ vault postgres app pin }}", &line), RENDER_ERR_SYNTAX);
+    EXPECT_EQ(scan("x\n{{ vault postgres app\n", &line), RENDER_ERR_SYNTAX);
+    EXPECT_EQ(line, 2u);
+    EXPECT_EQ(scan("{{ vault " + std::string(RENDER_TAG_MAX, 'a') + " }}", &line), RENDER_ERR_LIMIT);
+
+    render_refs_free(&refs);
+    ASSERT_EQ(scan("{{ vault postgres app }}\n{{ vault postgres nobody }}\n"), RENDER_OK);
+    size_t missing = 0;
+    EXPECT_EQ(render_refs_resolve(&refs, &missing), RENDER_ERR_MISSING);
+    EXPECT_EQ(refs.refs[missing].line, 2u);
+}
+
+TEST_F(RenderTest, RendersFilesWithPrivatePermissions) {
+    write_file("/tmp/test_render_a.conf.tmpl", "pw={{ vault postgres app }}\n");
+    write_file("/tmp/test_render_b.conf.tmpl", "smtp={{ vault \"smtp relay\" mailer }}\n");
+    unlink("/tmp/test_render_a.conf");
+    unlink("/tmp/test_render_b.conf");
+
+    render_job_t jobs[2];
+    memset(jobs, 0, sizeof(jobs));
+    jobs[0].input = "/tmp/test_render_a.conf.tmpl";
+    jobs[1].input = "/tmp/test_render_b.conf.tmpl";
+    ASSERT_EQ(render_output_path(jobs[0].input, jobs[0].output, sizeof(jobs[0].output)), 0);
+    ASSERT_EQ(render_output_path(jobs[1].input, jobs[1].output, sizeof(jobs[1].output)), 0);
+    EXPECT_STREQ(jobs[0].output, "/tmp/test_render_a.conf");
+
+    ASSERT_EQ(render_files(jobs, 2, 2), RENDER_OK);
+    EXPECT_EQ(read_file("/tmp/test_render_a.conf"), "pw=db-secret\n");
+    EXPECT_EQ(read_file("/tmp/test_render_b.conf"), "smtp=smtp-secret\n");
+
+    struct stat st;
+    ASSERT_EQ(stat("/tmp/test_render_b.conf", &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600u);
+
+    char output[64];
+    EXPECT_NE(render_output_path("config.yaml", output, sizeof(output)), 0);
+    EXPECT_NE(render_output_path(".tmpl", output, sizeof(output)), 0);
+
+    unlink("/tmp/test_render_a.conf.tmpl");
+    unlink("/tmp/test_render_b.conf.tmpl");
+    unlink("/tmp/test_render_a.conf");
+    unlink("/tmp/test_render_b.conf");
+}
+
+TEST_F(RenderTest, MissingEntryWritesNoOutput) {
+    write_file("/tmp/test_render_ok.tmpl", "{{ vault postgres app }}\n");
+    write_file("/tmp/test_render_bad.tmpl", "\n\n{{ vault postgres nobody }}\n");
+    unlink("/tmp/test_render_ok");
+    unlink("/tmp/test_render_bad");
+
+    render_job_t jobs[2];
+    memset(jobs, 0, sizeof(jobs));
+    jobs[0].input = "/tmp/test_render_ok.tmpl";
+    jobs[1].input = "/tmp/test_render_bad.tmpl";
+    strcpy(jobs[0].output, "/tmp/test_render_ok");
+    strcpy(jobs[1].output, "/tmp/test_render_bad");
+
+    EXPECT_EQ(render_files(jobs, 2, 0), RENDER_ERR_MISSING);
+    EXPECT_EQ(jobs[1].status, RENDER_ERR_MISSING);
+    EXPECT_EQ(jobs[1].error_line, 3u);
+    EXPECT_NE(access("/tmp/test_render_ok", F_OK), 0);
+    EXPECT_NE(access("/tmp/test_render_bad", F_OK), 0);
+
+    unlink("/tmp/test_render_ok.tmpl");
+    unlink("/tmp/test_render_bad.tmpl");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
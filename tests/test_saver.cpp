@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "vault_controller.h"
+}
+#include "vault_test_util.h"
+
+static std::atomic<int> g_saves(0);
+
+static void count_saves(vault_save_stage_t stage) {
+    if (stage == VAULT_SAVE_RENAMED) {
+        g_saves.fetch_add(1);
+    }
+}
+
+struct SaveErrors {
+    std::atomic<int> calls;
+    std::atomic<int> last_error;
+};
+
+static void record_error(vault_handle_t*, int error, void* context) {
+    SaveErrors* errors = static_cast<SaveErrors*>(context);
+    errors->last_error.store(error);
+    errors->calls.fetch_add(1);
+}
+
+class VaultSaverTest : public VaultFileTest {
+protected:
+    const char* test_dir = "/tmp/test_saver_dir";
+
+    VaultSaverTest() : VaultFileTest("/tmp/test_saver_dir/vault.dat", "saver_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        rmdir(test_dir);
+        ASSERT_EQ(mkdir(test_dir, 0700), 0);
+        g_saves.store(0);
+    }
+
+    void TearDown() override {
+        vault_set_save_hook(nullptr);
+        VaultFileTest::TearDown();
+        rmdir(test_dir);
+    }
+
+    size_t reopened_count() {
+        vault_handle_t* vault = vault_handle_open(master_password, test_vault_path,
+                                                  VAULT_OPEN_READ_ONLY);
+        if (!vault) return 0;
+        size_t count = vault_handle_entry_count(vault);
+        vault_handle_close(vault);
+        return count;
+    }
+};
+
+TEST_F(VaultSaverTest, BurstIsCoalescedIntoFewSaves) {
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    off_t empty_size = test_file_size(test_vault_path);
+    ASSERT_EQ(vault_handle_start_saver(vault, 1000, nullptr, nullptr), 0);
+    EXPECT_NE(vault_handle_start_saver(vault, 1000, nullptr, nullptr), 0);
+    vault_set_save_hook(count_saves);
+
+    for (int i = 0; i < 100; i++) {
+        char service[32];
+        snprintf(service, sizeof(service), "burst%d", i);
+        ASSERT_EQ(put(vault, service, service), 0);
+    }
+    EXPECT_EQ(g_saves.load(), 0);
+    EXPECT_EQ(test_file_size(test_vault_path), empty_size);
+    EXPECT_EQ(vault_handle_entry_count(vault), 100u);
+
+    ASSERT_EQ(vault_handle_flush(vault), 0);
+    EXPECT_EQ(g_saves.load(), 1);
+    EXPECT_EQ(vault_handle_flush(vault), 0);
+    EXPECT_EQ(g_saves.load(), 1);
+    off_t saved_size = test_file_size(test_vault_path);
+    EXPECT_GT(saved_size, empty_size);
+
+    ASSERT_EQ(vault_handle_begin_batch(vault), 0);
+    ASSERT_EQ(put(vault, "batched", "batched"), 0);
+    EXPECT_NE(vault_handle_flush(vault), 0);
+    ASSERT_EQ(vault_handle_commit_batch(vault), 0);
+    ASSERT_EQ(vault_handle_sync(vault), 0);
+    EXPECT_EQ(g_saves.load(), 2);
+    EXPECT_GT(test_file_size(test_vault_path), saved_size);
+
+    vault_handle_close(vault);
+    EXPECT_EQ(g_saves.load(), 2);
+    EXPECT_EQ(reopened_count(), 101u);
+}
+
+TEST_F(VaultSaverTest, CloseWritesPendingChanges) {
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    ASSERT_EQ(vault_handle_start_saver(vault, 60000, nullptr, nullptr), 0);
+    ASSERT_EQ(put(vault, "one", "one"), 0);
+    ASSERT_EQ(put(vault, "two", "two"), 0);
+    vault_handle_close(vault);
+
+    EXPECT_EQ(reopened_count(), 2u);
+
+    vault = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_NE(vault_handle_start_saver(vault, 0, nullptr, nullptr), 0);
+    vault_handle_close(vault);
+}
+
+TEST_F(VaultSaverTest, MasterPasswordChangeIsNotOverwritten) {
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    ASSERT_EQ(vault_handle_start_saver(vault, 0, nullptr, nullptr), 0);
+    for (int i = 0; i < 20; i++) {
+        char service[32];
+        snprintf(service, sizeof(service), "entry%d", i);
+        ASSERT_EQ(put(vault, service, service), 0);
+    }
+    ASSERT_EQ(vault_handle_change_master_password(vault, master_password, "rotated"), 0);
+    vault_handle_close(vault);
+
+    vault = vault_handle_open("rotated", test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_entry_count(vault), 20u);
+    vault_handle_close(vault);
+}
+
+TEST_F(VaultSaverTest, FailedSaveIsReported) {
+    SaveErrors errors;
+    errors.calls.store(0);
+    errors.last_error.store(0);
+
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+    ASSERT_NE(vault, nullptr);
+    ASSERT_EQ(vault_handle_start_saver(vault, 0, record_error, &errors), 0);
+    ASSERT_EQ(put(vault, "saved", "saved"), 0);
+    ASSERT_EQ(vault_handle_flush(vault), 0);
+    EXPECT_EQ(errors.calls.load(), 0);
+
+    remove_vault_files(test_vault_path);
+    ASSERT_EQ(rmdir(test_dir), 0);
+
+    ASSERT_EQ(put(vault, "lost", "lost"), 0);
+    EXPECT_NE(vault_handle_flush(vault), 0);
+    EXPECT_GE(errors.calls.load(), 1);
+    EXPECT_EQ(errors.last_error.load(), ENOENT);
+
+    ASSERT_EQ(mkdir(test_dir, 0700), 0);
+    ASSERT_EQ(put(vault, "recovered", "recovered"), 0);
+    ASSERT_EQ(vault_handle_flush(vault), 0);
+    vault_handle_close(vault);
+    EXPECT_EQ(reopened_count(), 3u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
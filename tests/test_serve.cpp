@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <thread>
+extern "C" {
+    #include "serve.h"
+    #include "vault_controller.h"
+}
+
+class ServeTest : public ::testing::Test {
+protected:
+    const char* test_vault_path = "/tmp/test_serve_vault.dat";
+    const char* test_backup_path = "/tmp/test_serve_vault.dat.backup";
+    const char* master_password = "serve_master_password";
+    serve_stats_t stats;
+
+    void SetUp() override {
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        memset(&stats, 0, sizeof(stats));
+        ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+        ASSERT_EQ(vault_store("github", "alice", "gh-pass", "JBSWY3DPEHPK3PXP", true), 0);
+        ASSERT_EQ(vault_store("gitlab", "bob", "gl-pass", nullptr, true), 0);
+    }
+
+    void TearDown() override {
+        vault_cleanup();
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+    }
+
+    std::string request(const std::string& json, int* status = nullptr) {
+        char* buffer = nullptr;
+        size_t len = 0;
+        FILE* out = open_memstream(&buffer, &len);
+        std::string line = json;
+        int ret = serve_handle_request(&line[0], line.size(), out, &stats);
+        fclose(out);
+        std::string response(buffer, len);
+        free(buffer);
+        if (status) *status = ret;
+        return response;
+    }
+
+    std::string serve(const std::string& input) {
+        int fds[2];
+        EXPECT_EQ(pipe(fds), 0);
+        EXPECT_EQ(write(fds[1], input.data(), input.size()), (ssize_t)input.size());
+        close(fds[1]);
+
+        char* buffer = nullptr;
+        size_t len = 0;
+        FILE* out = open_memstream(&buffer, &len);
+        EXPECT_EQ(serve_stdio(fds[0], out, &stats), 0);
+        fclose(out);
+        close(fds[0]);
+
+        std::string output(buffer, len);
+        free(buffer);
+        return output;
+    }
+
+    static int connect_to(const char* path) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path);
+        for (int attempt = 0; attempt < 200; attempt++) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) return fd;
+            close(fd);
+            usleep(10000);
+        }
+        return -1;
+    }
+
+    static std::string read_line(int fd) {
+        std::string line;
+        char c;
+        while (read(fd, &c, 1) == 1) {
+            line += c;
+            if (c == '\n') break;
+        }
+        return line;
+    }
+
+    static void send_line(int fd, const std::string& line) {
+        EXPECT_EQ(write(fd, line.data(), line.size()), (ssize_t)line.size());
+    }
+};
+
+TEST_F(ServeTest, GetReturnsStructuredEntry) {
+    std::string response = request("{\"id\": 7, \"op\": \"get\", \"service\": \"github\", \"username\": \"alice\"}");
+
+    EXPECT_EQ(response.rfind("{\"id\":7,\"ok\":true,\"result\":{\"service\":\"github\",\"username\":\"alice\","
+                             "\"password\":\"gh-pass\",\"totp\":true,", 0), 0u) << response;
+    EXPECT_EQ(response.back(), '\n');
+    EXPECT_EQ(std::count(response.begin(), response.end(), '\n'), 1);
+}
+
+TEST_F(ServeTest, StructuredErrorsEchoRequestId) {
+    EXPECT_EQ(request("{\"id\":\"q1\",\"op\":\"get\",\"service\":\"nope\",\"username\":\"x\"}"),
+              "{\"id\":\"q1\",\"ok\":false,\"error\":{\"code\":\"not_found\",\"message\":\"no such entry\"}}\n");
+    EXPECT_NE(request("{\"id\":2,\"op\":\"get\",\"service\":\"github\"}").find("\"invalid_params\""), std::string::npos);
+    EXPECT_NE(request("{\"id\":3,\"op\":\"launch\"}").find("\"unknown_op\""), std::string::npos);
+    EXPECT_NE(request("{\"id\":4,\"v\":2,\"op\":\"ping\"}").find("\"unsupported_version\""), std::string::npos);
+    EXPECT_NE(request("{\"id\":5}").find("\"invalid_request\""), std::string::npos);
+
+    const char* malformed[] = {
+        "", "[]", "{\"id\":1,", "{\"op\":\"ping\"} x", "{\"op\":{\"nested\":1}}",
+        "{\"op\":\"ping\",\"id\":nope}", "{\"op\":\"bad\\q\"}"
+    };
+    for (const char* line : malformed) {
+        EXPECT_EQ(request(line), "{\"id\":null,\"ok\":false,\"error\":{\"code\":\"parse_error\","
+                                 "\"message\":\"request is not a flat JSON object\"}}\n") << line;
+    }
+    EXPECT_EQ(stats.errors, 12u);
+}
+
+TEST_F(ServeTest, StoreAndRemoveUseEscapedStrings) {
+    int status;
+    EXPECT_EQ(request("{\"id\":1,\"op\":\"store\",\"service\":\"caf\\u00e9\",\"username\":\"a\\\"b\","
+                      "\"password\":\"p\\u00e9\\n\\ud83d\\ude00\"}", &status),
+              "{\"id\":1,\"ok\":true,\"result\":{\"created\":true}}\n");
+    EXPECT_EQ(status, SERVE_CONTINUE);
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_get("caf\xc3\xa9", "a\"b", &entry), 0);
+    EXPECT_STREQ(entry.password, "p\xc3\xa9\n\xf0\x9f\x98\x80");
+
+    EXPECT_NE(request("{\"id\":2,\"op\":\"search\",\"query\":\"CAF\"}").find("\"count\":1,"), std::string::npos);
+    EXPECT_EQ(request("{\"id\":3,\"op\":\"remove\",\"service\":\"caf\\u00e9\",\"username\":\"a\\\"b\"}"),
+              "{\"id\":3,\"ok\":true,\"result\":{}}\n");
+    EXPECT_EQ(vault_entry_count(), 2u);
+
+    request("{\"id\":4,\"op\":\"quit\"}", &status);
+    EXPECT_EQ(status, SERVE_QUIT);
+}
+
+TEST_F(ServeTest, PipelinedRequestsAnswerInOrderWithOneSave) {
+    std::string input;
+    for (int i = 0; i < 200; i++) {
+        input += "{\"id\":" + std::to_string(i) + ",\"op\":\"store\",\"service\":\"svc" +
+                 std::to_string(i) + "\",\"username\":\"u\",\"password\":\"p\"}\n";
+    }
+    input += "{\"id\":\"last\",\"op\":\"totp\",\"service\":\"github\",\"username\":\"alice\"}";
+
+    std::string output = serve(input);
+
+    size_t pos = output.find('\n');
+    ASSERT_NE(pos, std::string::npos);
+    EXPECT_EQ(output.substr(0, pos), "{\"protocol\":1,\"server\":\"securekey\",\"entries\":2}");
+    for (int i = 0; i < 200; i++) {
+        std::string expected = "{\"id\":" + std::to_string(i) + ",\"ok\":true,\"result\":{\"created\":true}}\n";
+        ASSERT_EQ(output.compare(pos + 1, expected.size(), expected), 0) << i;
+        pos += expected.size();
+    }
+    EXPECT_NE(output.find("{\"id\":\"last\",\"ok\":true,\"result\":{\"code\":\"", pos), std::string::npos);
+
+    EXPECT_EQ(stats.requests, 201u);
+    EXPECT_EQ(stats.errors, 0u);
+    EXPECT_LE(stats.commits, 3u);
+
+    vault_cleanup();
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    EXPECT_EQ(vault_entry_count(), 202u);
+    EXPECT_GE(vault_find_entry("svc199", "u"), 0);
+}
+
+TEST_F(ServeTest, FailedSaveFailsOnlyTheChanges) {
+    const char* dir = "/tmp/test_serve_fail";
+    std::string path = std::string(dir) + "/vault.dat";
+    vault_cleanup();
+    mkdir(dir, 0700);
+    ASSERT_EQ(vault_init(master_password, path.c_str()), 0);
+    ASSERT_EQ(vault_store("github", "alice", "gh-pass", nullptr, true), 0);
+
+    unlink(path.c_str());
+    unlink((path + ".backup").c_str());
+    unlink((path + ".lock").c_str());
+    ASSERT_EQ(rmdir(dir), 0);
+
+    std::string input =
+        "{\"id\":1,\"op\":\"get\",\"service\":\"github\",\"username\":\"alice\"}\n"
+        "{\"id\":\"s\",\"op\":\"store\",\"service\":\"npm\",\"username\":\"a\",\"password\":\"np\"}\n"
+        "{\"id\":3,\"op\":\"store\",\"service\":\"npm\",\"username\":\"a\"}\n"
+        "{\"id\":4,\"op\":\"remove\",\"service\":\"github\",\"username\":\"alice\"}\n"
+        "{\"id\":5,\"op\":\"ping\"}\n";
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], input.data(), input.size()), (ssize_t)input.size());
+    close(fds[1]);
+
+    char* buffer = nullptr;
+    size_t len = 0;
+    FILE* out = open_memstream(&buffer, &len);
+    EXPECT_NE(serve_stdio(fds[0], out, &stats), 0);
+    fclose(out);
+    close(fds[0]);
+    std::string output(buffer, len);
+    free(buffer);
+
+    const std::string failed = ",\"ok\":false,\"error\":{\"code\":\"save_failed\","
+                               "\"message\":\"vault could not be saved, changes are lost\"}}\n";
+    size_t pos = output.find('\n') + 1;
+    const std::string kept = "{\"id\":1,\"ok\":true,\"result\":{\"service\":\"github\",\"username\":\"alice\"";
+    EXPECT_EQ(output.compare(pos, kept.size(), kept), 0) << output;
+    pos = output.find('\n', pos) + 1;
+    EXPECT_EQ(output.compare(pos, std::string::npos,
+                             "{\"id\":\"s\"" + failed +
+                             "{\"id\":3,\"ok\":false,\"error\":{\"code\":\"invalid_params\","
+                             "\"message\":\"password is required (max 255 bytes)\"}}\n"
+                             "{\"id\":4" + failed +
+                             "{\"id\":5,\"ok\":true,\"result\":{}}\n"), 0)
+        << output;
+    EXPECT_EQ(stats.requests, 5u);
+    EXPECT_EQ(stats.errors, 3u);
+
+    mkdir(dir, 0700);
+    vault_cleanup();
+    unlink(path.c_str());
+    unlink((path + ".backup").c_str());
+    unlink((path + ".lock").c_str());
+    rmdir(dir);
+}
+
+TEST_F(ServeTest, SocketServesClientsIndependently) {
+    const char* path = "/tmp/test_serve.sock";
+    int ret = -1;
+    std::thread server([&] { ret = serve_socket(path, &stats); });
+
+    int a = connect_to(path);
+    int b = connect_to(path);
+    ASSERT_GE(a, 0);
+    ASSERT_GE(b, 0);
+    EXPECT_EQ(read_line(a), "{\"protocol\":1,\"server\":\"securekey\",\"entries\":2}\n");
+    EXPECT_EQ(read_line(b), "{\"protocol\":1,\"server\":\"securekey\",\"entries\":2}\n");
+
+    send_line(a, "{\"id\":1,\"op\":\"store\",\"service\":\"npm\",\"username\":\"a\",\"password\":\"np\"}\n");
+    EXPECT_EQ(read_line(a), "{\"id\":1,\"ok\":true,\"result\":{\"created\":true}}\n");
+
+    send_line(b, "{\"id\":2,\"op\":\"get\",\"service\":\"npm\",\"username\":\"a\"}\n{\"id\":3,\"op\":\"quit\"}\n");
+    EXPECT_EQ(read_line(b).rfind("{\"id\":2,\"ok\":true,\"result\":{\"service\":\"npm\"", 0), 0u);
+    EXPECT_EQ(read_line(b), "{\"id\":3,\"ok\":true,\"result\":{}}\n");
+    EXPECT_EQ(read_line(b), "");
+
+    send_line(a, "{\"id\":4,\"op\":\"ping\"}\n");
+    EXPECT_EQ(read_line(a), "{\"id\":4,\"ok\":true,\"result\":{}}\n");
+
+    close(a);
+    close(b);
+    serve_stop();
+    server.join();
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(stats.connections, 2u);
+    EXPECT_EQ(stats.requests, 4u);
+    EXPECT_EQ(stats.errors, 0u);
+    struct stat st;
+    EXPECT_NE(stat(path, &st), 0);
+    EXPECT_GE(vault_find_entry("npm", "a"), 0);
+}
+
+TEST_F(ServeTest, SocketClientThatStopsReadingDoesNotStallOthers) {
+    std::string padding(120, 'x');
+    ASSERT_EQ(vault_begin_batch(), 0);
+    for (int i = 0; i < 300; i++) {
+        std::string service = "bulk" + std::to_string(i) + padding;
+        ASSERT_EQ(vault_store(service.c_str(), "u", "p", nullptr, true), 0);
+    }
+    ASSERT_EQ(vault_commit_batch(), 0);
+
+    const char* path = "/tmp/test_serve_stall.sock";
+    int ret = -1;
+    std::thread server([&] { ret = serve_socket(path, &stats); });
+
+    int stalled = connect_to(path);
+    int other = connect_to(path);
+    ASSERT_GE(stalled, 0);
+    ASSERT_GE(other, 0);
+    read_line(stalled);
+    read_line(other);
+
+    // Far more output than the socket buffers hold, none of it read yet.
+    std::string lists;
+    for (int i = 0; i < 60; i++) {
+        lists += "{\"id\":" + std::to_string(i) + ",\"op\":\"list\"}\n";
+    }
+    send_line(stalled, lists);
+
+    struct timeval timeout = {5, 0};
+    setsockopt(other, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    for (int i = 0; i < 20; i++) {
+        send_line(other, "{\"id\":" + std::to_string(i) + ",\"op\":\"ping\"}\n");
+        ASSERT_EQ(read_line(other), "{\"id\":" + std::to_string(i) + ",\"ok\":true,\"result\":{}}\n");
+    }
+
+    // The stalled client still gets every answer once it reads.
+    for (int i = 0; i < 60; i++) {
+        std::string line = read_line(stalled);
+        ASSERT_EQ(line.rfind("{\"id\":" + std::to_string(i) + ",\"ok\":true,\"result\":{\"count\":302,", 0), 0u) << i;
+    }
+
+    close(stalled);
+    close(other);
+    serve_stop();
+    server.join();
+
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(stats.requests, 80u);
+    EXPECT_EQ(stats.errors, 0u);
+}
@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+extern "C" {
+    #include "vault_controller.h"
+}
+
+static int g_saves = 0;
+
+static void count_saves(vault_save_stage_t stage) {
+    if (stage == VAULT_SAVE_RENAMED) {
+        g_saves++;
+    }
+}
+
+class VaultShardTest : public ::testing::Test {
+protected:
+    const char* sharded_path = "/tmp/test_shards_vault.d";
+    const char* single_path = "/tmp/test_shards_vault.dat";
+    const char* copy_path = "/tmp/test_shards_copy.dat";
+    const char* master_password = "shard_master_password";
+    const uint32_t shards = 8;
+
+    void remove_vault(const char* path) {
+        std::string base(path);
+        for (uint32_t s = 0; s < VAULT_MAX_SHARDS; s++) {
+            char shard[64];
+            snprintf(shard, sizeof(shard), "/" VAULT_SHARD_PREFIX "%03u", s);
+            unlink((base + shard).c_str());
+        }
+        unlink((base + "/" VAULT_MANIFEST_NAME).c_str());
+        rmdir(path);
+        unlink(path);
+        unlink((base + ".backup").c_str());
+        unlink((base + ".lock").c_str());
+    }
+
+    void SetUp() override {
+        remove_vault(sharded_path);
+        remove_vault(single_path);
+        remove_vault(copy_path);
+        vault_set_durability(VAULT_DURABILITY_NONE);
+        g_saves = 0;
+    }
+
+    void TearDown() override {
+        vault_set_save_hook(nullptr);
+        vault_set_durability(VAULT_DURABILITY_FSYNC);
+        remove_vault(sharded_path);
+        remove_vault(single_path);
+        remove_vault(copy_path);
+    }
+
+    std::string shard_file(uint32_t s) {
+        char name[64];
+        snprintf(name, sizeof(name), "/" VAULT_SHARD_PREFIX "%03u", s);
+        return std::string(sharded_path) + name;
+    }
+
+    std::vector<std::string> shard_contents() {
+        std::vector<std::string> contents;
+        for (uint32_t s = 0; s < shards; s++) {
+            std::string data;
+            FILE* fp = fopen(shard_file(s).c_str(), "rb");
+            if (fp) {
+                char buffer[4096];
+                size_t n;
+                while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) data.append(buffer, n);
+                fclose(fp);
+            }
+            contents.push_back(data);
+        }
+        return contents;
+    }
+
+    static int store(vault_handle_t* vault, int i) {
+        char service[32], password[32];
+        snprintf(service, sizeof(service), "service%d", i);
+        snprintf(password, sizeof(password), "pw-%d", i);
+        return vault_handle_store(vault, service, "user", password, nullptr, true);
+    }
+
+    void fill(const char* path, int count) {
+        vault_handle_t* vault = vault_handle_open(master_password, path, 0);
+        ASSERT_NE(vault, nullptr);
+        ASSERT_EQ(vault_handle_begin_batch(vault), 0);
+        for (int i = 0; i < count; i++) {
+            ASSERT_EQ(store(vault, i), 0);
+        }
+        ASSERT_EQ(vault_handle_commit_batch(vault), 0);
+        vault_handle_close(vault);
+    }
+
+    void expect_entries(const char* path, int count) {
+        vault_handle_t* vault = vault_handle_open(master_password, path, VAULT_OPEN_READ_ONLY);
+        ASSERT_NE(vault, nullptr);
+        EXPECT_EQ(vault_handle_entry_count(vault), (size_t)count);
+        for (int i = 0; i < count; i++) {
+            char service[32], password[32];
+            snprintf(service, sizeof(service), "service%d", i);
+            snprintf(password, sizeof(password), "pw-%d", i);
+            VaultEntry entry;
+            ASSERT_EQ(vault_handle_get(vault, service, "user", &entry), 0) << service;
+            EXPECT_STREQ(entry.password, password);
+        }
+        vault_handle_close(vault);
+    }
+};
+
+TEST_F(VaultShardTest, StoresAndReopensAcrossShards) {
+    ASSERT_EQ(vault_create_sharded(sharded_path, shards), 0);
+    EXPECT_NE(vault_create_sharded(sharded_path, shards), 0);
+    EXPECT_NE(vault_create_sharded("/tmp/test_shards_bad.d", 0), 0);
+
+    fill(sharded_path, 200);
+    expect_entries(sharded_path, 200);
+
+    vault_handle_t* vault = vault_handle_open(master_password, sharded_path, 0);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_shard_count(vault), shards);
+    EXPECT_NE(vault_handle_change_master_password(vault, master_password, "other"), 0);
+    vault_handle_close(vault);
+
+    int populated = 0;
+    for (uint32_t s = 0; s < shards; s++) {
+        struct stat st;
+        ASSERT_EQ(stat(shard_file(s).c_str(), &st), 0);
+        populated += st.st_size > (off_t)sizeof(VaultHeader);
+    }
+    EXPECT_EQ(populated, (int)shards);
+}
+
+TEST_F(VaultShardTest, MutationRewritesOnlyAffectedShard) {
+    ASSERT_EQ(vault_create_sharded(sharded_path, shards), 0);
+    fill(sharded_path, 50);
+
+    vault_handle_t* vault = vault_handle_open(master_password, sharded_path, 0);
+    ASSERT_NE(vault, nullptr);
+    std::vector<std::string> before = shard_contents();
+
+    vault_set_save_hook(count_saves);
+    ASSERT_EQ(vault_handle_store(vault, "service7", "user", "changed", nullptr, true), 0);
+    EXPECT_EQ(g_saves, 1);
+    ASSERT_EQ(vault_handle_remove(vault, "service7", "user"), 0);
+    EXPECT_EQ(g_saves, 2);
+    vault_handle_close(vault);
+
+    std::vector<std::string> after = shard_contents();
+    int rewritten = 0;
+    for (uint32_t s = 0; s < shards; s++) {
+        rewritten += before[s] != after[s];
+    }
+    EXPECT_EQ(rewritten, 1);
+
+    vault = vault_handle_open(master_password, sharded_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_entry_count(vault), 49u);
+    EXPECT_LT(vault_handle_find_entry(vault, "service7", "user"), 0);
+    vault_handle_close(vault);
+}
+
+TEST_F(VaultShardTest, ReshardRoundTrip) {
+    fill(single_path, 120);
+
+    ASSERT_EQ(vault_reshard(master_password, single_path, sharded_path, shards), 0);
+    EXPECT_NE(vault_reshard(master_password, single_path, sharded_path, shards), 0);
+    expect_entries(sharded_path, 120);
+
+    ASSERT_EQ(vault_reshard(master_password, sharded_path, copy_path, 1), 0);
+    expect_entries(copy_path, 120);
+
+    vault_handle_t* vault = vault_handle_open(master_password, copy_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_shard_count(vault), 1u);
+    vault_handle_close(vault);
+}
+
+TEST_F(VaultShardTest, SwappedShardsAreRejected) {
+    ASSERT_EQ(vault_create_sharded(sharded_path, shards), 0);
+    fill(sharded_path, 40);
+
+    std::string a = shard_file(1), b = shard_file(2), tmp = shard_file(1) + ".swap";
+    ASSERT_EQ(rename(a.c_str(), tmp.c_str()), 0);
+    ASSERT_EQ(rename(b.c_str(), a.c_str()), 0);
+    ASSERT_EQ(rename(tmp.c_str(), b.c_str()), 0);
+
+    EXPECT_EQ(vault_handle_open(master_password, sharded_path, VAULT_OPEN_READ_ONLY), nullptr);
+}
+
+TEST_F(VaultShardTest, ReloadReadsOnlyChangedShards) {
+    ASSERT_EQ(vault_create_sharded(sharded_path, shards), 0);
+    fill(sharded_path, 60);
+
+    vault_handle_t* reader = vault_handle_open(master_password, sharded_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(reader, nullptr);
+    const vault_snapshot_t* before = vault_snapshot_acquire(reader);
+
+    vault_handle_t* writer = vault_handle_open(master_password, sharded_path, 0);
+    ASSERT_NE(writer, nullptr);
+    ASSERT_EQ(vault_handle_store(writer, "service10", "user", "reloaded", nullptr, true), 0);
+    vault_handle_close(writer);
+
+    ASSERT_EQ(vault_handle_reload(reader), 1);
+    VaultEntry entry;
+    ASSERT_EQ(vault_handle_get(reader, "service10", "user", &entry), 0);
+    EXPECT_STREQ(entry.password, "reloaded");
+    EXPECT_EQ(vault_handle_entry_count(reader), 60u);
+
+    const vault_snapshot_t* after = vault_snapshot_acquire(reader);
+    size_t shared = 0;
+    for (size_t i = 0; i < vault_snapshot_count(after); i++) {
+        const VaultEntry* current = vault_snapshot_entry(after, i);
+        int old_index = vault_snapshot_find(before, current->service, current->username);
+        shared += old_index >= 0 && vault_snapshot_entry(before, (size_t)old_index) == current;
+    }
+    EXPECT_GT(shared, 0u);
+    EXPECT_LT(shared, 60u);
+    vault_snapshot_release(reader, after);
+    vault_snapshot_release(reader, before);
+
+    vault_handle_close(reader);
+}
+
+TEST_F(VaultShardTest, BackgroundSaverWritesChangedShards) {
+    ASSERT_EQ(vault_create_sharded(sharded_path, shards), 0);
+    vault_handle_t* vault = vault_handle_open(master_password, sharded_path, 0);
+    ASSERT_NE(vault, nullptr);
+    ASSERT_EQ(vault_handle_start_saver(vault, 1000, nullptr, nullptr), 0);
+
+    vault_set_save_hook(count_saves);
+    for (int i = 0; i < 30; i++) {
+        ASSERT_EQ(store(vault, i), 0);
+    }
+    EXPECT_EQ(g_saves, 0);
+    ASSERT_EQ(vault_handle_flush(vault), 0);
+    EXPECT_EQ(g_saves, (int)shards);
+
+    ASSERT_EQ(store(vault, 30), 0);
+    vault_handle_close(vault);
+    EXPECT_EQ(g_saves, (int)shards + 1);
+
+    expect_entries(sharded_path, 31);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
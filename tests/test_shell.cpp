@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "shell.h"
+    #include "totp_engine.h"
+    #include "vault_controller.h"
+}
+
+class ShellTest : public ::testing::Test {
+protected:
+    const char* test_vault_path = "/tmp/test_shell_vault.dat";
+    const char* test_backup_path = "/tmp/test_shell_vault.dat.backup";
+    const char* master_password = "shell_master_password";
+    shell_session_t session;
+
+    void SetUp() override {
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+        ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+        ASSERT_EQ(vault_store("github", "alice", "original", nullptr, true), 0);
+        shell_session_init(&session, test_vault_path, 0, 0);
+    }
+
+    void TearDown() override {
+        shell_session_cleanup(&session);
+        vault_cleanup();
+        unlink(test_vault_path);
+        unlink(test_backup_path);
+    }
+
+    int run_script(const char* script) {
+        FILE* in = fmemopen((void*)script, strlen(script), "r");
+        testing::internal::CaptureStdout();
+        testing::internal::CaptureStderr();
+        int ret = shell_run(&session, in);
+        testing::internal::GetCapturedStdout();
+        testing::internal::GetCapturedStderr();
+        fclose(in);
+        return ret;
+    }
+
+    std::string stored_password(const char* service, const char* username) {
+        vault_cleanup();
+        EXPECT_EQ(vault_init(master_password, test_vault_path), 0);
+        VaultEntry entry;
+        testing::internal::CaptureStderr();
+        int found = vault_get(service, username, &entry);
+        testing::internal::GetCapturedStderr();
+        return found == 0 ? std::string(entry.password) : std::string();
+    }
+};
+
+TEST_F(ShellTest, TokenizerHandlesQuotesAndEscapes) {
+    char line[] = "store \"my bank\" 'bob smith' pa\\ ss \"q\\\"uote\"\n";
+    char* argv[SHELL_MAX_ARGS];
+
+    ASSERT_EQ(shell_tokenize(line, argv, SHELL_MAX_ARGS), 5);
+    EXPECT_STREQ(argv[0], "store");
+    EXPECT_STREQ(argv[1], "my bank");
+    EXPECT_STREQ(argv[2], "bob smith");
+    EXPECT_STREQ(argv[3], "pa ss");
+    EXPECT_STREQ(argv[4], "q\"uote");
+
+    char unbalanced[] = "get \"github alice";
+    EXPECT_EQ(shell_tokenize(unbalanced, argv, SHELL_MAX_ARGS), -1);
+
+    char blank[] = "   \t\n";
+    EXPECT_EQ(shell_tokenize(blank, argv, SHELL_MAX_ARGS), 0);
+}
+
+TEST_F(ShellTest, HistoryRedactsSecrets) {
+    char store_line[] = "store \"my bank\" bob hunter2 --totp JBSWY3DPEHPK3PXP";
+    char get_line[] = "get github alice --show";
+
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(shell_execute(&session, store_line), SHELL_OK);
+    EXPECT_EQ(shell_execute(&session, get_line), SHELL_OK);
+    testing::internal::GetCapturedStdout();
+
+    EXPECT_STREQ(shell_history_get(&session, 0), "store \"my bank\" bob ******** --totp ********");
+    EXPECT_STREQ(shell_history_get(&session, 1), "get github alice --show");
+    EXPECT_EQ(shell_history_get(&session, 2), nullptr);
+
+    for (int i = 0; i < SHELL_HISTORY_SIZE + 5; i++) {
+        char line[32];
+        snprintf(line, sizeof(line), "help %d", i);
+        testing::internal::CaptureStdout();
+        shell_execute(&session, line);
+        testing::internal::GetCapturedStdout();
+    }
+    EXPECT_STREQ(shell_history_get(&session, 0), "help 5");
+    EXPECT_EQ(shell_history_get(&session, SHELL_HISTORY_SIZE), nullptr);
+}
+
+TEST_F(ShellTest, ScriptCommitsOnce) {
+    const char* script =
+        "# provisioning\n"
+        "store gitlab bob s3cret\n"
+        "store github alice changed\n"
+        "remove gitlab bob\n"
+        "store bank carol \"two words\"\n"
+        "list\n";
+
+    EXPECT_EQ(run_script(script), 0);
+    EXPECT_EQ(stored_password("github", "alice"), "changed");
+    EXPECT_EQ(stored_password("bank", "carol"), "two words");
+    EXPECT_EQ(stored_password("gitlab", "bob"), "");
+}
+
+TEST_F(ShellTest, FailedScriptSavesNothing) {
+    const char* script =
+        "store github alice changed\n"
+        "store bank carol secret\n"
+        "remove missing entry\n"
+        "store never reached\n";
+
+    EXPECT_EQ(run_script(script), 1);
+    EXPECT_EQ(session.line_number, 3u);
+    EXPECT_EQ(stored_password("github", "alice"), "original");
+    EXPECT_EQ(stored_password("bank", "carol"), "");
+}
+
+TEST_F(ShellTest, StoreKeepsOtpSettingsOfExistingEntry) {
+    VaultEntry hotp;
+    memset(&hotp, 0, sizeof(hotp));
+    strcpy(hotp.service, "bank");
+    strcpy(hotp.username, "carol");
+    strcpy(hotp.totp_secret, "GEZDGNBVGY3TQOJQ");
+    hotp.totp_type = OTP_TYPE_HOTP;
+    hotp.totp_counter = 7;
+    hotp.totp_digits = 8;
+    ASSERT_EQ(vault_put_entry(&hotp), 0);
+
+    EXPECT_EQ(run_script("store bank carol newpass\n"), 0);
+    EXPECT_EQ(stored_password("bank", "carol"), "newpass");
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_get("bank", "carol", &entry), 0);
+    EXPECT_STREQ(entry.totp_secret, "GEZDGNBVGY3TQOJQ");
+    EXPECT_EQ(entry.totp_type, OTP_TYPE_HOTP);
+    EXPECT_EQ(entry.totp_counter, 7u);
+    EXPECT_EQ(entry.totp_digits, 8);
+
+    EXPECT_EQ(run_script("store bank carol other --totp JBSWY3DPEHPK3PXP\n"), 0);
+    stored_password("bank", "carol");
+    ASSERT_EQ(vault_get("bank", "carol", &entry), 0);
+    EXPECT_STREQ(entry.password, "other");
+    EXPECT_STREQ(entry.totp_secret, "JBSWY3DPEHPK3PXP");
+}
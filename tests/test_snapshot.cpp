@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "vault_controller.h"
+}
+#include "vault_test_util.h"
+
+class VaultSnapshotTest : public VaultFileTest {
+protected:
+    vault_handle_t* vault = nullptr;
+
+    VaultSnapshotTest() : VaultFileTest("/tmp/test_snapshot_vault.dat", "snapshot_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        vault = vault_handle_open(master_password, test_vault_path, 0);
+        ASSERT_NE(vault, nullptr);
+        ASSERT_EQ(put("seed", "seed-pass"), 0);
+    }
+
+    void TearDown() override {
+        vault_handle_close(vault);
+        VaultFileTest::TearDown();
+    }
+
+    int put(const char* service, const char* password) {
+        return VaultFileTest::put(vault, service, password);
+    }
+};
+
+TEST_F(VaultSnapshotTest, HeldSnapshotDoesNotChange) {
+    ASSERT_EQ(put("mail", "old"), 0);
+    const vault_snapshot_t* snap = vault_snapshot_acquire(vault);
+    ASSERT_NE(snap, nullptr);
+
+    ASSERT_EQ(put("mail", "new"), 0);
+    ASSERT_EQ(put("extra", "x"), 0);
+    ASSERT_EQ(vault_handle_remove_entry_at(vault, (size_t)vault_handle_find_entry(vault, "seed", "user")), 0);
+
+    EXPECT_EQ(vault_snapshot_count(snap), 2u);
+    int index = vault_snapshot_find(snap, "mail", "user");
+    ASSERT_GE(index, 0);
+    EXPECT_STREQ(vault_snapshot_entry(snap, (size_t)index)->password, "old");
+    EXPECT_GE(vault_snapshot_find(snap, "seed", "user"), 0);
+    EXPECT_LT(vault_snapshot_find(snap, "extra", "user"), 0);
+    EXPECT_EQ(vault_snapshot_entry(snap, 5), nullptr);
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_handle_get(vault, "mail", "user", &entry), 0);
+    EXPECT_STREQ(entry.password, "new");
+    EXPECT_EQ(vault_handle_entry_count(vault), 2u);
+
+    vault_snapshot_release(vault, snap);
+}
+
+TEST_F(VaultSnapshotTest, RetiredSnapshotsAreReclaimed) {
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQ(put("churn", i % 2 ? "a" : "b"), 0);
+    }
+    EXPECT_EQ(vault_handle_retired_snapshots(vault), 0u);
+
+    const vault_snapshot_t* snap = vault_snapshot_acquire(vault);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(put("churn", i % 2 ? "a" : "b"), 0);
+    }
+    EXPECT_EQ(vault_handle_retired_snapshots(vault), 5u);
+    EXPECT_STREQ(vault_snapshot_entry(snap, 1)->password, "a");
+
+    vault_snapshot_release(vault, snap);
+    EXPECT_EQ(vault_handle_retired_snapshots(vault), 0u);
+}
+
+struct BatchProbe {
+    vault_handle_t* vault;
+    int found;
+    size_t count;
+};
+
+static void* probe_thread(void* arg) {
+    BatchProbe* probe = static_cast<BatchProbe*>(arg);
+    probe->found = vault_handle_find_entry(probe->vault, "batched", "user");
+    probe->count = vault_handle_entry_count(probe->vault);
+    return nullptr;
+}
+
+TEST_F(VaultSnapshotTest, BatchIsPublishedOnCommit) {
+    ASSERT_EQ(vault_handle_begin_batch(vault), 0);
+    ASSERT_EQ(put("batched", "pw"), 0);
+    EXPECT_GE(vault_handle_find_entry(vault, "batched", "user"), 0);
+
+    BatchProbe probe = {vault, 0, 0};
+    pthread_t thread;
+    ASSERT_EQ(pthread_create(&thread, nullptr, probe_thread, &probe), 0);
+    pthread_join(thread, nullptr);
+    EXPECT_LT(probe.found, 0);
+    EXPECT_EQ(probe.count, 1u);
+
+    ASSERT_EQ(vault_handle_commit_batch(vault), 0);
+    ASSERT_EQ(pthread_create(&thread, nullptr, probe_thread, &probe), 0);
+    pthread_join(thread, nullptr);
+    EXPECT_GE(probe.found, 0);
+    EXPECT_EQ(probe.count, 2u);
+}
+
+struct StormArgs {
+    vault_handle_t* vault;
+    std::atomic<bool>* stop;
+    std::atomic<int>* failures;
+};
+
+static void* snapshot_reader(void* arg) {
+    StormArgs* args = static_cast<StormArgs*>(arg);
+    while (!args->stop->load()) {
+        const vault_snapshot_t* snap = vault_snapshot_acquire(args->vault);
+        size_t count = vault_snapshot_count(snap);
+        for (size_t i = 0; i < count; i++) {
+            const VaultEntry* entry = vault_snapshot_entry(snap, i);
+            if (vault_snapshot_find(snap, entry->service, entry->username) != (int)i ||
+                strcmp(entry->service, entry->password) != 0) {
+                args->failures->fetch_add(1);
+            }
+        }
+        vault_snapshot_release(args->vault, snap);
+
+        VaultEntry entry;
+        if (vault_handle_get(args->vault, "seed", "user", &entry) != 0) {
+            args->failures->fetch_add(1);
+        }
+    }
+    return nullptr;
+}
+
+TEST_F(VaultSnapshotTest, ReadersStayConsistentDuringWriteStorm) {
+    ASSERT_EQ(put("seed", "seed"), 0);
+    std::atomic<bool> stop(false);
+    std::atomic<int> failures(0);
+    StormArgs args = {vault, &stop, &failures};
+
+    pthread_t readers[3];
+    for (pthread_t& reader : readers) {
+        ASSERT_EQ(pthread_create(&reader, nullptr, snapshot_reader, &args), 0);
+    }
+
+    for (int i = 0; i < 200; i++) {
+        char service[32];
+        snprintf(service, sizeof(service), "storm%d", i % 40);
+        if (i % 3 == 2) {
+            int index = vault_handle_find_entry(vault, service, "user");
+            if (index >= 0) {
+                ASSERT_EQ(vault_handle_remove_entry_at(vault, (size_t)index), 0);
+            }
+        } else {
+            ASSERT_EQ(put(service, service), 0);
+        }
+    }
+
+    stop.store(true);
+    for (pthread_t reader : readers) {
+        pthread_join(reader, nullptr);
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(vault_handle_retired_snapshots(vault), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "vault_controller.h"
+    #include "vault_stats.h"
+    #include "crypto_engine.h"
+}
+#include "vault_test_util.h"
+
+class VaultStatsTest : public VaultFileTest {
+protected:
+    vault_handle_t* vault = nullptr;
+
+    VaultStatsTest() : VaultFileTest("/tmp/test_stats_vault.dat", "stats_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        vault = vault_handle_open(master_password, test_vault_path, 0);
+        ASSERT_NE(vault, nullptr);
+    }
+
+    void TearDown() override {
+        if (vault) vault_handle_close(vault);
+        VaultFileTest::TearDown();
+    }
+
+    void put(const char* service, const char* username, const char* password, const char* totp) {
+        ASSERT_EQ(VaultFileTest::put(vault, service, password, username, totp), 0);
+    }
+};
+
+TEST_F(VaultStatsTest, EmptyVault) {
+    vault_stats_t stats;
+    ASSERT_EQ(vault_stats_collect(vault, &stats), 0);
+    EXPECT_EQ(stats.entries, 0u);
+    EXPECT_EQ(stats.useful_bytes, 0u);
+    EXPECT_EQ(stats.allocated_bytes, 0u);
+    EXPECT_STREQ(stats.kdf_name, KDF_NAME);
+    EXPECT_EQ(stats.kdf_iterations, (uint32_t)KDF_ITERATIONS);
+}
+
+TEST_F(VaultStatsTest, FieldLengthHistograms) {
+    put("a", "12345678", "123456789", "");
+    put("github.com", "user@example.com", std::string(40, 'x').c_str(), "JBSWY3DPEHPK3PXP");
+    put(std::string(200, 's').c_str(), "u", std::string(17, 'p').c_str(), "");
+
+    vault_stats_t stats;
+    ASSERT_EQ(vault_stats_collect(vault, &stats), 0);
+    EXPECT_EQ(stats.entries, 3u);
+    EXPECT_EQ(stats.totp_entries, 1u);
+
+    const stats_histogram_t* service = &stats.fields[STATS_FIELD_SERVICE];
+    EXPECT_EQ(service->counts[1], 1u);
+    EXPECT_EQ(service->counts[2], 1u);
+    EXPECT_EQ(service->counts[6], 1u);
+    EXPECT_EQ(service->max_length, 200u);
+    EXPECT_EQ(service->total_length, 211u);
+
+    const stats_histogram_t* username = &stats.fields[STATS_FIELD_USERNAME];
+    EXPECT_EQ(username->counts[1], 2u);
+    EXPECT_EQ(username->counts[2], 1u);
+
+    const stats_histogram_t* password = &stats.fields[STATS_FIELD_PASSWORD];
+    EXPECT_EQ(password->counts[2], 1u);
+    EXPECT_EQ(password->counts[3], 1u);
+    EXPECT_EQ(password->counts[4], 1u);
+
+    const stats_histogram_t* totp = &stats.fields[STATS_FIELD_TOTP];
+    EXPECT_EQ(totp->counts[0], 2u);
+    EXPECT_EQ(totp->counts[2], 1u);
+}
+
+TEST_F(VaultStatsTest, UsefulBytesCountContentOnly) {
+    put("svc", "user", "password", "");
+
+    vault_stats_t stats;
+    ASSERT_EQ(vault_stats_collect(vault, &stats), 0);
+    size_t fixed = sizeof(VaultEntry) - VAULT_SERVICE_LEN - VAULT_USERNAME_LEN -
+                   VAULT_PASSWORD_LEN - VAULT_TOTP_LEN;
+    EXPECT_EQ(stats.allocated_bytes, sizeof(VaultEntry));
+    EXPECT_EQ(stats.useful_bytes, 3 + 4 + 8 + fixed);
+    EXPECT_LT(stats.useful_bytes, stats.allocated_bytes);
+}
+
+TEST_F(VaultStatsTest, LayoutMatchesFilesOnDisk) {
+    put("one", "user", "password1", "");
+    put("two", "user", "password2", "");
+
+    vault_stats_t stats;
+    ASSERT_EQ(vault_stats_collect(vault, &stats), 0);
+    std::string base(test_vault_path);
+    EXPECT_EQ(stats.layout.shards, 1u);
+    EXPECT_EQ(stats.layout.version, (uint32_t)VAULT_VERSION);
+    EXPECT_EQ(stats.layout.codec, vault_handle_compression(vault));
+    EXPECT_EQ((off_t)stats.layout.file_bytes, test_file_size(base));
+    EXPECT_EQ(stats.layout.ciphertext_bytes, stats.layout.file_bytes - sizeof(VaultHeader));
+    EXPECT_EQ((off_t)stats.layout.backup_bytes, test_file_size(base + ".backup"));
+    EXPECT_GT(stats.layout.backup_bytes, 0u);
+}
+
+TEST_F(VaultStatsTest, JsonReport) {
+    put("github.com", "user", "password", "JBSWY3DPEHPK3PXP");
+
+    vault_stats_t stats;
+    ASSERT_EQ(vault_stats_collect(vault, &stats), 0);
+
+    char* buffer = nullptr;
+    size_t size = 0;
+    FILE* out = open_memstream(&buffer, &size);
+    ASSERT_NE(out, nullptr);
+    ASSERT_EQ(vault_stats_write_json(&stats, out), 0);
+    fclose(out);
+
+    std::string json(buffer, size);
+    free(buffer);
+    EXPECT_NE(json.find("\"entries\": 1"), std::string::npos);
+    EXPECT_NE(json.find("\"totp_entries\": 1"), std::string::npos);
+    EXPECT_NE(json.find("\"allocated_bytes\": " + std::to_string(sizeof(VaultEntry))),
+              std::string::npos);
+    EXPECT_NE(json.find("\"iterations\": " + std::to_string(KDF_ITERATIONS)), std::string::npos);
+    EXPECT_NE(json.find("\"unlock_ms\""), std::string::npos);
+    EXPECT_NE(json.find("\"password\": {\"max\": 8"), std::string::npos);
+    EXPECT_NE(json.find("\"9-16\": 1"), std::string::npos);
+}
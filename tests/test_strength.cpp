@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+extern "C" {
+    #include "strength.h"
+}
+
+static const char* kPasswordsList = "/tmp/test_strength_passwords.txt";
+static const char* kNamesList = "/tmp/test_strength_names.txt";
+static const char* kDictPath = "/tmp/test_strength.dict";
+
+static void write_list(const char* path, const char* contents) {
+    FILE* fp = fopen(path, "w");
+    ASSERT_NE(fp, nullptr);
+    fputs(contents, fp);
+    fclose(fp);
+}
+
+class StrengthTest : public ::testing::Test {
+protected:
+    strength_result_t result;
+
+    void SetUp() override {
+        write_list(kPasswordsList, "123456\npassword\nqwerty\ndragon\npassword1\n");
+        write_list(kNamesList, "michael\njennifer\n");
+
+        const char* paths[] = {kPasswordsList, kNamesList};
+        const char* names[] = {"passwords", "names"};
+        ASSERT_EQ(strength_dict_build(paths, names, 2, kDictPath), 0);
+        ASSERT_EQ(strength_load_dictionary(kDictPath), 0);
+        memset(&result, 0, sizeof(result));
+    }
+
+    void TearDown() override {
+        strength_unload_dictionary();
+        remove(kPasswordsList);
+        remove(kNamesList);
+        remove(kDictPath);
+    }
+
+    bool has_pattern(match_pattern_t pattern) const {
+        for (size_t i = 0; i < result.match_count; i++) {
+            if (result.sequence[i].pattern == pattern) return true;
+        }
+        return false;
+    }
+};
+
+TEST_F(StrengthTest, LoadsBuiltDictionary) {
+    EXPECT_TRUE(strength_dictionary_loaded());
+    EXPECT_STREQ(strength_dict_name(0), "passwords");
+    EXPECT_STREQ(strength_dict_name(1), "names");
+    EXPECT_STREQ(strength_dict_name(5), "unknown");
+}
+
+TEST_F(StrengthTest, DecoratedCommonPasswordIsWeak) {
+    ASSERT_EQ(strength_estimate("Password1!", &result), 0);
+    EXPECT_LE(result.score, 1);
+    ASSERT_TRUE(has_pattern(MATCH_DICTIONARY));
+    EXPECT_EQ(result.sequence[0].i, 0u);
+    EXPECT_STREQ(strength_dict_name(result.sequence[0].dict), "passwords");
+}
+
+TEST_F(StrengthTest, LeetAndReversedWordsMatchDictionary) {
+    ASSERT_EQ(strength_estimate("p@$$w0rd", &result), 0);
+    ASSERT_EQ(result.match_count, 1u);
+    EXPECT_EQ(result.sequence[0].pattern, MATCH_DICTIONARY);
+    EXPECT_TRUE(result.sequence[0].l33t);
+    EXPECT_EQ(result.score, 0);
+
+    ASSERT_EQ(strength_estimate("nogard", &result), 0);
+    ASSERT_EQ(result.match_count, 1u);
+    EXPECT_TRUE(result.sequence[0].reversed);
+    EXPECT_EQ(result.score, 0);
+}
+
+TEST_F(StrengthTest, DetectsRepeatsSequencesAndYears) {
+    ASSERT_EQ(strength_estimate("zzzzzzzzzzzz", &result), 0);
+    EXPECT_TRUE(has_pattern(MATCH_REPEAT));
+    EXPECT_EQ(result.score, 0);
+
+    ASSERT_EQ(strength_estimate("abcdefghijk", &result), 0);
+    EXPECT_TRUE(has_pattern(MATCH_SEQUENCE));
+    EXPECT_EQ(result.score, 0);
+
+    ASSERT_EQ(strength_estimate("jennifer1987", &result), 0);
+    EXPECT_TRUE(has_pattern(MATCH_YEAR));
+    EXPECT_LE(result.score, 1);
+}
+
+TEST_F(StrengthTest, RandomPasswordIsVeryStrong) {
+    ASSERT_EQ(strength_estimate("x7#Kq9!vLm2$Wp4z", &result), 0);
+    EXPECT_EQ(result.score, 4);
+    EXPECT_GT(result.entropy_bits, 40.0);
+    EXPECT_NEAR(result.entropy_bits, result.guesses_log10 * 3.3219, 0.01);
+}
+
+TEST_F(StrengthTest, RejectsInvalidInput) {
+    std::string too_long(STRENGTH_MAX_LENGTH + 1, 'a');
+    EXPECT_EQ(strength_estimate("", &result), -1);
+    EXPECT_EQ(strength_estimate(NULL, &result), -1);
+    EXPECT_EQ(strength_estimate("abc", NULL), -1);
+    EXPECT_EQ(strength_estimate(too_long.c_str(), &result), -1);
+}
+
+TEST_F(StrengthTest, RejectsCorruptDictionary) {
+    const char* bad_path = "/tmp/test_strength_bad.dict";
+    write_list(bad_path, "not a dictionary file at all, just some text");
+
+    EXPECT_EQ(strength_load_dictionary(bad_path), -1);
+    EXPECT_EQ(strength_load_dictionary("/tmp/does_not_exist.dict"), -1);
+    EXPECT_TRUE(strength_dictionary_loaded());
+
+    ASSERT_EQ(strength_estimate("dragon", &result), 0);
+    EXPECT_TRUE(has_pattern(MATCH_DICTIONARY));
+    remove(bad_path);
+}
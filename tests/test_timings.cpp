@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "timings.h"
+    #include "vault_controller.h"
+}
+#include "vault_test_util.h"
+
+class TimingsTest : public VaultFileTest {
+protected:
+    TimingsTest() : VaultFileTest("/tmp/test_timings_vault.dat", "timings_master_password") {}
+
+    void SetUp() override {
+        VaultFileTest::SetUp();
+        timings_reset();
+    }
+
+    void TearDown() override {
+        timings_enable(TIMINGS_OFF);
+        timings_reset();
+        VaultFileTest::TearDown();
+    }
+
+    void store(const char* service) {
+        vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, 0);
+        ASSERT_NE(vault, nullptr);
+        ASSERT_EQ(vault_handle_store(vault, service, "user", "pw", nullptr, true), 0);
+        vault_handle_close(vault);
+    }
+
+    std::string report() {
+        char buffer[4096] = {0};
+        FILE* out = fmemopen(buffer, sizeof(buffer) - 1, "w");
+        timings_report(out);
+        fclose(out);
+        return buffer;
+    }
+};
+
+TEST_F(TimingsTest, DisabledRecordsNothing) {
+    store("mail");
+    for (int i = 0; i < TIMING_PHASE_COUNT; i++) {
+        EXPECT_EQ(timings_phase_calls((timing_phase_t)i), 0u);
+    }
+    EXPECT_EQ(timings_counter(TIMING_BYTES_WRITTEN), 0u);
+    EXPECT_EQ(report(), "");
+}
+
+TEST_F(TimingsTest, OpenAndSaveRecordEveryPhase) {
+    store("mail");
+    timings_enable(TIMINGS_TEXT);
+    store("git");
+
+    EXPECT_EQ(timings_phase_calls(TIMING_KDF), 1u);
+    EXPECT_GT(timings_phase_ms(TIMING_KDF), 0.0);
+    EXPECT_EQ(timings_phase_calls(TIMING_LOCK_WAIT), 1u);
+    EXPECT_EQ(timings_phase_calls(TIMING_FILE_READ), 1u);
+    EXPECT_EQ(timings_phase_calls(TIMING_DECRYPT), 1u);
+    EXPECT_EQ(timings_phase_calls(TIMING_BACKUP), 1u);
+    EXPECT_EQ(timings_phase_calls(TIMING_ENCRYPT), 1u);
+    EXPECT_GE(timings_phase_calls(TIMING_FILE_WRITE), 2u);
+    EXPECT_GE(timings_phase_calls(TIMING_FSYNC), 1u);
+    EXPECT_EQ(timings_phase_calls(TIMING_RENAME), 1u);
+    EXPECT_EQ(timings_counter(TIMING_ENTRIES_LOADED), 1u);
+
+    struct stat st;
+    ASSERT_EQ(stat(test_vault_path, &st), 0);
+    EXPECT_EQ(timings_counter(TIMING_BYTES_WRITTEN), (uint64_t)st.st_size);
+    EXPECT_GT(timings_counter(TIMING_BYTES_READ), 0u);
+
+    std::string text = report();
+    EXPECT_NE(text.find("kdf"), std::string::npos);
+    EXPECT_NE(text.find("bytes_written"), std::string::npos);
+    EXPECT_EQ(text.find("decompress"), std::string::npos);
+}
+
+TEST_F(TimingsTest, JsonReportListsAllPhases) {
+    timings_enable(TIMINGS_JSON);
+    store("mail");
+
+    vault_handle_t* vault = vault_handle_open(master_password, test_vault_path, VAULT_OPEN_READ_ONLY);
+    ASSERT_NE(vault, nullptr);
+    EXPECT_EQ(vault_handle_search(vault, "mail", nullptr, 0), 1u);
+    vault_handle_close(vault);
+    EXPECT_EQ(timings_counter(TIMING_ENTRIES_SCANNED), 1u);
+
+    std::string json = report();
+    EXPECT_EQ(json.compare(0, 11, "{\"phases\":{"), 0);
+    EXPECT_NE(json.find("\"kdf\":{\"ms\":"), std::string::npos);
+    EXPECT_NE(json.find("\"decompress\":{\"ms\":0.000,\"calls\":0}"), std::string::npos);
+    EXPECT_NE(json.find("\"entries_scanned\":1}"), std::string::npos);
+    EXPECT_EQ(json.back(), '\n');
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
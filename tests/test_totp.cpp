@@ -68,6 +68,46 @@ TEST_F(TOTPEngineTest, ValidateTOTPFormat) {
     EXPECT_GE(code, 100000u);
 }
 
+TEST_F(TOTPEngineTest, RFC6238Vectors) {
+    struct {
+        const char* seed;
+        totp_algorithm_t algorithm;
+        time_t time;
+        uint32_t expected;
+    } vectors[] = {
+        {"12345678901234567890", TOTP_ALG_SHA1, 59, 94287082u},
+        {"12345678901234567890123456789012", TOTP_ALG_SHA256, 59, 46119246u},
+        {"1234567890123456789012345678901234567890123456789012345678901234", TOTP_ALG_SHA512, 59, 90693936u},
+        {"12345678901234567890", TOTP_ALG_SHA1, 1111111109, 7081804u},
+        {"12345678901234567890123456789012", TOTP_ALG_SHA256, 1111111109, 68084774u},
+        {"1234567890123456789012345678901234567890123456789012345678901234", TOTP_ALG_SHA512, 1234567890, 93441116u}
+    };
+
+    for (const auto& vector : vectors) {
+        char secret[128];
+        ASSERT_GT(base32_encode((const unsigned char*)vector.seed, strlen(vector.seed),
+                                secret, sizeof(secret)), 0);
+        EXPECT_EQ(generate_totp_at(secret, vector.algorithm, 8, 30, vector.time), vector.expected)
+            << totp_algorithm_name(vector.algorithm) << " at " << vector.time;
+    }
+}
+
+TEST_F(TOTPEngineTest, RFC4226HOTPVectors) {
+    const uint32_t expected[] = {755224u, 287082u, 359152u, 969429u, 338314u};
+    char secret[64];
+    ASSERT_GT(base32_encode((const unsigned char*)"12345678901234567890", 20,
+                            secret, sizeof(secret)), 0);
+
+    for (uint64_t counter = 0; counter < 5; counter++) {
+        EXPECT_EQ(generate_otp(secret, TOTP_ALG_SHA1, 6, counter), expected[counter]);
+    }
+}
+
+TEST_F(TOTPEngineTest, RejectsUnsupportedDigits) {
+    EXPECT_EQ(generate_otp("JBSWY3DPEHPK3PXP", TOTP_ALG_SHA1, 5, 0), 0u);
+    EXPECT_EQ(generate_otp("JBSWY3DPEHPK3PXP", TOTP_ALG_SHA1, 9, 0), 0u);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
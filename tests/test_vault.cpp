@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <string>
+#include <cstring>
+#include <time.h>
 extern "C" {
     #include "vault_controller.h"
     #include "crypto_engine.h"
@@ -346,7 +349,194 @@ TEST_F(VaultTest, EncryptionWorks) {
     delete[] content;
 }
 
+TEST_F(VaultTest, StoreRejectsOverlongTOTPSecret) {
+    vault_init(master_password, test_vault_path);
+
+    std::string secret(VAULT_TOTP_LEN, 'A');
+    EXPECT_NE(vault_store("Service", "user", "password", secret.c_str(), true), 0);
+    EXPECT_EQ(vault_entry_count(), 0);
+
+    secret.pop_back();
+    EXPECT_EQ(vault_store("Service", "user", "password", secret.c_str(), true), 0);
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_get("Service", "user", &entry), 0);
+    EXPECT_EQ(strlen(entry.totp_secret), secret.size());
+}
+
+TEST_F(VaultTest, BatchWritesOnceOnCommit) {
+    vault_init(master_password, test_vault_path);
+
+    struct stat before;
+    ASSERT_EQ(stat(test_vault_path, &before), 0);
+
+    ASSERT_EQ(vault_begin_batch(), 0);
+    for (int i = 0; i < 20; i++) {
+        VaultEntry entry = {};
+        snprintf(entry.service, sizeof(entry.service), "Service%d", i);
+        snprintf(entry.username, sizeof(entry.username), "user%d", i);
+        snprintf(entry.password, sizeof(entry.password), "pass%d", i);
+        ASSERT_EQ(vault_put_entry(&entry), 0);
+    }
+
+    struct stat during;
+    ASSERT_EQ(stat(test_vault_path, &during), 0);
+    EXPECT_EQ(during.st_size, before.st_size) << "Batch must not write before commit";
+
+    ASSERT_EQ(vault_commit_batch(), 0);
+    vault_cleanup();
+
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    EXPECT_EQ(vault_entry_count(), 20u);
+}
+
+TEST_F(VaultTest, OpensVersion1Vault) {
+    struct {
+        char magic[4];
+        uint32_t version;
+        unsigned char salt[SALT_SIZE];
+        uint32_t entry_count;
+    } header;
+    struct {
+        char service[256];
+        char username[256];
+        char password[256];
+        char totp_secret[64];
+    } old_entries[2];
+
+    memset(&header, 0, sizeof(header));
+    memset(old_entries, 0, sizeof(old_entries));
+    memcpy(header.magic, VAULT_MAGIC, 4);
+    header.version = 1;
+    memset(header.salt, 0x5A, SALT_SIZE);
+    header.entry_count = 2;
+
+    strcpy(old_entries[0].service, "Legacy");
+    strcpy(old_entries[0].username, "user");
+    strcpy(old_entries[0].password, "legacy_password");
+    strcpy(old_entries[0].totp_secret, "JBSWY3DPEHPK3PXP");
+    strcpy(old_entries[1].service, "Other");
+    strcpy(old_entries[1].username, "user2");
+    strcpy(old_entries[1].password, "other_password");
+
+    unsigned char key[KEY_LEN];
+    ASSERT_EQ(derive_key_with_salt(master_password, header.salt, SALT_SIZE, key), 0);
+
+    unsigned char ciphertext[sizeof(old_entries) + 64];
+    int cipher_len = encrypt_data((unsigned char*)old_entries, sizeof(old_entries), key, ciphertext);
+    ASSERT_GT(cipher_len, 0);
+
+    FILE* fp = fopen(test_vault_path, "wb");
+    ASSERT_NE(fp, nullptr);
+    fwrite(&header, sizeof(header), 1, fp);
+    fwrite(ciphertext, 1, cipher_len, fp);
+    fclose(fp);
+
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    EXPECT_EQ(vault_entry_count(), 2u);
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_get("Legacy", "user", &entry), 0);
+    EXPECT_STREQ(entry.password, "legacy_password");
+    EXPECT_STREQ(entry.totp_secret, "JBSWY3DPEHPK3PXP");
+    EXPECT_EQ(entry.totp_period, 30u);
+    EXPECT_EQ(entry.totp_digits, 6);
+
+    ASSERT_EQ(vault_store("New", "user3", "new_password", nullptr, true), 0);
+    vault_cleanup();
+
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    EXPECT_EQ(vault_entry_count(), 3u);
+    ASSERT_EQ(vault_get("Other", "user2", &entry), 0);
+    EXPECT_STREQ(entry.password, "other_password");
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
+
+TEST_F(VaultTest, TracksPasswordChangeTime) {
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    time_t before = time(NULL);
+    ASSERT_EQ(vault_store("Service", "user", "first_password", nullptr, true), 0);
+
+    VaultEntry entry;
+    ASSERT_EQ(vault_get("Service", "user", &entry), 0);
+    EXPECT_GE(entry.password_updated_at, (uint64_t)before);
+
+    vault_cleanup();
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    VaultEntry stored;
+    ASSERT_EQ(vault_get("Service", "user", &stored), 0);
+    uint64_t changed_at = stored.password_updated_at;
+
+    strcpy(stored.totp_secret, "JBSWY3DPEHPK3PXP");
+    stored.password_updated_at = 0;
+    ASSERT_EQ(vault_put_entry(&stored), 0);
+    ASSERT_EQ(vault_get("Service", "user", &entry), 0);
+    EXPECT_EQ(entry.password_updated_at, changed_at) << "Unchanged password keeps its timestamp";
+
+    ASSERT_EQ(vault_store("Service", "user", "second_password", nullptr, true), 0);
+    ASSERT_EQ(vault_get("Service", "user", &entry), 0);
+    EXPECT_GE(entry.password_updated_at, changed_at);
+}
+
+
+TEST_F(VaultTest, SearchMatchesServiceAndUsername) {
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    ASSERT_EQ(vault_store("GitHub", "alice", "pass1", nullptr, true), 0);
+    ASSERT_EQ(vault_store("gitlab", "bob", "pass2", nullptr, true), 0);
+    ASSERT_EQ(vault_store("bank", "Alice.Smith", "pass3", nullptr, true), 0);
+
+    size_t matches[4];
+    ASSERT_EQ(vault_search("git", matches, 4), 2u);
+    EXPECT_EQ(matches[0], 0u);
+    EXPECT_EQ(matches[1], 1u);
+
+    ASSERT_EQ(vault_search("ALICE", matches, 4), 2u);
+    EXPECT_EQ(matches[1], 2u);
+
+    EXPECT_EQ(vault_search("", matches, 1), 3u);
+    EXPECT_EQ(vault_search("nomatch", matches, 4), 0u);
+}
+
+TEST_F(VaultTest, LookupIndexTracksInsertsAndRemovals) {
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    ASSERT_EQ(vault_begin_batch(), 0);
+
+    char service[32];
+    for (int i = 0; i < 500; i++) {
+        snprintf(service, sizeof(service), "service%d", i);
+        VaultEntry entry = {};
+        strcpy(entry.service, service);
+        strcpy(entry.username, "user");
+        strcpy(entry.password, "pw");
+        ASSERT_EQ(vault_put_entry(&entry), 0);
+    }
+
+    for (int i = 0; i < 500; i += 3) {
+        snprintf(service, sizeof(service), "service%d", i);
+        ASSERT_EQ(vault_remove_entry_at((size_t)vault_find_entry(service, "user")), 0);
+    }
+    ASSERT_EQ(vault_commit_batch(), 0);
+
+    for (int i = 0; i < 500; i++) {
+        snprintf(service, sizeof(service), "service%d", i);
+        int index = vault_find_entry(service, "user");
+        if (i % 3 == 0) {
+            EXPECT_EQ(index, -1) << service;
+        } else {
+            ASSERT_GE(index, 0) << service;
+            VaultEntry entry;
+            ASSERT_EQ(vault_get_entry_at((size_t)index, &entry), 0);
+            EXPECT_STREQ(entry.service, service);
+        }
+    }
+    EXPECT_EQ(vault_find_entry("service1", "other"), -1);
+
+    vault_cleanup();
+    ASSERT_EQ(vault_init(master_password, test_vault_path), 0);
+    EXPECT_EQ(vault_entry_count(), 333u);
+    EXPECT_GE(vault_find_entry("service499", "user"), 0);
+}
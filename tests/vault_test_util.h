@@ -0,0 +1,65 @@
+#ifndef VAULT_TEST_UTIL_H
+#define VAULT_TEST_UTIL_H
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+extern "C" {
+    #include "vault_controller.h"
+}
+
+/* Removes a single-file vault together with its backup and lock files. */
+inline void remove_vault_files(const std::string& path) {
+    unlink(path.c_str());
+    unlink((path + ".backup").c_str());
+    unlink((path + ".lock").c_str());
+}
+
+inline VaultEntry make_test_entry(const char* service, const char* username, const char* password,
+                                  const char* totp_secret = "") {
+    VaultEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.service, service, VAULT_SERVICE_LEN - 1);
+    strncpy(entry.username, username, VAULT_USERNAME_LEN - 1);
+    strncpy(entry.password, password, VAULT_PASSWORD_LEN - 1);
+    strncpy(entry.totp_secret, totp_secret, VAULT_TOTP_LEN - 1);
+    return entry;
+}
+
+inline off_t test_file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+/*
+ * Fixture for suites that work on one vault file. The file is removed
+ * before and after each test, and saves skip fsync while the test runs.
+ */
+class VaultFileTest : public ::testing::Test {
+protected:
+    const char* test_vault_path;
+    const char* master_password;
+
+    VaultFileTest(const char* vault_path, const char* master)
+        : test_vault_path(vault_path), master_password(master) {}
+
+    void SetUp() override {
+        remove_vault_files(test_vault_path);
+        vault_set_durability(VAULT_DURABILITY_NONE);
+    }
+
+    void TearDown() override {
+        vault_set_durability(VAULT_DURABILITY_FSYNC);
+        remove_vault_files(test_vault_path);
+    }
+
+    static int put(vault_handle_t* vault, const char* service, const char* password,
+                   const char* username = "user", const char* totp_secret = "") {
+        VaultEntry entry = make_test_entry(service, username, password, totp_secret);
+        return vault_handle_put_entry(vault, &entry);
+    }
+};
+
+#endif
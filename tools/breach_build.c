@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "breach_check.h"
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--prefix-bits N] [--bloom BITS_PER_KEY] <pwned-passwords.txt|-> <output.db>\n",
+            program);
+    fprintf(stderr, "Input is the HIBP SHA-1 dump ordered by hash, one HASH:COUNT per line.\n");
+}
+
+int main(int argc, char* argv[]) {
+    breach_build_options_t options = {0, 0};
+    const char* positional[2];
+    int positional_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--prefix-bits") == 0 && i + 1 < argc) {
+            options.prefix_bits = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bloom") == 0 && i + 1 < argc) {
+            options.bloom_bits_per_key = atoi(argv[++i]);
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 1;
+        } else if (positional_count < 2) {
+            positional[positional_count++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (positional_count != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* input = strcmp(positional[0], "-") == 0 ? stdin : fopen(positional[0], "r");
+    if (!input) {
+        fprintf(stderr, "Error: Cannot open %s\n", positional[0]);
+        return 1;
+    }
+
+    breach_build_stats_t stats;
+    int ret = breach_db_build(input, positional[1], &options, &stats);
+    if (input != stdin) fclose(input);
+
+    if (ret != 0) {
+        fprintf(stderr, "Error: Failed to build %s\n", positional[1]);
+        return 1;
+    }
+
+    printf("Wrote %llu hashes to %s (%llu duplicates merged, %llu lines skipped)\n",
+           (unsigned long long)stats.records, positional[1],
+           (unsigned long long)stats.duplicates, (unsigned long long)stats.skipped);
+    return 0;
+}
@@ -0,0 +1,470 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "serve.h"
+#include "serve_load.h"
+#include "crypto_engine.h"
+
+#define LOAD_DEFAULT_CONNECTIONS 8
+#define LOAD_DEFAULT_RATE 1000
+#define LOAD_DEFAULT_DURATION 10
+#define LOAD_DEFAULT_WARMUP 1
+#define LOAD_DEFAULT_STORE_KEYS 64
+#define LOAD_PASSWORD_LEN 20
+#define LOAD_REQUEST_MAX 4096
+
+typedef struct {
+    char* service;
+    char* username;
+    int totp;
+} load_key_t;
+
+typedef struct {
+    int connections;
+    double rate;
+    double duration;
+    double warmup;
+    load_mix_t mix;
+    const char* mix_text;
+    uint32_t store_keys;
+    uint64_t seed;
+    double max_p50_ms;
+    double max_p99_ms;
+    double max_p999_ms;
+    double max_error_percent;
+    const char* json_path;
+} load_config_t;
+
+typedef struct {
+    const load_config_t* config;
+    int index;
+    int fd;
+    FILE* in;
+    uint64_t start_ns;
+    uint64_t last_ns;
+    int failed;
+    pthread_t thread;
+    latency_histogram_t latency[LOAD_OP_COUNT];
+    latency_histogram_t service_time;
+    uint64_t errors[LOAD_OP_COUNT];
+} load_worker_t;
+
+/* Services and usernames are kept JSON-encoded, exactly as list returned them. */
+static load_key_t* g_keys;
+static size_t g_key_count;
+static size_t* g_totp_keys;
+static size_t g_totp_count;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t ns) {
+    struct timespec ts = {(time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static int send_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int connect_worker(load_worker_t* worker, const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+
+    worker->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (worker->fd < 0) return -1;
+    if (connect(worker->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        !(worker->in = fdopen(worker->fd, "r"))) {
+        close(worker->fd);
+        worker->fd = -1;
+        return -1;
+    }
+
+    char* greeting = NULL;
+    size_t cap = 0;
+    int ok = getline(&greeting, &cap, worker->in) > 0 && strstr(greeting, "\"protocol\":1");
+    free(greeting);
+    return ok ? 0 : -1;
+}
+
+static void free_keys(void) {
+    for (size_t i = 0; i < g_key_count; i++) {
+        free(g_keys[i].service);
+        free(g_keys[i].username);
+    }
+    free(g_keys);
+    free(g_totp_keys);
+}
+
+static char* copy_range(const char* start, const char* end) {
+    char* copy = malloc((size_t)(end - start) + 1);
+    if (copy) {
+        memcpy(copy, start, (size_t)(end - start));
+        copy[end - start] = '\0';
+    }
+    return copy;
+}
+
+/* Asks the server for its entries so get and totp hit keys that exist. */
+static int load_keys(load_worker_t* worker) {
+    static const char request[] = "{\"id\":0,\"op\":\"list\"}\n";
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    if (send_all(worker->fd, request, sizeof(request) - 1) != 0 ||
+        (len = getline(&line, &cap, worker->in)) <= 0 || !strstr(line, "\"ok\":true")) {
+        free(line);
+        return -1;
+    }
+
+    const char* end = line + len;
+    const char* p = line;
+    const char *service, *service_end, *username, *username_end;
+    while ((service = load_json_string(p, end, "service", &service_end)) &&
+           (username = load_json_string(service_end, end, "username", &username_end))) {
+        load_key_t* grown = realloc(g_keys, (g_key_count + 1) * sizeof(load_key_t));
+        if (!grown) break;
+        g_keys = grown;
+        load_key_t* key = &g_keys[g_key_count++];
+        key->service = copy_range(service, service_end);
+        key->username = copy_range(username, username_end);
+        key->totp = strncmp(username_end, ",\"totp\":true", 12) == 0;
+        if (!key->service || !key->username) {
+            free(line);
+            return -1;
+        }
+        p = username_end;
+    }
+    free(line);
+
+    g_totp_keys = malloc((g_key_count ? g_key_count : 1) * sizeof(size_t));
+    if (!g_totp_keys) return -1;
+    for (size_t i = 0; i < g_key_count; i++) {
+        if (g_keys[i].totp) g_totp_keys[g_totp_count++] = i;
+    }
+    return 0;
+}
+
+static int format_request(char* out, load_op_t op, uint64_t id, const load_config_t* config,
+                          uint64_t* random) {
+    const load_key_t* key;
+    int len;
+    switch (op) {
+        case LOAD_OP_GET:
+        case LOAD_OP_TOTP:
+            key = op == LOAD_OP_GET ? &g_keys[next_random(random) % g_key_count]
+                                    : &g_keys[g_totp_keys[next_random(random) % g_totp_count]];
+            len = snprintf(out, LOAD_REQUEST_MAX, "{\"id\":%llu,\"op\":\"%s\",\"service\":%s,\"username\":%s}\n",
+                           (unsigned long long)id, load_op_name(op), key->service, key->username);
+            break;
+        case LOAD_OP_LIST:
+            len = snprintf(out, LOAD_REQUEST_MAX, "{\"id\":%llu,\"op\":\"list\"}\n", (unsigned long long)id);
+            break;
+        case LOAD_OP_STORE: {
+            char password[LOAD_PASSWORD_LEN + 1];
+            for (int i = 0; i < LOAD_PASSWORD_LEN; i++) {
+                password[i] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"[next_random(random) % 62];
+            }
+            password[LOAD_PASSWORD_LEN] = '\0';
+            len = snprintf(out, LOAD_REQUEST_MAX,
+                           "{\"id\":%llu,\"op\":\"store\",\"service\":\"serve-load-%u\",\"username\":\"load\","
+                           "\"password\":\"%s\"}\n",
+                           (unsigned long long)id, (unsigned)(next_random(random) % config->store_keys),
+                           password);
+            break;
+        }
+        default:
+            return -1;
+    }
+    return len > 0 && len < LOAD_REQUEST_MAX ? len : -1;
+}
+
+/*
+ * Open loop: request k of a connection is due at a fixed time whether or not
+ * earlier answers were slow, and its latency is measured from that time. A
+ * stalled server therefore shows up in the percentiles instead of quietly
+ * lowering the request rate (coordinated omission).
+ */
+static void* run_worker(void* arg) {
+    load_worker_t* worker = arg;
+    const load_config_t* config = worker->config;
+    uint64_t interval = (uint64_t)(1e9 * config->connections / config->rate);
+    uint64_t first = worker->start_ns + (uint64_t)(1e9 * worker->index / config->rate);
+    uint64_t measure_from = worker->start_ns + (uint64_t)(config->warmup * 1e9);
+    uint64_t stop = measure_from + (uint64_t)(config->duration * 1e9);
+    uint64_t random = config->seed + (uint64_t)worker->index * 0x2545F4914F6CDD1Dull;
+
+    char request[LOAD_REQUEST_MAX];
+    char* line = NULL;
+    size_t cap = 0;
+    for (uint64_t k = 0;; k++) {
+        uint64_t intended = first + k * interval;
+        if (intended >= stop) break;
+        sleep_until(intended);
+
+        load_op_t op = load_mix_pick(&config->mix, next_random(&random));
+        int len = format_request(request, op, k + 1, config, &random);
+        uint64_t sent = now_ns();
+        if (len < 0 || send_all(worker->fd, request, (size_t)len) != 0 ||
+            getline(&line, &cap, worker->in) <= 0) {
+            worker->failed = 1;
+            break;
+        }
+        uint64_t done = now_ns();
+        worker->last_ns = done;
+        if (intended < measure_from) continue;
+
+        latency_record(&worker->latency[op], done - intended);
+        latency_record(&worker->service_time, done - sent);
+        if (!strstr(line, "\"ok\":true")) worker->errors[op]++;
+    }
+
+    secure_cleanup(request, sizeof(request));
+    if (line) secure_cleanup(line, cap);
+    free(line);
+    return NULL;
+}
+
+static double ms(uint64_t ns) {
+    return ns / 1e6;
+}
+
+static void print_row(FILE* out, const char* name, const latency_histogram_t* h, uint64_t errors) {
+    fprintf(out, "%-8s %9llu %8llu %10.3f %10.3f %10.3f %10.3f\n", name, (unsigned long long)h->total,
+            (unsigned long long)errors, ms(latency_percentile(h, 50)), ms(latency_percentile(h, 99)),
+            ms(latency_percentile(h, 99.9)), ms(h->max_ns));
+}
+
+static void write_json_row(FILE* out, const char* name, const latency_histogram_t* h, uint64_t errors) {
+    fprintf(out, "\"%s\":{\"count\":%llu,\"errors\":%llu,\"p50_ms\":%.3f,\"p99_ms\":%.3f,"
+                 "\"p999_ms\":%.3f,\"max_ms\":%.3f}",
+            name, (unsigned long long)h->total, (unsigned long long)errors,
+            ms(latency_percentile(h, 50)), ms(latency_percentile(h, 99)),
+            ms(latency_percentile(h, 99.9)), ms(h->max_ns));
+}
+
+static int check_limit(const char* name, double value, double limit, const char* unit) {
+    if (limit < 0 || value <= limit) return 0;
+    fprintf(stderr, "Threshold exceeded: %s %.3f%s > %.3f%s\n", name, value, unit, limit, unit);
+    return 1;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <socket>\n", program);
+    fprintf(stderr, "Drives a `securekey serve --listen <socket>` instance at a fixed request rate\n");
+    fprintf(stderr, "and reports latency percentiles measured from each request's scheduled time.\n\n");
+    fprintf(stderr, "  --connections N      Concurrent connections (default %d, max %d)\n",
+            LOAD_DEFAULT_CONNECTIONS, SERVE_MAX_CONNECTIONS);
+    fprintf(stderr, "  --rate N             Requests per second over all connections (default %d)\n",
+            LOAD_DEFAULT_RATE);
+    fprintf(stderr, "  --duration S         Measured seconds (default %d)\n", LOAD_DEFAULT_DURATION);
+    fprintf(stderr, "  --warmup S           Unmeasured seconds before that (default %d)\n",
+            LOAD_DEFAULT_WARMUP);
+    fprintf(stderr, "  --mix LIST           Op weights (default %s)\n", LOAD_DEFAULT_MIX);
+    fprintf(stderr, "  --store-keys N       Stores overwrite serve-load-0..N-1 (default %d)\n",
+            LOAD_DEFAULT_STORE_KEYS);
+    fprintf(stderr, "  --seed N             Random seed (default 1)\n");
+    fprintf(stderr, "  --max-p50 MS         Fail if the median latency is higher\n");
+    fprintf(stderr, "  --max-p99 MS         Fail if p99 latency is higher\n");
+    fprintf(stderr, "  --max-p999 MS        Fail if p99.9 latency is higher\n");
+    fprintf(stderr, "  --max-errors PERCENT Fail if more requests than this get an error\n");
+    fprintf(stderr, "  --json FILE          Also write the results as JSON\n");
+}
+
+int main(int argc, char* argv[]) {
+    load_config_t config = {LOAD_DEFAULT_CONNECTIONS, LOAD_DEFAULT_RATE, LOAD_DEFAULT_DURATION,
+                            LOAD_DEFAULT_WARMUP, {{0}, 0}, LOAD_DEFAULT_MIX,
+                            LOAD_DEFAULT_STORE_KEYS, 1, -1, -1, -1, -1, NULL};
+    const char* socket_path = NULL;
+    int bad = 0;
+
+    for (int i = 1; i < argc && !bad; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--connections") == 0 && value) {
+            config.connections = atoi(argv[++i]);
+            bad = config.connections < 1 || config.connections > SERVE_MAX_CONNECTIONS;
+        } else if (strcmp(argv[i], "--rate") == 0 && value) {
+            config.rate = atof(argv[++i]);
+            bad = config.rate <= 0;
+        } else if (strcmp(argv[i], "--duration") == 0 && value) {
+            config.duration = atof(argv[++i]);
+            bad = config.duration <= 0;
+        } else if (strcmp(argv[i], "--warmup") == 0 && value) {
+            config.warmup = atof(argv[++i]);
+            bad = config.warmup < 0;
+        } else if (strcmp(argv[i], "--mix") == 0 && value) {
+            config.mix_text = argv[++i];
+        } else if (strcmp(argv[i], "--store-keys") == 0 && value) {
+            config.store_keys = (uint32_t)atoi(argv[++i]);
+            bad = config.store_keys < 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && value) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-p50") == 0 && value) {
+            config.max_p50_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-p99") == 0 && value) {
+            config.max_p99_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-p999") == 0 && value) {
+            config.max_p999_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-errors") == 0 && value) {
+            config.max_error_percent = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && value) {
+            config.json_path = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            bad = 1;
+        } else if (!socket_path) {
+            socket_path = argv[i];
+        } else {
+            bad = 1;
+        }
+    }
+    if (!bad && load_mix_parse(config.mix_text, &config.mix) != 0) {
+        fprintf(stderr, "Error: Invalid --mix (use e.g. %s)\n", LOAD_DEFAULT_MIX);
+        return 1;
+    }
+    if (bad || !socket_path) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    load_worker_t* workers = calloc((size_t)config.connections, sizeof(load_worker_t));
+    if (!workers) return 1;
+    for (int i = 0; i < config.connections; i++) {
+        workers[i].config = &config;
+        workers[i].index = i;
+        if (connect_worker(&workers[i], socket_path) != 0) {
+            fprintf(stderr, "Error: Cannot connect to %s (is `securekey serve --listen` running?)\n",
+                    socket_path);
+            return 1;
+        }
+    }
+    if (load_keys(&workers[0]) != 0) {
+        fprintf(stderr, "Error: list request failed\n");
+        return 1;
+    }
+    if ((config.mix.weights[LOAD_OP_GET] && g_key_count == 0) ||
+        (config.mix.weights[LOAD_OP_TOTP] && g_totp_count == 0)) {
+        fprintf(stderr, "Error: The vault has no entries%s for get/totp; adjust --mix\n",
+                g_key_count ? " with TOTP" : "");
+        return 1;
+    }
+
+    uint64_t start = now_ns() + 10000000ull;
+    int failed = 0;
+    for (int i = 0; i < config.connections; i++) {
+        workers[i].start_ns = start;
+        if (pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]) != 0) {
+            fprintf(stderr, "Error: Cannot start connection threads\n");
+            return 1;
+        }
+    }
+
+    latency_histogram_t* all = calloc(LOAD_OP_COUNT + 2, sizeof(latency_histogram_t));
+    if (!all) return 1;
+    latency_histogram_t* total = &all[LOAD_OP_COUNT];
+    latency_histogram_t* service_time = &all[LOAD_OP_COUNT + 1];
+    uint64_t errors[LOAD_OP_COUNT] = {0};
+    uint64_t error_total = 0;
+    uint64_t last = start;
+    for (int i = 0; i < config.connections; i++) {
+        load_worker_t* worker = &workers[i];
+        pthread_join(worker->thread, NULL);
+        failed |= worker->failed;
+        for (int op = 0; op < LOAD_OP_COUNT; op++) {
+            latency_merge(&all[op], &worker->latency[op]);
+            latency_merge(total, &worker->latency[op]);
+            errors[op] += worker->errors[op];
+            error_total += worker->errors[op];
+        }
+        latency_merge(service_time, &worker->service_time);
+        if (worker->last_ns > last) last = worker->last_ns;
+        fclose(worker->in);
+    }
+    free(workers);
+    if (failed) {
+        fprintf(stderr, "Error: The server closed a connection during the run\n");
+        free(all);
+        free_keys();
+        return 1;
+    }
+
+    uint64_t measure_from = start + (uint64_t)(config.warmup * 1e9);
+    double elapsed = last > measure_from ? (last - measure_from) / 1e9 : config.duration;
+    double throughput = total->total / elapsed;
+    double error_percent = total->total ? 100.0 * error_total / total->total : 0.0;
+
+    printf("%d connections, %.0f req/s target, %.1f s measured after %.1f s warmup, mix %s\n",
+           config.connections, config.rate, config.duration, config.warmup, config.mix_text);
+    printf("Completed %llu requests in %.2f s: %.1f req/s, %llu errors (%.2f%%)\n\n",
+           (unsigned long long)total->total, elapsed, throughput, (unsigned long long)error_total,
+           error_percent);
+    printf("Latency from the scheduled send time, in ms:\n");
+    printf("%-8s %9s %8s %10s %10s %10s %10s\n", "op", "count", "errors", "p50", "p99", "p99.9", "max");
+    for (int op = 0; op < LOAD_OP_COUNT; op++) {
+        if (all[op].total) print_row(stdout, load_op_name((load_op_t)op), &all[op], errors[op]);
+    }
+    print_row(stdout, "all", total, error_total);
+    printf("\nService time from the actual send (hides queueing):\n");
+    print_row(stdout, "all", service_time, error_total);
+
+    int exceeded = check_limit("p50", ms(latency_percentile(total, 50)), config.max_p50_ms, " ms") |
+                   check_limit("p99", ms(latency_percentile(total, 99)), config.max_p99_ms, " ms") |
+                   check_limit("p99.9", ms(latency_percentile(total, 99.9)), config.max_p999_ms, " ms") |
+                   check_limit("errors", error_percent, config.max_error_percent, "%");
+
+    int ret = exceeded ? 1 : 0;
+    FILE* out = config.json_path ? fopen(config.json_path, "w") : NULL;
+    if (config.json_path && !out) {
+        fprintf(stderr, "Error: Cannot write %s\n", config.json_path);
+        ret = 1;
+    } else if (out) {
+        fprintf(out, "{\"connections\":%d,\"target_rate\":%.1f,\"duration_s\":%.3f,\"warmup_s\":%.3f,"
+                     "\"mix\":\"%s\",\"elapsed_s\":%.3f,\"throughput\":%.1f,\"ops\":{",
+                config.connections, config.rate, config.duration, config.warmup, config.mix_text,
+                elapsed, throughput);
+        int first = 1;
+        for (int op = 0; op < LOAD_OP_COUNT; op++) {
+            if (!all[op].total) continue;
+            if (!first) fputc(',', out);
+            write_json_row(out, load_op_name((load_op_t)op), &all[op], errors[op]);
+            first = 0;
+        }
+        fputs("},", out);
+        write_json_row(out, "all", total, error_total);
+        fputc(',', out);
+        write_json_row(out, "service_time", service_time, error_total);
+        fprintf(out, ",\"passed\":%s}\n", exceeded ? "false" : "true");
+        if (fclose(out) != 0) ret = 1;
+    }
+
+    free(all);
+    free_keys();
+    return ret;
+}
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <string.h>
+#include "strength.h"
+
+int main(int argc, char* argv[]) {
+    const char* paths[STRENGTH_MAX_DICTS];
+    const char* names[STRENGTH_MAX_DICTS];
+    char name_buf[STRENGTH_MAX_DICTS][STRENGTH_DICT_NAME_LEN];
+
+    if (argc < 3 || argc - 2 > STRENGTH_MAX_DICTS) {
+        fprintf(stderr, "Usage: %s <output.dict> <name>=<wordlist> [...]\n", argv[0]);
+        return 1;
+    }
+
+    size_t count = 0;
+    for (int i = 2; i < argc; i++) {
+        const char* eq = strchr(argv[i], '=');
+        if (!eq || eq == argv[i] || (size_t)(eq - argv[i]) >= STRENGTH_DICT_NAME_LEN) {
+            fprintf(stderr, "Error: Invalid list spec '%s' (expected name=path)\n", argv[i]);
+            return 1;
+        }
+
+        memcpy(name_buf[count], argv[i], eq - argv[i]);
+        name_buf[count][eq - argv[i]] = '\0';
+        names[count] = name_buf[count];
+        paths[count] = eq + 1;
+        count++;
+    }
+
+    if (strength_dict_build(paths, names, count, argv[1]) != 0) {
+        fprintf(stderr, "Error: Failed to build dictionary %s\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vault_controller.h"
+#include "vault_codec.h"
+#include "vault_gen.h"
+#include "crypto_engine.h"
+#include "utilities.h"
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <vault> <entries>\n", program);
+    fprintf(stderr, "Creates a vault filled with <entries> synthetic entries.\n");
+    fprintf(stderr, "The same seed and lengths always produce the same entries.\n\n");
+    fprintf(stderr, "  --master-fd N        Read the master password from a file descriptor\n");
+    fprintf(stderr, "  --seed N             Generator seed (default %d)\n", VAULT_GEN_DEFAULT_SEED);
+    fprintf(stderr, "  --service-len R      Service length, N or MIN-MAX (default 8-24)\n");
+    fprintf(stderr, "  --username-len R     Username length (default 10-32)\n");
+    fprintf(stderr, "  --password-len R     Password length (default 12-24)\n");
+    fprintf(stderr, "  --totp PERCENT       Share of entries with a TOTP secret (default 10)\n");
+    fprintf(stderr, "  --shards N           Write a sharded vault directory (1-%d)\n",
+            VAULT_MAX_SHARDS);
+    fprintf(stderr, "  --compression C      none, zlib, zlib-dict, zstd or zstd-dict\n");
+}
+
+int main(int argc, char* argv[]) {
+    vault_gen_config_t config;
+    vault_gen_defaults(&config);
+    int master_fd = -1;
+    int shards = 1;
+    const char* positional[2];
+    int positional_count = 0;
+    int bad = 0;
+
+    for (int i = 1; i < argc && !bad; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--master-fd") == 0 && value) {
+            master_fd = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && value) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--service-len") == 0 && value) {
+            bad = vault_gen_parse_range(argv[++i], VAULT_SERVICE_LEN - 1, &config.service_len);
+        } else if (strcmp(argv[i], "--username-len") == 0 && value) {
+            bad = vault_gen_parse_range(argv[++i], VAULT_USERNAME_LEN - 1, &config.username_len);
+        } else if (strcmp(argv[i], "--password-len") == 0 && value) {
+            bad = vault_gen_parse_range(argv[++i], VAULT_PASSWORD_LEN - 1, &config.password_len);
+        } else if (strcmp(argv[i], "--totp") == 0 && value) {
+            config.totp_percent = (uint32_t)atoi(argv[++i]);
+            bad = config.totp_percent > 100;
+        } else if (strcmp(argv[i], "--shards") == 0 && value) {
+            shards = atoi(argv[++i]);
+            bad = shards < 1 || shards > VAULT_MAX_SHARDS;
+        } else if (strcmp(argv[i], "--compression") == 0 && value) {
+            vault_codec_t codec;
+            bad = vault_codec_parse(argv[++i], &codec) != 0 || vault_set_compression(codec) != 0;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            bad = 1;
+        } else if (positional_count < 2) {
+            positional[positional_count++] = argv[i];
+        } else {
+            bad = 1;
+        }
+    }
+
+    long entries = positional_count == 2 ? atol(positional[1]) : 0;
+    if (bad || positional_count != 2 || entries < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char password[VAULT_PASSWORD_LEN];
+    int read = master_fd >= 0 ? read_password_fd(master_fd, password, sizeof(password))
+                              : read_password_secure("Master password: ", password, sizeof(password));
+    if (read != 0) {
+        fprintf(stderr, "Error: Failed to read master password\n");
+        return 1;
+    }
+
+    int ret = -1;
+    if (shards == 1 || vault_create_sharded(positional[0], (uint32_t)shards) == 0) {
+        vault_handle_t* vault = vault_handle_open(password, positional[0], 0);
+        if (vault) {
+            if (vault_handle_entry_count(vault) != 0) {
+                fprintf(stderr, "Error: %s already holds entries\n", positional[0]);
+            } else {
+                ret = vault_gen_fill(vault, &config, 0, (size_t)entries);
+            }
+            vault_handle_close(vault);
+        }
+    }
+    secure_cleanup(password, sizeof(password));
+    crypto_cleanup();
+    if (ret != 0) {
+        fprintf(stderr, "Error: Failed to generate %s\n", positional[0]);
+        return 1;
+    }
+
+    printf("Wrote %ld entries to %s\n", entries, positional[0]);
+    return 0;
+}
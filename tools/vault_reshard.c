@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vault_controller.h"
+#include "vault_codec.h"
+#include "crypto_engine.h"
+#include "utilities.h"
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--master-fd N] [--compression C] <source-vault> <destination> <shards>\n",
+            program);
+    fprintf(stderr, "Copies a vault into a new directory split into <shards> files (1-%d).\n",
+            VAULT_MAX_SHARDS);
+    fprintf(stderr, "A shard count of 1 writes a single-file vault.\n");
+    fprintf(stderr, "--compression rewrites the entries with another codec (none, zlib, zlib-dict,\n");
+    fprintf(stderr, "zstd or zstd-dict); by default the source vault's codec is kept.\n");
+}
+
+int main(int argc, char* argv[]) {
+    int master_fd = -1;
+    const char* positional[3];
+    int positional_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--master-fd") == 0 && i + 1 < argc) {
+            master_fd = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compression") == 0 && i + 1 < argc) {
+            vault_codec_t codec;
+            if (vault_codec_parse(argv[++i], &codec) != 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            if (vault_set_compression(codec) != 0) {
+                fprintf(stderr, "Error: this build does not support %s compression\n", argv[i]);
+                return 1;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 1;
+        } else if (positional_count < 3) {
+            positional[positional_count++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    int shards = positional_count == 3 ? atoi(positional[2]) : 0;
+    if (positional_count != 3 || shards < 1 || shards > VAULT_MAX_SHARDS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char password[VAULT_PASSWORD_LEN];
+    int read = master_fd >= 0 ? read_password_fd(master_fd, password, sizeof(password))
+                              : read_password_secure("Master password: ", password, sizeof(password));
+    if (read != 0) {
+        fprintf(stderr, "Error: Failed to read master password\n");
+        return 1;
+    }
+
+    int ret = vault_reshard(password, positional[0], positional[1], (uint32_t)shards);
+    secure_cleanup(password, sizeof(password));
+    crypto_cleanup();
+    if (ret != 0) {
+        fprintf(stderr, "Error: Failed to reshard %s\n", positional[0]);
+        return 1;
+    }
+
+    printf("Wrote %s with %d shard(s)\n", positional[1], shards);
+    return 0;
+}